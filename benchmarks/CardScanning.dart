@@ -0,0 +1,45 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Allocates short-lived objects next to a large old space that is never
+// written to again. The old lists take about 256MB on 64-bit targets. Most
+// of the time goes to scavenges, and most of each scavenge goes to scanning
+// the clean cards of the remembered set.
+
+import 'BenchmarkBase.dart';
+
+const int OLD_LISTS = 32768;
+const int OLD_LIST_LENGTH = 1000;
+const int ALLOCATIONS = 100000;
+
+void main() {
+  new CardScanningBenchmark().report();
+}
+
+class CardScanningBenchmark extends BenchmarkBase {
+  List old;
+  int allocated = 0;
+
+  CardScanningBenchmark() : super("CardScanning");
+
+  void setup() {
+    old = new List(OLD_LISTS);
+    for (int i = 0; i < OLD_LISTS; i++) {
+      old[i] = new List(OLD_LIST_LENGTH);
+    }
+  }
+
+  void exercise() => run();
+
+  void run() {
+    for (int i = 0; i < ALLOCATIONS; i++) {
+      List young = new List(10);
+      allocated += young.length;
+    }
+  }
+
+  void teardown() {
+    Expect.equals(OLD_LISTS, old.length);
+  }
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Throws exceptions through a few frames without handlers, some of them
+// with try blocks that do not catch, and catches them again.
+
+import 'BenchmarkBase.dart';
+
+const int ITERATIONS = 1000;
+const int DEPTH = 8;
+
+void main() {
+  new ThrowCatchBenchmark().report();
+}
+
+class ThrowCatchBenchmark extends BenchmarkBase {
+  int caught = 0;
+
+  ThrowCatchBenchmark() : super("ThrowCatch");
+
+  void exercise() => run();
+
+  void run() {
+    for (int i = 0; i < ITERATIONS; i++) {
+      try {
+        throwAt(DEPTH);
+      } on FormatException catch (e) {
+        caught++;
+      }
+    }
+  }
+
+  static void throwAt(int depth) {
+    if (depth == 0) throw const FormatException();
+    if (depth.isEven) {
+      throwAt(depth - 1);
+    } else {
+      try {
+        throwAt(depth - 1);
+      } on StateError catch (e) {
+        throw new StateError("Unexpected");
+      }
+    }
+  }
+}
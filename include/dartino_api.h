@@ -6,6 +6,7 @@
 #define INCLUDE_DARTINO_API_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #ifdef _MSC_VER
@@ -29,6 +30,61 @@ typedef void (*PrintInterceptionFunction)(
 typedef void (*ProgramExitCallback)(DartinoProgram, int exitcode, void* data);
 typedef void* DartinoConnection;
 
+// Number of buckets in a DartinoGCPauseHistogram. Bucket 0 counts pauses
+// shorter than one microsecond, bucket i counts pauses of at least 2^(i-1) and
+// less than 2^i microseconds, and the last bucket counts all longer pauses.
+#define DARTINO_GC_PAUSE_BUCKETS 24
+
+typedef struct {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint64_t buckets[DARTINO_GC_PAUSE_BUCKETS];
+} DartinoGCPauseHistogram;
+
+// The phases of the garbage collectors that are timed separately.
+typedef enum {
+  DARTINO_GC_PHASE_SCAVENGE_ROOTS,
+  DARTINO_GC_PHASE_SCAVENGE_REMEMBERED_SET,
+  DARTINO_GC_PHASE_SCAVENGE_COPY,
+  DARTINO_GC_PHASE_SCAVENGE_WEAK,
+  DARTINO_GC_PHASE_MARK,
+  DARTINO_GC_PHASE_MARK_WEAK,
+  DARTINO_GC_PHASE_SWEEP,
+  DARTINO_GC_PHASE_COMPACT,
+  DARTINO_GC_PHASE_COUNT
+} DartinoGCPhase;
+
+// Garbage collection counters of a program. The byte counters are totals
+// over all scavenges, so the survival rate of new-space objects is
+// (bytes_survived + bytes_promoted) / bytes_scavenged. The heap fields
+// describe the shared heap as it was after the most recent collection. The
+// stack fields count how often process stacks were grown, the words copied
+// to the grown stacks, the collections the growing forced, and the length in
+// words of the largest stack.
+typedef struct {
+  uint64_t scavenges;
+  uint64_t old_space_gcs;
+  DartinoGCPauseHistogram scavenge_pauses;
+  DartinoGCPauseHistogram old_space_pauses;
+  DartinoGCPauseHistogram phase_pauses[DARTINO_GC_PHASE_COUNT];
+  uint64_t bytes_scavenged;
+  uint64_t bytes_survived;
+  uint64_t bytes_promoted;
+  uint64_t new_space_used;
+  uint64_t new_space_size;
+  uint64_t old_space_used;
+  uint64_t old_space_size;
+  uint64_t old_space_resident;
+  uint64_t old_space_free;
+  uint64_t old_space_largest_free;
+  uint64_t foreign_memory;
+  uint64_t stack_growths;
+  uint64_t stack_words_copied;
+  uint64_t stack_growth_gcs;
+  uint64_t largest_stack;
+} DartinoGCStatistics;
+
 // Blocking callback returning a new connection.
 typedef DartinoConnection (*DartinoConnectionListenerCallback)(void* data);
 
@@ -68,6 +124,12 @@ DARTINO_EXPORT void DartinoDeleteProgram(DartinoProgram program);
 DARTINO_EXPORT DartinoProgram DartinoLoadProgramFromFlash(void* location,
                                                           size_t size);
 
+// Load a program from the program image in the file at path, as written
+// by DartinoWriteProgramImage. The heap of the program is mapped from the
+// file instead of being read into memory. Returns NULL if the file is not
+// a program image for this VM.
+DARTINO_EXPORT DartinoProgram DartinoLoadProgramImage(const char* path);
+
 // Starts the main method of the program. The given callback will be called once
 // all processes of the program have terminated.
 //
@@ -96,6 +158,24 @@ DARTINO_EXPORT void DartinoRunMultipleMain(int count,
                                            int argc,
                                            char** argv);
 
+// Fill in [statistics] with the garbage collection counters of [program]. It
+// is safe to call this while the program is running.
+DARTINO_EXPORT void DartinoGetGCStatistics(DartinoProgram program,
+                                           DartinoGCStatistics* statistics);
+
+// Ask for a heap census of [program] to be written to the file at [path]. The
+// census is taken after the next garbage collection. It counts the objects,
+// bytes and retained bytes of each class, with classes named by their offset
+// in the program heap.
+DARTINO_EXPORT void DartinoRequestHeapCensus(DartinoProgram program,
+                                             const char* path);
+
+// Write the allocation samples taken in [program] to the file at [path].
+// Samples are only taken when the VM runs with --allocation_sample_interval.
+// Returns false if the file could not be written.
+DARTINO_EXPORT bool DartinoWriteAllocationProfile(DartinoProgram program,
+                                                  const char* path);
+
 // Add a default shared library for the dart:ffi foreign lookups.
 // More than one default shared library can be added. The libraries
 // are used for foreign lookups where no library has been specified.
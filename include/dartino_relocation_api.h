@@ -36,4 +36,14 @@ DARTINO_EXPORT int DartinoRelocateProgram(DartinoProgram program,
                                         void* target,
                                         uintptr_t base);
 
+// Writes the given program as a program image to the file at path. The
+// image can be loaded with DartinoLoadProgramImage. Its heap is mapped
+// from the file, read-only, so processes that load the same image share
+// its pages.
+//
+// The program has to be loaded from a snapshot. Returns false if it is
+// not or if the file could not be written.
+DARTINO_EXPORT bool DartinoWriteProgramImage(DartinoProgram program,
+                                             const char* path);
+
 #endif  // INCLUDE_DARTINO_RELOCATION_API_H_
@@ -448,6 +448,8 @@ abstract class _StringBase implements String {
   String toUpperCase() => internalToUpperCase(this);
 
   @dartino.native external int get length;
+
+  @dartino.native external int get hashCode;
 }
 
 class _OneByteString extends _StringBase {
@@ -464,8 +466,6 @@ class _OneByteString extends _StringBase {
 
   @dartino.native external bool operator ==(Object other);
 
-  int get hashCode => identityHashCode(this);
-
   @dartino.native String operator +(String other) {
     throw new ArgumentError(other);
   }
@@ -507,8 +507,6 @@ class _TwoByteString extends _StringBase {
 
   @dartino.native external bool operator ==(Object other);
 
-  int get hashCode => identityHashCode(this);
-
   @dartino.native String operator +(String other) {
     throw new ArgumentError(other);
   }
@@ -211,10 +211,10 @@ class Coroutine {
     _caller = _coroutineCurrent();
     var result = dartino.coroutineChange(this, argument);
 
-    // If the called coroutine is done now, we clear the
-    // stack reference in it so the memory can be reclaimed.
+    // If the called coroutine is done now, we give its stack
+    // back to the VM so it can be reused or reclaimed.
     if (isDone) {
-      _stack = null;
+      _coroutineReleaseStack(this);
     } else {
       _caller = null;
     }
@@ -242,6 +242,7 @@ class Coroutine {
 
   @dartino.native external static _coroutineCurrent();
   @dartino.native external static _coroutineNewStack(coroutine, entry);
+  @dartino.native external static _coroutineReleaseStack(coroutine);
 }
 
 class ProcessDeath {
@@ -72,6 +72,17 @@ abstract class Foreign {
 
   dynamic _convert(argument) => ForeignConversion.convert(argument);
 
+  /**
+   * Waits until the finalizers of the [Foreign] objects that garbage
+   * collections have found dead so far have run.
+   *
+   * Finalizers do not run during the garbage collection but soon after it,
+   * on a helper thread. Tests use this to observe their effect.
+   */
+  @dartino.native static void waitForFinalizers() {
+    throw new UnsupportedError('waitForFinalizers');
+  }
+
   @dartino.native static int _bitsPerMachineWord() {
     throw new UnsupportedError('_bitsPerMachineWord');
   }
@@ -0,0 +1,46 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+import 'dart:io' as io;
+
+import 'package:dartino_compiler/bytecode_profile.dart';
+import 'package:dartino_compiler/program_info.dart';
+
+main(List<String> arguments) async {
+  usage(message) {
+    print("Invalid arguments: $message");
+    print("Usage: ${io.Platform.script} <bytecode profile> "
+        "<snapshot.info.json>");
+  }
+
+  if (arguments.length != 2) {
+    usage("Exactly 2 arguments must be supplied");
+    io.exit(-1);
+  }
+
+  io.File profile_file = new io.File(arguments[0]);
+  if (!await profile_file.exists()) {
+    usage("The file '${arguments[0]}' does not exist.");
+    io.exit(-1);
+  }
+
+  String info_filename = arguments[1];
+  if (!info_filename.endsWith('.info.json')) {
+    usage("The program info file must end in '.info.json' "
+        "(was: '$info_filename').");
+    io.exit(-1);
+  }
+
+  io.File info_file = new io.File(info_filename);
+  if (!await info_file.exists()) {
+    usage("The file '$info_filename' does not exist.");
+    io.exit(-1);
+  }
+
+  NameOffsetMapping info =
+      ProgramInfoJson.decode(await info_file.readAsString());
+  BytecodeProfile profile = new BytecodeProfile.parse(
+      await profile_file.readAsString(), info);
+  io.stdout.write(profile.format());
+}
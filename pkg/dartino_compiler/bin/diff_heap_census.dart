@@ -0,0 +1,49 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+import 'dart:io' as io;
+
+import 'package:dartino_compiler/heap_census.dart';
+import 'package:dartino_compiler/program_info.dart';
+
+main(List<String> arguments) async {
+  usage(message) {
+    print("Invalid arguments: $message");
+    print("Usage: ${io.Platform.script} <before.census> [<after.census>] "
+        "[<snapshot.info.json>]");
+  }
+
+  NameOffsetMapping info;
+  if (arguments.isNotEmpty && arguments.last.endsWith('.info.json')) {
+    io.File info_file = new io.File(arguments.last);
+    if (!await info_file.exists()) {
+      usage("The file '${arguments.last}' does not exist.");
+      io.exit(-1);
+    }
+    info = ProgramInfoJson.decode(await info_file.readAsString());
+    arguments = arguments.sublist(0, arguments.length - 1);
+  }
+
+  if (arguments.length != 1 && arguments.length != 2) {
+    usage("One or two census files must be supplied");
+    io.exit(-1);
+  }
+
+  List<HeapCensusSnapshot> snapshots = <HeapCensusSnapshot>[];
+  for (String filename in arguments) {
+    io.File file = new io.File(filename);
+    if (!await file.exists()) {
+      usage("The file '$filename' does not exist.");
+      io.exit(-1);
+    }
+    snapshots.add(new HeapCensusSnapshot.parse(
+        await file.readAsString(), info: info));
+  }
+
+  if (snapshots.length == 1) {
+    io.stdout.write(snapshots[0].formatTable());
+  } else {
+    io.stdout.write(formatHeapCensusDiff(snapshots[0], snapshots[1]));
+  }
+}
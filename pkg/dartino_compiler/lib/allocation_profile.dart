@@ -0,0 +1,117 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+/// Reading allocation profiles written by the VM.
+///
+/// With `--allocation_sample_interval=<bytes>` the VM samples one allocation
+/// every that many bytes and writes the samples to the file given by
+/// `--allocation_profile_file` (or by `DartinoWriteAllocationProfile`). It
+/// has one line per class and stack:
+///
+///     <samples>,<bytes>,<class>,<bcp>;<bcp>;...
+///
+/// Classes are offsets in the program heap, and the stack frames are the
+/// bytecode offsets of the calls, innermost first. The snapshot's
+/// `.info.json` file maps both to names.
+library dartino_compiler.allocation_profile;
+
+import 'program_info.dart';
+
+class AllocationSample {
+  final int samples;
+  final int bytes;
+  final String className;
+  final List<String> frames;
+
+  AllocationSample(this.samples, this.bytes, this.className, this.frames);
+}
+
+class AllocationProfile {
+  final int interval;
+  final List<AllocationSample> samples;
+
+  AllocationProfile(this.interval, this.samples);
+
+  /// Parses an allocation profile, naming classes and functions with [info].
+  factory AllocationProfile.parse(String text, NameOffsetMapping info) {
+    Configuration conf;
+    List<NamedEntry> functions;
+    int interval = 0;
+    int hashtag = 0;
+    List<AllocationSample> samples = <AllocationSample>[];
+    for (String line in text.split('\n')) {
+      if (line.isEmpty || line.startsWith('#')) continue;
+      Match property = propertyRegexp.firstMatch(line);
+      if (property != null) {
+        String value = property.group(2);
+        switch (property.group(1)) {
+          case 'model':
+            conf = configurationFromModel(value);
+            if (conf == null) {
+              throw new FormatException("Unknown memory model '$value'.");
+            }
+            functions = functionEntries(info, conf);
+            break;
+          case 'interval':
+            interval = int.parse(value);
+            break;
+          case 'hashtag':
+            hashtag = int.parse(value);
+            break;
+        }
+        continue;
+      }
+      if (conf == null) {
+        throw new FormatException("Memory model absent in allocation profile.");
+      }
+      if (hashtag != info.snapshotHash) {
+        throw new FormatException(
+            "The allocation profile is not from this snapshot.");
+      }
+      List<String> fields = line.split(',');
+      if (fields.length != 4) {
+        throw new FormatException("Malformed allocation sample '$line'.");
+      }
+      String className = fields[2];
+      if (className.startsWith('0x')) {
+        int offset = int.parse(className.substring(2), radix: 16);
+        String name = info.className(conf, offset);
+        if (name != null) className = shortName(name);
+      }
+      List<String> frames = <String>[];
+      if (fields[3].isNotEmpty) {
+        for (String frame in fields[3].split(';')) {
+          int bcp = int.parse(frame.substring(2), radix: 16);
+          String name = findEntry(functions, new Tick(0, bcp, hashtag)).name;
+          frames.add(name == null ? frame : shortName(name));
+        }
+      }
+      samples.add(new AllocationSample(int.parse(fields[0]),
+          int.parse(fields[1]), className, frames));
+    }
+    return new AllocationProfile(interval, samples);
+  }
+
+  /// Returns the profile as folded stacks, outermost frame first and the
+  /// allocated class last, weighted by the estimated number of bytes
+  /// allocated. This is the input format of flame graph tools.
+  String formatFolded() {
+    Map<String, int> weights = <String, int>{};
+    for (AllocationSample sample in samples) {
+      List<String> path = sample.frames.reversed.toList()
+          ..add(sample.className);
+      String key = path.join(';');
+      // Each sample stands for [interval] bytes, unless the sampled objects
+      // were larger than that.
+      int estimate = sample.samples * interval;
+      if (sample.bytes > estimate) estimate = sample.bytes;
+      weights[key] = (weights[key] ?? 0) + estimate;
+    }
+    StringBuffer buffer = new StringBuffer();
+    weights.forEach((String key, int weight) {
+      buffer.writeln("$key $weight");
+    });
+    return buffer.toString();
+  }
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+/// Reading bytecode profiles written by the VM.
+///
+/// With `--bytecode_profile_file` a VM built with debugging support counts
+/// the bytecodes it dispatches, and writes the counts when it shuts down. It
+/// has one line per bytecode, called function and branch, most frequent
+/// first:
+///
+///     bytecode,<count>,<name>
+///     call,<count>,<bcp>
+///     branch,<taken>,<executed>,<bcp>
+///
+/// Calls are the bytecode offset of the first bytecode of the called
+/// function, and branches the bytecode offset of the branch. The snapshot's
+/// `.info.json` file maps both to functions.
+library dartino_compiler.bytecode_profile;
+
+import 'program_info.dart';
+
+class BytecodeCount {
+  final String name;
+  final int count;
+
+  BytecodeCount(this.name, this.count);
+}
+
+class CallCount {
+  final String function;
+  final int count;
+
+  CallCount(this.function, this.count);
+}
+
+class BranchCount {
+  final String function;
+  /// The offset of the branch from the start of the function object.
+  final int offset;
+  final int taken;
+  final int executed;
+
+  BranchCount(this.function, this.offset, this.taken, this.executed);
+}
+
+class BytecodeProfile {
+  final int dispatches;
+  final int unattributed;
+  final List<BytecodeCount> bytecodes;
+  final List<CallCount> calls;
+  final List<BranchCount> branches;
+
+  BytecodeProfile(this.dispatches, this.unattributed, this.bytecodes,
+      this.calls, this.branches);
+
+  /// Parses a bytecode profile, naming functions with [info].
+  factory BytecodeProfile.parse(String text, NameOffsetMapping info) {
+    Configuration conf;
+    List<NamedEntry> functions;
+    int dispatches = 0;
+    int unattributed = 0;
+    int hashtag = 0;
+    List<BytecodeCount> bytecodes = <BytecodeCount>[];
+    List<CallCount> calls = <CallCount>[];
+    List<BranchCount> branches = <BranchCount>[];
+
+    NamedEntry functionAt(String field) {
+      if (conf == null) {
+        throw new FormatException("Memory model absent in bytecode profile.");
+      }
+      if (hashtag != info.snapshotHash) {
+        throw new FormatException(
+            "The bytecode profile is not from this snapshot.");
+      }
+      int bcp = int.parse(field.substring(2), radix: 16);
+      return findEntry(functions, new Tick(0, bcp, hashtag));
+    }
+
+    String nameOf(NamedEntry entry) {
+      return entry.name == null ? "0x${entry.offset.toRadixString(16)}"
+                                : shortName(entry.name);
+    }
+
+    for (String line in text.split('\n')) {
+      if (line.isEmpty || line.startsWith('#')) continue;
+      Match property = propertyRegexp.firstMatch(line);
+      if (property != null) {
+        String value = property.group(2);
+        switch (property.group(1)) {
+          case 'model':
+            conf = configurationFromModel(value);
+            if (conf == null) {
+              throw new FormatException("Unknown memory model '$value'.");
+            }
+            functions = functionEntries(info, conf);
+            break;
+          case 'hashtag':
+            hashtag = int.parse(value);
+            break;
+          case 'dispatches':
+            dispatches = int.parse(value);
+            break;
+          case 'unattributed':
+            unattributed = int.parse(value);
+            break;
+        }
+        continue;
+      }
+      List<String> fields = line.split(',');
+      switch (fields[0]) {
+        case 'bytecode':
+          if (fields.length != 3) break;
+          bytecodes.add(new BytecodeCount(fields[2], int.parse(fields[1])));
+          continue;
+        case 'call':
+          if (fields.length != 3) break;
+          calls.add(new CallCount(nameOf(functionAt(fields[2])),
+              int.parse(fields[1])));
+          continue;
+        case 'branch':
+          if (fields.length != 4) break;
+          NamedEntry function = functionAt(fields[3]);
+          int bcp = int.parse(fields[3].substring(2), radix: 16);
+          branches.add(new BranchCount(nameOf(function),
+              bcp - function.offset, int.parse(fields[1]),
+              int.parse(fields[2])));
+          continue;
+      }
+      throw new FormatException("Malformed bytecode profile line '$line'.");
+    }
+    return new BytecodeProfile(
+        dispatches, unattributed, bytecodes, calls, branches);
+  }
+
+  /// Returns a report of the counts, most frequent first.
+  String format() {
+    String percent(int count, int total) {
+      if (total == 0) return "   -%";
+      return "${(count * 100 ~/ total).toString().padLeft(4)}%";
+    }
+
+    StringBuffer buffer = new StringBuffer();
+    buffer.writeln("# Bytecodes, of $dispatches dispatched.");
+    for (BytecodeCount bytecode in bytecodes) {
+      buffer.writeln("${bytecode.count.toString().padLeft(12)} "
+          "${percent(bytecode.count, dispatches)} ${bytecode.name}");
+    }
+    buffer.writeln("# Calls.");
+    for (CallCount call in calls) {
+      buffer.writeln("${call.count.toString().padLeft(12)} ${call.function}");
+    }
+    buffer.writeln("# Taken branches, and how often they were executed.");
+    for (BranchCount branch in branches) {
+      buffer.writeln("${branch.taken.toString().padLeft(12)} "
+          "${percent(branch.taken, branch.executed)} of "
+          "${branch.executed} ${branch.function}+${branch.offset}");
+    }
+    if (unattributed > 0) {
+      buffer.writeln("# $unattributed calls and branches in other programs.");
+    }
+    return buffer.toString();
+  }
+}
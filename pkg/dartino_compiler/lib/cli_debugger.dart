@@ -15,6 +15,10 @@ import "src/hub/session_manager.dart" show
 
 import 'dartino_class.dart';
 
+import 'heap_census.dart' show
+    HeapCensusClass,
+    HeapCensusSnapshot;
+
 import 'src/codegen_visitor.dart';
 
 import 'src/dartino_backend.dart';
@@ -29,6 +33,10 @@ import 'vm_commands.dart' show
     ClassValue,
     ConnectionError,
     DartValue,
+    GCPauseHistogram,
+    GCStatisticsResult,
+    HeapCensusEntry,
+    HeapCensusResult,
     Instance,
     InstanceStructure,
     Integer,
@@ -78,6 +86,9 @@ Commands:
                                         from a local variable
   'p/print'                             print the values of all locals
   'lp/processes'                        list all processes
+  'gc'                                  show garbage collection statistics
+  'census [file]'                       show the classes retaining the most
+                                        memory, and write a heap census file
   'disasm/disassemble'                  disassemble code for frame
   't/toggle <flag>'                     toggle one of the flags:
                                           - 'internal' : show internal frames
@@ -364,6 +375,23 @@ class CommandLineDebugger {
           writeStdoutLine('');
         }
         break;
+      case 'gc':
+        if (checkPausedOrRunning('cannot show gc statistics')) {
+          printGCStatistics(await vmContext.gcStatistics());
+        }
+        break;
+      case 'census':
+        if (checkPaused('cannot take heap census')) {
+          HeapCensusSnapshot census = heapCensusSnapshot(
+              await vmContext.heapCensus());
+          writeStdout(census.formatTable());
+          if (commandComponents.length > 1) {
+            Uri uri = base.resolve(commandComponents[1]);
+            await new File.fromUri(uri).writeAsString(census.format());
+            writeStdoutLine("### wrote heap census to ${uri.toFilePath()}");
+          }
+        }
+        break;
       case 'finish':
         if (checkPaused('cannot finish method')) {
           await handleProcessStopResponse(await vmContext.stepOut());
@@ -651,6 +679,50 @@ class CommandLineDebugger {
     writeStdoutLine(BreakpointToString(breakpoint));
   }
 
+  String GCPauseHistogramToString(GCPauseHistogram pauses) {
+    int average = pauses.count == 0
+        ? 0
+        : pauses.totalMicroseconds ~/ pauses.count;
+    return "${pauses.count} pauses, average $average us, "
+        "max ${pauses.maxMicroseconds} us";
+  }
+
+  HeapCensusSnapshot heapCensusSnapshot(HeapCensusResult result) {
+    return new HeapCensusSnapshot(result.classes.map((HeapCensusEntry entry) {
+      DartinoClass klass =
+          vmContext.dartinoSystem.lookupClassById(entry.classId);
+      String name = klass == null ? "class ${entry.classId}" : klass.name;
+      return new HeapCensusClass(
+          name, entry.count, entry.bytes, entry.retained);
+    }));
+  }
+
+  void printGCStatistics(GCStatisticsResult statistics) {
+    writeStdoutLine("scavenges: ${statistics.scavenges}, "
+        "${GCPauseHistogramToString(statistics.scavengePauses)}");
+    writeStdoutLine("old-space GCs: ${statistics.oldSpaceGCs}, "
+        "${GCPauseHistogramToString(statistics.oldSpacePauses)}");
+    for (int i = 0; i < statistics.phasePauses.length; i++) {
+      writeStdoutLine("  ${GCStatisticsResult.phaseNames[i]}: "
+          "${GCPauseHistogramToString(statistics.phasePauses[i])}");
+    }
+    int survivalPercent = (statistics.survivalRate * 100).round();
+    writeStdoutLine("bytes promoted: ${statistics.bytesPromoted}, "
+        "survival rate: $survivalPercent%");
+    writeStdoutLine("new-space: "
+        "${statistics.newSpaceUsed}/${statistics.newSpaceSize}");
+    writeStdoutLine("old-space: "
+        "${statistics.oldSpaceUsed}/${statistics.oldSpaceSize}, "
+        "resident ${statistics.oldSpaceResident}, "
+        "free ${statistics.oldSpaceFree}, "
+        "largest free ${statistics.oldSpaceLargestFree}");
+    writeStdoutLine("foreign memory: ${statistics.foreignMemory}");
+    writeStdoutLine("stack growths: ${statistics.stackGrowths}, "
+        "words copied: ${statistics.stackWordsCopied}, "
+        "forced GCs: ${statistics.stackGrowthGCs}, "
+        "largest stack: ${statistics.largestStack} words");
+  }
+
   // This method is a helper method for computing the default output for one
 // of the stop command results. There are currently the following stop
 // responses:
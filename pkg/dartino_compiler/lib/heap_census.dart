@@ -0,0 +1,133 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+/// Reading, writing and comparing heap census files.
+///
+/// A census file is written by the VM (on request from the embedder or on
+/// SIGUSR2) or by the debugger. It has one line per class:
+///
+///     <class>,<instances>,<bytes>,<retained bytes>
+///
+/// The VM names classes by their offset in the program heap, as `0x<hex>`,
+/// which the snapshot's `.info.json` file maps to names. The debugger writes
+/// the class names directly.
+library dartino_compiler.heap_census;
+
+import 'program_info.dart';
+
+final RegExp _propertyRegexp = new RegExp(r'^(\w+)=(.*$)');
+
+class HeapCensusClass {
+  final String name;
+  final int count;
+  final int bytes;
+  final int retained;
+
+  const HeapCensusClass(this.name, this.count, this.bytes, this.retained);
+}
+
+class HeapCensusSnapshot {
+  final Map<String, HeapCensusClass> classes;
+
+  HeapCensusSnapshot(Iterable<HeapCensusClass> classes)
+      : classes = new Map<String, HeapCensusClass>.fromIterable(
+          classes, key: (HeapCensusClass c) => c.name);
+
+  int get count => classes.values.fold(0, (sum, c) => sum + c.count);
+  int get bytes => classes.values.fold(0, (sum, c) => sum + c.bytes);
+
+  /// Parses a census file. Class offsets are turned into names with [info]
+  /// when it is given.
+  factory HeapCensusSnapshot.parse(String text, {NameOffsetMapping info}) {
+    Configuration conf;
+    List<HeapCensusClass> classes = <HeapCensusClass>[];
+    for (String line in text.split('\n')) {
+      if (line.isEmpty || line.startsWith('#')) continue;
+      Match property = _propertyRegexp.firstMatch(line);
+      if (property != null) {
+        if (property.group(1) == 'model') {
+          conf = configurationFromModel(property.group(2));
+          if (conf == null) {
+            throw new FormatException(
+                "Unknown memory model '${property.group(2)}'.");
+          }
+        }
+        continue;
+      }
+      List<String> fields = line.split(',');
+      if (fields.length != 4) {
+        throw new FormatException("Malformed heap census line '$line'.");
+      }
+      String name = fields[0];
+      if (info != null && conf != null && name.startsWith('0x')) {
+        int offset = int.parse(name.substring(2), radix: 16);
+        String symbolicName = info.className(conf, offset);
+        if (symbolicName != null) name = shortName(symbolicName);
+      }
+      classes.add(new HeapCensusClass(name, int.parse(fields[1]),
+          int.parse(fields[2]), int.parse(fields[3])));
+    }
+    return new HeapCensusSnapshot(classes);
+  }
+
+  String format() {
+    StringBuffer buffer = new StringBuffer();
+    buffer.writeln("# Heap census from the Dartino debugger.");
+    buffer.writeln("objects=$count");
+    buffer.writeln("bytes=$bytes");
+    buffer.writeln("# class,count,bytes,retained");
+    for (HeapCensusClass c in classes.values) {
+      buffer.writeln("${c.name},${c.count},${c.bytes},${c.retained}");
+    }
+    return buffer.toString();
+  }
+
+  /// Returns a table of the [limit] classes retaining the most bytes.
+  String formatTable({int limit: 20}) {
+    List<HeapCensusClass> sorted = classes.values.toList()
+        ..sort((a, b) => b.retained - a.retained);
+    StringBuffer buffer = new StringBuffer();
+    buffer.writeln("${'retained'.padLeft(12)} ${'bytes'.padLeft(12)} "
+        "${'count'.padLeft(10)}  class");
+    for (HeapCensusClass c in sorted.take(limit)) {
+      buffer.writeln("${'${c.retained}'.padLeft(12)} "
+          "${'${c.bytes}'.padLeft(12)} "
+          "${'${c.count}'.padLeft(10)}  ${c.name}");
+    }
+    return buffer.toString();
+  }
+}
+
+/// Returns a table of the classes whose retained size changed the most
+/// between [before] and [after].
+String formatHeapCensusDiff(
+    HeapCensusSnapshot before, HeapCensusSnapshot after, {int limit: 20}) {
+  const HeapCensusClass none = const HeapCensusClass(null, 0, 0, 0);
+  Set<String> names = new Set<String>()
+      ..addAll(before.classes.keys)
+      ..addAll(after.classes.keys);
+  List<List> rows = <List>[];
+  for (String name in names) {
+    HeapCensusClass b = before.classes[name] ?? none;
+    HeapCensusClass a = after.classes[name] ?? none;
+    rows.add([name, a.retained - b.retained, a.bytes - b.bytes,
+              a.count - b.count]);
+  }
+  rows.sort((x, y) => y[1].abs() - x[1].abs());
+
+  String signed(int value) => value > 0 ? "+$value" : "$value";
+
+  StringBuffer buffer = new StringBuffer();
+  buffer.writeln("objects ${before.count} -> ${after.count}, "
+      "bytes ${before.bytes} -> ${after.bytes}");
+  buffer.writeln("${'retained'.padLeft(12)} ${'bytes'.padLeft(12)} "
+      "${'count'.padLeft(10)}  class");
+  for (List row in rows.take(limit)) {
+    if (row[1] == 0 && row[2] == 0 && row[3] == 0) continue;
+    buffer.writeln("${signed(row[1]).padLeft(12)} "
+        "${signed(row[2]).padLeft(12)} ${signed(row[3]).padLeft(10)}  "
+        "${row[0]}");
+  }
+  return buffer.toString();
+}
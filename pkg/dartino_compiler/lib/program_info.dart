@@ -399,6 +399,31 @@ class NamedEntry {
   NamedEntry(this.offset, this.name);
 }
 
+// Computes an offset sorted list of Function entries.
+List<NamedEntry> functionEntries(NameOffsetMapping info, Configuration conf) {
+  List<NamedEntry> functions = new List<NamedEntry>();
+  Map<int,String> programObjectNames = info.programObjectNames[conf];
+  programObjectNames.forEach((int offset, String name) {
+    if (name.endsWith("-method")) {
+      functions.add(new NamedEntry(offset, name));
+    }
+  });
+  functions.sort((a, b) => a.offset - b.offset);
+  return functions;
+}
+
+// Returns the configuration of a memory model written by the VM, or null if
+// the model is not recognized.
+Configuration configurationFromModel(String model) {
+  switch (model) {
+    case 'b64double': return Configuration.Offset64BitsDouble;
+    case 'b64float': return Configuration.Offset64BitsFloat;
+    case 'b32double': return Configuration.Offset32BitsDouble;
+    case 'b32float': return Configuration.Offset32BitsFloat;
+  }
+  return null;
+}
+
 class Profile {
   Profile();
 
@@ -474,15 +499,7 @@ Future<Profile> decodeTickSamples(
     return null;
   }
 
-  // Compute a offset sorted list of Function entries.
-  List<NamedEntry> functions = new List<NamedEntry>();
-  Map<int,String> programObjectNames = info.programObjectNames[conf];
-  programObjectNames.forEach((int offset, String name) {
-    if (name.endsWith("-method")) {
-      functions.add(new NamedEntry(offset, name));
-    }
-  });
-  functions.sort((a, b) => a.offset - b.offset);
+  List<NamedEntry> functions = functionEntries(info, conf);
 
   Map<String, FunctionInfo> results = <String, FunctionInfo>{};
   for (Tick t in profile.ticks) {
@@ -128,6 +128,22 @@ abstract class VmCommand {
           ids[i] = CommandBuffer.readInt32FromBuffer(buffer, (i + 1) * 4);
         }
         return new ProcessGetProcessIdsResult(ids);
+      case VmCommandCode.GCStatisticsResult:
+        return new GCStatisticsResult.fromBuffer(buffer);
+      case VmCommandCode.HeapCensusResult:
+        int count = CommandBuffer.readInt32FromBuffer(buffer, 0);
+        List<HeapCensusEntry> classes = new List<HeapCensusEntry>(count);
+        int offset = 4;
+        for (int i = 0; i < count; i++) {
+          int classId =
+              translateClass(CommandBuffer.readInt64FromBuffer(buffer, offset));
+          int instances = CommandBuffer.readInt64FromBuffer(buffer, offset + 8);
+          int bytes = CommandBuffer.readInt64FromBuffer(buffer, offset + 16);
+          int retained = CommandBuffer.readInt64FromBuffer(buffer, offset + 24);
+          classes[i] = new HeapCensusEntry(classId, instances, bytes, retained);
+          offset += 32;
+        }
+        return new HeapCensusResult(classes);
       case VmCommandCode.UncaughtException:
         int offset = 0;
         int processId = CommandBuffer.readInt32FromBuffer(buffer, offset);
@@ -1420,6 +1436,199 @@ class ProcessGetProcessIdsResult extends VmCommand {
   String valuesToString() => "ids: $ids";
 }
 
+class GCStatistics extends VmCommand {
+  const GCStatistics()
+      : super(VmCommandCode.GCStatistics);
+
+  /// The peer will respond with [GCStatisticsResult].
+  int get numberOfResponsesExpected => 1;
+
+  String valuesToString() => "";
+}
+
+/// Pause times of one kind of collection or collection phase. Bucket 0 counts
+/// pauses shorter than a microsecond, bucket i pauses of at least 2^(i-1) and
+/// less than 2^i microseconds, and the last bucket all longer pauses.
+class GCPauseHistogram {
+  final int count;
+  final int totalMicroseconds;
+  final int maxMicroseconds;
+  final List<int> buckets;
+
+  const GCPauseHistogram(
+      this.count, this.totalMicroseconds, this.maxMicroseconds, this.buckets);
+
+  String toString() => "count: $count, total: $totalMicroseconds us, "
+      "max: $maxMicroseconds us, buckets: $buckets";
+}
+
+/// Garbage collection counters of the program, see DartinoGCStatistics in
+/// dartino_api.h.
+class GCStatisticsResult extends VmCommand {
+  static const List<String> phaseNames = const <String>[
+      "scavenge-roots",
+      "scavenge-remembered-set",
+      "scavenge-copy",
+      "scavenge-weak",
+      "mark",
+      "mark-weak",
+      "sweep",
+      "compact"];
+
+  final int scavenges;
+  final int oldSpaceGCs;
+  final GCPauseHistogram scavengePauses;
+  final GCPauseHistogram oldSpacePauses;
+  final List<GCPauseHistogram> phasePauses;
+  final int bytesScavenged;
+  final int bytesSurvived;
+  final int bytesPromoted;
+  final int newSpaceUsed;
+  final int newSpaceSize;
+  final int oldSpaceUsed;
+  final int oldSpaceSize;
+  final int oldSpaceResident;
+  final int oldSpaceFree;
+  final int oldSpaceLargestFree;
+  final int foreignMemory;
+  final int stackGrowths;
+  final int stackWordsCopied;
+  final int stackGrowthGCs;
+  final int largestStack;
+
+  const GCStatisticsResult(
+      this.scavenges,
+      this.oldSpaceGCs,
+      this.scavengePauses,
+      this.oldSpacePauses,
+      this.phasePauses,
+      this.bytesScavenged,
+      this.bytesSurvived,
+      this.bytesPromoted,
+      this.newSpaceUsed,
+      this.newSpaceSize,
+      this.oldSpaceUsed,
+      this.oldSpaceSize,
+      this.oldSpaceResident,
+      this.oldSpaceFree,
+      this.oldSpaceLargestFree,
+      this.foreignMemory,
+      this.stackGrowths,
+      this.stackWordsCopied,
+      this.stackGrowthGCs,
+      this.largestStack)
+      : super(VmCommandCode.GCStatisticsResult);
+
+  factory GCStatisticsResult.fromBuffer(Uint8List buffer) {
+    int offset = 0;
+    int readInt32() {
+      int value = CommandBuffer.readInt32FromBuffer(buffer, offset);
+      offset += 4;
+      return value;
+    }
+    int readInt64() {
+      int value = CommandBuffer.readInt64FromBuffer(buffer, offset);
+      offset += 8;
+      return value;
+    }
+    int bucketCount = readInt32();
+    int phaseCount = readInt32();
+    GCPauseHistogram readHistogram() {
+      int count = readInt64();
+      int total = readInt64();
+      int max = readInt64();
+      List<int> buckets = new List<int>(bucketCount);
+      for (int i = 0; i < bucketCount; i++) {
+        buckets[i] = readInt64();
+      }
+      return new GCPauseHistogram(count, total, max, buckets);
+    }
+    int scavenges = readInt64();
+    int oldSpaceGCs = readInt64();
+    GCPauseHistogram scavengePauses = readHistogram();
+    GCPauseHistogram oldSpacePauses = readHistogram();
+    List<GCPauseHistogram> phasePauses =
+        new List<GCPauseHistogram>(phaseCount);
+    for (int i = 0; i < phaseCount; i++) {
+      phasePauses[i] = readHistogram();
+    }
+    return new GCStatisticsResult(
+        scavenges,
+        oldSpaceGCs,
+        scavengePauses,
+        oldSpacePauses,
+        phasePauses,
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64(),
+        readInt64());
+  }
+
+  /// The fraction of scavenged new-space bytes that survived or were
+  /// promoted.
+  double get survivalRate => bytesScavenged == 0
+      ? 0.0
+      : (bytesSurvived + bytesPromoted) / bytesScavenged;
+
+  int get numberOfResponsesExpected => 0;
+
+  String valuesToString() {
+    return "scavenges: $scavenges, oldSpaceGCs: $oldSpaceGCs, "
+        "bytesPromoted: $bytesPromoted, survivalRate: $survivalRate, "
+        "oldSpaceFree: $oldSpaceFree, "
+        "oldSpaceLargestFree: $oldSpaceLargestFree, "
+        "foreignMemory: $foreignMemory, "
+        "stackGrowths: $stackGrowths, "
+        "stackWordsCopied: $stackWordsCopied, "
+        "stackGrowthGCs: $stackGrowthGCs, "
+        "largestStack: $largestStack";
+  }
+}
+
+class HeapCensus extends VmCommand {
+  const HeapCensus()
+      : super(VmCommandCode.HeapCensus);
+
+  /// The peer will respond with [HeapCensusResult].
+  int get numberOfResponsesExpected => 1;
+
+  String valuesToString() => "";
+}
+
+class HeapCensusEntry {
+  final int classId;
+  final int count;
+  final int bytes;
+  final int retained;
+
+  const HeapCensusEntry(this.classId, this.count, this.bytes, this.retained);
+
+  String toString() => "classId: $classId, count: $count, bytes: $bytes, "
+      "retained: $retained";
+}
+
+class HeapCensusResult extends VmCommand {
+  final List<HeapCensusEntry> classes;
+
+  const HeapCensusResult(this.classes)
+      : super(VmCommandCode.HeapCensusResult);
+
+  int get numberOfResponsesExpected => 0;
+
+  String valuesToString() => "classes: $classes";
+}
+
 class SessionEnd extends VmCommand {
   const SessionEnd()
       : super(VmCommandCode.SessionEnd);
@@ -1812,10 +2021,15 @@ enum VmCommandCode {
   ProcessGetProcessIds,
   ProcessGetProcessIdsResult,
 
+  GCStatistics,
+  GCStatisticsResult,
+
   SetEntryPoint,
   CreateSnapshot,
   ProgramInfo,
   CollectGarbage,
+  HeapCensus,
+  HeapCensusResult,
 
   NewMap,
   DeleteMap,
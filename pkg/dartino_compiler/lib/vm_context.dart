@@ -922,6 +922,16 @@ class DartinoVmContext {
     return response.ids;
   }
 
+  Future<HeapCensusResult> heapCensus() async {
+    assert(isPaused);
+    return await runCommand(const HeapCensus());
+  }
+
+  Future<GCStatisticsResult> gcStatistics() async {
+    assert(isSpawned);
+    return await runCommand(const GCStatistics());
+  }
+
   Future<BackTrace> processStack(int processId) async {
     assert(isPaused);
     ProcessBacktrace backtraceResponse =
@@ -12,7 +12,7 @@
 namespace dartino {
 
 uint8 Bytecode::Print(uint8* bcp) {
-  Opcode opcode = static_cast<Opcode>(*bcp);
+  Opcode opcode = Unfuse(static_cast<Opcode>(*bcp));
   const char* bytecode_format = BytecodeFormat(opcode);
   const char* print_format = PrintFormat(opcode);
 
@@ -34,49 +34,67 @@ uint8 Bytecode::Print(uint8* bcp) {
   } else {
     FATAL1("Unknown bytecode format %s\n", bytecode_format);
   }
+  if (IsSuperinstruction(static_cast<Opcode>(*bcp))) Print::Out(" (fused)");
+  if (IsQuickened(static_cast<Opcode>(*bcp))) Print::Out(" (quickened)");
   return Size(opcode);
 }
 
 uint8 Bytecode::Size(Opcode opcode) {
-  const uint8 sizes[kNumBytecodes] = {
+  const uint8 sizes[kMethodEnd + 1] = {
 #define EACH(name, branching, format, size, stack_diff, print) size,
       BYTECODES_DO(EACH)
 #undef EACH
   };
   ASSERT(opcode < kNumBytecodes);
-  return sizes[opcode];
+  return sizes[Unfuse(opcode)];
 }
 
 #define STR(string) #string
 
+const char* Bytecode::Name(Opcode opcode) {
+  const char* names[kNumBytecodes] = {
+#define EACH(name, branching, format, size, stack_diff, print) STR(name),
+      BYTECODES_DO(EACH)
+#undef EACH
+#define EACH(name, first, second) STR(name),
+      SUPERINSTRUCTIONS_DO(EACH)
+#undef EACH
+#define EACH(name, original) STR(name),
+      QUICKENED_DO(EACH)
+#undef EACH
+  };
+  ASSERT(opcode < kNumBytecodes);
+  return names[opcode];
+}
+
 const char* Bytecode::PrintFormat(Opcode opcode) {
-  const char* print_formats[kNumBytecodes] = {
+  const char* print_formats[kMethodEnd + 1] = {
 #define EACH(name, branching, format, size, stack_diff, print) print,
       BYTECODES_DO(EACH)
 #undef EACH
   };
   ASSERT(opcode < kNumBytecodes);
-  return print_formats[opcode];
+  return print_formats[Unfuse(opcode)];
 }
 
 const char* Bytecode::BytecodeFormat(Opcode opcode) {
-  const char* bytecode_formats[kNumBytecodes] = {
+  const char* bytecode_formats[kMethodEnd + 1] = {
 #define EACH(name, branching, format, size, stack_diff, print) format,
       BYTECODES_DO(EACH)
 #undef EACH
   };
   ASSERT(opcode < kNumBytecodes);
-  return bytecode_formats[opcode];
+  return bytecode_formats[Unfuse(opcode)];
 }
 
 int8 Bytecode::StackDiff(Opcode opcode) {
-  const int8 stack_diffs[kNumBytecodes] = {
+  const int8 stack_diffs[kMethodEnd + 1] = {
 #define EACH(name, branching, format, size, stack_diff, print) stack_diff,
       BYTECODES_DO(EACH)
 #undef EACH
   };
   ASSERT(opcode < kNumBytecodes);
-  return stack_diffs[opcode];
+  return stack_diffs[Unfuse(opcode)];
 }
 
 bool Bytecode::IsInvokeVariant(Opcode opcode) {
@@ -95,6 +113,31 @@ bool Bytecode::IsStaticInvoke(Opcode opcode) {
   return opcode >= kInvokeStatic && opcode <= kInvokeFactory;
 }
 
+Opcode Bytecode::Fuse(Opcode first, Opcode second) {
+#define EACH(name, fused_first, fused_second) \
+  if (first == k##fused_first && second == k##fused_second) return k##name;
+  SUPERINSTRUCTIONS_DO(EACH)
+#undef EACH
+  return first;
+}
+
+Opcode Bytecode::Unfuse(Opcode opcode) {
+  switch (opcode) {
+#define EACH(name, first, second) \
+  case k##name:                   \
+    return k##first;
+    SUPERINSTRUCTIONS_DO(EACH)
+#undef EACH
+#define EACH(name, original) \
+  case k##name:              \
+    return k##original;
+    QUICKENED_DO(EACH)
+#undef EACH
+    default:
+      return opcode;
+  }
+}
+
 // TODO(ager): use branches to skip forward by more than
 // a bytecode at a time.
 uint8* Bytecode::PreviousBytecode(uint8* current_bcp) {
@@ -129,9 +129,53 @@ const int kLoadLiteralWideLimit = 0x3fffffff;
                                                                                \
   V(MethodEnd, false, "I", 5, 0, "method end %d" )
 
+// Superinstructions replace the opcode of the first bytecode of a common
+// pair, and run both bytecodes with a single dispatch. The second bytecode
+// stays in place, so a superinstruction has the operands and size of its
+// first bytecode, and branches and frames can still point at the second one.
+// The compiler never emits them; the VM fuses pairs when it folds a program
+// and unfuses them before unfolding it or attaching a debugger. Run a
+// program with --bytecode_pair_file to see which pairs it dispatches most.
+// Only keep pairs whose fused handler measures faster than the two plain
+// ones: fusing LoadLocal0 with InvokeMethod, for example, bypasses the
+// handler of the quickened InvokeMethod and makes calls slower.
+#define SUPERINSTRUCTIONS_DO(V)                                                \
+  /* Name                         First        Second           */            \
+  V(LoadLocal4AndLoadField,       LoadLocal4,  LoadField)                     \
+  V(LoadLocalAndLoadField,        LoadLocal,   LoadField)                     \
+  V(LoadLiteral1AndInvokeAdd,     LoadLiteral1, InvokeAdd)                    \
+  V(LoadLiteral1AndInvokeSub,     LoadLiteral1, InvokeSub)                    \
+  V(StoreLocalAndPop,             StoreLocal,  Pop)                           \
+  V(InvokeEqAndBranchIfFalseWide, InvokeEq,    BranchIfFalseWide)             \
+  V(InvokeLtAndBranchIfFalseWide, InvokeLt,    BranchIfFalseWide)             \
+  V(InvokeGtAndBranchIfFalseWide, InvokeGt,    BranchIfFalseWide)             \
+  V(InvokeGeAndBranchIfFalseWide, InvokeGe,    BranchIfFalseWide)
+
+// Quickened bytecodes replace a bytecode with a form specialized for what
+// the VM learned about it, and keep its operands. The interpreter rewrites
+// a LoadStaticInit once the static is initialized, as long as the program
+// has only had one process, and folding rewrites invokes of methods with
+// few arguments to the variant for their arity. Like superinstructions they
+// never leave the VM: unfusing the program reverts them too.
+#define QUICKENED_DO(V)                                                        \
+  /* Name                   Original      */                                  \
+  V(LoadStaticInitialized,  LoadStaticInit)                                   \
+  V(InvokeMethod0,          InvokeMethod)                                     \
+  V(InvokeMethod1,          InvokeMethod)                                     \
+  V(InvokeMethod2,          InvokeMethod)                                     \
+  V(InvokeMethod3,          InvokeMethod)
+
 #define BYTECODE_OPCODE(name, branching, format, length, stack_diff, print) \
   k##name,
-enum Opcode { BYTECODES_DO(BYTECODE_OPCODE) };
+#define SUPERINSTRUCTION_OPCODE(name, first, second) k##name,
+#define QUICKENED_OPCODE(name, original) k##name,
+enum Opcode {
+  BYTECODES_DO(BYTECODE_OPCODE)
+  SUPERINSTRUCTIONS_DO(SUPERINSTRUCTION_OPCODE)
+  QUICKENED_DO(QUICKENED_OPCODE)
+};
+#undef QUICKENED_OPCODE
+#undef SUPERINSTRUCTION_OPCODE
 #undef BYTECODE_OPCODE
 
 #define BYTECODE_LENGTH(name, branching, format, length, stack_diff, print) \
@@ -139,9 +183,31 @@ enum Opcode { BYTECODES_DO(BYTECODE_OPCODE) };
 BYTECODES_DO(BYTECODE_LENGTH)
 #undef BYTECODE_LENGTH
 
+#define SUPERINSTRUCTION_LENGTH(name, first, second) \
+  const int k##name##Length = k##first##Length;
+SUPERINSTRUCTIONS_DO(SUPERINSTRUCTION_LENGTH)
+#undef SUPERINSTRUCTION_LENGTH
+
+#define QUICKENED_LENGTH(name, original) \
+  const int k##name##Length = k##original##Length;
+QUICKENED_DO(QUICKENED_LENGTH)
+#undef QUICKENED_LENGTH
+
 class Bytecode {
  public:
-  static const int kNumBytecodes = kMethodEnd + 1;
+  static const int kNumSuperinstructions =
+#define SUPERINSTRUCTION_COUNT(name, first, second) 1 +
+      SUPERINSTRUCTIONS_DO(SUPERINSTRUCTION_COUNT) 0;
+#undef SUPERINSTRUCTION_COUNT
+  static const int kFirstQuickened = kMethodEnd + 1 + kNumSuperinstructions;
+  static const int kNumQuickened =
+#define QUICKENED_COUNT(name, original) 1 +
+      QUICKENED_DO(QUICKENED_COUNT) 0;
+#undef QUICKENED_COUNT
+  static const int kNumBytecodes = kFirstQuickened + kNumQuickened;
+  // The number of arities InvokeMethod has a quickened variant for.
+  static const int kNumInvokeMethodArities =
+      kInvokeMethod3 - kInvokeMethod0 + 1;
   static const int kGuaranteedFrameSize = 32;
   static const int kUnfoldOffset = kInvokeMethodUnfold - kInvokeMethod;
 
@@ -155,6 +221,9 @@ class Bytecode {
   // returned.
   static int8 StackDiff(Opcode opcode);
 
+  // Get the name of the opcode.
+  static const char* Name(Opcode opcode);
+
   // Get the print format of the opcode.
   static const char* PrintFormat(Opcode opcode);
 
@@ -169,6 +238,20 @@ class Bytecode {
   static bool IsInvoke(Opcode opcode);
   static bool IsStaticInvoke(Opcode opcode);
 
+  // Superinstructions.
+  static bool IsSuperinstruction(Opcode opcode) {
+    return opcode > kMethodEnd && opcode < kFirstQuickened;
+  }
+  // Returns the superinstruction for [first] followed by [second], or
+  // [first] if there is none.
+  static Opcode Fuse(Opcode first, Opcode second);
+  // Returns the first bytecode of a superinstruction, the original of a
+  // quickened bytecode, or [opcode] itself.
+  static Opcode Unfuse(Opcode opcode);
+
+  // Quickened bytecodes.
+  static bool IsQuickened(Opcode opcode) { return opcode >= kFirstQuickened; }
+
   // Compute the previous bytecode. Takes time linear in the number of
   // bytecodes in the method.
   static uint8* PreviousBytecode(uint8* current_bcp);
@@ -0,0 +1,47 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include <string.h>
+
+#include "src/shared/assert.h"
+#include "src/shared/bytecodes.h"
+#include "src/shared/test_case.h"
+
+namespace dartino {
+
+TEST_CASE(Superinstructions) {
+  EXPECT_EQ(kLoadLocal4AndLoadField, Bytecode::Fuse(kLoadLocal4, kLoadField));
+  EXPECT_EQ(kStoreLocalAndPop, Bytecode::Fuse(kStoreLocal, kPop));
+  EXPECT_EQ(kLoadLocal3, Bytecode::Fuse(kLoadLocal3, kReturn));
+  EXPECT_EQ(kLoadLocal0, Bytecode::Fuse(kLoadLocal0, kInvokeMethod));
+  EXPECT_EQ(kPop, Bytecode::Fuse(kPop, kPop));
+
+#define V(name, first, second)                             \
+  EXPECT(Bytecode::IsSuperinstruction(k##name));           \
+  EXPECT_EQ(k##name, Bytecode::Fuse(k##first, k##second)); \
+  EXPECT_EQ(k##first, Bytecode::Unfuse(k##name));          \
+  EXPECT_EQ(Bytecode::Size(k##first), Bytecode::Size(k##name));
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+
+  EXPECT(!Bytecode::IsSuperinstruction(kMethodEnd));
+  EXPECT_EQ(kMethodEnd, Bytecode::Unfuse(kMethodEnd));
+  EXPECT_EQ(0, strcmp("StoreLocalAndPop", Bytecode::Name(kStoreLocalAndPop)));
+}
+
+TEST_CASE(QuickenedBytecodes) {
+#define V(name, original)                            \
+  EXPECT(Bytecode::IsQuickened(k##name));            \
+  EXPECT(!Bytecode::IsSuperinstruction(k##name));    \
+  EXPECT_EQ(k##original, Bytecode::Unfuse(k##name)); \
+  EXPECT_EQ(Bytecode::Size(k##original), Bytecode::Size(k##name));
+  QUICKENED_DO(V)
+#undef V
+
+  EXPECT(!Bytecode::IsQuickened(kLoadStaticInit));
+  EXPECT(!Bytecode::IsQuickened(kInvokeGeAndBranchIfFalseWide));
+  EXPECT(kLoadStaticInitialized == Bytecode::kFirstQuickened);
+}
+
+}  // namespace dartino
@@ -104,10 +104,15 @@ class Connection {
     kProcessGetProcessIds,
     kProcessGetProcessIdsResult,
 
+    kGCStatistics,
+    kGCStatisticsResult,
+
     kSetEntryPoint,
     kCreateSnapshot,
     kProgramInfo,
     kCollectGarbage,
+    kHeapCensus,
+    kHeapCensusResult,
 
     kNewMap,
     kDeleteMap,
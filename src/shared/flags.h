@@ -48,6 +48,16 @@ namespace dartino {
                "Max heap size in kbytes (default unlimited)")             \
   FLAG_INTEGER(release, semispace_size, 16,                               \
                "New-space semispace size in kbytes (default 16)")         \
+  FLAG_INTEGER(release, min_semispace_size, 0,                            \
+               "Min adaptive semispace size in kbytes (default fixed)")   \
+  FLAG_INTEGER(release, max_semispace_size, 0,                            \
+               "Max adaptive semispace size in kbytes (default fixed)")   \
+  FLAG_BOOLEAN(release, pretenure, false,                                 \
+               "Allocate long-lived instances directly in old-space")     \
+  FLAG_BOOLEAN(release, private_heaps, false,                             \
+               "Give spawned processes a new-space of their own")         \
+  FLAG_BOOLEAN(release, huge_pages, false,                                \
+               "Back the heap with transparent huge pages if possible")   \
   FLAG_BOOLEAN(release, verbose, false, "Verbose output")                 \
   FLAG_BOOLEAN(debug, print_flags, false, "Print flags")                  \
   FLAG_INTEGER(release, profile_interval, 1000, "Profile interval in us") \
@@ -56,6 +66,28 @@ namespace dartino {
                "Collect execution time sampels of the entire VM")         \
   FLAG_CSTRING(release, tick_file, "dartino.ticks",                       \
                "Write tick samples in this file")                         \
+  FLAG_BOOLEAN(release, heap_census_signal, false,                        \
+               "Take a heap census when the VM receives SIGUSR2")         \
+  FLAG_CSTRING(release, heap_census_file, "dartino.census",               \
+               "Prefix of the heap census files taken on signal")         \
+  FLAG_INTEGER(release, allocation_sample_interval, 0,                    \
+               "Sample an allocation every this many bytes (0 = off)")    \
+  FLAG_CSTRING(release, allocation_profile_file, "dartino.allocations",   \
+               "Write allocation samples in this file")                   \
+  FLAG_BOOLEAN(release, jit, false,                                       \
+               "Compile hot functions to machine code (x64 only)")        \
+  FLAG_INTEGER(release, jit_threshold, 1000,                              \
+               "Calls of a function before the JIT compiles it")          \
+  FLAG_BOOLEAN(release, print_inline_cache_statistics, false,             \
+               "Print the hit rate of the inline caches of a program")    \
+  FLAG_BOOLEAN(release, superinstructions, true,                          \
+               "Fuse common bytecode pairs when folding the program")     \
+  FLAG_BOOLEAN(release, quickening, true,                                 \
+               "Rewrite bytecodes to specialized forms in place")         \
+  FLAG_CSTRING(release, bytecode_pair_file, NULL,                         \
+               "Count dispatched bytecode pairs and write them here")     \
+  FLAG_CSTRING(release, bytecode_profile_file, NULL,                      \
+               "Count bytecodes, calls and taken branches; write here")   \
   /* Temporary compiler flags */                                          \
   FLAG_BOOLEAN(release, trace_compiler, false, "")                        \
   FLAG_BOOLEAN(release, trace_library, false, "")
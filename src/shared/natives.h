@@ -138,6 +138,7 @@ namespace dartino {
                                                                                \
   N(CoroutineCurrent, "Coroutine", "_coroutineCurrent", true)                  \
   N(CoroutineNewStack, "Coroutine", "_coroutineNewStack", true)                \
+  N(CoroutineReleaseStack, "Coroutine", "_coroutineReleaseStack", true)        \
                                                                                \
   N(StopwatchFrequency, "Stopwatch", "_frequency", true)                       \
   N(StopwatchNow, "Stopwatch", "_now", true)                                   \
@@ -189,6 +190,7 @@ namespace dartino {
                                                                                \
   N(ForeignRegisterFinalizer, "Foreign", "_registerFinalizer", true)           \
   N(ForeignRemoveFinalizer, "Foreign", "_removeFinalizer", true)               \
+  N(ForeignWaitForFinalizers, "Foreign", "waitForFinalizers", true)            \
                                                                                \
   N(AllocateFunctionPointer, "ForeignCallback", "_allocateFunctionPointer",    \
     true)                                                                      \
@@ -228,6 +230,7 @@ namespace dartino {
   N(ForeignFree, "ForeignMemory", "_free", true)                               \
                                                                                \
   N(StringLength, "_StringBase", "length", true)                               \
+  N(StringHashCode, "_StringBase", "hashCode", true)                           \
                                                                                \
   N(OneByteStringAdd, "_OneByteString", "+", true)                             \
   N(OneByteStringCodeUnitAt, "_OneByteString", "codeUnitAt", true)             \
@@ -118,6 +118,17 @@ void SetLastError(int value);
 // TODO(ager): Make this configurable through the embedding API?
 int MaxStackSizeInWords();
 
+// Maps [size] bytes of the file [name], from [offset] on, into memory, at
+// [address] if that range is free. [offset] must be page aligned. The mapping
+// is private and copy-on-write, so the pages that are not written stay shared
+// with other mappings of the file. Returns NULL on failure, if the file has
+// less than [size] bytes from [offset] on, and on platforms without
+// memory-mapped files.
+void* MapFile(const char* name, uword offset, uword size, void* address);
+void UnmapFile(void* address, uword size);
+// Makes the pages of a mapped file read-only.
+void ProtectMappedFile(void* address, uword size);
+
 inline OperatingSystem OS() {
 #if defined(__ANDROID__)
   return kAndroid;
@@ -150,9 +161,16 @@ inline Architecture Arch() {
 static const int kPageBits = 12;  // 4k pages are universal at this point.
 static const int kPageSize = 1 << kPageBits;
 
+// The size of the large pages used with -Xhuge-pages.
+static const uword kHugePageSize = 2 * MB;
+
 static const int kAnyArena = -1;
 void* AllocatePages(uword size, int arenas);
 void FreePages(void* address, uword size);
+// Tells the OS that the contents of the pages are no longer needed. The pages
+// stay allocated, but the OS may reclaim the physical memory behind them
+// until they are written again. Their contents are undefined afterwards.
+void DiscardPages(void* address, uword size);
 void VirtualMemoryInit();
 
 struct HeapMemoryRange {
@@ -185,12 +203,17 @@ class VirtualMemory {
   // Returns the size of the reserved memory.
   uword size() const { return size_; }
 
-  // Commits real memory. Returns whether the operation succeeded.
-  bool Commit(void* address, uword size);
+  // Commits real memory, which the CPU may execute code from if
+  // [executable] is true. Returns whether the operation succeeded.
+  bool Commit(void* address, uword size, bool executable = false);
 
   // Uncommit real memory.  Returns whether the operation succeeded.
   bool Uncommit(void* address, uword size);
 
+  // Lets the OS reclaim committed memory without uncommitting it.  Returns
+  // whether the operation succeeded.
+  bool Discard(void* address, uword size);
+
  private:
   void* address_;   // Start address of the virtual memory.
   const uword size_;  // Size of the virtual memory.
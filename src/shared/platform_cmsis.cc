@@ -156,6 +156,15 @@ void Platform::SetLastError(int value) { }
 
 int Platform::MaxStackSizeInWords() { return 16 * KB; }
 
+void* Platform::MapFile(const char* name, uword offset, uword size,
+                        void* address) {
+  return NULL;
+}
+
+void Platform::UnmapFile(void* address, uword size) {}
+
+void Platform::ProtectMappedFile(void* address, uword size) {}
+
 VirtualMemory::VirtualMemory(uword size) : size_(size) {}
 
 VirtualMemory::~VirtualMemory() {}
@@ -170,6 +179,8 @@ void Platform::FreePages(void* address, uword size) {
   page_free(address, size >> PAGE_SIZE_SHIFT);
 }
 
+void Platform::DiscardPages(void* address, uword size) {}
+
 int Platform::GetHeapMemoryRanges(HeapMemoryRange* ranges_return, int ranges) {
   const int kRanges = 4;
   memory_range_t ranges_get[kRanges];
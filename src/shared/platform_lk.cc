@@ -192,6 +192,15 @@ char* Platform::GetEnv(const char* name) { return NULL; }
 
 int Platform::MaxStackSizeInWords() { return 16 * KB; }
 
+void* Platform::MapFile(const char* name, uword offset, uword size,
+                        void* address) {
+  return NULL;
+}
+
+void Platform::UnmapFile(void* address, uword size) {}
+
+void Platform::ProtectMappedFile(void* address, uword size) {}
+
 void* Platform::AllocatePages(uword size, int arenas) {
   size = Utils::RoundUp(size, PAGE_SIZE);
   void* memory = page_alloc(size >> PAGE_SIZE_SHIFT, arenas);
@@ -202,6 +211,8 @@ void Platform::FreePages(void* address, uword size) {
   page_free(address, size >> PAGE_SIZE_SHIFT);
 }
 
+void Platform::DiscardPages(void* address, uword size) {}
+
 int Platform::GetHeapMemoryRanges(HeapMemoryRange* ranges,
                                   int number_of_ranges) {
   const int kRanges = 4;
@@ -14,6 +14,7 @@
 #include <semaphore.h>
 #include <sys/types.h>  // mmap & munmap
 #include <sys/mman.h>   // mmap & munmap
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
 #include <signal.h>
@@ -242,6 +243,30 @@ int Platform::FormatString(char* buffer, size_t length, const char* format,
 
 int Platform::MaxStackSizeInWords() { return 128 * KB; }
 
+void* Platform::MapFile(const char* name, uword offset, uword size,
+                        void* address) {
+  int fd = open(name, O_RDONLY);
+  if (fd < 0) return NULL;
+  // Touching a mapped page past the end of the file raises SIGBUS, so only
+  // map what the file has.
+  struct stat info;
+  if (fstat(fd, &info) != 0 || offset > static_cast<uword>(info.st_size) ||
+      size > static_cast<uword>(info.st_size) - offset) {
+    close(fd);
+    return NULL;
+  }
+  void* result = mmap(address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                      offset);
+  close(fd);
+  return (result == MAP_FAILED) ? NULL : result;
+}
+
+void Platform::UnmapFile(void* address, uword size) { munmap(address, size); }
+
+void Platform::ProtectMappedFile(void* address, uword size) {
+  mprotect(address, size, PROT_READ);
+}
+
 int Platform::GetLastError() { return errno; }
 void Platform::SetLastError(int value) { errno = value; }
 
@@ -290,7 +315,12 @@ static void* RandomizedVirtualAlloc(size_t size) {
 
   // Try to randomize the allocation address.
   for (size_t attempts = 0; base == MAP_FAILED && attempts < 3; ++attempts) {
-    base = mmap(GetRandomMmapAddr(), size, PROT_NONE,
+    uword hint = reinterpret_cast<uword>(GetRandomMmapAddr());
+    // Huge pages can only be used for aligned parts of the heap.
+    if (Flags::huge_pages) {
+      hint = Utils::RoundDown(hint, Platform::kHugePageSize);
+    }
+    base = mmap(reinterpret_cast<void*>(hint), size, PROT_NONE,
                 kMmapFlags | MAP_NORESERVE, kMmapFd, kMmapFdOffset);
   }
 
@@ -314,17 +344,37 @@ VirtualMemory::~VirtualMemory() {
 
 bool VirtualMemory::IsReserved() const { return address_ != MAP_FAILED; }
 
-bool VirtualMemory::Commit(void* address, uword size) {
-  int prot = PROT_READ | PROT_WRITE;
-  return mmap(address, size, prot, kMmapFlags | MAP_FIXED, kMmapFd,
-              kMmapFdOffset) != MAP_FAILED;
+bool VirtualMemory::Commit(void* address, uword size, bool executable) {
+  int prot = PROT_READ | PROT_WRITE | (executable ? PROT_EXEC : 0);
+  if (mmap(address, size, prot, kMmapFlags | MAP_FIXED, kMmapFd,
+           kMmapFdOffset) == MAP_FAILED) {
+    return false;
+  }
+#if defined(MADV_HUGEPAGE)
+  // Only a hint, the memory is usable whether or not it succeeds.
+  if (Flags::huge_pages) madvise(address, size, MADV_HUGEPAGE);
+#endif
+  return true;
 }
 
 bool VirtualMemory::Uncommit(void* address, uword size) {
-  return mmap(address, size, PROT_NONE, kMmapFlags | MAP_NORESERVE, kMmapFd,
+  // Without MAP_FIXED the kernel would put the new mapping somewhere else and
+  // leave the committed pages in place.
+  return mmap(address, size, PROT_NONE,
+              kMmapFlags | MAP_NORESERVE | MAP_FIXED, kMmapFd,
               kMmapFdOffset) != MAP_FAILED;
 }
 
+bool VirtualMemory::Discard(void* address, uword size) {
+#if defined(DARTINO_TARGET_OS_LINUX) || !defined(MADV_FREE)
+  // On Linux MADV_FREE only frees the pages under memory pressure, so the
+  // resident size would not go down.
+  return madvise(address, size, MADV_DONTNEED) == 0;
+#else
+  return madvise(address, size, MADV_FREE) == 0;
+#endif
+}
+
 }  // namespace dartino
 
 #endif  // defined(DARTINO_TARGET_OS_POSIX)
@@ -6,6 +6,7 @@
 
 #if defined(DARTINO_TARGET_OS_WIN) || defined(DARTINO_TARGET_OS_POSIX)
 
+#include "src/shared/flags.h"
 #include "src/shared/globals.h"
 #include "src/shared/platform.h"
 #include "src/shared/utils.h"
@@ -33,8 +34,15 @@ class Arena {
     uword pages = size >> kPageBits;
     if (pages == 0 || pages > pages_) return 0;
 
+    // Whole huge pages are only any use if they are aligned.
+    uword alignment = 1;
+    if (Flags::huge_pages && size % kHugePageSize == 0) {
+      alignment = kHugePageSize >> kPageBits;
+    }
+
     lock_->Lock();
-    for (size_t i = 0; i <= pages_ - pages; i++) {
+    for (size_t i = Align(0, alignment); i <= pages_ - pages;
+         i = Align(i + 1, alignment)) {
       if (map_[i + pages - 1] != 0) {
         // This is just an optimization to skip large blocks of allocated pages
         // faster.
@@ -83,6 +91,16 @@ class Arena {
     vm_->Uncommit(reinterpret_cast<void*>(address), size);
   }
 
+  // Returns the first page index from [index] whose address is aligned to
+  // [alignment] pages.
+  size_t Align(size_t index, uword alignment) {
+    if (alignment == 1) return index;
+    uword base = reinterpret_cast<uword>(vm_->address());
+    uword address = base + (index << kPageBits);
+    address = Utils::RoundUp(address, alignment << kPageBits);
+    return (address - base) >> kPageBits;
+  }
+
   void GetMemoryRange(void** start, uword* size) {
     *start = vm_->address();
     *size = vm_->size();
@@ -117,6 +135,12 @@ void FreePages(void* address, uword size) {
   arena->Free(reinterpret_cast<uword>(address), size);
 }
 
+void DiscardPages(void* address, uword size) {
+  ASSERT(Utils::IsAligned(reinterpret_cast<uword>(address), kPageSize));
+  ASSERT(size == Utils::RoundUp(size, kPageSize));
+  vm->Discard(address, size);
+}
+
 int GetHeapMemoryRanges(HeapMemoryRange* ranges, int number_of_ranges) {
   arena->GetMemoryRange(&ranges[0].address, &ranges[0].size);
   return 1;
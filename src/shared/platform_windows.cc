@@ -251,6 +251,16 @@ int Platform::FormatString(char* buffer, size_t length, const char* format,
 
 int Platform::MaxStackSizeInWords() { return 128 * KB; }
 
+// Files are not mapped on Windows yet, so program images cannot be loaded.
+void* Platform::MapFile(const char* name, uword offset, uword size,
+                        void* address) {
+  return NULL;
+}
+
+void Platform::UnmapFile(void* address, uword size) {}
+
+void Platform::ProtectMappedFile(void* address, uword size) {}
+
 int Platform::GetLastError() { return ::GetLastError(); }
 void Platform::SetLastError(int value) { ::SetLastError(value); }
 
@@ -311,8 +321,9 @@ VirtualMemory::~VirtualMemory() { VirtualFree(address_, size_, MEM_RELEASE); }
 
 bool VirtualMemory::IsReserved() const { return address_ == NULL; }
 
-bool VirtualMemory::Commit(void* address, uword size) {
-  if (NULL == VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE)) {
+bool VirtualMemory::Commit(void* address, uword size, bool executable) {
+  DWORD protect = executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+  if (NULL == VirtualAlloc(address, size, MEM_COMMIT, protect)) {
     return false;
   }
   return true;
@@ -322,6 +333,10 @@ bool VirtualMemory::Uncommit(void* address, uword size) {
   return VirtualFree(address, size, MEM_DECOMMIT) != 0;
 }
 
+bool VirtualMemory::Discard(void* address, uword size) {
+  return VirtualAlloc(address, size, MEM_RESET, PAGE_READWRITE) != NULL;
+}
+
 }  // namespace dartino
 
 #endif  // defined(DARTINO_TARGET_OS_WIN)
@@ -99,6 +99,7 @@
       ],
       'sources': [
         'assert_test.cc',
+        'bytecodes_test.cc',
         'flags_test.cc',
         'globals_test.cc',
         'random_test.cc',
@@ -35,6 +35,22 @@ extern "C" void InterpreterEntry() {
   FATAL("InterpreterEntry not implemented.");
 }
 
+extern "C" void InterpreterJitMethodEntry() {
+  FATAL("InterpreterJitMethodEntry not implemented.");
+}
+
+extern "C" void InterpreterInvokeMethodReturn() {
+  FATAL("InterpreterInvokeMethodReturn not implemented.");
+}
+
+extern "C" void InterpreterInvokeStaticReturn() {
+  FATAL("InterpreterInvokeStaticReturn not implemented.");
+}
+
+extern "C" void InterpreterLoadStaticInitReturn() {
+  FATAL("InterpreterLoadStaticInitReturn not implemented.");
+}
+
 void SetBytecodeBreak(Opcode opcode) {
   FATAL("SetBytecodeBreak not implemented.");
 }
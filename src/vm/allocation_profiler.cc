@@ -0,0 +1,213 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/allocation_profiler.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "src/vm/frame.h"
+#include "src/vm/object.h"
+#include "src/vm/process.h"
+#include "src/vm/profile_header.h"
+#include "src/vm/program.h"
+
+namespace dartino {
+
+AllocationSampler::AllocationSampler()
+    : profiler_(NULL),
+      interval_(0),
+      countdown_(kNeverSample),
+      state_(kCounting),
+      object_(NULL),
+      depth_(0) {
+  static_assert(kCountdownOffset == offsetof(AllocationSampler, countdown_),
+                "countdown_");
+}
+
+void AllocationSampler::Enable(AllocationProfiler* profiler, word interval) {
+  ASSERT(interval > 0);
+  profiler_ = profiler;
+  interval_ = interval;
+  countdown_ = interval;
+}
+
+bool AllocationSampler::StartSample(bool can_fail) {
+  if (state_ == kAllocated) {
+    // The class of the previously sampled object has been set by now.
+    FinishSample();
+    if (countdown_ >= 0) return false;
+  }
+  if (profiler_ == NULL) {
+    countdown_ = kNeverSample;
+    return false;
+  }
+  switch (state_) {
+    case kCounting:
+      if (can_fail) {
+        state_ = kWaitingForStack;
+        return true;
+      }
+      depth_ = 0;
+      state_ = kStackRecorded;
+      return false;
+    case kWaitingForStack:
+      // The failure was handled by something other than the interpreter, so
+      // the stack is unknown.
+      depth_ = 0;
+      state_ = kStackRecorded;
+      return false;
+    case kStackRecorded:
+      // The retried allocation failed for real.
+      return false;
+    case kAllocated:
+      break;
+  }
+  UNREACHABLE();
+  return false;
+}
+
+void AllocationSampler::RecordStack(Process* process) {
+  ASSERT(state_ == kWaitingForStack);
+  Program* program = process->program();
+  Frame frame(process->stack());
+  depth_ = 0;
+  while (depth_ < kMaxFrames && frame.MovePrevious()) {
+    uint8* bcp = frame.ByteCodePointer();
+    if (bcp == NULL) continue;
+    // Bytecode offsets only mean something for a program from a snapshot,
+    // but the depth of the stack is kept in any case.
+    frames_[depth_++] = program->was_loaded_from_snapshot()
+        ? program->ComputeBcpOffset(reinterpret_cast<uword>(bcp))
+        : 0;
+  }
+  state_ = kStackRecorded;
+}
+
+void AllocationSampler::Allocated(HeapObject* object) {
+  ASSERT(state_ == kStackRecorded);
+  object_ = object;
+  state_ = kAllocated;
+  // The countdown stays below zero, so the next allocation goes through
+  // StartSample and finishes this sample.
+}
+
+void AllocationSampler::FinishSample() {
+  if (state_ != kAllocated) return;
+  profiler_->Record(object_->get_class(), object_->Size(), frames_, depth_);
+  object_ = NULL;
+  state_ = kCounting;
+  countdown_ += interval_;
+}
+
+AllocationProfiler::AllocationProfiler(Program* program)
+    : program_(program), mutex_(Platform::CreateMutex()), samples_(0) {}
+
+AllocationProfiler::~AllocationProfiler() { delete mutex_; }
+
+static uword HashStack(const int* frames, int depth) {
+  uword hash = depth;
+  for (int i = 0; i < depth; i++) {
+    hash = hash * 31 + static_cast<uword>(frames[i]);
+  }
+  return hash;
+}
+
+void AllocationProfiler::Record(Class* klass, uword size, const int* frames,
+                                int depth) {
+  uword hash = HashStack(frames, depth);
+  ScopedLock locker(mutex_);
+  samples_++;
+  int previous = -1;
+  auto it = stack_entries_.Find(hash);
+  if (it != stack_entries_.End()) {
+    for (int i = it->second; i != -1; i = entries_[i].next) {
+      Entry& entry = entries_[i];
+      if (entry.klass == klass && SameStack(entry, frames, depth)) {
+        entry.samples++;
+        entry.bytes += size;
+        return;
+      }
+      previous = i;
+    }
+  }
+  Entry entry = {klass, 1, size, depth, static_cast<int>(frames_.size()), -1};
+  for (int i = 0; i < depth; i++) frames_.PushBack(frames[i]);
+  int index = entries_.size();
+  entries_.PushBack(entry);
+  if (previous == -1) {
+    stack_entries_[hash] = index;
+  } else {
+    entries_[previous].next = index;
+  }
+}
+
+bool AllocationProfiler::SameStack(const Entry& entry, const int* frames,
+                                   int depth) {
+  if (entry.depth != depth) return false;
+  for (int i = 0; i < depth; i++) {
+    if (frames_[entry.first_frame + i] != frames[i]) return false;
+  }
+  return true;
+}
+
+uword AllocationProfiler::samples() {
+  ScopedLock locker(mutex_);
+  return samples_;
+}
+
+uword AllocationProfiler::SamplesOf(Class* klass) {
+  ScopedLock locker(mutex_);
+  uword samples = 0;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].klass == klass) samples += entries_[i].samples;
+  }
+  return samples;
+}
+
+void AllocationProfiler::VisitProgramPointers(PointerVisitor* visitor) {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    visitor->Visit(reinterpret_cast<Object**>(&entries_[i].klass));
+  }
+}
+
+bool AllocationProfiler::WriteToFile(const char* path, word interval) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) return false;
+  bool from_snapshot = program_->was_loaded_from_snapshot();
+  ScopedLock locker(mutex_);
+  WriteProfileHeader(file, "Allocation samples",
+                     from_snapshot ? program_->snapshot_hash() : 0);
+  fprintf(file, "interval=%lu\n", static_cast<unsigned long>(interval));
+  fprintf(file, "samples=%lu\n", static_cast<unsigned long>(samples_));
+  fprintf(file, "# samples,bytes,class,frames\n");
+  HashMap<Class*, int> class_numbers;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    const Entry& entry = entries_[i];
+    fprintf(file, "%lu,%lu,", static_cast<unsigned long>(entry.samples),
+            static_cast<unsigned long>(entry.bytes));
+    if (from_snapshot) {
+      fprintf(file, "0x%lx,", static_cast<unsigned long>(
+          program_->OffsetOf(HeapObject::cast(entry.klass))));
+    } else {
+      // Without a snapshot there is no .info.json file to name the class.
+      auto it = class_numbers.Find(entry.klass);
+      int number = class_numbers.size();
+      if (it == class_numbers.End()) {
+        class_numbers[entry.klass] = number;
+      } else {
+        number = it->second;
+      }
+      fprintf(file, "?%d,", number);
+    }
+    for (int j = 0; j < entry.depth; j++) {
+      fprintf(file, "%s0x%x", j == 0 ? "" : ";",
+              frames_[entry.first_frame + j]);
+    }
+    fprintf(file, "\n");
+  }
+  return fclose(file) == 0;
+}
+
+}  // namespace dartino
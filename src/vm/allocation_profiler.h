@@ -0,0 +1,146 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// The allocation profiler samples the allocations in the heaps of a program.
+// Each time another --allocation_sample_interval bytes have been allocated in
+// a heap, the class and size of the object being allocated and the Dart
+// stack of the allocating process are recorded. Samples are aggregated by
+// class and stack, and written in a text format that decode_allocations.dart
+// turns into folded stacks.
+//
+// The stack of a process can only be walked when the interpreter has saved
+// its state, so a sampled allocation first fails with a retry-after-GC
+// failure. HandleGC records the stack instead of collecting garbage and the
+// interpreter retries the allocation, which then succeeds.
+
+#ifndef SRC_VM_ALLOCATION_PROFILER_H_
+#define SRC_VM_ALLOCATION_PROFILER_H_
+
+#include "src/shared/globals.h"
+#include "src/shared/platform.h"
+#include "src/vm/hash_map.h"
+#include "src/vm/vector.h"
+
+namespace dartino {
+
+class AllocationProfiler;
+class Class;
+class HeapObject;
+class PointerVisitor;
+class Process;
+class Program;
+
+// The sampling state of a single heap. It is only used by the thread that
+// allocates in the heap.
+class AllocationSampler {
+ public:
+  static const int kMaxFrames = 32;
+
+  enum State {
+    // Counting down to the next sample.
+    kCounting,
+    // The sampled allocation failed and waits for the stack to be recorded.
+    kWaitingForStack,
+    // The stack is recorded and the allocation is being retried.
+    kStackRecorded,
+    // The object is allocated, but its class may not be set yet.
+    kAllocated
+  };
+
+  AllocationSampler();
+
+  void Enable(AllocationProfiler* profiler, word interval);
+  bool is_enabled() const { return profiler_ != NULL; }
+  AllocationProfiler* profiler() const { return profiler_; }
+  word interval() const { return interval_; }
+
+  State state() const { return state_; }
+
+  // Counts [size] allocated bytes. Returns true if the allocation must go
+  // through Heap::SampleAllocation.
+  bool Countdown(uword size) {
+    countdown_ -= static_cast<word>(size);
+    return countdown_ < 0;
+  }
+
+  // Allocations that fail are retried, so they are not counted.
+  void Uncount(uword size) { countdown_ += static_cast<word>(size); }
+
+  // Called when the countdown has passed zero. Returns true if the stack of
+  // the allocating process should be recorded before allocating.
+  bool StartSample(bool can_fail);
+
+  // Records the stack of [process], which must have saved its state.
+  void RecordStack(Process* process);
+
+  void Allocated(HeapObject* object);
+
+  // Adds the allocated object to the profile. Must be called before the
+  // object can move.
+  void FinishSample();
+
+  // The interpreters count down inline when they allocate numbers.
+  static const uword kCountdownOffset = 2 * kWordSize;
+
+ private:
+  // Far enough from overflow to count and uncount without checking.
+  static const word kNeverSample = static_cast<word>(~static_cast<uword>(0) >>
+                                                     2);
+
+  AllocationProfiler* profiler_;
+  word interval_;
+  word countdown_;
+  State state_;
+  HeapObject* object_;
+  int depth_;
+  int frames_[kMaxFrames];
+};
+
+// The samples of all the heaps of a program.
+class AllocationProfiler {
+ public:
+  struct Entry {
+    Class* klass;
+    uword samples;
+    uword bytes;
+    int depth;
+    // The frames of the stack are [frames_[first_frame], ...,
+    // frames_[first_frame + depth - 1]], innermost first.
+    int first_frame;
+    // The next entry with the same stack hash, or -1.
+    int next;
+  };
+
+  explicit AllocationProfiler(Program* program);
+  ~AllocationProfiler();
+
+  // Private heaps record samples concurrently, so this takes a lock.
+  void Record(Class* klass, uword size, const int* frames, int depth);
+
+  uword samples();
+  uword SamplesOf(Class* klass);
+
+  // Classes move when the program heap is collected.
+  void VisitProgramPointers(PointerVisitor* visitor);
+
+  // Writes the samples in the text format read by decode_allocations.dart.
+  // Stack frames are bytecode offsets in the program heap, and classes are
+  // program heap offsets. Returns false if the file could not be written.
+  bool WriteToFile(const char* path, word interval);
+
+ private:
+  bool SameStack(const Entry& entry, const int* frames, int depth);
+
+  Program* program_;
+  Mutex* mutex_;
+  uword samples_;
+  Vector<Entry> entries_;
+  Vector<int> frames_;
+  // Maps the hash of a stack to the first entry with that hash.
+  HashMap<uword, int> stack_entries_;
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_ALLOCATION_PROFILER_H_
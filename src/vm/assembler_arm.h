@@ -260,6 +260,7 @@ class Assembler {
     const Immediate&);
   INSTRUCTION_2(ldrb, "ldrb %r, %a", Register, const Address&);
   INSTRUCTION_3(ldrb, "ldrb %r, %a%W", Register, const Address&, WriteBack);
+  INSTRUCTION_2(ldrh, "ldrh %r, %a", Register, const Address&);
 
   INSTRUCTION_3(lsl, "lsl %r, %r, %i", Register, Register, const Immediate&);
   INSTRUCTION_3(lsl, "lsl %r, %r, %r", Register, Register, Register);
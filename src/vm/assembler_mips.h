@@ -179,6 +179,7 @@ class Assembler {
 
   INSTRUCTION_2(lb, "lb %r, %a", Register, const Address&);
   INSTRUCTION_2(lbu, "lbu %r, %a", Register, const Address&);
+  INSTRUCTION_2(lhu, "lhu %r, %a", Register, const Address&);
   INSTRUCTION_2(lw, "lw %r, %a", Register, const Address&);
   INSTRUCTION_2(lw, "lw %r, %s", Register, const char*);
 
@@ -169,7 +169,7 @@ class Operand {
   uint8 rex_;
   uint8 encoding_[6];
 
-  explicit Operand(Register reg) { SetModRM(3, reg); }
+  explicit Operand(Register reg) : length_(0), rex_(0) { SetModRM(3, reg); }
 
   // Get the operand encoding byte at the given index.
   uint8 EncodingAt(int index) const {
@@ -178,12 +178,14 @@ class Operand {
   }
 
   friend class Assembler;
+  friend class JitAssembler;
 };
 
 class Address : public Operand {
  public:
   explicit Address(Register base, int32 disp = 0) {
-    if (disp == 0 && base != RBP) {
+    // Like RBP, R13 can only be a base register with a displacement.
+    if (disp == 0 && (base & 7) != RBP) {
       SetModRM(0, base);
       if (base == RSP) SetSIB(TIMES_1, RSP, base);
     } else if (Utils::IsInt8(disp)) {
@@ -206,7 +208,7 @@ class Address : public Operand {
 
   Address(Register base, Register index, ScaleFactor scale, int32 disp = 0) {
     ASSERT(index != RSP);  // Illegal addressing mode.
-    if (disp == 0 && base != RBP) {
+    if (disp == 0 && (base & 7) != RBP) {
       SetModRM(0, RSP);
       SetSIB(scale, index, base);
     } else if (Utils::IsInt8(disp)) {
@@ -286,10 +288,18 @@ class Assembler {
     Register, Register, const Immediate&);
   INSTRUCTION_3(movsd, "movsd %rq, %m(%rq)",
     Register, const Immediate&, Register);
+  INSTRUCTION_2(movsd, "movsd %a, %rq", Register, const Address&);
+  INSTRUCTION_2(movsd, "movsd %rq, %a", const Address&, Register);
+
+  INSTRUCTION_2(addsd, "addsd %rq, %rq", Register, Register);
+  INSTRUCTION_2(subsd, "subsd %rq, %rq", Register, Register);
+  INSTRUCTION_2(mulsd, "mulsd %rq, %rq", Register, Register);
+  INSTRUCTION_2(ucomisd, "ucomisd %rq, %rq", Register, Register);
 
   INSTRUCTION_2(movb, "movb %b, %a", const Address&, const Immediate&);
 
   INSTRUCTION_2(movzbq, "movzbq %a, %rq", Register, const Address&);
+  INSTRUCTION_2(movzwq, "movzwq %a, %rq", Register, const Address&);
 
   INSTRUCTION_2(cmove, "cmove %rq, %rq", Register, Register);
 
@@ -253,6 +253,7 @@ class Assembler {
 
   INSTRUCTION_2(leal, "leal %a, %rl", Register, const Address&);
   INSTRUCTION_2(movzbl, "movzbl %a, %rl", Register, const Address&);
+  INSTRUCTION_2(movzwl, "movzwl %a, %rl", Register, const Address&);
 
   INSTRUCTION_2(cmpl, "cmpl %i, %rl", Register, const Immediate&);
   INSTRUCTION_2(cmpl, "cmpl %i, %a", const Address&, const Immediate&);
@@ -0,0 +1,251 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/bytecode_profiler.h"
+
+#include <stdio.h>
+
+#include "src/shared/flags.h"
+#include "src/shared/platform.h"
+#include "src/shared/utils.h"
+#include "src/vm/process.h"
+#include "src/vm/profile_header.h"
+#include "src/vm/program.h"
+#include "src/vm/vector.h"
+
+namespace dartino {
+
+BytecodeProfiler* BytecodeProfiler::profiler_ = NULL;
+
+void BytecodeProfiler::Setup() {
+  ASSERT(profiler_ == NULL);
+  if (Flags::bytecode_pair_file == NULL &&
+      Flags::bytecode_profile_file == NULL) {
+    return;
+  }
+  profiler_ = new BytecodeProfiler();
+}
+
+void BytecodeProfiler::TearDown() {
+  if (profiler_ == NULL) return;
+  const char* pair_file = Flags::bytecode_pair_file;
+  if (pair_file != NULL && !profiler_->WriteToFile(pair_file)) {
+    Print::Error("Failed to write bytecode pairs to %s\n", pair_file);
+  }
+  const char* profile_file = Flags::bytecode_profile_file;
+  if (profile_file != NULL && !profiler_->WriteProfileToFile(profile_file)) {
+    Print::Error("Failed to write bytecode profile to %s\n", profile_file);
+  }
+  delete profiler_;
+  profiler_ = NULL;
+}
+
+BytecodeProfiler::BytecodeProfiler()
+    : dispatches_(0),
+      mutex_(Platform::CreateMutex()),
+      has_hashtag_(false),
+      hashtag_(0),
+      unattributed_(0) {
+  for (int i = 0; i < kNumOpcodes * kNumOpcodes; i++) pairs_[i] = 0;
+}
+
+BytecodeProfiler::~BytecodeProfiler() { delete mutex_; }
+
+static bool IsCall(Opcode opcode) {
+  return Bytecode::IsInvokeVariant(opcode) || opcode == kInvokeSelector ||
+         opcode == kInvokeNoSuchMethod;
+}
+
+// Returns whether the branch [opcode] is taken, given the stack at [sp].
+static bool IsTaken(Program* program, Opcode opcode, Object** sp) {
+  switch (opcode) {
+    case kBranchIfTrueWide:
+    case kBranchBackIfTrue:
+    case kBranchBackIfTrueWide:
+      return sp[0] == program->true_object();
+    case kBranchIfFalseWide:
+    case kBranchBackIfFalse:
+    case kBranchBackIfFalseWide:
+      return sp[0] != program->true_object();
+    default:
+      return true;
+  }
+}
+
+void BytecodeProfiler::Count(Process* process, uint8* bcp, Object** sp) {
+  CountPair(bcp);
+
+  // A call is counted at the first bytecode of the function it calls, when
+  // the process does not continue after the invoke it ran last. Calls to
+  // intrinsics run no bytecodes, and are not counted.
+  uint8* previous = process->profiled_bcp();
+  process->set_profiled_bcp(bcp);
+  Program* program = process->program();
+  if (!program->was_loaded_from_snapshot() || !program->is_optimized()) {
+    return;
+  }
+  int hashtag = program->snapshot_hash();
+  uword offset = program->ComputeBcpOffset(reinterpret_cast<uword>(bcp));
+  if (previous != NULL) {
+    Opcode opcode = Bytecode::Unfuse(static_cast<Opcode>(*previous));
+    if (IsCall(opcode) && bcp != previous + Bytecode::Size(opcode)) {
+      CountCall(hashtag, offset);
+    }
+  }
+
+  Opcode opcode = Bytecode::Unfuse(static_cast<Opcode>(*bcp));
+  if (opcode >= kBranchWide && opcode <= kPopAndBranchBackWide) {
+    CountBranch(hashtag, offset, IsTaken(program, opcode, sp));
+  }
+}
+
+void BytecodeProfiler::CountPair(uint8* bcp) {
+  Opcode first = Bytecode::Unfuse(static_cast<Opcode>(*bcp));
+  Opcode second =
+      Bytecode::Unfuse(static_cast<Opcode>(bcp[Bytecode::Size(first)]));
+  dispatches_.fetch_add(1, kRelaxed);
+  pairs_[first * kNumOpcodes + second].fetch_add(1, kRelaxed);
+}
+
+bool BytecodeProfiler::Attribute(int hashtag) {
+  if (!has_hashtag_) {
+    has_hashtag_ = true;
+    hashtag_ = hashtag;
+  }
+  if (hashtag == hashtag_) return true;
+  unattributed_++;
+  return false;
+}
+
+void BytecodeProfiler::CountCall(int hashtag, uword offset) {
+  ScopedLock locker(mutex_);
+  if (!Attribute(hashtag)) return;
+  auto it = calls_.Find(offset);
+  if (it == calls_.End()) {
+    calls_[offset] = 1;
+  } else {
+    it->second++;
+  }
+}
+
+void BytecodeProfiler::CountBranch(int hashtag, uword offset, bool taken) {
+  ScopedLock locker(mutex_);
+  if (!Attribute(hashtag)) return;
+  auto it = branches_.Find(offset);
+  if (it == branches_.End()) {
+    branches_[offset] = {1, taken ? 1u : 0u};
+  } else {
+    it->second.executed++;
+    if (taken) it->second.taken++;
+  }
+}
+
+uint64 BytecodeProfiler::PairCount(Opcode first, Opcode second) const {
+  first = Bytecode::Unfuse(first);
+  second = Bytecode::Unfuse(second);
+  return pairs_[first * kNumOpcodes + second].load(kRelaxed);
+}
+
+uint64 BytecodeProfiler::BytecodeCount(Opcode opcode) const {
+  opcode = Bytecode::Unfuse(opcode);
+  uint64 count = 0;
+  for (int i = 0; i < kNumOpcodes; i++) {
+    count += pairs_[opcode * kNumOpcodes + i].load(kRelaxed);
+  }
+  return count;
+}
+
+struct PairEntry {
+  uint64 count;
+  int pair;
+};
+
+static bool MoreFrequent(const PairEntry& a, const PairEntry& b) {
+  if (a.count != b.count) return a.count > b.count;
+  return a.pair < b.pair;
+}
+
+bool BytecodeProfiler::WriteToFile(const char* path) const {
+  Vector<PairEntry> counts;
+  for (int i = 0; i < kNumOpcodes * kNumOpcodes; i++) {
+    uint64 count = pairs_[i].load(kRelaxed);
+    if (count != 0) counts.PushBack({count, i});
+  }
+  counts.Sort(MoreFrequent);
+
+  FILE* file = fopen(path, "w");
+  if (file == NULL) return false;
+  fprintf(file, "# Bytecode pairs dispatched by the Dartino VM.\n");
+  fprintf(file, "dispatches=%llu\n",
+          static_cast<unsigned long long>(dispatches_.load(kRelaxed)));
+  fprintf(file, "# count,first,second\n");
+  for (size_t i = 0; i < counts.size(); i++) {
+    Opcode first = static_cast<Opcode>(counts[i].pair / kNumOpcodes);
+    Opcode second = static_cast<Opcode>(counts[i].pair % kNumOpcodes);
+    fprintf(file, "%llu,%s,%s\n",
+            static_cast<unsigned long long>(counts[i].count),
+            Bytecode::Name(first), Bytecode::Name(second));
+  }
+  return fclose(file) == 0;
+}
+
+struct ProfileEntry {
+  uint64 count;
+  uint64 executed;
+  uword key;
+};
+
+static bool MoreCounted(const ProfileEntry& a, const ProfileEntry& b) {
+  if (a.count != b.count) return a.count > b.count;
+  return a.key < b.key;
+}
+
+bool BytecodeProfiler::WriteProfileToFile(const char* path) {
+  Vector<ProfileEntry> bytecodes;
+  for (int i = 0; i < kNumOpcodes; i++) {
+    uint64 count = BytecodeCount(static_cast<Opcode>(i));
+    if (count != 0) bytecodes.PushBack({count, 0, static_cast<uword>(i)});
+  }
+  bytecodes.Sort(MoreCounted);
+
+  ScopedLock locker(mutex_);
+  Vector<ProfileEntry> calls;
+  for (auto& pair : calls_) calls.PushBack({pair.second, 0, pair.first});
+  calls.Sort(MoreCounted);
+  Vector<ProfileEntry> branches;
+  for (auto& pair : branches_) {
+    branches.PushBack({pair.second.taken, pair.second.executed, pair.first});
+  }
+  branches.Sort(MoreCounted);
+
+  FILE* file = fopen(path, "w");
+  if (file == NULL) return false;
+  WriteProfileHeader(file, "Bytecode profile", hashtag_);
+  fprintf(file, "dispatches=%llu\n",
+          static_cast<unsigned long long>(dispatches_.load(kRelaxed)));
+  fprintf(file, "unattributed=%llu\n",
+          static_cast<unsigned long long>(unattributed_));
+  fprintf(file, "# bytecode,count,name\n");
+  for (size_t i = 0; i < bytecodes.size(); i++) {
+    fprintf(file, "bytecode,%llu,%s\n",
+            static_cast<unsigned long long>(bytecodes[i].count),
+            Bytecode::Name(static_cast<Opcode>(bytecodes[i].key)));
+  }
+  fprintf(file, "# call,count,function\n");
+  for (size_t i = 0; i < calls.size(); i++) {
+    fprintf(file, "call,%llu,0x%lx\n",
+            static_cast<unsigned long long>(calls[i].count),
+            static_cast<unsigned long>(calls[i].key));
+  }
+  fprintf(file, "# branch,taken,executed,bcp\n");
+  for (size_t i = 0; i < branches.size(); i++) {
+    fprintf(file, "branch,%llu,%llu,0x%lx\n",
+            static_cast<unsigned long long>(branches[i].count),
+            static_cast<unsigned long long>(branches[i].executed),
+            static_cast<unsigned long>(branches[i].key));
+  }
+  return fclose(file) == 0;
+}
+
+}  // namespace dartino
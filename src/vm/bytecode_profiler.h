@@ -0,0 +1,94 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// The bytecode profiler counts the bytecodes the interpreters dispatch. It
+// counts in the debug prologues of the bytecodes (see
+// GenerateBytecodePrologue), so it only counts in builds with
+// DARTINO_ENABLE_DEBUGGING. While it runs, programs are not fused and
+// functions are not compiled.
+//
+// With --bytecode_pair_file it writes how often each pair of bytecodes is
+// dispatched in a row, to find candidates for superinstructions (see
+// SUPERINSTRUCTIONS_DO in bytecodes.h).
+//
+// With --bytecode_profile_file it writes how often each bytecode was
+// dispatched, how often each function was called, and how often each branch
+// was taken. Functions and branches are written as bytecode offsets in the
+// program heap, like the samples of the tick sampler, so they are only
+// counted for a program from a snapshot. decode_bytecode_profile.dart in
+// pkg/dartino_compiler names them with the .info.json file of the snapshot.
+
+#ifndef SRC_VM_BYTECODE_PROFILER_H_
+#define SRC_VM_BYTECODE_PROFILER_H_
+
+#include "src/shared/atomic.h"
+#include "src/shared/bytecodes.h"
+#include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
+
+namespace dartino {
+
+class Mutex;
+class Object;
+class Process;
+
+class BytecodeProfiler {
+ public:
+  static void Setup();
+  static void TearDown();
+  static BytecodeProfiler* GlobalInstance() { return profiler_; }
+
+  BytecodeProfiler();
+  ~BytecodeProfiler();
+
+  // Counts the bytecode at [bcp] that [process] is about to run. [sp] points
+  // at the top of its stack.
+  void Count(Process* process, uint8* bcp, Object** sp);
+
+  // Counts the bytecode at [bcp] and the bytecode after it.
+  void CountPair(uint8* bcp);
+
+  // Counts a call of the function whose bytecodes start at [offset], and a
+  // branch at [offset] in the program of the snapshot with [hashtag].
+  void CountCall(int hashtag, uword offset);
+  void CountBranch(int hashtag, uword offset, bool taken);
+
+  uint64 PairCount(Opcode first, Opcode second) const;
+  uint64 BytecodeCount(Opcode opcode) const;
+
+  // Write the pairs that were dispatched and the profile, most frequent
+  // first. Return false if the file could not be written.
+  bool WriteToFile(const char* path) const;
+  bool WriteProfileToFile(const char* path);
+
+ private:
+  static const int kNumOpcodes = kMethodEnd + 1;
+
+  struct BranchCount {
+    uint64 executed;
+    uint64 taken;
+  };
+
+  static BytecodeProfiler* profiler_;
+
+  Atomic<uint64> dispatches_;
+  Atomic<uint64> pairs_[kNumOpcodes * kNumOpcodes];
+
+  // Protects the fields below.
+  Mutex* mutex_;
+  // The snapshot the calls and branches are counted for, once there is one.
+  // Calls and branches in other programs are only counted in unattributed_.
+  bool has_hashtag_;
+  int hashtag_;
+  uint64 unattributed_;
+  HashMap<uword, uint64> calls_;
+  HashMap<uword, BranchCount> branches_;
+
+  // Returns false if calls and branches of [hashtag] are not attributed.
+  bool Attribute(int hashtag);
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_BYTECODE_PROFILER_H_
@@ -0,0 +1,63 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+#include "src/vm/bytecode_profiler.h"
+
+namespace dartino {
+
+// Returns whether the file at [path] has a line that is [expected].
+static bool HasLine(const char* path, const char* expected) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return false;
+  char line[128];
+  bool found = false;
+  while (!found && fgets(line, sizeof(line), file) != NULL) {
+    line[strcspn(line, "\n")] = '\0';
+    found = strcmp(line, expected) == 0;
+  }
+  fclose(file);
+  return found;
+}
+
+TEST_CASE(BytecodeProfilerProfile) {
+  BytecodeProfiler profiler;
+  uint8 bytecodes[] = {kLoadLocal0, kPop, kLoadLocal0, kReturn};
+  profiler.CountPair(&bytecodes[0]);
+  profiler.CountPair(&bytecodes[1]);
+  profiler.CountPair(&bytecodes[2]);
+  EXPECT_EQ(2, static_cast<int>(profiler.BytecodeCount(kLoadLocal0)));
+  EXPECT_EQ(1, static_cast<int>(profiler.PairCount(kLoadLocal0, kPop)));
+
+  // Calls and branches are attributed to the first snapshot they are
+  // counted for.
+  profiler.CountCall(42, 0x100);
+  profiler.CountCall(42, 0x100);
+  profiler.CountCall(42, 0x200);
+  profiler.CountCall(7, 0x100);
+  profiler.CountBranch(42, 0x104, true);
+  profiler.CountBranch(42, 0x104, false);
+  profiler.CountBranch(42, 0x104, true);
+
+  char path[] = "/tmp/bytecode_profile_XXXXXX";
+  int fd = mkstemp(path);
+  EXPECT(fd >= 0);
+  close(fd);
+  EXPECT(profiler.WriteProfileToFile(path));
+  EXPECT(HasLine(path, "hashtag=42"));
+  EXPECT(HasLine(path, "dispatches=3"));
+  EXPECT(HasLine(path, "unattributed=1"));
+  EXPECT(HasLine(path, "bytecode,2,LoadLocal0"));
+  EXPECT(HasLine(path, "call,2,0x100"));
+  EXPECT(HasLine(path, "call,1,0x200"));
+  EXPECT(HasLine(path, "branch,2,3,0x104"));
+  unlink(path);
+}
+
+}  // namespace dartino
@@ -0,0 +1,95 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/catch_table.h"
+
+#include "src/shared/assert.h"
+#include "src/shared/utils.h"
+#include "src/vm/object.h"
+
+namespace dartino {
+
+// The table is not aligned, so the blocks are read and written a field at a
+// time.
+static const int kBlockSize = 3 * sizeof(int32);
+
+int CatchTable::Count(uint8* table) { return Utils::ReadInt32(table); }
+
+CatchTable::Block CatchTable::At(uint8* table, int index) {
+  uint8* address = table + sizeof(int32) + index * kBlockSize;
+  Block block;
+  block.start = Utils::ReadInt32(address);
+  block.end = Utils::ReadInt32(address + sizeof(int32));
+  block.frame_size = Utils::ReadInt32(address + 2 * sizeof(int32));
+  return block;
+}
+
+void CatchTable::AtPut(uint8* table, int index, const Block& block) {
+  uint8* address = table + sizeof(int32) + index * kBlockSize;
+  Utils::WriteInt32(address, block.start);
+  Utils::WriteInt32(address + sizeof(int32), block.end);
+  Utils::WriteInt32(address + 2 * sizeof(int32), block.frame_size);
+}
+
+void CatchTable::Sort(uint8* table) {
+  // Tables are short, so an insertion sort does.
+  int count = Count(table);
+  for (int i = 1; i < count; i++) {
+    Block block = At(table, i);
+    int j = i - 1;
+    for (; j >= 0; j--) {
+      Block other = At(table, j);
+      if (other.start < block.start ||
+          (other.start == block.start && other.end >= block.end)) {
+        break;
+      }
+      AtPut(table, j + 1, other);
+    }
+    AtPut(table, j + 1, block);
+  }
+}
+
+bool CatchTable::Find(uint8* table, int offset, Block* block) {
+  // Find the last block that starts at or before [offset].
+  int low = 0;
+  int high = Count(table);
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    if (Utils::ReadInt32(table + sizeof(int32) + middle * kBlockSize) <=
+        offset) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  // The blocks before it either contain [offset] or end at or before it.
+  // The innermost one that contains it is the one that starts last.
+  for (int i = low - 1; i >= 0; i--) {
+    Block candidate = At(table, i);
+    if (candidate.end > offset) {
+      *block = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+Function* CatchTableCache::Lookup(uint8* bcp, int* table_offset) {
+  Entry* entry = &entries_[reinterpret_cast<uword>(bcp) & (kSize - 1)];
+  if (entry->bcp != bcp) {
+    entry->function = Function::FromBytecodePointer(bcp, &entry->table_offset);
+    entry->bcp = bcp;
+  }
+  *table_offset = entry->table_offset;
+  return entry->function;
+}
+
+void CatchTableCache::Clear() {
+  for (int i = 0; i < kSize; i++) {
+    entries_[i].bcp = NULL;
+  }
+}
+
+}  // namespace dartino
@@ -0,0 +1,74 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_CATCH_TABLE_H_
+#define SRC_VM_CATCH_TABLE_H_
+
+#include "src/shared/globals.h"
+
+namespace dartino {
+
+class Function;
+
+// The catch table of a function follows its MethodEnd bytecode, if the
+// operand of MethodEnd says it has one. It holds a count, and that many
+// blocks of bytecodes that catch exceptions. The handler of a block starts
+// at its end. Blocks are disjoint or nested, and the compiler emits the
+// innermost ones first. When the VM creates a function it sorts the blocks
+// by their start, so a throw finds the innermost block around a bytecode
+// with a binary search.
+class CatchTable {
+ public:
+  struct Block {
+    int32 start;
+    int32 end;
+    // The number of stack slots of the frame when the handler runs.
+    int32 frame_size;
+  };
+
+  // Sorts the blocks of the table at [table] by start, and nested blocks
+  // that start at the same bytecode outermost first.
+  static void Sort(uint8* table);
+
+  // Finds the innermost block of the table at [table] that contains the
+  // bytecode at [offset], and copies it to [block]. Returns false if there
+  // is none.
+  static bool Find(uint8* table, int offset, Block* block);
+
+ private:
+  static int Count(uint8* table);
+  static Block At(uint8* table, int index);
+  static void AtPut(uint8* table, int index, const Block& block);
+};
+
+// Maps the bytecode pointers of frames to their functions and catch tables,
+// so throwing through a frame again does not need to walk the bytecodes of
+// its function to find them. It also remembers the functions that have no
+// catch table, which throws skip. Each process has its own cache, which is
+// cleared when the program GC moves the functions.
+class CatchTableCache {
+ public:
+  static const int kSize = 64;
+
+  CatchTableCache() { Clear(); }
+
+  // Returns the function of the bytecode at [bcp], and sets [table_offset]
+  // to the offset of its catch table, or -1 if it has none.
+  Function* Lookup(uint8* bcp, int* table_offset);
+
+  void Clear();
+
+ private:
+  struct Entry {
+    uint8* bcp;
+    Function* function;
+    int table_offset;
+  };
+
+  Entry entries_[kSize];
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_CATCH_TABLE_H_
@@ -0,0 +1,56 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+#include "src/shared/utils.h"
+#include "src/vm/catch_table.h"
+
+namespace dartino {
+
+static void WriteTable(uint8* table, const int32* blocks, int count) {
+  Utils::WriteInt32(table, count);
+  for (int i = 0; i < 3 * count; i++) {
+    Utils::WriteInt32(table + (i + 1) * sizeof(int32), blocks[i]);
+  }
+}
+
+static int HandlerAt(uint8* table, int offset) {
+  CatchTable::Block block;
+  if (!CatchTable::Find(table, offset, &block)) return -1;
+  return block.end;
+}
+
+TEST_CASE(CatchTableFind) {
+  // A try in a try, the catch block of the outer try, a try that starts
+  // with the outer one, and a try after them, not sorted.
+  const int32 blocks[] = {
+      20, 30, 2,
+      10, 50, 1,
+      50, 60, 1,
+      10, 15, 3,
+      70, 80, 1,
+  };
+  // Leave the table unaligned, like the ones after the bytecodes.
+  uint8 table[1 + 4 + sizeof(blocks)];
+  WriteTable(table + 1, blocks, 5);
+  CatchTable::Sort(table + 1);
+
+  EXPECT_EQ(-1, HandlerAt(table + 1, 5));
+  EXPECT_EQ(15, HandlerAt(table + 1, 10));
+  EXPECT_EQ(15, HandlerAt(table + 1, 14));
+  EXPECT_EQ(50, HandlerAt(table + 1, 15));
+  EXPECT_EQ(30, HandlerAt(table + 1, 20));
+  EXPECT_EQ(50, HandlerAt(table + 1, 30));
+  EXPECT_EQ(60, HandlerAt(table + 1, 50));
+  EXPECT_EQ(-1, HandlerAt(table + 1, 65));
+  EXPECT_EQ(80, HandlerAt(table + 1, 79));
+  EXPECT_EQ(-1, HandlerAt(table + 1, 80));
+
+  CatchTable::Block block;
+  EXPECT(CatchTable::Find(table + 1, 25, &block));
+  EXPECT_EQ(2, block.frame_size);
+}
+
+}  // namespace dartino
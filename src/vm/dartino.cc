@@ -6,8 +6,12 @@
 
 #include "src/shared/platform.h"
 
+#include "src/vm/bytecode_profiler.h"
 #include "src/vm/event_handler.h"
 #include "src/vm/ffi.h"
+#include "src/vm/finalizer_queue.h"
+#include "src/vm/heap_census.h"
+#include "src/vm/jit.h"
 #include "src/vm/object_memory.h"
 #include "src/vm/object.h"
 #include "src/vm/preempter.h"
@@ -29,14 +33,22 @@ void Dartino::Setup() {
   StaticClassStructures::Setup();
   ForeignFunctionInterface::Setup();
   EventHandler::Setup();
+  FinalizerQueue::Setup();
   Scheduler::Setup();
   Preempter::Setup();
+  HeapCensus::Setup();
+  Jit::Setup();
+  BytecodeProfiler::Setup();
 }
 
 void Dartino::TearDown() {
+  BytecodeProfiler::TearDown();
+  Jit::TearDown();
+  HeapCensus::TearDown();
   Preempter::TearDown();
   Thread::TearDown();
   Scheduler::TearDown();
+  FinalizerQueue::TearDown();
   EventHandler::TearDown();
   ForeignFunctionInterface::TearDown();
   StaticClassStructures::TearDown();
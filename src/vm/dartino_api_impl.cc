@@ -16,7 +16,7 @@
 #include "src/vm/ffi.h"
 #include "src/vm/program.h"
 #include "src/vm/program_folder.h"
-#include "src/vm/program_info_block.h"
+#include "src/vm/program_image.h"
 #include "src/vm/scheduler.h"
 #include "src/vm/session.h"
 #include "src/vm/snapshot.h"
@@ -159,22 +159,12 @@ void DartinoRunMultipleMain(int count,
 
 DartinoProgram DartinoLoadProgramFromFlash(void* heap, size_t size) {
   dartino::Program* program =
-      new dartino::Program(dartino::Program::kLoadedFromSnapshot);
-  uword address = reinterpret_cast<uword>(heap);
-  // The info block is appended at the end of the image.
-  size_t heap_size = size - sizeof(dartino::ProgramInfoBlock);
-  uword block_address = address + heap_size;
-  dartino::ProgramInfoBlock* program_info =
-      reinterpret_cast<dartino::ProgramInfoBlock*>(block_address);
-  if (!dartino::ProgramInfoBlock::MightBeProgramInfoBlock(program_info)) {
-    return NULL;
-  }
-  program_info->WriteToProgram(program);
-  dartino::Chunk* memory = dartino::ObjectMemory::CreateFlashChunk(
-      program->heap()->space(), heap, heap_size);
+      dartino::ProgramImage::ProgramFromRelocatedHeap(heap, size);
+  return reinterpret_cast<DartinoProgram>(program);
+}
 
-  program->heap()->space()->Append(memory);
-  program->heap()->space()->SetReadOnly();
+DartinoProgram DartinoLoadProgramImage(const char* path) {
+  dartino::Program* program = dartino::ProgramImage::Load(path);
   return reinterpret_cast<DartinoProgram>(program);
 }
 
@@ -209,6 +199,23 @@ void DartinoDeleteProgram(DartinoProgram raw_program) {
   delete program;
 }
 
+void DartinoGetGCStatistics(DartinoProgram raw_program,
+                            DartinoGCStatistics* statistics) {
+  dartino::Program* program = reinterpret_cast<dartino::Program*>(raw_program);
+  program->gc_statistics()->Get(statistics);
+}
+
+void DartinoRequestHeapCensus(DartinoProgram raw_program, const char* path) {
+  dartino::Program* program = reinterpret_cast<dartino::Program*>(raw_program);
+  program->RequestHeapCensus(path);
+}
+
+bool DartinoWriteAllocationProfile(DartinoProgram raw_program,
+                                   const char* path) {
+  dartino::Program* program = reinterpret_cast<dartino::Program*>(raw_program);
+  return program->WriteAllocationProfile(path);
+}
+
 bool DartinoAddDefaultSharedLibrary(const char* library) {
   return dartino::ForeignFunctionInterface::AddDefaultSharedLibrary(library);
 }
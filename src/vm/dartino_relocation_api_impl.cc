@@ -24,3 +24,10 @@ int DartinoRelocateProgram(DartinoProgram program, void* target,
       dartino_program, reinterpret_cast<uint8*>(target), base);
   return relocator.Relocate();
 }
+
+bool DartinoWriteProgramImage(DartinoProgram program, const char* path) {
+  dartino::Program* dartino_program =
+      reinterpret_cast<dartino::Program*>(program);
+  if (!dartino_program->is_optimized()) return false;
+  return dartino::ProgramImageWriter::Write(dartino_program, path);
+}
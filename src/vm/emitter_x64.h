@@ -0,0 +1,587 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_EMITTER_X64_H_
+#define SRC_VM_EMITTER_X64_H_
+
+#if defined(DARTINO_TARGET_X64)
+
+#include "src/shared/globals.h"
+
+#include "src/vm/assembler.h"
+#include "src/vm/gc_metadata.h"
+#include "src/vm/jit.h"
+#include "src/vm/object.h"
+#include "src/vm/process.h"
+#include "src/vm/program.h"
+
+namespace dartino {
+
+// The code templates shared by the x64 interpreter generator and the JIT.
+// The interpreter generator emits assembly text with an Assembler and the
+// JIT emits machine code with a JitAssembler; their instructions have the
+// same names and operands, so the templates are written once against
+// either. [Generator] is the class that derives from the EmitterX64 and
+// provides assembler(), and [LabelType] is the label of its assembler.
+// Jump targets that are not local to a template are passed as [Target],
+// which is a handler name or a label pointer.
+//
+// Both run with the frame and registers of the interpreter: RSP is the Dart
+// stack, R8 the C stack with the process in its spill area, and RBP the
+// frame pointer.
+template <typename Generator, typename LabelType>
+class EmitterX64 {
+ protected:
+  void LoadLocal(Register reg, int index);
+  void StoreLocal(Register reg, int index);
+  void StoreLocal(const Immediate& value, int index);
+
+  void Push(Register reg);
+  void Pop(Register reg);
+  void Drop(int n);
+  void Drop(Register reg);
+
+  void LoadProcess(Register reg);
+  void LoadProgram(Register reg);
+  void LoadStaticsArray(Register reg);
+  void LoadLiteralNull(Register reg);
+  void LoadLiteralTrue(Register reg);
+  void LoadLiteralFalse(Register reg);
+
+  void SwitchToDartStack();
+  void SwitchToCStack();
+
+  void Return(bool is_return_null);
+
+  // Jumps to [gc] if [reg] holds the failure that asks for a GC and a retry
+  // of the bytecode. Overwrites R11.
+  template <typename Target>
+  void JumpIfRetryAfterGC(Register reg, Target gc);
+
+  // This function overwrites the 'object' and 'scratch' registers!
+  void AddToRememberedSet(Register object, Register value, Register scratch);
+
+  // Sets RDX to 1 if the object of the class in RBX that is allocated from
+  // the fields on the stack is immutable, and to 0 otherwise. It is only
+  // immutable if [immutable] is set and all its fields are.
+  // Overwrites RAX, R10 and R11.
+  void ComputeImmutability(bool immutable);
+
+  // Pops the fields into the new instance in RAX of the class in RBX, and
+  // pushes the instance. Overwrites RBX, R10 and R11.
+  void PopFieldsIntoInstance();
+
+  // Jumps to [initialized] unless [value] is an initializer. Overwrites RBX.
+  void JumpIfNotInitializer(Register value, LabelType* initialized);
+
+  // Jumps to [numbers] if RAX and RBX are both doubles or both large
+  // integers, which are identical by value rather than by reference.
+  // Overwrites RCX and RDX.
+  void JumpIfIdenticalByValue(LabelType* numbers);
+
+  // Jumps to [fallback] unless [left] and [right] are both doubles, and
+  // loads their values into XMM0 and XMM1. Overwrites RCX.
+  template <typename Target>
+  void LoadDoubleValues(Register left, Register right, Target fallback);
+
+  // Jumps to [true_case] if the double in XMM0 compares to the double in
+  // XMM1 by [condition], and to [false_case] otherwise. The comparison is
+  // unordered if either is NaN, which sets the parity, zero and carry flags
+  // and makes every comparison false.
+  void CompareDoubles(Condition condition, LabelType* true_case,
+                      LabelType* false_case);
+
+  // Allocates an object of [size] bytes by bumping the top of the new-space
+  // of the process' heap, and sets its class to the root at [class_offset]
+  // in the program. Leaves the object in RDX. Jumps to [fallback] when the
+  // new-space is exhausted or the allocation is due to be sampled.
+  // Overwrites RBX, RCX, RSI and RDI.
+  template <typename Target>
+  void AllocateNumber(int size, int class_offset, Target fallback);
+
+  // Replace the two arguments of an arithmetic bytecode with a new large
+  // integer holding RAX or a new double holding XMM0.
+  template <typename Target>
+  void ReplaceOperandsWithLargeInteger(Target fallback);
+  template <typename Target>
+  void ReplaceOperandsWithDouble(Target fallback);
+
+  // The smi cases of the bitwise builtins. They replace the operands with
+  // the result, and jump to [fallback] if an operand is not a smi or the
+  // result is not a smi.
+  template <typename Target>
+  void SmiBitNot(Target fallback);
+  template <typename Target>
+  void SmiBitShr(Target fallback);
+  template <typename Target>
+  void SmiBitShl(Target fallback);
+
+ private:
+  Generator* generator() { return static_cast<Generator*>(this); }
+};
+
+#define __ generator()->assembler()->
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadLocal(Register reg, int index) {
+  __ movq(reg, Address(RSP, index * kWordSize));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::StoreLocal(Register reg, int index) {
+  __ movq(Address(RSP, index * kWordSize), reg);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::StoreLocal(const Immediate& value,
+                                                  int index) {
+  __ movq(Address(RSP, index * kWordSize), value);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::Push(Register reg) {
+  __ pushq(reg);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::Pop(Register reg) {
+  __ popq(reg);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::Drop(int n) {
+  if (n != 0) __ addq(RSP, Immediate(n * kWordSize));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::Drop(Register reg) {
+  __ leaq(RSP, Address(RSP, reg, TIMES_WORD_SIZE));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadProcess(Register reg) {
+  __ movq(reg, Address(R8, Jit::kInterpreterSpillSize + kWordSize));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadProgram(Register reg) {
+  LoadProcess(reg);
+  __ movq(reg, Address(reg, Process::kProgramOffset));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadStaticsArray(Register reg) {
+  LoadProcess(reg);
+  __ movq(reg, Address(reg, Process::kStaticsOffset));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadLiteralNull(Register reg) {
+  LoadProgram(reg);
+  __ movq(reg, Address(reg, Program::kNullObjectOffset));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadLiteralTrue(Register reg) {
+  LoadProgram(reg);
+  __ movq(reg, Address(reg, Program::kTrueObjectOffset));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::LoadLiteralFalse(Register reg) {
+  LoadProgram(reg);
+  __ movq(reg, Address(reg, Program::kFalseObjectOffset));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::SwitchToDartStack() {
+  __ movq(R8, RSP);
+  __ movq(RSP, Address(R8, Jit::kInterpreterSpillSize));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::SwitchToCStack() {
+  __ movq(Address(R8, Jit::kInterpreterSpillSize), RSP);
+  __ movq(RSP, R8);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::Return(bool is_return_null) {
+  // Materialize the result in register RAX.
+  if (is_return_null) {
+    LoadLiteralNull(RAX);
+  } else {
+    LoadLocal(RAX, 0);
+  }
+  __ movq(RSP, RBP);
+  __ popq(RBP);
+  __ ret();
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::JumpIfRetryAfterGC(Register reg,
+                                                          Target gc) {
+  __ movq(R11, reg);
+  __ andq(R11, Immediate(Failure::kTagMask | Failure::kTypeMask));
+  __ cmpq(R11, Immediate(Failure::kTag));
+  __ j(EQUAL, gc);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::AddToRememberedSet(Register object,
+                                                          Register value,
+                                                          Register scratch) {
+  LabelType smi;
+  __ testq(value, Immediate(Smi::kTagMask));
+  __ j(ZERO, &smi);
+  // TODO(erikcorry): Filter out non-new-space values.
+
+  LoadProcess(scratch);
+  __ shrq(object, Immediate(GCMetadata::kCardSizeLog2));
+  __ addq(object, Address(scratch, Process::kRememberedSetBiasOffset));
+  __ movb(Address(object), Immediate(GCMetadata::kNewSpacePointers));
+
+  __ Bind(&smi);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::ComputeImmutability(bool immutable) {
+  // Initialization of 'allocate immutable' argument depends on [immutable].
+  __ movq(RDX, Immediate(immutable ? 1 : 0));
+  if (!immutable) return;
+
+  // Loop over all arguments and find out if all of them are immutable (then we
+  // can set the immutable bit in this object too).
+  __ movq(R11, Address(RBX, Class::kInstanceFormatOffset - HeapObject::kTag));
+  __ andq(R11, Immediate(InstanceFormat::FixedSizeField::mask()));
+  int size_shift = InstanceFormat::FixedSizeField::shift() - kPointerSizeLog2;
+  __ shrq(R11, Immediate(size_shift));
+
+  // R11 = SizeOfEntireObject - Instance::kSize
+  __ subq(R11, Immediate(Instance::kSize));
+
+  // R10 = StackPointer(RSP) + NumberOfFields*kPointerSize
+  __ movq(R10, RSP);
+  __ addq(R10, R11);
+
+  LabelType loop, done;
+  LabelType break_loop_with_mutable_field;
+
+  // Decrement pointer to point to next field.
+  __ Bind(&loop);
+  __ subq(R10, Immediate(kPointerSize));
+
+  // Test whether R10 < RSP. If so we're done and it's immutable.
+  __ cmpq(R10, RSP);
+  __ j(BELOW, &done);
+
+  // If Smi, continue the loop.
+  __ movq(R11, Address(R10));
+  __ testq(R11, Immediate(Smi::kTagMask));
+  __ j(ZERO, &loop);
+
+  // Load class of object we want to test immutability of.
+  __ movq(RAX, Address(R11, HeapObject::kClassOffset - HeapObject::kTag));
+
+  // Load instance format & handle the three cases:
+  //  - never immutable (based on instance format) => not immutable
+  //  - always immutable (based on instance format) => immutable
+  //  - else (only instances) => check runtime-tracked bit
+  uword mask = InstanceFormat::ImmutableField::mask();
+  uword always_immutable_mask = InstanceFormat::ImmutableField::encode(
+      InstanceFormat::ALWAYS_IMMUTABLE);
+  uword never_immutable_mask =
+      InstanceFormat::ImmutableField::encode(InstanceFormat::NEVER_IMMUTABLE);
+
+  __ movq(RAX, Address(RAX, Class::kInstanceFormatOffset - HeapObject::kTag));
+  __ andq(RAX, Immediate(mask));
+
+  // If this is type never immutable we break the loop.
+  __ cmpq(RAX, Immediate(never_immutable_mask));
+  __ j(EQUAL, &break_loop_with_mutable_field);
+
+  // If this is type is always immutable we continue the loop.
+  __ cmpq(RAX, Immediate(always_immutable_mask));
+  __ j(EQUAL, &loop);
+
+  // Else, we must have an Instance and check the runtime-tracked
+  // immutable bit.
+  uword im_mask = Instance::FlagsImmutabilityField::encode(true);
+  __ movq(R11, Address(R11, Instance::kFlagsOffset - HeapObject::kTag));
+  __ testq(R11, Immediate(im_mask));
+  __ j(NOT_ZERO, &loop);
+
+  __ Bind(&break_loop_with_mutable_field);
+  __ movl(RDX, Immediate(0));
+
+  __ Bind(&done);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::PopFieldsIntoInstance() {
+  __ movq(R11, Address(RBX, Class::kInstanceFormatOffset - HeapObject::kTag));
+  __ andq(R11, Immediate(InstanceFormat::FixedSizeField::mask()));
+  // The fixed size is recorded as the number of pointers. Therefore, the
+  // size in bytes is the recorded size multiplied by kPointerSize. Instead
+  // of doing the multiplication we shift by kPointerSizeLog2 less.
+  ASSERT(InstanceFormat::FixedSizeField::shift() >= kPointerSizeLog2);
+  int size_shift = InstanceFormat::FixedSizeField::shift() - kPointerSizeLog2;
+  __ shrq(R11, Immediate(size_shift));
+
+  // Compute the address of the first and last instance field.
+  __ leaq(R10, Address(RAX, R11, TIMES_1, -1 * kWordSize - HeapObject::kTag));
+  __ leaq(R11, Address(RAX, Instance::kSize - HeapObject::kTag));
+
+  LabelType loop, done;
+  __ Bind(&loop);
+  __ cmpq(R10, R11);
+  __ j(BELOW, &done);
+  Pop(RBX);
+  // No write barrier, because newly allocated instances are always
+  // in new-space, or are already entered into the remembered set.
+  __ movq(Address(R10, 0), RBX);
+  __ subq(R10, Immediate(1 * kWordSize));
+  __ jmp(&loop);
+
+  __ Bind(&done);
+  Push(RAX);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::JumpIfNotInitializer(
+    Register value, LabelType* initialized) {
+  ASSERT(Smi::kTag == 0);
+  __ testq(value, Immediate(Smi::kTagMask));
+  __ j(ZERO, initialized);
+  __ movq(RBX, Address(value, HeapObject::kClassOffset - HeapObject::kTag));
+  __ movq(RBX, Address(RBX, Class::kInstanceFormatOffset - HeapObject::kTag));
+
+  int type = InstanceFormat::INITIALIZER_TYPE;
+  __ andq(RBX, Immediate(InstanceFormat::TypeField::mask()));
+  __ cmpq(RBX, Immediate(type << InstanceFormat::TypeField::shift()));
+  __ j(NOT_EQUAL, initialized);
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::JumpIfIdenticalByValue(
+    LabelType* numbers) {
+  LabelType done;
+
+  // If either is a smi they are not both doubles or large integers.
+  __ testq(RAX, Immediate(Smi::kTagMask));
+  __ j(ZERO, &done);
+  __ testq(RBX, Immediate(Smi::kTagMask));
+  __ j(ZERO, &done);
+
+  // If they do not have the same type they are not both double or
+  // large integers.
+  __ movq(RCX, Address(RAX, HeapObject::kClassOffset - HeapObject::kTag));
+  __ movq(RCX, Address(RCX, Class::kInstanceFormatOffset - HeapObject::kTag));
+  __ movq(RDX, Address(RBX, HeapObject::kClassOffset - HeapObject::kTag));
+  __ cmpq(RCX, Address(RDX, Class::kInstanceFormatOffset - HeapObject::kTag));
+  __ j(NOT_EQUAL, &done);
+
+  int double_type = InstanceFormat::DOUBLE_TYPE;
+  int large_integer_type = InstanceFormat::LARGE_INTEGER_TYPE;
+  int type_field_shift = InstanceFormat::TypeField::shift();
+
+  __ andq(RCX, Immediate(InstanceFormat::TypeField::mask()));
+  __ cmpq(RCX, Immediate(double_type << type_field_shift));
+  __ j(EQUAL, numbers);
+  __ cmpq(RCX, Immediate(large_integer_type << type_field_shift));
+  __ j(EQUAL, numbers);
+
+  __ Bind(&done);
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::LoadDoubleValues(Register left,
+                                                        Register right,
+                                                        Target fallback) {
+  ASSERT(Smi::kTag == 0);
+  __ testq(left, Immediate(Smi::kTagMask));
+  __ j(ZERO, fallback);
+  __ testq(right, Immediate(Smi::kTagMask));
+  __ j(ZERO, fallback);
+
+  LoadProgram(RCX);
+  __ movq(RCX, Address(RCX, Program::kDoubleClassOffset));
+  __ cmpq(RCX, Address(left, HeapObject::kClassOffset - HeapObject::kTag));
+  __ j(NOT_EQUAL, fallback);
+  __ cmpq(RCX, Address(right, HeapObject::kClassOffset - HeapObject::kTag));
+  __ j(NOT_EQUAL, fallback);
+
+  int value_offset = Double::kValueOffset - HeapObject::kTag;
+  __ movsd(XMM0, Address(left, value_offset));
+  __ movsd(XMM1, Address(right, value_offset));
+}
+
+template <typename Generator, typename LabelType>
+void EmitterX64<Generator, LabelType>::CompareDoubles(Condition condition,
+                                                      LabelType* true_case,
+                                                      LabelType* false_case) {
+  switch (condition) {
+    case EQUAL:
+      __ ucomisd(XMM0, XMM1);
+      __ j(PARITY_EVEN, false_case);
+      __ j(EQUAL, true_case);
+      break;
+    case GREATER:
+      __ ucomisd(XMM0, XMM1);
+      __ j(ABOVE, true_case);
+      break;
+    case GREATER_EQUAL:
+      __ ucomisd(XMM0, XMM1);
+      __ j(ABOVE_EQUAL, true_case);
+      break;
+    case LESS:
+      __ ucomisd(XMM1, XMM0);
+      __ j(ABOVE, true_case);
+      break;
+    case LESS_EQUAL:
+      __ ucomisd(XMM1, XMM0);
+      __ j(ABOVE_EQUAL, true_case);
+      break;
+    default:
+      UNREACHABLE();
+  }
+  __ jmp(false_case);
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::AllocateNumber(int size,
+                                                      int class_offset,
+                                                      Target fallback) {
+  LoadProcess(RSI);
+  __ movq(RSI, Address(RSI, Process::kHeapOffset));
+
+  // Leave allocations that are due to be sampled to the runtime, which
+  // counts them again.
+  __ movq(RCX, Address(RSI, Heap::kAllocationCountdownOffset));
+  __ subq(RCX, Immediate(size));
+  __ j(LESS, fallback);
+
+  // Like SemiSpace::TryAllocate, keep room for the sentinel at the end of
+  // the chunk.
+  __ movq(RDI, Address(RSI, Heap::kSpaceOffset));
+  __ movq(RDX, Address(RDI, Space::kTopOffset));
+  __ leaq(RBX, Address(RDX, size));
+  __ cmpq(RBX, Address(RDI, Space::kLimitOffset));
+  __ j(ABOVE_EQUAL, fallback);
+
+  __ movq(Address(RSI, Heap::kAllocationCountdownOffset), RCX);
+  __ movq(Address(RDI, Space::kTopOffset), RBX);
+  __ movq(Address(RBX, 0), Immediate(0));
+
+  LoadProgram(RCX);
+  __ movq(RCX, Address(RCX, class_offset));
+  __ movq(Address(RDX, HeapObject::kClassOffset), RCX);
+  __ addq(RDX, Immediate(HeapObject::kTag));
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::ReplaceOperandsWithLargeInteger(
+    Target fallback) {
+  AllocateNumber(LargeInteger::AllocationSize(),
+                 Program::kLargeIntegerClassOffset, fallback);
+  __ movq(Address(RDX, LargeInteger::kValueOffset - HeapObject::kTag), RAX);
+  StoreLocal(RDX, 1);
+  Drop(1);
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::ReplaceOperandsWithDouble(
+    Target fallback) {
+  AllocateNumber(Double::AllocationSize(), Program::kDoubleClassOffset,
+                 fallback);
+  __ movsd(Address(RDX, Double::kValueOffset - HeapObject::kTag), XMM0);
+  StoreLocal(RDX, 1);
+  Drop(1);
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::SmiBitNot(Target fallback) {
+  LoadLocal(RAX, 0);
+  __ testq(RAX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, fallback);
+
+  __ notq(RAX);
+  __ andq(RAX, Immediate(~Smi::kTagMask));
+  StoreLocal(RAX, 0);
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::SmiBitShr(Target fallback) {
+  LoadLocal(RAX, 1);
+  __ testq(RAX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, fallback);
+  LoadLocal(RCX, 0);
+  __ testq(RCX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, fallback);
+
+  // Untag the smis and do the shift.
+  __ sarq(RAX, Immediate(1));
+  __ sarq(RCX, Immediate(1));
+  __ cmpq(RCX, Immediate(64));
+  LabelType shift;
+  __ j(LESS, &shift);
+  __ movq(RCX, Immediate(63));
+  __ Bind(&shift);
+  __ sarq_cl(RAX);
+
+  // Re-tag the resulting smi. No need to check for overflow
+  // here, because the top two bits of eax are either 00 or 11
+  // because we've shifted eax arithmetically at least one
+  // position to the right.
+  ASSERT(Smi::kTagSize == 1 && Smi::kTag == 0);
+  __ addq(RAX, RAX);
+
+  StoreLocal(RAX, 1);
+  Drop(1);
+}
+
+template <typename Generator, typename LabelType>
+template <typename Target>
+void EmitterX64<Generator, LabelType>::SmiBitShl(Target fallback) {
+  LoadLocal(RAX, 1);
+  __ testq(RAX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, fallback);
+  LoadLocal(RCX, 0);
+  __ testq(RCX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, fallback);
+
+  // Untag the shift count, but not the value. If the shift
+  // count is greater than 63 (or negative), the shift is going
+  // to misbehave so we have to guard against that.
+  __ sarq(RCX, Immediate(1));
+  __ cmpq(RCX, Immediate(64));
+  __ j(ABOVE_EQUAL, fallback);
+
+  // Only allow to shift out "sign bits". If we shift
+  // out any other bit, it's an overflow.
+  __ movq(RBX, RAX);
+  __ shlq_cl(RAX);
+  __ movq(RDX, RAX);
+  __ sarq_cl(RDX);
+  __ cmpq(RBX, RDX);
+  __ j(NOT_EQUAL, fallback);
+
+  StoreLocal(RAX, 1);
+  Drop(1);
+}
+
+#undef __
+
+}  // namespace dartino
+
+#endif  // defined(DARTINO_TARGET_X64)
+
+#endif  // SRC_VM_EMITTER_X64_H_
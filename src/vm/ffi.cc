@@ -5,6 +5,7 @@
 #include "src/vm/ffi.h"
 
 #include "src/shared/asan_helper.h"
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/natives.h"
 #include "src/vm/object.h"
 #include "src/vm/port.h"
@@ -58,8 +59,10 @@ BEGIN_NATIVE(ForeignMarkForFinalization) {
   HeapObject* foreign = HeapObject::cast(arguments[0]);
   int size = static_cast<int>(AsForeignWord(arguments[1]));
   process->heap()->AllocatedForeignMemory(size);
+  // The finalizer may run after a private heap is gone, so the memory is
+  // accounted to the shared heap.
   process->RegisterFinalizer(foreign, Process::FinalizeForeign,
-                             process->heap());
+                             process->program()->process_heap());
   return process->program()->null_object();
 }
 END_NATIVE()
@@ -87,6 +90,13 @@ BEGIN_LEAF_NATIVE(ForeignRemoveFinalizer) {
 }
 END_NATIVE()
 
+BEGIN_LEAF_NATIVE(ForeignWaitForFinalizers) {
+  FinalizerQueue* queue = FinalizerQueue::GlobalInstance();
+  if (queue != NULL) queue->WaitUntilIdle();
+  return process->program()->null_object();
+}
+END_NATIVE()
+
 BEGIN_LEAF_NATIVE(ForeignBitsPerWord) { return Smi::FromWord(kBitsPerWord); }
 END_NATIVE()
 
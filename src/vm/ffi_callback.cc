@@ -18,10 +18,10 @@ static Object* AllocateCoroutine(Process* process) {
   Object* raw_stack = process->NewStack(Process::kInitialStackSize);
   // Retry on allocation failure.
   if (raw_stack->IsRetryAfterGCFailure()) {
-    process->program()->CollectNewSpace();
+    process->program()->CollectNewSpace(process);
     raw_stack = process->NewStack(Process::kInitialStackSize);
     if (raw_stack->IsRetryAfterGCFailure()) {
-      process->program()->CollectNewSpace();
+      process->program()->CollectNewSpace(process);
       raw_stack = process->NewStack(Process::kInitialStackSize);
     }
   }
@@ -53,11 +53,11 @@ static Object* AllocateCoroutine(Process* process) {
     raw_coroutine = process->NewInstance(process->program()->coroutine_class());
     // Retry on allocation failure.
     if (raw_coroutine->IsRetryAfterGCFailure()) {
-      process->program()->CollectNewSpace();
+      process->program()->CollectNewSpace(process);
       raw_coroutine =
           process->NewInstance(process->program()->coroutine_class());
       if (raw_coroutine->IsRetryAfterGCFailure()) {
-        process->program()->CollectNewSpace();
+        process->program()->CollectNewSpace(process);
         raw_coroutine =
             process->NewInstance(process->program()->coroutine_class());
       }
@@ -101,10 +101,10 @@ static Object* ConvertFfiArgument(word value, Process* process) {
 
   Object* result = process->NewInteger(value);
   if (result->IsRetryAfterGCFailure()) {
-    process->program()->CollectNewSpace();
+    process->program()->CollectNewSpace(process);
     result = process->NewInteger(value);
     if (result->IsRetryAfterGCFailure()) {
-      process->program()->CollectNewSpace();
+      process->program()->CollectNewSpace(process);
       result = process->NewInteger(value);
     }
   }
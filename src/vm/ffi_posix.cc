@@ -16,6 +16,7 @@
 #include "src/shared/platform.h"
 #include "src/shared/utils.h"
 
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/natives.h"
 #include "src/vm/object.h"
 #include "src/vm/process.h"
@@ -91,13 +92,17 @@ void* ForeignFunctionInterface::LookupInDefaultLibraries(const char* symbol) {
   return NULL;
 }
 
+static void CloseForeignLibrary(void* handle) {
+  if (dlclose(handle) != 0) {
+    Print::Error("Failed to close handle: %s\n", dlerror());
+  }
+}
+
 void FinalizeForeignLibrary(HeapObject* foreign, void*) {
   word address = AsForeignWord(foreign);
   void* handle = reinterpret_cast<void*>(address);
   ASSERT(handle != NULL);
-  if (dlclose(handle) != 0) {
-    Print::Error("Failed to close handle: %s\n", dlerror());
-  }
+  FinalizerQueue::Schedule(CloseForeignLibrary, handle);
 }
 
 BEGIN_LEAF_NATIVE(ForeignLibraryLookup) {
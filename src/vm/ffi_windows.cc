@@ -11,6 +11,7 @@
 #include <Windows.h>
 
 #include "src/shared/platform.h"
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/natives.h"
 #include "src/vm/object.h"
 #include "src/vm/process.h"
@@ -102,13 +103,17 @@ void* ForeignFunctionInterface::LookupInDefaultLibraries(const char* symbol) {
   return NULL;
 }
 
+static void CloseForeignLibrary(void* handle) {
+  if (!FreeLibrary(reinterpret_cast<HMODULE>(handle)) == 0) {
+    Print::Error("Failed to close handle: %d\n", GetLastError());
+  }
+}
+
 void FinalizeForeignLibrary(HeapObject* foreign, void*) {
   word address = AsForeignWord(foreign);
-  HMODULE handle = reinterpret_cast<HMODULE>(address);
+  void* handle = reinterpret_cast<void*>(address);
   ASSERT(handle != NULL);
-  if (!FreeLibrary(handle) == 0) {
-    Print::Error("Failed to close handle: %d\n", GetLastError());
-  }
+  FinalizerQueue::Schedule(CloseForeignLibrary, handle);
 }
 
 BEGIN_LEAF_NATIVE(ForeignLibraryLookup) {
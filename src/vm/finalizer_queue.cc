@@ -0,0 +1,109 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/finalizer_queue.h"
+
+#include "src/shared/platform.h"
+
+namespace dartino {
+
+FinalizerQueue* FinalizerQueue::finalizer_queue_ = NULL;
+
+void FinalizerQueue::Setup() {
+  ASSERT(finalizer_queue_ == NULL);
+  finalizer_queue_ = new FinalizerQueue();
+}
+
+void FinalizerQueue::TearDown() {
+  ASSERT(finalizer_queue_ != NULL);
+  delete finalizer_queue_;
+  finalizer_queue_ = NULL;
+}
+
+void FinalizerQueue::Schedule(Callback callback, void* arg) {
+  if (finalizer_queue_ == NULL) {
+    callback(arg);
+  } else {
+    finalizer_queue_->Enqueue(callback, arg);
+  }
+}
+
+void FinalizerQueue::Dispatch() {
+  if (finalizer_queue_ != NULL) finalizer_queue_->Flush();
+}
+
+FinalizerQueue::FinalizerQueue()
+    : monitor_(Platform::CreateMonitor()),
+      running_(true),
+      busy_(false),
+      started_(false) {}
+
+FinalizerQueue::~FinalizerQueue() {
+  {
+    ScopedMonitorLock locker(monitor_);
+    for (size_t i = 0; i < pending_.size(); i++) ready_.PushBack(pending_[i]);
+    pending_.Clear();
+    running_ = false;
+    monitor_->NotifyAll();
+  }
+  // The thread only stops when it has run all flushed callbacks.
+  if (started_) thread_.Join();
+  RunAll(&ready_);
+  delete monitor_;
+}
+
+void FinalizerQueue::Enqueue(Callback callback, void* arg) {
+  ScopedMonitorLock locker(monitor_);
+  Entry entry = {callback, arg};
+  pending_.PushBack(entry);
+}
+
+void FinalizerQueue::Flush() {
+  ScopedMonitorLock locker(monitor_);
+  if (pending_.IsEmpty()) return;
+  for (size_t i = 0; i < pending_.size(); i++) ready_.PushBack(pending_[i]);
+  pending_.Clear();
+  if (!started_) {
+    started_ = true;
+    thread_ = Thread::Run(RunFinalizerThread, reinterpret_cast<void*>(this));
+  }
+  monitor_->NotifyAll();
+}
+
+void FinalizerQueue::WaitUntilIdle() {
+  Flush();
+  ScopedMonitorLock locker(monitor_);
+  while (!ready_.IsEmpty() || busy_) monitor_->Wait();
+}
+
+void* FinalizerQueue::RunFinalizerThread(void* peer) {
+  reinterpret_cast<FinalizerQueue*>(peer)->Run();
+  return NULL;
+}
+
+void FinalizerQueue::Run() {
+  ScopedMonitorLock locker(monitor_);
+  while (true) {
+    while (ready_.IsEmpty() && running_) monitor_->Wait();
+    if (ready_.IsEmpty()) break;
+    Vector<Entry> batch;
+    batch.Swap(ready_);
+    busy_ = true;
+    monitor_->Unlock();
+    RunAll(&batch);
+    monitor_->Lock();
+    busy_ = false;
+    monitor_->NotifyAll();
+  }
+}
+
+void FinalizerQueue::RunAll(Vector<Entry>* entries) {
+  for (size_t i = 0; i < entries->size(); i++) {
+    Entry& entry = (*entries)[i];
+    entry.callback(entry.arg);
+  }
+  entries->Clear();
+}
+
+}  // namespace dartino
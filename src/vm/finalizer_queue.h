@@ -0,0 +1,77 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_FINALIZER_QUEUE_H_
+#define SRC_VM_FINALIZER_QUEUE_H_
+
+#include "src/shared/globals.h"
+#include "src/vm/thread.h"
+#include "src/vm/vector.h"
+
+namespace dartino {
+
+class Monitor;
+
+// Native finalizers release resources outside of the Dartino heaps, like
+// foreign memory, library handles and whatever external finalizers
+// registered from Dart free. They do not need the dead object, so instead of
+// running them during weak processing the GC queues them, and hands them to
+// a helper thread in one batch when it is done. That keeps their cost out of
+// the GC pause.
+class FinalizerQueue {
+ public:
+  typedef void (*Callback)(void* arg);
+
+  static void Setup();
+  static void TearDown();
+  static FinalizerQueue* GlobalInstance() { return finalizer_queue_; }
+
+  // Queues [callback] on the global queue, or runs it right away if there is
+  // none.
+  static void Schedule(Callback callback, void* arg);
+
+  // Hands the callbacks queued on the global queue to its thread.
+  static void Dispatch();
+
+  FinalizerQueue();
+  // Runs the callbacks that are still queued.
+  ~FinalizerQueue();
+
+  // Called by the GC on the thread that runs it. The callbacks, including
+  // the external finalizers registered from Dart, then run on the helper
+  // thread, not on the thread of the process that registered them.
+  void Enqueue(Callback callback, void* arg);
+
+  // Hands the queued callbacks to the thread, starting it if needed.
+  void Flush();
+
+  // Flushes and waits until the thread has run all callbacks.
+  void WaitUntilIdle();
+
+ private:
+  struct Entry {
+    Callback callback;
+    void* arg;
+  };
+
+  static FinalizerQueue* finalizer_queue_;
+
+  Monitor* monitor_;
+  // Callbacks queued since the last flush.
+  Vector<Entry> pending_;
+  // Callbacks flushed to the thread, but not yet taken by it.
+  Vector<Entry> ready_;
+  bool running_;
+  bool busy_;
+  bool started_;
+  ThreadIdentifier thread_;
+
+  static void* RunFinalizerThread(void* peer);
+  void Run();
+  static void RunAll(Vector<Entry>* entries);
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_FINALIZER_QUEUE_H_
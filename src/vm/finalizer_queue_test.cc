@@ -0,0 +1,31 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+#include "src/vm/finalizer_queue.h"
+
+namespace dartino {
+
+static void Increment(void* arg) { (*reinterpret_cast<int*>(arg))++; }
+
+TEST_CASE(FinalizerQueue) {
+  int count = 0;
+  FinalizerQueue* queue = new FinalizerQueue();
+
+  // Queued callbacks only run once they are flushed.
+  for (int i = 0; i < 1000; i++) queue->Enqueue(Increment, &count);
+  EXPECT_EQ(0, count);
+  queue->WaitUntilIdle();
+  EXPECT_EQ(1000, count);
+
+  // Callbacks that are still queued run when the queue goes away.
+  for (int i = 0; i < 10; i++) queue->Enqueue(Increment, &count);
+  queue->Flush();
+  for (int i = 0; i < 10; i++) queue->Enqueue(Increment, &count);
+  delete queue;
+  EXPECT_EQ(1020, count);
+}
+
+}  // namespace dartino
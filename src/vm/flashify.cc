@@ -191,6 +191,16 @@ class FlashifyVisitor : public HeapObjectVisitor {
       printf("\t.long Intrinsic_ListIndexSet\n");
     } else if (code == &Intrinsic_ListLength) {
       printf("\t.long Intrinsic_ListLength\n");
+    } else if (code == &Intrinsic_StringLength) {
+      printf("\t.long Intrinsic_StringLength\n");
+    } else if (code == &Intrinsic_StringHashCode) {
+      printf("\t.long Intrinsic_StringHashCode\n");
+    } else if (code == &Intrinsic_OneByteStringCodeUnitAt) {
+      printf("\t.long Intrinsic_OneByteStringCodeUnitAt\n");
+    } else if (code == &Intrinsic_OneByteStringEqual) {
+      printf("\t.long Intrinsic_OneByteStringEqual\n");
+    } else if (code == &Intrinsic_TwoByteStringCodeUnitAt) {
+      printf("\t.long Intrinsic_TwoByteStringCodeUnitAt\n");
     } else if (code == &InterpreterMethodEntry) {
       printf("\t.long InterpreterMethodEntry\n");
     } else {
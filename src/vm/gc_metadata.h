@@ -194,27 +194,39 @@ class GCMetadata {
 
     bool HasNextChunk() {
       Space* owner = chunk()->owner();
-      ChunkListIterator new_it = it_;
-      ++new_it;
-      return new_it != owner->ChunkListEnd();
+      return NextCompactionChunk(it_, owner->ChunkListEnd()) !=
+             owner->ChunkListEnd();
     }
 
     Destination NextChunk() {
-      ChunkListIterator new_it = it_;
-      ++new_it;
+      ChunkListIterator new_it =
+          NextCompactionChunk(it_, chunk()->owner()->ChunkListEnd());
       return Destination(new_it, new_it->start(), new_it->usable_end());
     }
 
     Destination NextSweepingChunk() {
-      ChunkListIterator new_it = it_;
-      ++new_it;
+      ChunkListIterator new_it =
+          NextCompactionChunk(it_, chunk()->owner()->ChunkListEnd());
       return Destination(new_it, new_it->start(), new_it->compaction_top());
     }
 
+    // Large-object chunks are never compacted into, so they are skipped
+    // when looking for the next destination chunk.
+    static ChunkListIterator SkipLargeObjectChunks(ChunkListIterator it,
+                                                   ChunkListIterator end) {
+      while (it != end && it->is_large_object()) ++it;
+      return it;
+    }
+
     uword address;
     uword limit;
 
    private:
+    static ChunkListIterator NextCompactionChunk(ChunkListIterator it,
+                                                 ChunkListIterator end) {
+      return SkipLargeObjectChunks(++it, end);
+    }
+
     ChunkListIterator it_;
   };
 
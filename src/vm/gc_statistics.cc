@@ -0,0 +1,132 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/gc_statistics.h"
+
+#include <string.h>
+
+#include "src/shared/utils.h"
+#include "src/vm/heap.h"
+#include "src/vm/mark_sweep.h"
+#include "src/vm/object_memory.h"
+
+namespace dartino {
+
+GCPhaseTimer::GCPhaseTimer()
+    : start_(Platform::GetMicroseconds()), last_(start_), phases_(0) {
+  memset(phase_times_, 0, sizeof(phase_times_));
+}
+
+void GCPhaseTimer::EndPhase(DartinoGCPhase phase) {
+  uint64 now = Platform::GetMicroseconds();
+  phase_times_[phase] += now - last_;
+  phases_ |= 1 << phase;
+  last_ = now;
+}
+
+GCStatistics::GCStatistics() : mutex_(Platform::CreateMutex()) {
+  memset(&statistics_, 0, sizeof(statistics_));
+}
+
+GCStatistics::~GCStatistics() { delete mutex_; }
+
+void GCStatistics::RecordScavenge(const GCPhaseTimer& timer, uword scavenged,
+                                  uword survived, uword promoted,
+                                  TwoSpaceHeap* heap) {
+  uint64 pause = timer.elapsed();
+  ScopedLock locker(mutex_);
+  statistics_.scavenges++;
+  AddPause(&statistics_.scavenge_pauses, pause);
+  RecordPhases(timer);
+  statistics_.bytes_scavenged += scavenged;
+  statistics_.bytes_survived += survived;
+  statistics_.bytes_promoted += promoted;
+  // Private heaps promote into the shared old-space while other processes
+  // may be allocating in it, so only the owner of the old-space samples it.
+  if (!heap->is_private()) RecordHeap(heap);
+}
+
+void GCStatistics::RecordOldSpaceGC(const GCPhaseTimer& timer,
+                                    TwoSpaceHeap* heap) {
+  uint64 pause = timer.elapsed();
+  ScopedLock locker(mutex_);
+  statistics_.old_space_gcs++;
+  AddPause(&statistics_.old_space_pauses, pause);
+  RecordPhases(timer);
+  RecordHeap(heap);
+}
+
+void GCStatistics::RecordStackGrowth(int length, uword copied,
+                                     int collections) {
+  ScopedLock locker(mutex_);
+  statistics_.stack_growths++;
+  statistics_.stack_words_copied += copied;
+  statistics_.stack_growth_gcs += collections;
+  if (static_cast<uint64>(length) > statistics_.largest_stack) {
+    statistics_.largest_stack = length;
+  }
+}
+
+void GCStatistics::Get(DartinoGCStatistics* statistics) {
+  ScopedLock locker(mutex_);
+  *statistics = statistics_;
+}
+
+const char* GCStatistics::PhaseName(int phase) {
+  switch (phase) {
+    case DARTINO_GC_PHASE_SCAVENGE_ROOTS:
+      return "scavenge-roots";
+    case DARTINO_GC_PHASE_SCAVENGE_REMEMBERED_SET:
+      return "scavenge-remembered-set";
+    case DARTINO_GC_PHASE_SCAVENGE_COPY:
+      return "scavenge-copy";
+    case DARTINO_GC_PHASE_SCAVENGE_WEAK:
+      return "scavenge-weak";
+    case DARTINO_GC_PHASE_MARK:
+      return "mark";
+    case DARTINO_GC_PHASE_MARK_WEAK:
+      return "mark-weak";
+    case DARTINO_GC_PHASE_SWEEP:
+      return "sweep";
+    case DARTINO_GC_PHASE_COMPACT:
+      return "compact";
+  }
+  UNREACHABLE();
+  return NULL;
+}
+
+void GCStatistics::AddPause(DartinoGCPauseHistogram* histogram, uint64 us) {
+  int bucket = (us == 0) ? 0 : Utils::HighestBit(us) + 1;
+  if (bucket >= DARTINO_GC_PAUSE_BUCKETS) bucket = DARTINO_GC_PAUSE_BUCKETS - 1;
+  histogram->count++;
+  histogram->total_us += us;
+  if (us > histogram->max_us) histogram->max_us = us;
+  histogram->buckets[bucket]++;
+}
+
+void GCStatistics::RecordPhases(const GCPhaseTimer& timer) {
+  for (int i = 0; i < DARTINO_GC_PHASE_COUNT; i++) {
+    // A collection only goes through some of the phases.
+    if (timer.ran_phase(i)) {
+      AddPause(&statistics_.phase_pauses[i], timer.phase_time(i));
+    }
+  }
+}
+
+void GCStatistics::RecordHeap(TwoSpaceHeap* heap) {
+  OldSpace* old_space = heap->old_space();
+  uword old_size = old_space->Size();
+  uword old_used = old_space->Used();
+  statistics_.new_space_used = heap->space()->Used();
+  statistics_.new_space_size = heap->space()->Size();
+  statistics_.old_space_used = old_used;
+  statistics_.old_space_size = old_size;
+  statistics_.old_space_resident = old_size - old_space->discarded();
+  statistics_.old_space_free = old_size > old_used ? old_size - old_used : 0;
+  statistics_.old_space_largest_free =
+      old_space->free_list()->LargestChunkSize();
+  statistics_.foreign_memory = heap->used_foreign_memory();
+}
+
+}  // namespace dartino
@@ -0,0 +1,73 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Counters and pause-time histograms for the garbage collectors of a program.
+// They are exposed to embedders through DartinoGetGCStatistics and to the
+// debugger through the GCStatistics session command.
+
+#ifndef SRC_VM_GC_STATISTICS_H_
+#define SRC_VM_GC_STATISTICS_H_
+
+#include "include/dartino_api.h"
+
+#include "src/shared/globals.h"
+#include "src/shared/platform.h"
+
+namespace dartino {
+
+class TwoSpaceHeap;
+
+// Splits the time of one collection into its phases.
+class GCPhaseTimer {
+ public:
+  GCPhaseTimer();
+
+  // Attributes the time since the last call (or since construction) to
+  // [phase].
+  void EndPhase(DartinoGCPhase phase);
+
+  // Time since construction, including work outside the timed phases.
+  uint64 elapsed() const { return Platform::GetMicroseconds() - start_; }
+  uint64 start() const { return start_; }
+  uint64 phase_time(int phase) const { return phase_times_[phase]; }
+  bool ran_phase(int phase) const { return (phases_ & (1 << phase)) != 0; }
+
+ private:
+  uint64 start_;
+  uint64 last_;
+  int phases_;
+  uint64 phase_times_[DARTINO_GC_PHASE_COUNT];
+};
+
+class GCStatistics {
+ public:
+  GCStatistics();
+  ~GCStatistics();
+
+  // The collectors record on the interpreter thread, while Get is called on
+  // the session thread or by the embedder, so all of them take a lock.
+  void RecordScavenge(const GCPhaseTimer& timer, uword scavenged,
+                      uword survived, uword promoted, TwoSpaceHeap* heap);
+  void RecordOldSpaceGC(const GCPhaseTimer& timer, TwoSpaceHeap* heap);
+  // Records that a process stack grew to [length] words, copying [copied]
+  // words, after forcing [collections] collections to make room.
+  void RecordStackGrowth(int length, uword copied, int collections);
+
+  void Get(DartinoGCStatistics* statistics);
+
+  static const char* PhaseName(int phase);
+
+ private:
+  static void AddPause(DartinoGCPauseHistogram* histogram, uint64 us);
+
+  void RecordPhases(const GCPhaseTimer& timer);
+  void RecordHeap(TwoSpaceHeap* heap);
+
+  Mutex* mutex_;
+  DartinoGCStatistics statistics_;
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_GC_STATISTICS_H_
@@ -4,6 +4,7 @@
 
 #include "src/vm/heap.h"
 
+#include <stddef.h>
 #include <stdio.h>
 
 #include "src/shared/assert.h"
@@ -13,7 +14,14 @@
 namespace dartino {
 
 Heap::Heap(RandomXorShift* random)
-    : random_(random), space_(NULL), foreign_memory_(0) {}
+    : random_(random),
+      space_(NULL),
+      foreign_memory_(0),
+      large_object_size_(~static_cast<uword>(0)) {
+  static_assert(kSpaceOffset == offsetof(Heap, space_), "space_");
+  static_assert(kAllocationSamplerOffset == offsetof(Heap, allocation_sampler_),
+                "allocation_sampler_");
+}
 
 OneSpaceHeap::OneSpaceHeap(RandomXorShift* random, int maximum_initial_size)
     : Heap(random) {
@@ -22,16 +30,43 @@ OneSpaceHeap::OneSpaceHeap(RandomXorShift* random, int maximum_initial_size)
   AdjustAllocationBudget();
 }
 
-TwoSpaceHeap::TwoSpaceHeap()
+static uword SemiSpaceSizeFromFlag(int kbytes) {
+  uword size = Utils::RoundUp(kbytes << 10, Platform::kPageSize);
+  uword page_size = Platform::kPageSize;
+  return Utils::Minimum(static_cast<uword>(1) << 24,
+                        Utils::Maximum(size, page_size));
+}
+
+TwoSpaceHeap::TwoSpaceHeap(TwoSpaceHeap* shared_heap)
     : Heap(reinterpret_cast<RandomXorShift*>(NULL)),
-      old_space_(new OldSpace(this)),
-      unused_semispace_(new SemiSpace(Space::kCannotResize, kNewSpacePage, 0)) {
+      shared_heap_(shared_heap),
+      old_space_(shared_heap == NULL ? new OldSpace(this)
+                                     : shared_heap->old_space()),
+      unused_semispace_(new SemiSpace(Space::kCannotResize, kNewSpacePage, 0)),
+      last_scavenge_end_(0) {
   space_ = new SemiSpace(Space::kCannotResize, kNewSpacePage, 0);
-  uword size = Utils::RoundUp(Flags::semispace_size << 10, Platform::kPageSize);
-  size = Utils::Minimum(1ul << 24,
-                        Utils::Maximum(size, 0ul + Platform::kPageSize));
-  semispace_size_ = size;
+  large_object_size_ = kLargeObjectSize;
+  semispace_size_ = SemiSpaceSizeFromFlag(Flags::semispace_size);
+  // Without explicit bounds the semispace size is fixed.
+  min_semispace_size_ =
+      Flags::min_semispace_size == 0
+          ? semispace_size_
+          : Utils::Minimum(SemiSpaceSizeFromFlag(Flags::min_semispace_size),
+                           semispace_size_);
+  max_semispace_size_ =
+      Flags::max_semispace_size == 0
+          ? semispace_size_
+          : Utils::Maximum(SemiSpaceSizeFromFlag(Flags::max_semispace_size),
+                           semispace_size_);
   max_size_ = Utils::RoundUp(Flags::max_heap_size * 1024, Platform::kPageSize);
+  if (shared_heap != NULL) {
+    shared_heap->private_heaps_.Append(this);
+    // Private heaps sample allocations like the heap they were created for.
+    AllocationSampler* sampler = shared_heap->allocation_sampler();
+    if (sampler->is_enabled()) {
+      allocation_sampler_.Enable(sampler->profiler(), sampler->interval());
+    }
+  }
 }
 
 bool TwoSpaceHeap::Initialize() {
@@ -47,15 +82,22 @@ bool TwoSpaceHeap::Initialize() {
   space_->UpdateBaseAndLimit(chunk, chunk->start());
   unused_semispace_->Append(unused_chunk);
   AdjustAllocationBudget();
-  AdjustOldAllocationBudget();
+  if (!is_private()) AdjustOldAllocationBudget();
   water_mark_ = chunk->start();
+  last_scavenge_end_ = Platform::GetMicroseconds();
   return true;
 }
 
 uword TwoSpaceHeap::MaxExpansion() {
+  // The old-space and the limit belong to the shared heap.
+  if (is_private()) return shared_heap_->MaxExpansion();
   if (max_size_ == 0) return kUnlimitedExpansion;
-  if (semispace_size_ * 2 > max_size_) return 0;
-  uword max = max_size_ - 2 * semispace_size_;
+  uword new_space_size = space_->size() + unused_semispace_->size();
+  for (auto heap : private_heaps_) {
+    new_space_size += heap->space()->size() + heap->unused_space()->size();
+  }
+  if (new_space_size > max_size_) return 0;
+  uword max = max_size_ - new_space_size;
   uword old_space_size = old_space_->Size();
   if (max < old_space_size) return 0;
   return max - old_space_size;
@@ -69,19 +111,37 @@ Heap::~Heap() {
 TwoSpaceHeap::~TwoSpaceHeap() {
   // We do this before starting to destroy the heap, because the callbacks can
   // trigger calls that assume the heap is still working.
-  WeakPointer::ForceCallbacks(old_space_->weak_pointers());
-  WeakPointer::ForceCallbacks(space_->weak_pointers());
+  if (!is_private()) old_space_->weak_pointers()->ForceCallbacks();
+  space_->weak_pointers()->ForceCallbacks();
   delete unused_semispace_;
-  delete old_space_;
+  if (is_private()) {
+    shared_heap_->private_heaps_.Remove(this);
+  } else {
+    ASSERT(private_heaps_.IsEmpty());
+    delete old_space_;
+  }
 }
 
 Object* Heap::Allocate(uword size) {
   ASSERT(no_allocation_ == 0);
-  uword result = space_->Allocate(size);
-  if (result == 0) {
-    return HandleAllocationFailure(size);
+  if (allocation_sampler_.Countdown(size)) return SampleAllocation(size);
+  return AllocateUnsampled(size);
+}
+
+Object* Heap::SampleAllocation(uword size) {
+  // Failing lets the interpreter record the stack in HandleGC. It must not
+  // fail where the caller relies on allocation succeeding.
+  bool can_fail = !space_->in_no_allocation_failure_scope();
+  if (allocation_sampler_.StartSample(can_fail)) {
+    allocation_sampler_.Uncount(size);
+    return Failure::retry_after_gc(size);
   }
-  return HeapObject::FromAddress(result);
+  Object* result = AllocateUnsampled(size);
+  if (!result->IsFailure() &&
+      allocation_sampler_.state() == AllocationSampler::kStackRecorded) {
+    allocation_sampler_.Allocated(HeapObject::cast(result));
+  }
+  return result;
 }
 
 Object* Heap::CreateBooleanObject(uword position, Class* the_class,
@@ -98,7 +158,7 @@ Object* Heap::CreateBooleanObject(uword position, Class* the_class,
 Object* Heap::CreateInstance(Class* the_class, Object* init_value,
                              bool immutable) {
   uword size = the_class->instance_format().fixed_size();
-  Object* raw_result = Allocate(size);
+  Object* raw_result = AllocateInstance(the_class, size);
   if (raw_result->IsFailure()) return raw_result;
   Instance* result = reinterpret_cast<Instance*>(raw_result);
   result->set_class(the_class);
@@ -109,6 +169,23 @@ Object* Heap::CreateInstance(Class* the_class, Object* init_value,
   return result;
 }
 
+Object* TwoSpaceHeap::AllocateInstance(Class* the_class, uword size) {
+  if (!Flags::pretenure || !pretenuring_.ShouldPretenure(the_class)) {
+    return Allocate(size);
+  }
+  // A sampled instance is allocated in new-space like any other.
+  if (allocation_sampler_.Countdown(size)) return SampleAllocation(size);
+  uword result = old_space_->Allocate(size);
+  if (result == 0) {
+    allocation_sampler_.Uncount(size);
+    return Failure::retry_after_gc(size);
+  }
+  // Instances are initialized without a write barrier, see
+  // HandleAllocationFailure.
+  GCMetadata::InsertIntoRememberedSet(result);
+  return HeapObject::FromAddress(result);
+}
+
 Object* TwoSpaceHeap::CreateOldSpaceInstance(Class* the_class,
                                              Object* init_value) {
   uword size = the_class->instance_format().fixed_size();
@@ -302,6 +379,12 @@ Object* Heap::CreateFunction(Class* the_class, int arity, List<uint8> bytecodes,
 }
 
 void TwoSpaceHeap::AllocatedForeignMemory(uword size) {
+  // Foreign memory counts against the budget of the shared old-space.
+  if (is_private()) {
+    shared_heap_->AllocatedForeignMemory(size);
+    if (old_space()->needs_garbage_collection()) space()->TriggerGCSoon();
+    return;
+  }
   ASSERT(static_cast<word>(foreign_memory_) >= 0);
   foreign_memory_ += size;
   old_space()->DecreaseAllocationBudget(size);
@@ -311,11 +394,19 @@ void TwoSpaceHeap::AllocatedForeignMemory(uword size) {
 }
 
 void TwoSpaceHeap::FreedForeignMemory(uword size) {
+  if (is_private()) return shared_heap_->FreedForeignMemory(size);
   foreign_memory_ -= size;
   ASSERT(static_cast<word>(foreign_memory_) >= 0);
   old_space()->IncreaseAllocationBudget(size);
 }
 
+bool TwoSpaceHeap::PrivateNewSpaceIncludes(uword address) {
+  for (auto heap : private_heaps_) {
+    if (heap->space()->Includes(address)) return true;
+  }
+  return false;
+}
+
 void TwoSpaceHeap::SwapSemiSpaces() {
   SemiSpace* temp = space_;
   space_ = unused_semispace_;
@@ -323,6 +414,71 @@ void TwoSpaceHeap::SwapSemiSpaces() {
   water_mark_ = space_->top();
 }
 
+// The adaptive semispace sizing tries to keep the time spent in scavenges
+// between these percentages of the time spent running Dart code.
+static const uint64 kScavengeOverheadGrowPercent = 5;
+static const uint64 kScavengeOverheadShrinkPercent = 1;
+
+// The cost of a scavenge is proportional to the number of surviving bytes, so
+// growing the semispace only pays off if few objects survive.  With a high
+// survival rate a larger semispace just makes each scavenge slower.
+static const uword kGrowSurvivalPercent = 10;
+static const uword kShrinkSurvivalPercent = 50;
+
+uword TwoSpaceHeap::ClampSemiSpaceSize(uword size) {
+  size = Utils::Minimum(size, max_semispace_size_);
+  if (max_size_ != 0) {
+    // Leave at least half of the memory not used by old-space for old-space
+    // to grow into.  Both semispaces count against the limit.
+    uword old_space_size = old_space_->Size();
+    uword available =
+        max_size_ > old_space_size ? (max_size_ - old_space_size) >> 2 : 0;
+    available = available & ~(Platform::kPageSize - 1);
+    size = Utils::Minimum(size, available);
+  }
+  return Utils::Maximum(size, min_semispace_size_);
+}
+
+void TwoSpaceHeap::AdjustSemiSpaceSize(uword from_used, uword survived,
+                                       uint64 scavenge_start) {
+  uint64 now = Platform::GetMicroseconds();
+  if (min_semispace_size_ != max_semispace_size_ && from_used != 0) {
+    uint64 scavenge_time = now - scavenge_start;
+    uint64 mutator_time = scavenge_start - last_scavenge_end_;
+    uword survival_percent = static_cast<uword>(
+        static_cast<uint64>(survived) * 100 / from_used);
+    uword size = semispace_size_;
+    if (survival_percent >= kShrinkSurvivalPercent ||
+        scavenge_time * 100 < mutator_time * kScavengeOverheadShrinkPercent) {
+      size >>= 1;
+    } else if (survival_percent <= kGrowSurvivalPercent &&
+               scavenge_time * 100 >=
+                   mutator_time * kScavengeOverheadGrowPercent) {
+      size <<= 1;
+    }
+    semispace_size_ = ClampSemiSpaceSize(size);
+  }
+  last_scavenge_end_ = now;
+
+  // The survivors of the next scavenge are copied to the unused semispace, so
+  // it must be at least as large as the allocatable part of the active one.
+  // The active semispace keeps its chunk until it is the unused one, but we
+  // limit allocation in it to the new size right away.
+  space_->LimitAllocationTo(semispace_size_);
+  uword needed = Utils::RoundUp(space_->limit_ - space_->start(),
+                                Platform::kPageSize);
+  uword unused_size = Utils::Maximum(semispace_size_, needed);
+  if (unused_semispace_->size() != unused_size &&
+      !unused_semispace_->ReplaceChunk(unused_size)) {
+    // Keep the old chunk, and make sure the active semispace fits into it.
+    // The survivors in the active semispace came from the unused one, so they
+    // are known to fit.
+    uword limit = space_->start() + unused_semispace_->size();
+    ASSERT(space_->top() < limit);
+    space_->limit_ = Utils::Minimum(space_->limit_, limit);
+  }
+}
+
 void Heap::ReplaceSpace(SemiSpace* space) {
   delete space_;
   space_ = space;
@@ -337,34 +493,34 @@ SemiSpace* Heap::TakeSpace() {
 
 void TwoSpaceHeap::AddWeakPointer(HeapObject* object,
                                   WeakPointerCallback callback, void* arg) {
-  WeakPointer* weak_pointer = new WeakPointer(object, callback, arg);
+  WeakPointer weak_pointer(object, callback, arg);
   if (space_->IsInSingleChunk(object)) {
-    space_->weak_pointers()->Append(weak_pointer);
+    space_->weak_pointers()->Add(weak_pointer);
   } else {
     ASSERT(old_space_->Includes(object->address()));
-    old_space_->weak_pointers()->Append(weak_pointer);
+    old_space_->weak_pointers()->Add(weak_pointer);
   }
 }
 
 void TwoSpaceHeap::AddExternalWeakPointer(HeapObject* object,
                                           ExternalWeakPointerCallback callback,
                                           void* arg) {
-  WeakPointer* weak_pointer = new WeakPointer(object, callback, arg);
+  WeakPointer weak_pointer(object, callback, arg);
   if (space_->IsInSingleChunk(object)) {
-    space_->weak_pointers()->Append(weak_pointer);
+    space_->weak_pointers()->Add(weak_pointer);
   } else {
     ASSERT(old_space_->Includes(object->address()));
-    old_space_->weak_pointers()->Append(weak_pointer);
+    old_space_->weak_pointers()->Add(weak_pointer);
   }
 }
 
 void TwoSpaceHeap::RemoveWeakPointer(HeapObject* object) {
   if (space_->IsInSingleChunk(object)) {
-    bool success = WeakPointer::Remove(space_->weak_pointers(), object);
+    bool success = space_->weak_pointers()->Remove(object);
     ASSERT(success);
   } else {
     ASSERT(old_space_->Includes(object->address()));
-    bool success = WeakPointer::Remove(old_space_->weak_pointers(), object);
+    bool success = old_space_->weak_pointers()->Remove(object);
     ASSERT(success);
   }
 }
@@ -372,15 +528,20 @@ void TwoSpaceHeap::RemoveWeakPointer(HeapObject* object) {
 bool TwoSpaceHeap::RemoveExternalWeakPointer(
     HeapObject* object, ExternalWeakPointerCallback callback) {
   if (space_->IsInSingleChunk(object)) {
-    return WeakPointer::Remove(space_->weak_pointers(), object, callback);
+    return space_->weak_pointers()->Remove(object, callback);
   } else {
-    return WeakPointer::Remove(old_space_->weak_pointers(), object, callback);
+    return old_space_->weak_pointers()->Remove(object, callback);
   }
 }
 
 void GenerationalScavengeVisitor::VisitBlock(Object** start, Object** end) {
   for (Object** p = start; p < end; p++) {
-    if (!InFromSpace(*p)) continue;
+    if (!InFromSpace(*p)) {
+      if (other_new_spaces_ && GCMetadata::GetPageType(*p) == kNewSpacePage) {
+        *record_ = GCMetadata::kNewSpacePointers;
+      }
+      continue;
+    }
     HeapObject* old_object = reinterpret_cast<HeapObject*>(*p);
     if (old_object->HasForwardingAddress()) {
       HeapObject* destination = old_object->forwarding_address();
@@ -398,6 +559,11 @@ void GenerationalScavengeVisitor::VisitBlock(Object** start, Object** end) {
         }
         *p = moved_object;
       } else {
+        // First survival. The class has to be read before cloning, since
+        // that overwrites the header with the forwarding address.
+        if (pretenuring_ != NULL && old_object->IsInstance()) {
+          pretenuring_->RecordSurvivor(old_object->get_class());
+        }
         *p = old_object->CloneInToSpace(to_);
         *record_ = GCMetadata::kNewSpacePointers;
       }
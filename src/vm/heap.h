@@ -5,10 +5,14 @@
 #ifndef SRC_VM_HEAP_H_
 #define SRC_VM_HEAP_H_
 
+#include "src/shared/flags.h"
 #include "src/shared/globals.h"
 #include "src/shared/random.h"
+#include "src/vm/allocation_profiler.h"
+#include "src/vm/double_list.h"
 #include "src/vm/object.h"
 #include "src/vm/object_memory.h"
+#include "src/vm/pretenuring.h"
 #include "src/vm/weak_pointer.h"
 
 namespace dartino {
@@ -23,10 +27,16 @@ class Heap {
   // for the object.
   Object* Allocate(uword size);
 
-  // Called when an allocation fails in the semispace.  Usually returns a
-  // retry-after-GC failure, but may divert large allocations to an old space.
+  // Called when an allocation fails in the semispace, or is too large for
+  // it.  Usually returns a retry-after-GC failure, but may divert large
+  // allocations to an old space.
   virtual Object* HandleAllocationFailure(uword size) = 0;
 
+  // Allocate the raw memory for an instance of [the_class].
+  virtual Object* AllocateInstance(Class* the_class, uword size) {
+    return Allocate(size);
+  }
+
   // Allocate heap object.
   Object* CreateInstance(Class* the_class, Object* init_value, bool immutable);
   Object* CreateBooleanObject(uword address, Class* the_class,
@@ -104,6 +114,8 @@ class Heap {
 
   RandomXorShift* random() { return random_; }
 
+  AllocationSampler* allocation_sampler() { return &allocation_sampler_; }
+
   uword used_foreign_memory() { return foreign_memory_; }
 
 #ifdef DEBUG
@@ -119,6 +131,13 @@ class Heap {
   // For asserts.
   virtual bool IsTwoSpaceHeap() { return false; }
 
+  // The interpreters allocate numbers by bumping the top of the space. If
+  // you change these, remember to update the static_asserts in heap.cc.
+  static const uword kSpaceOffset = 2 * kWordSize;
+  static const uword kAllocationSamplerOffset = 5 * kWordSize;
+  static const uword kAllocationCountdownOffset =
+      kAllocationSamplerOffset + AllocationSampler::kCountdownOffset;
+
  protected:
   friend class ExitReference;
   friend class Scheduler;
@@ -136,6 +155,19 @@ class Heap {
 
   Object* AllocateRawClass(uword size);
 
+  Object* AllocateUnsampled(uword size) {
+    uword result = (size < large_object_size_) ? space_->Allocate(size) : 0;
+    if (result == 0) {
+      Object* object = HandleAllocationFailure(size);
+      if (object->IsFailure()) allocation_sampler_.Uncount(size);
+      return object;
+    }
+    return HeapObject::FromAddress(result);
+  }
+
+  // Called when the allocation sampler's countdown has passed zero.
+  Object* SampleAllocation(uword size);
+
   // Adjust the allocation budget based on the current heap size.
   void AdjustAllocationBudget() { space()->AdjustAllocationBudget(0); }
 
@@ -148,6 +180,12 @@ class Heap {
   // The number of bytes of foreign memory heap objects are holding on to.
   uword foreign_memory_;
 
+  // Allocations of at least this size bypass the semispace and go straight
+  // to HandleAllocationFailure.
+  uword large_object_size_;
+
+  AllocationSampler allocation_sampler_;
+
 #ifdef DEBUG
   void IncrementNoAllocation() { ++no_allocation_; }
   void DecrementNoAllocation() { --no_allocation_; }
@@ -170,9 +208,16 @@ class OneSpaceHeap : public Heap {
 #endif
 };
 
-class TwoSpaceHeap : public Heap {
+class TwoSpaceHeap;
+typedef DoubleList<TwoSpaceHeap> PrivateHeapList;
+
+// A generational heap. The heap shared by the processes of a program owns
+// its old-space. A private heap, used by a single process, has a new-space
+// of its own but allocates in the old-space of the shared heap it was
+// created for.
+class TwoSpaceHeap : public Heap, public PrivateHeapList::Entry {
  public:
-  TwoSpaceHeap();
+  explicit TwoSpaceHeap(TwoSpaceHeap* shared_heap = NULL);
   virtual ~TwoSpaceHeap();
 
   // Returns false for allocation failure.
@@ -181,23 +226,48 @@ class TwoSpaceHeap : public Heap {
   OldSpace* old_space() { return old_space_; }
   SemiSpace* unused_space() { return unused_semispace_; }
 
+  bool is_private() { return shared_heap_ != NULL; }
+
+  // The private heaps that allocate in the old-space of this heap.
+  PrivateHeapList* private_heaps() { return &private_heaps_; }
+
+  // Whether [address] is in the new-space of one of the private heaps.
+  bool PrivateNewSpaceIncludes(uword address);
+
   void SwapSemiSpaces();
 
-  // Iterate over all objects in the heap.
+  // Make the next scavenge promote all live objects, leaving the new-space
+  // empty.
+  void PromoteAllOnNextScavenge() { water_mark_ = space_->top(); }
+
+  // Called after a scavenge to pick the semispace size for the next cycles.
+  // [from_used] is the number of bytes that were in use in the from-space,
+  // [survived] the number of bytes that were copied or promoted and
+  // [scavenge_start] the time at which the scavenge started.
+  void AdjustSemiSpaceSize(uword from_used, uword survived,
+                           uint64 scavenge_start);
+
+  // The semispace size currently aimed for by the adaptive sizing.
+  uword semispace_size() { return semispace_size_; }
+
+  // Iterate over all objects in the heap. The old-space belongs to the
+  // shared heap.
   virtual void IterateObjects(HeapObjectVisitor* visitor) {
     Heap::IterateObjects(visitor);
-    old_space_->IterateObjects(visitor);
+    if (!is_private()) old_space_->IterateObjects(visitor);
   }
 
   // Flush will write cached values back to object memory.
   // Flush must be called before traveral of heap.
   virtual void Flush() {
     Heap::Flush();
-    old_space_->Flush();
+    if (!is_private()) old_space_->Flush();
   }
 
   // Returns the number of bytes allocated in the space.
-  virtual int Used() { return old_space_->Used() + Heap::Used(); }
+  virtual int Used() {
+    return is_private() ? Heap::Used() : old_space_->Used() + Heap::Used();
+  }
 
 #ifdef DEBUG
   virtual void Find(uword word);
@@ -208,8 +278,13 @@ class TwoSpaceHeap : public Heap {
   }
 
   virtual Object* HandleAllocationFailure(uword size) {
-    if (size >= (semispace_size_ >> 1)) {
-      uword result = old_space_->Allocate(size);
+    // While the semispace size is being adjusted the active semispace can be
+    // smaller than the target size.
+    uword semispace_size = Utils::Minimum(semispace_size_, space_->size());
+    if (size >= (semispace_size >> 1) || size >= large_object_size_) {
+      uword result = (size >= large_object_size_)
+                         ? old_space_->AllocateLargeObject(size)
+                         : old_space_->Allocate(size);
       if (result != 0) {
         // The code that populates newly allocated objects assumes that they
         // are in new space and does not have a write barrier.  We mark the
@@ -221,6 +296,14 @@ class TwoSpaceHeap : public Heap {
     return Failure::retry_after_gc(size);
   }
 
+  virtual Object* AllocateInstance(Class* the_class, uword size);
+
+  // Called after a scavenge to update which classes are pretenured.
+  void UpdatePretenuring() { pretenuring_.UpdateDecisions(); }
+
+  // Called when classes have moved.
+  void ClearPretenuring() { pretenuring_.Clear(); }
+
   // Used during object-rewriting to allocate directly in old-space when
   // new-space is full.
   Object* CreateOldSpaceInstance(Class* the_class, Object* init_value);
@@ -237,8 +320,8 @@ class TwoSpaceHeap : public Heap {
   bool RemoveExternalWeakPointer(HeapObject* object,
                                  ExternalWeakPointerCallback callback);
   void VisitWeakObjectPointers(PointerVisitor* visitor) {
-    WeakPointer::Visit(space_->weak_pointers(), visitor);
-    WeakPointer::Visit(old_space_->weak_pointers(), visitor);
+    space_->weak_pointers()->Visit(visitor);
+    old_space_->weak_pointers()->Visit(visitor);
   }
 
   void AllocatedForeignMemory(uword size);
@@ -250,14 +333,27 @@ class TwoSpaceHeap : public Heap {
  private:
   friend class GenerationalScavengeVisitor;
 
+  // Objects of at least this size get an old-space chunk of their own, so
+  // they are never copied. At this size rounding the chunk up to whole
+  // pages wastes little memory.
+  static const uword kLargeObjectSize = 64 * KB;
+
   // Allocate or deallocate the pages used for heap metadata.
   void ManageMetadata(bool allocate);
 
+  uword ClampSemiSpaceSize(uword size);
+
+  TwoSpaceHeap* shared_heap_;
+  PrivateHeapList private_heaps_;
   OldSpace* old_space_;
   SemiSpace* unused_semispace_;
   uword water_mark_;
   uword max_size_;
   uword semispace_size_;
+  uword min_semispace_size_;
+  uword max_semispace_size_;
+  uint64 last_scavenge_end_;
+  PretenuringTable pretenuring_;
 };
 
 // Helper class for copying HeapObjects.
@@ -301,7 +397,10 @@ class GenerationalScavengeVisitor : public PointerVisitor {
         to_(heap->unused_semispace_),
         old_(heap->old_space()),
         record_(&dummy_record_),
-        water_mark_(heap->water_mark_) {}
+        water_mark_(heap->water_mark_),
+        pretenuring_(Flags::pretenure ? &heap->pretenuring_ : NULL),
+        other_new_spaces_(heap->is_private() ||
+                          !heap->private_heaps()->IsEmpty()) {}
 
   virtual void VisitClass(Object** p) {}
 
@@ -335,6 +434,10 @@ class GenerationalScavengeVisitor : public PointerVisitor {
   // set byte.
   uint8 dummy_record_;
   uword water_mark_;
+  PretenuringTable* pretenuring_;
+  // Whether there are new-spaces other than the one being scavenged, whose
+  // old-space pointers must stay in the remembered set.
+  bool other_new_spaces_;
 };
 
 // Read [object] as an integer word value.
@@ -0,0 +1,349 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/heap_census.h"
+
+#include <stdio.h>
+
+#if defined(DARTINO_TARGET_OS_POSIX)
+#include <signal.h>
+#endif
+
+#include "src/shared/flags.h"
+#include "src/shared/utils.h"
+#include "src/vm/heap.h"
+#include "src/vm/object.h"
+#include "src/vm/profile_header.h"
+#include "src/vm/program.h"
+
+namespace dartino {
+
+Atomic<bool> HeapCensus::signal_pending_(false);
+
+class CensusEdgeVisitor : public PointerVisitor {
+ public:
+  explicit CensusEdgeVisitor(HeapCensus* census) : census_(census) {}
+
+  void VisitBlock(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) {
+      Object* object = *p;
+      if (!object->IsHeapObject()) continue;
+      HeapObject* heap_object = HeapObject::cast(object);
+      // Classes, functions and other objects in the program heap are not
+      // part of the census.
+      if (census_->InHeap(heap_object)) census_->AddEdge(heap_object);
+    }
+  }
+
+ private:
+  HeapCensus* census_;
+};
+
+HeapCensus::HeapCensus(Program* program)
+    : program_(program),
+      heap_(program->process_heap()),
+      object_count_(0),
+      size_(0) {}
+
+void HeapCensus::Take() {
+  // The spaces also hold garbage that has not been collected yet, so only
+  // the objects the graph reaches from the roots are counted.
+  BuildGraph();
+  for (size_t i = 1; i < nodes_.size(); i++) CountObject(nodes_[i]);
+  int* idom = new int[nodes_.size()];
+  int* order = new int[nodes_.size()];
+  ComputeDominators(idom, order);
+  ComputeRetainedSizes(idom, order);
+  delete[] order;
+  delete[] idom;
+}
+
+int HeapCensus::ClassIndex(Class* klass) {
+  auto it = class_indices_.Find(klass);
+  if (it != class_indices_.End()) return it->second;
+  int index = classes_.size();
+  ClassEntry entry = {klass, 0, 0, 0};
+  classes_.PushBack(entry);
+  class_indices_[klass] = index;
+  return index;
+}
+
+bool HeapCensus::InHeap(HeapObject* object) {
+  uword address = object->address();
+  return heap_->space()->Includes(address) ||
+         heap_->old_space()->Includes(address) ||
+         heap_->PrivateNewSpaceIncludes(address);
+}
+
+void HeapCensus::CountObject(HeapObject* object) {
+  ClassEntry& entry = classes_[ClassIndex(object->get_class())];
+  uword size = object->Size();
+  entry.count++;
+  entry.size += size;
+  object_count_++;
+  size_ += size;
+}
+
+void HeapCensus::AddEdge(HeapObject* object) {
+  // Objects are word aligned, so shifting the address out makes a better hash
+  // key.
+  uword key = object->address() >> kPointerSizeLog2;
+  auto it = node_indices_.Find(key);
+  int index;
+  if (it == node_indices_.End()) {
+    index = nodes_.size();
+    nodes_.PushBack(object);
+    node_indices_[key] = index;
+  } else {
+    index = it->second;
+  }
+  edges_.PushBack(index);
+}
+
+void HeapCensus::BuildGraph() {
+  CensusEdgeVisitor visitor(this);
+  nodes_.PushBack(NULL);
+  edge_starts_.PushBack(0);
+  program_->IterateSharedHeapRoots(&visitor);
+  // The nodes are numbered in the order they are found, so this is a
+  // breadth-first traversal that ends when no new objects turn up.
+  for (size_t i = 1; i < nodes_.size(); i++) {
+    edge_starts_.PushBack(edges_.size());
+    nodes_[i]->IteratePointers(&visitor);
+  }
+  edge_starts_.PushBack(edges_.size());
+}
+
+// Lengauer and Tarjan's dominator algorithm with path compression. Fills in
+// [order] with the nodes in depth-first order from the root, so every node
+// comes after its dominator, and [idom] with the immediate dominator of each
+// node. The recursive parts of the algorithm are written out with explicit
+// stacks since the object graph can be very deep.
+void HeapCensus::ComputeDominators(int* idom, int* order) {
+  int n = nodes_.size();
+  int* semi = new int[n];
+  int* parent = new int[n];
+  int* ancestor = new int[n];
+  int* label = new int[n];
+  int* bucket = new int[n];
+  int* next_in_bucket = new int[n];
+  int* stack = new int[n];
+  int* cursor = new int[n];
+
+  for (int i = 0; i < n; i++) {
+    semi[i] = -1;
+    ancestor[i] = -1;
+    label[i] = i;
+    bucket[i] = -1;
+    cursor[i] = edge_starts_[i];
+  }
+
+  // Number the nodes in depth-first order. [semi] holds the number until it
+  // is replaced by the number of the semidominator.
+  int count = 0;
+  int top = 0;
+  stack[top++] = 0;
+  semi[0] = count;
+  order[count++] = 0;
+  parent[0] = 0;
+  while (top > 0) {
+    int v = stack[top - 1];
+    if (cursor[v] == edge_starts_[v + 1]) {
+      top--;
+      continue;
+    }
+    int w = edges_[cursor[v]++];
+    if (semi[w] != -1) continue;
+    parent[w] = v;
+    semi[w] = count;
+    order[count++] = w;
+    stack[top++] = w;
+  }
+  ASSERT(count == n);
+
+  // The predecessors of each node, in the same layout as the edges.
+  int* predecessor_starts = new int[n + 1];
+  int* predecessors = new int[edges_.size()];
+  for (int i = 0; i <= n; i++) predecessor_starts[i] = 0;
+  for (size_t i = 0; i < edges_.size(); i++) {
+    predecessor_starts[edges_[i] + 1]++;
+  }
+  for (int i = 0; i < n; i++) {
+    predecessor_starts[i + 1] += predecessor_starts[i];
+  }
+  for (int i = 0; i < n; i++) cursor[i] = predecessor_starts[i];
+  for (int v = 0; v < n; v++) {
+    for (int i = edge_starts_[v]; i < edge_starts_[v + 1]; i++) {
+      predecessors[cursor[edges_[i]]++] = v;
+    }
+  }
+
+  // Returns the node with the smallest semidominator on the path from [v] to
+  // the root of its tree in the forest, compressing the path on the way.
+  auto eval = [&](int v) {
+    if (ancestor[v] == -1) return v;
+    int depth = 0;
+    for (int u = v; ancestor[ancestor[u]] != -1; u = ancestor[u]) {
+      stack[depth++] = u;
+    }
+    while (depth > 0) {
+      int u = stack[--depth];
+      int a = ancestor[u];
+      if (semi[label[a]] < semi[label[u]]) label[u] = label[a];
+      ancestor[u] = ancestor[a];
+    }
+    return label[v];
+  };
+
+  for (int i = n - 1; i > 0; i--) {
+    int w = order[i];
+    for (int j = predecessor_starts[w]; j < predecessor_starts[w + 1]; j++) {
+      int u = eval(predecessors[j]);
+      if (semi[u] < semi[w]) semi[w] = semi[u];
+    }
+    int s = order[semi[w]];
+    next_in_bucket[w] = bucket[s];
+    bucket[s] = w;
+    int p = parent[w];
+    ancestor[w] = p;
+    for (int v = bucket[p]; v != -1; v = next_in_bucket[v]) {
+      int u = eval(v);
+      idom[v] = semi[u] < semi[v] ? u : p;
+    }
+    bucket[p] = -1;
+  }
+  for (int i = 1; i < n; i++) {
+    int w = order[i];
+    if (idom[w] != order[semi[w]]) idom[w] = idom[idom[w]];
+  }
+  idom[0] = 0;
+
+  delete[] predecessors;
+  delete[] predecessor_starts;
+  delete[] cursor;
+  delete[] stack;
+  delete[] next_in_bucket;
+  delete[] bucket;
+  delete[] label;
+  delete[] ancestor;
+  delete[] parent;
+  delete[] semi;
+}
+
+// An object retains itself and everything it dominates. A class retains what
+// its instances retain, except that instances dominated by another instance
+// of the same class are not counted twice.
+void HeapCensus::ComputeRetainedSizes(int* idom, int* order) {
+  int n = nodes_.size();
+  uword* retained = new uword[n];
+  retained[0] = 0;
+  for (int i = 1; i < n; i++) retained[i] = nodes_[i]->Size();
+  for (int i = n - 1; i > 0; i--) {
+    int w = order[i];
+    retained[idom[w]] += retained[w];
+  }
+
+  // The children of each node in the dominator tree.
+  int* child_starts = new int[n + 1];
+  int* children = new int[n];
+  for (int i = 0; i <= n; i++) child_starts[i] = 0;
+  for (int i = 1; i < n; i++) child_starts[idom[i] + 1]++;
+  for (int i = 0; i < n; i++) child_starts[i + 1] += child_starts[i];
+  int* cursor = new int[n];
+  for (int i = 0; i < n; i++) cursor[i] = child_starts[i];
+  for (int i = 1; i < n; i++) children[cursor[idom[i]]++] = i;
+  for (int i = 0; i < n; i++) cursor[i] = child_starts[i];
+
+  // Walk the dominator tree, keeping track of how many instances of each
+  // class are on the path from the root.
+  int class_count = classes_.size();
+  int* on_path = new int[class_count];
+  for (int i = 0; i < class_count; i++) on_path[i] = 0;
+  int* node_class = new int[n];
+  int* stack = new int[n];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    int v = stack[top - 1];
+    if (cursor[v] < child_starts[v + 1]) {
+      int w = children[cursor[v]++];
+      int index = ClassIndex(nodes_[w]->get_class());
+      node_class[w] = index;
+      if (on_path[index]++ == 0) classes_[index].retained += retained[w];
+      stack[top++] = w;
+    } else {
+      if (v != 0) on_path[node_class[v]]--;
+      top--;
+    }
+  }
+
+  delete[] stack;
+  delete[] node_class;
+  delete[] on_path;
+  delete[] cursor;
+  delete[] children;
+  delete[] child_starts;
+  delete[] retained;
+}
+
+bool HeapCensus::WriteToFile(const char* path) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) return false;
+  bool from_snapshot = program_->was_loaded_from_snapshot();
+  WriteProfileHeader(file, "Heap census",
+                     from_snapshot ? program_->snapshot_hash() : 0);
+  fprintf(file, "objects=%lu\n", static_cast<unsigned long>(object_count_));
+  fprintf(file, "bytes=%lu\n", static_cast<unsigned long>(size_));
+  fprintf(file, "# class,count,bytes,retained\n");
+  for (size_t i = 0; i < classes_.size(); i++) {
+    const ClassEntry& entry = classes_[i];
+    if (from_snapshot) {
+      fprintf(file, "0x%lx,", static_cast<unsigned long>(
+          program_->OffsetOf(HeapObject::cast(entry.klass))));
+    } else {
+      // Without a snapshot there is no .info.json file to name the class.
+      fprintf(file, "?%lu,", static_cast<unsigned long>(i));
+    }
+    fprintf(file, "%lu,%lu,%lu\n", static_cast<unsigned long>(entry.count),
+            static_cast<unsigned long>(entry.size),
+            static_cast<unsigned long>(entry.retained));
+  }
+  return fclose(file) == 0;
+}
+
+#if defined(DARTINO_TARGET_OS_POSIX)
+
+static struct sigaction old_signal_handler;
+
+static void SignalHandler(int signal) { HeapCensus::RequestBySignal(); }
+
+void HeapCensus::Setup() {
+  if (!Flags::heap_census_signal) return;
+  struct sigaction sa;
+  sa.sa_handler = &SignalHandler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  if (sigaction(SIGUSR2, &sa, &old_signal_handler) != 0) {
+    FATAL("Failed to install heap census signal handler");
+  }
+}
+
+void HeapCensus::TearDown() {
+  if (!Flags::heap_census_signal) return;
+  sigaction(SIGUSR2, &old_signal_handler, NULL);
+}
+
+#else
+
+void HeapCensus::Setup() {}
+void HeapCensus::TearDown() {}
+
+#endif  // defined(DARTINO_TARGET_OS_POSIX)
+
+bool HeapCensus::TakeSignalRequest() {
+  bool expected = true;
+  return signal_pending_.compare_exchange_strong(expected, false);
+}
+
+}  // namespace dartino
@@ -0,0 +1,94 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// A heap census counts the live objects and bytes of each class in the heaps
+// of a program, and computes how many bytes each class retains: the size of
+// the objects that would become garbage if all instances of the class were
+// gone. Retained sizes come from the dominator tree of the object graph
+// rooted in the processes of the program.
+
+#ifndef SRC_VM_HEAP_CENSUS_H_
+#define SRC_VM_HEAP_CENSUS_H_
+
+#include "src/shared/atomic.h"
+#include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
+#include "src/vm/vector.h"
+
+namespace dartino {
+
+class Class;
+class HeapObject;
+class Program;
+class TwoSpaceHeap;
+
+class HeapCensus {
+ public:
+  struct ClassEntry {
+    Class* klass;
+    uword count;
+    uword size;
+    uword retained;
+  };
+
+  explicit HeapCensus(Program* program);
+
+  // Walks the object graph from the roots, so only live objects are counted.
+  // The processes of the program must not run while the census is taken.
+  void Take();
+
+  const Vector<ClassEntry>& classes() const { return classes_; }
+  uword object_count() const { return object_count_; }
+  uword size() const { return size_; }
+
+  // Writes the census in the text format read by the heap census tools.
+  // Classes are named by their offset in the program heap, which the
+  // snapshot's .info.json file maps to names. Returns false if the file could
+  // not be written.
+  bool WriteToFile(const char* path);
+
+  // Installs a handler that makes SIGUSR2 request a census of the next
+  // program to collect old-space garbage, if --heap_census_signal is given.
+  static void Setup();
+  static void TearDown();
+
+  static void RequestBySignal() { signal_pending_ = true; }
+  // Returns true once for every census requested by signal.
+  static bool TakeSignalRequest();
+  static bool signal_pending() { return signal_pending_; }
+
+ private:
+  friend class CensusEdgeVisitor;
+
+  int ClassIndex(Class* klass);
+  bool InHeap(HeapObject* object);
+  void CountObject(HeapObject* object);
+  void AddEdge(HeapObject* object);
+
+  void BuildGraph();
+  void ComputeDominators(int* idom, int* order);
+  void ComputeRetainedSizes(int* idom, int* order);
+
+  Program* program_;
+  TwoSpaceHeap* heap_;
+  uword object_count_;
+  uword size_;
+
+  Vector<ClassEntry> classes_;
+  HashMap<Class*, int> class_indices_;
+
+  // The object graph. Node 0 is an artificial root that points to all the
+  // roots of the processes. The edges of node i are the entries
+  // [edge_starts_[i], edge_starts_[i + 1]) of [edges_].
+  Vector<HeapObject*> nodes_;
+  HashMap<uword, int> node_indices_;
+  Vector<int> edge_starts_;
+  Vector<int> edges_;
+
+  static Atomic<bool> signal_pending_;
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_HEAP_CENSUS_H_
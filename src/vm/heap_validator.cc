@@ -22,7 +22,8 @@ void HeapPointerValidator::ValidatePointer(Object* object) {
   bool is_process_heap_obj = false;
   if (process_heap_ != NULL) {
     is_process_heap_obj = (process_heap_->space()->Includes(address) ||
-                           process_heap_->old_space()->Includes(address));
+                           process_heap_->old_space()->Includes(address) ||
+                           process_heap_->PrivateNewSpaceIncludes(address));
   }
 
   bool is_program_heap = program_heap_->space()->Includes(address);
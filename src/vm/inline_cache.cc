@@ -0,0 +1,68 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/inline_cache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+namespace dartino {
+
+static const int kMinimumCapacity = 64;
+
+InlineCache::InlineCache(int call_sites)
+    : memory_(NULL), header_(NULL), entries_(NULL) {
+  // These asserts need to hold when running on the target, but they don't need
+  // to hold on the host (the build machine, where the interpreter-generating
+  // program runs).  We put these asserts here on the assumption that the
+  // interpreter-generating program will not instantiate this class.
+  static_assert(kBytecodePointerOffset == offsetof(Entry, bcp), "bcp");
+  static_assert(kWaysOffset == offsetof(Entry, ways), "ways");
+  static_assert(kClassOffset == offsetof(Way, clazz), "clazz");
+  static_assert(kTargetOffset == offsetof(Way, target), "target");
+  static_assert(kCodeOffset == offsetof(Way, code), "code");
+  static_assert(kWaySize == sizeof(Way), "way size");
+  static_assert(kEntrySize == sizeof(Entry), "entry size");
+  static_assert(kMissesOffset == (kMissesIndex - kHeaderWords) * kWordSize,
+                "misses");
+  Allocate(call_sites);
+}
+
+InlineCache::~InlineCache() { delete[] memory_; }
+
+void InlineCache::Allocate(int call_sites) {
+  capacity_ = kMinimumCapacity;
+  while (capacity_ < 2 * call_sites) capacity_ *= 2;
+  // The probes of the last home index run past the end of the table.
+  int entries = capacity_ + kMaxProbes - 1;
+  int words = kHeaderWords + entries * (kEntrySize / kWordSize);
+  // Align the entries to their size, so none of them straddles two cache
+  // lines.
+  memory_ = new uword[words + kEntrySize / kWordSize]();
+  uword start = reinterpret_cast<uword>(memory_ + kHeaderWords);
+  entries_ = reinterpret_cast<Entry*>(Utils::RoundUp(start, kEntrySize));
+  header_ = reinterpret_cast<uword*>(entries_) - kHeaderWords;
+}
+
+void InlineCache::Clear(int call_sites) {
+  uword misses = header_[kMissesIndex];
+  delete[] memory_;
+  Allocate(call_sites);
+  header_[kMissesIndex] = misses;
+}
+
+int InlineCache::entries_in_use() const {
+  int count = 0;
+  for (int i = 0; i < capacity_ + kMaxProbes - 1; i++) {
+    if (entries_[i].bcp != NULL) count++;
+  }
+  return count;
+}
+
+void InlineCache::PrintStatistics() const {
+  Print::Out("Inline caches: %lu misses, %d call sites cached\n",
+             static_cast<unsigned long>(misses()), entries_in_use());
+}
+
+}  // namespace dartino
@@ -0,0 +1,99 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_INLINE_CACHE_H_
+#define SRC_VM_INLINE_CACHE_H_
+
+#include "src/shared/globals.h"
+#include "src/shared/utils.h"
+
+namespace dartino {
+
+class Class;
+class Function;
+
+// The inline caches of the method invocations of a program. They are kept in
+// a side table keyed by the bytecode pointer of the call site, so the
+// bytecodes stay unchanged. Every call site gets an entry of its own: the
+// table has at least twice as many entries as the program has call sites,
+// and a call site takes the first free entry among the kMaxProbes entries
+// starting at its home index. An entry holds kWays receiver classes, most
+// recently used first, and the method the call site invoked for each. A
+// call whose receiver class is in the entry of its call site skips the
+// dispatch table or the lookup cache. The interpreter probes and fills the
+// entries (currently only the x64 interpreter does).
+//
+// A hit only reads the table. The number of misses precedes the entries in
+// memory.
+class InlineCache {
+ public:
+  static const int kWays = 2;
+  static const int kMaxProbes = 4;
+
+  // If you add an offset here, remember to add the corresponding static_assert
+  // in inline_cache.cc.
+  static const int kBytecodePointerOffset = 0;
+  static const int kWaysOffset = kBytecodePointerOffset + sizeof(word);
+  static const int kClassOffset = 0;
+  static const int kTargetOffset = kClassOffset + sizeof(word);
+  static const int kCodeOffset = kTargetOffset + sizeof(word);
+  static const int kWaySize = kCodeOffset + sizeof(word);
+  // Entries are padded to a power of two so the interpreter can shift.
+  static const int kEntrySizeLog2 = 3 + kPointerSizeLog2;
+  static const int kEntrySize = 1 << kEntrySizeLog2;
+
+  // Offset of the miss count relative to the entries.
+  static const int kMissesOffset = -static_cast<int>(sizeof(word));
+
+  struct Way {
+    Class* clazz;
+    Function* target;
+    void* code;
+  };
+
+  struct Entry {
+    uint8* bcp;
+    Way ways[kWays];
+    word padding[(kEntrySize - kWaysOffset) / sizeof(word) - 3 * kWays];
+  };
+
+  // Makes room for the given number of call sites.
+  explicit InlineCache(int call_sites);
+  ~InlineCache();
+
+  Entry* entries() const { return entries_; }
+  int capacity() const { return capacity_; }
+
+  // Forgets all entries and makes room for the given number of call sites,
+  // but keeps counting. Must not be called while a process runs, since
+  // running processes hold on to the entries.
+  void Clear(int call_sites);
+
+  uword misses() const { return header_[kMissesIndex]; }
+  // The number of call sites that have an entry.
+  int entries_in_use() const;
+
+  // Prints the number of misses on stdout.
+  void PrintStatistics() const;
+
+  // The index of the first entry the call site at [bcp] may use.
+  uword ComputeIndex(uint8* bcp) const {
+    return reinterpret_cast<uword>(bcp) & (capacity_ - 1);
+  }
+
+ private:
+  static const int kMissesIndex = 0;
+  static const int kHeaderWords = 1;
+
+  void Allocate(int call_sites);
+
+  int capacity_;
+  uword* memory_;
+  uword* header_;
+  Entry* entries_;
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_INLINE_CACHE_H_
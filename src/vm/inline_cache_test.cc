@@ -0,0 +1,43 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+#include "src/vm/inline_cache.h"
+
+namespace dartino {
+
+TEST_CASE(InlineCacheStatistics) {
+  InlineCache cache(100);
+  EXPECT(cache.capacity() >= 200);
+  EXPECT(Utils::IsPowerOfTwo(cache.capacity()));
+  EXPECT_EQ(0, static_cast<int>(cache.misses()));
+  EXPECT_EQ(0, cache.entries_in_use());
+
+  // Update the cache the way the interpreter does: through the entries, and
+  // the miss count at a negative offset from them. The home index of a call
+  // site is its bytecode pointer masked by the capacity.
+  uint8 bytecodes[2];
+  InlineCache::Entry* entries = cache.entries();
+  uint8* base = reinterpret_cast<uint8*>(entries);
+  uword mask = cache.capacity() - 1;
+  uword* misses = reinterpret_cast<uword*>(base + InlineCache::kMissesOffset);
+  InlineCache::Entry* home = entries + cache.ComputeIndex(bytecodes);
+  EXPECT_EQ(reinterpret_cast<uword>(bytecodes) & mask,
+            cache.ComputeIndex(bytecodes));
+  home[0].bcp = bytecodes;
+  home[InlineCache::kMaxProbes - 1].bcp = bytecodes + 1;
+  *misses += 2;
+  EXPECT_EQ(2, static_cast<int>(cache.misses()));
+  EXPECT_EQ(2, cache.entries_in_use());
+
+  // Clearing the cache makes room for the new number of call sites, and
+  // keeps counting.
+  cache.Clear(1000);
+  EXPECT(cache.capacity() >= 2000);
+  EXPECT_EQ(0, cache.entries_in_use());
+  EXPECT_EQ(2, static_cast<int>(cache.misses()));
+}
+
+}  // namespace dartino
@@ -12,6 +12,8 @@
 #include "src/shared/names.h"
 #include "src/shared/selectors.h"
 
+#include "src/vm/bytecode_profiler.h"
+#include "src/vm/catch_table.h"
 #include "src/vm/frame.h"
 #include "src/vm/native_interpreter.h"
 #include "src/vm/natives.h"
@@ -120,7 +122,14 @@ Process::StackCheckResult HandleStackOverflow(Process* process, int size) {
 }
 
 void HandleGC(Process* process) {
-  process->program()->CollectNewSpace();
+  AllocationSampler* sampler = process->heap()->allocation_sampler();
+  if (sampler->state() == AllocationSampler::kWaitingForStack) {
+    // A sampled allocation failed only to get here, where the stack of the
+    // process can be walked. It succeeds when retried.
+    sampler->RecordStack(process);
+  } else {
+    process->program()->CollectNewSpace(process);
+  }
 
   // After a GC a lot of stacks might no longer have pointers to new space on
   // them. If so, the remembered set will no longer contain such a stack.
@@ -187,43 +196,29 @@ LookupCache::Entry* HandleLookupEntry(Process* process,
   return process->LookupEntrySlow(primary, clazz, selector);
 }
 
-// Overlay this struct on the catch table to interpret the bytes.
-struct CatchBlock {
-  int start;
-  int end;
-  int frame_size;
-};
-
-static uint8* FindCatchBlock(Stack* stack, int* stack_delta_result,
+static uint8* FindCatchBlock(Stack* stack, CatchTableCache* cache,
+                             int* stack_delta_result,
                              Object*** frame_pointer_result) {
   Frame frame(stack);
   while (frame.MovePrevious()) {
-    int offset = -1;
-    Function* function = frame.FunctionFromByteCodePointer(&offset);
+    uint8* bcp = frame.ByteCodePointer();
     // Skip frames with no byte code pointer / function.
-    if (function == NULL) continue;
+    if (bcp == NULL) continue;
 
     // Skip if there are no catch blocks.
-    if (offset == -1) continue;
-
-    uint8* bcp = frame.ByteCodePointer();
-    uint8* catch_block_address = function->bytecode_address_for(offset);
-    int count = Utils::ReadInt32(catch_block_address);
-    const CatchBlock* block =
-        reinterpret_cast<const CatchBlock*>(catch_block_address + 4);
-    for (int i = 0; i < count; i++) {
-      uint8* start_address = function->bytecode_address_for(block->start);
-      uint8* end_address = function->bytecode_address_for(block->end);
-      // The first hit is the one we use (due to the order they are
-      // emitted).
-      if (start_address <= bcp && end_address > bcp) {
-        // Read the number of stack slots we need to pop.
-        int index = frame.FirstLocalIndex() - block->frame_size - 1;
-        *stack_delta_result = index - stack->top();
-        *frame_pointer_result = frame.FramePointer();
-        return end_address;
-      }
-      block++;
+    int table_offset = -1;
+    Function* function = cache->Lookup(bcp, &table_offset);
+    if (table_offset == -1) continue;
+
+    CatchTable::Block block;
+    uint8* table = function->bytecode_address_for(table_offset);
+    int offset = bcp - function->bytecode_address_for(0);
+    if (CatchTable::Find(table, offset, &block)) {
+      // Read the number of stack slots we need to pop.
+      int index = frame.FirstLocalIndex() - block.frame_size - 1;
+      *stack_delta_result = index - stack->top();
+      *frame_pointer_result = frame.FramePointer();
+      return function->bytecode_address_for(block.end);
     }
   }
   return NULL;
@@ -237,12 +232,14 @@ uint8* HandleThrow(Process* process, Object* exception, int* stack_delta_result,
     // If we find a handler, we do a 2nd pass, unwind all coroutine stacks
     // until the handler, make the unused coroutines/stacks GCable and return
     // the handling bcp.
-    uint8* catch_bcp = FindCatchBlock(current->stack(), stack_delta_result,
-                                      frame_pointer_result);
+    uint8* catch_bcp =
+        FindCatchBlock(current->stack(), process->EnsureCatchTableCache(),
+                       stack_delta_result, frame_pointer_result);
     if (catch_bcp != NULL) {
       Coroutine* unused = process->coroutine();
       while (current != unused) {
         Coroutine* caller = unused->caller();
+        process->ReleaseStack(unused->stack());
         unused->set_stack(process->program()->null_object());
         unused->set_caller(unused);
         unused = caller;
@@ -278,7 +275,7 @@ void HandleEnterNoSuchMethod(Process* process) {
 
   // Read the bcp address for the frame.
   uint8* bcp = caller_frame.ByteCodePointer();
-  Opcode opcode = static_cast<Opcode>(*bcp);
+  Opcode opcode = Bytecode::Unfuse(static_cast<Opcode>(*bcp));
 
   int selector;
   if (opcode == Opcode::kInvokeSelector) {
@@ -379,6 +376,9 @@ Function* HandleInvokeSelector(Process* process) {
 int HandleAtBytecode(Process* process, uint8* bcp, Object** sp) {
   // TODO(ajohnsen): Support validate stack.
 
+  BytecodeProfiler* profiler = BytecodeProfiler::GlobalInstance();
+  if (profiler != NULL) profiler->Count(process, bcp, sp);
+
   // Always hit process-local/one-shot breakpoints first.
   ProcessDebugInfo* process_info = process->debug_info();
   if (process_info != NULL) {
@@ -22,7 +22,8 @@ namespace dartino {
 
 class InterpreterGenerator {
  public:
-  explicit InterpreterGenerator(Assembler* assembler) : assembler_(assembler) {}
+  explicit InterpreterGenerator(Assembler* assembler)
+      : assembler_(assembler), fused_size_(0), fused_second_(NULL) {}
 
   void Generate();
 
@@ -46,8 +47,17 @@ class InterpreterGenerator {
  protected:
   Assembler* assembler() const { return assembler_; }
 
+  // While the handler of a superinstruction is generated, dispatching past
+  // its first bytecode jumps straight to the handler of the second one.
+  bool IsFusedDispatch(int size) const {
+    return fused_second_ != NULL && size == fused_size_;
+  }
+  const char* fused_second() const { return fused_second_; }
+
  private:
   Assembler* const assembler_;
+  int fused_size_;
+  const char* fused_second_;
 };
 
 void InterpreterGenerator::Generate() {
@@ -64,6 +74,23 @@ void InterpreterGenerator::Generate() {
   BYTECODES_DO(V)
 #undef V
 
+#define V(name, first, second)           \
+  GenerateBytecodePrologue("BC_" #name); \
+  fused_size_ = k##first##Length;        \
+  fused_second_ = "BC_" #second;         \
+  Do##first();                           \
+  fused_second_ = NULL;
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+
+  // Only the x64 interpreter specializes the handlers of quickened
+  // bytecodes. Here they run like their originals.
+#define V(name, original)                \
+  GenerateBytecodePrologue("BC_" #name); \
+  Do##original();
+  QUICKENED_DO(V)
+#undef V
+
 #define V(name)                              \
   __ AlignToPowerOfTwo(3);                   \
   __ Bind("", "Intrinsic_" #name); \
@@ -77,6 +104,12 @@ void InterpreterGenerator::Generate() {
   assembler()->DefineLong("BC_" #name);
   BYTECODES_DO(V)
 #undef V
+#define V(name, first, second) assembler()->DefineLong("BC_" #name);
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original) assembler()->DefineLong("BC_" #name);
+  QUICKENED_DO(V)
+#undef V
 }
 
 class InterpreterGeneratorARM : public InterpreterGenerator {
@@ -228,6 +261,11 @@ class InterpreterGeneratorARM : public InterpreterGenerator {
   virtual void DoIntrinsicListIndexGet();
   virtual void DoIntrinsicListIndexSet();
   virtual void DoIntrinsicListLength();
+  virtual void DoIntrinsicStringLength();
+  virtual void DoIntrinsicStringHashCode();
+  virtual void DoIntrinsicOneByteStringCodeUnitAt();
+  virtual void DoIntrinsicOneByteStringEqual();
+  virtual void DoIntrinsicTwoByteStringCodeUnitAt();
 
  private:
   Label done_;
@@ -280,6 +318,19 @@ class InterpreterGeneratorARM : public InterpreterGenerator {
   void InvokeMul(const char* fallback);
   void InvokeTruncDiv(const char* fallback);
 
+  // Loads the two smi operands untagged into r0 and r1.
+  void LoadUntaggedOperands();
+
+  // Allocates a LargeInteger in new space by bumping the top of the space,
+  // and leaves it in r2. Overwrites r0, r1, r3, r7 and ip. Branches to
+  // [fallback] if the space is exhausted or the allocation is due to be
+  // sampled.
+  void AllocateLargeInteger(const char* fallback);
+
+  // Stores ip:r0 in the LargeInteger in r2, replaces the two operands with
+  // it and dispatches.
+  void StoreLargeIntegerResult(int size);
+
   void InvokeBitNot(const char* fallback);
   void InvokeBitAnd(const char* fallback);
   void InvokeBitOr(const char* fallback);
@@ -793,10 +844,19 @@ void InterpreterGeneratorARM::InvokeAdd(const char* fallback) {
   __ tst(R1, Immediate(Smi::kTagMask));
   __ b(NE, fallback);
 
+  Label overflow;
   __ adds(R0, R0, R1);
-  __ b(VS, fallback);
+  __ b(VS, &overflow);
   DropNAndSetTop(1, R0);
   Dispatch(kInvokeAddLength);
+
+  // The sum of the untagged operands fits in 32 bits.
+  __ Bind(&overflow);
+  AllocateLargeInteger(fallback);
+  LoadUntaggedOperands();
+  __ add(R0, R0, R1);
+  __ asr(IP, R0, Immediate(31));
+  StoreLargeIntegerResult(kInvokeAddLength);
 }
 
 void InterpreterGeneratorARM::InvokeSub(const char* fallback) {
@@ -807,10 +867,18 @@ void InterpreterGeneratorARM::InvokeSub(const char* fallback) {
   __ tst(R1, Immediate(Smi::kTagMask));
   __ b(NE, fallback);
 
+  Label overflow;
   __ subs(R0, R0, R1);
-  __ b(VS, fallback);
+  __ b(VS, &overflow);
   DropNAndSetTop(1, R0);
   Dispatch(kInvokeAddLength);
+
+  __ Bind(&overflow);
+  AllocateLargeInteger(fallback);
+  LoadUntaggedOperands();
+  __ sub(R0, R0, R1);
+  __ asr(IP, R0, Immediate(31));
+  StoreLargeIntegerResult(kInvokeSubLength);
 }
 
 void InterpreterGeneratorARM::InvokeMod(const char* fallback) {
@@ -832,13 +900,21 @@ void InterpreterGeneratorARM::InvokeMul(const char* fallback) {
   // produce a 64-bit result with the high 32 bit in IP and the
   // low in R0. We then check that the high 33 bit are all equal
   // which is the overflow check.
+  Label overflow;
   __ asr(R0, R0, Immediate(1));
   __ smull(R0, IP, R1, R0);
   __ cmp(IP, Operand(R0, ASR, 31));
-  __ b(NE, fallback);
+  __ b(NE, &overflow);
 
   DropNAndSetTop(1, R0);
   Dispatch(kInvokeMulLength);
+
+  // Multiply the untagged operands to get the full product in ip:r0.
+  __ Bind(&overflow);
+  AllocateLargeInteger(fallback);
+  LoadUntaggedOperands();
+  __ smull(R0, IP, R1, R0);
+  StoreLargeIntegerResult(kInvokeMulLength);
 }
 
 void InterpreterGeneratorARM::InvokeTruncDiv(const char* fallback) {
@@ -1421,6 +1497,127 @@ void InterpreterGeneratorARM::DoIntrinsicListLength() {
   __ bx(LR);
 }
 
+void InterpreterGeneratorARM::DoIntrinsicStringLength() {
+  LoadLocal(R2, 0);  // String.
+  __ ldr(R0, Address(R2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ bx(LR);
+}
+
+void InterpreterGeneratorARM::DoIntrinsicStringHashCode() {
+  ASSERT(OneByteString::kHashValueOffset == TwoByteString::kHashValueOffset);
+  LoadLocal(R2, 0);  // String.
+  __ ldr(R1, Address(R2, OneByteString::kHashValueOffset - HeapObject::kTag));
+
+  // A hash of zero has not been computed yet.
+  __ cmp(R1, Immediate(0));
+  __ b(EQ, &intrinsic_failure_);
+  __ mov(R0, R1);
+  __ bx(LR);
+}
+
+void InterpreterGeneratorARM::DoIntrinsicOneByteStringCodeUnitAt() {
+  LoadLocal(R1, 0);  // Index.
+  LoadLocal(R2, 1);  // String.
+
+  ASSERT(Smi::kTag == 0);
+  __ tst(R1, Immediate(Smi::kTagMask));
+  __ b(NE, &intrinsic_failure_);
+  __ cmp(R1, Immediate(0));
+  __ b(LT, &intrinsic_failure_);
+
+  // Check the index against the length.
+  __ ldr(R3, Address(R2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ cmp(R1, R3);
+  __ b(GE, &intrinsic_failure_);
+
+  // Load the character and smi-tag it.
+  ASSERT(Smi::kTagSize == 1);
+  __ add(R2, R2, Operand(R1, ASR, 1));
+  __ ldrb(R0, Address(R2, OneByteString::kSize - HeapObject::kTag));
+  __ add(R0, R0, R0);
+  __ bx(LR);
+}
+
+void InterpreterGeneratorARM::DoIntrinsicOneByteStringEqual() {
+  LoadLocal(R1, 0);  // Other.
+  LoadLocal(R2, 1);  // String.
+
+  Label equal, not_equal, compare, loop;
+  __ cmp(R1, R2);
+  __ b(EQ, &equal);
+
+  // Leave comparing with anything but another one-byte string to the native.
+  ASSERT(Smi::kTag == 0);
+  __ tst(R1, Immediate(Smi::kTagMask));
+  __ b(EQ, &intrinsic_failure_);
+  __ ldr(R3, Address(R1, HeapObject::kClassOffset - HeapObject::kTag));
+  __ ldr(R7, Address(R2, HeapObject::kClassOffset - HeapObject::kTag));
+  __ cmp(R3, R7);
+  __ b(NE, &intrinsic_failure_);
+
+  __ ldr(R3, Address(R1, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ ldr(R7, Address(R2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ cmp(R3, R7);
+  __ b(NE, &not_equal);
+  ASSERT(Smi::kTagSize == 1);
+  __ asr(R3, R3, Immediate(1));
+
+  // Strings with different hashes differ, if both hashes are computed.
+  int hash_offset = OneByteString::kHashValueOffset - HeapObject::kTag;
+  __ ldr(R7, Address(R1, hash_offset));
+  __ ldr(R12, Address(R2, hash_offset));
+  __ add(R1, R1, Immediate(OneByteString::kSize - HeapObject::kTag));
+  __ add(R2, R2, Immediate(OneByteString::kSize - HeapObject::kTag));
+  __ cmp(R7, Immediate(0));
+  __ b(EQ, &loop);
+  __ cmp(R12, Immediate(0));
+  __ b(EQ, &loop);
+  __ cmp(R7, R12);
+  __ b(NE, &not_equal);
+
+  // Compare the characters from the end.
+  __ Bind(&loop);
+  __ cmp(R3, Immediate(0));
+  __ b(EQ, &equal);
+  __ sub(R3, R3, Immediate(1));
+  __ ldrb(R7, Address(R1, Operand(R3, TIMES_1)));
+  __ ldrb(R12, Address(R2, Operand(R3, TIMES_1)));
+  __ cmp(R7, R12);
+  __ b(EQ, &loop);
+
+  __ Bind(&not_equal);
+  LoadFalse(R0);
+  __ bx(LR);
+
+  __ Bind(&equal);
+  LoadTrue(R0);
+  __ bx(LR);
+}
+
+void InterpreterGeneratorARM::DoIntrinsicTwoByteStringCodeUnitAt() {
+  LoadLocal(R1, 0);  // Index.
+  LoadLocal(R2, 1);  // String.
+
+  ASSERT(Smi::kTag == 0);
+  __ tst(R1, Immediate(Smi::kTagMask));
+  __ b(NE, &intrinsic_failure_);
+  __ cmp(R1, Immediate(0));
+  __ b(LT, &intrinsic_failure_);
+
+  // Check the index against the length.
+  __ ldr(R3, Address(R2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ cmp(R1, R3);
+  __ b(GE, &intrinsic_failure_);
+
+  // The smi-tagged index is the offset of the code unit. Load it and smi-tag
+  // it.
+  ASSERT(Smi::kTagSize == 1);
+  __ add(R2, R2, R1);
+  __ ldrh(R0, Address(R2, TwoByteString::kSize - HeapObject::kTag));
+  __ add(R0, R0, R0);
+  __ bx(LR);
+}
+
 void InterpreterGeneratorARM::Push(Register reg) {
 #ifdef DARTINO_THUMB_ONLY
   StoreLocal(reg, -1);
@@ -1984,6 +2181,51 @@ void InterpreterGeneratorARM::InvokeCompare(const char* fallback,
   Dispatch(5);
 }
 
+void InterpreterGeneratorARM::LoadUntaggedOperands() {
+  LoadLocal(R0, 1);
+  __ asr(R0, R0, Immediate(1));
+  LoadLocal(R1, 0);
+  __ asr(R1, R1, Immediate(1));
+}
+
+void InterpreterGeneratorARM::AllocateLargeInteger(const char* fallback) {
+  int size = LargeInteger::AllocationSize();
+  __ ldr(R1, Address(R4, Process::kHeapOffset));
+
+  // Leave allocations that are due to be sampled to the runtime, which
+  // counts them again.
+  __ ldr(R3, Address(R1, Heap::kAllocationCountdownOffset));
+  __ sub(R3, R3, Immediate(size));
+  __ cmp(R3, Immediate(0));
+  __ b(LT, fallback);
+
+  // Like SemiSpace::TryAllocate, keep room for the sentinel at the end of
+  // the chunk.
+  __ ldr(R7, Address(R1, Heap::kSpaceOffset));
+  __ ldr(R2, Address(R7, Space::kTopOffset));
+  __ add(R0, R2, Immediate(size));
+  __ ldr(IP, Address(R7, Space::kLimitOffset));
+  __ cmp(R0, IP);
+  __ b(CS, fallback);
+
+  __ str(R3, Address(R1, Heap::kAllocationCountdownOffset));
+  __ str(R0, Address(R7, Space::kTopOffset));
+  __ mov(R3, Immediate(0));
+  __ str(R3, Address(R0, 0));
+
+  __ ldr(R3, Address(R10, Program::kLargeIntegerClassOffset));
+  __ str(R3, Address(R2, HeapObject::kClassOffset));
+  __ add(R2, R2, Immediate(HeapObject::kTag));
+}
+
+void InterpreterGeneratorARM::StoreLargeIntegerResult(int size) {
+  int offset = LargeInteger::kValueOffset - HeapObject::kTag;
+  __ str(R0, Address(R2, offset));
+  __ str(IP, Address(R2, offset + kWordSize));
+  DropNAndSetTop(1, R2);
+  Dispatch(size);
+}
+
 void InterpreterGeneratorARM::AddIf(Condition cond, Register reg,
                                     int add_if_eq) {
   __ it(cond);
@@ -2018,6 +2260,12 @@ void InterpreterGeneratorARM::CheckStackOverflow(int size) {
 }
 
 void InterpreterGeneratorARM::Dispatch(int size) {
+  if (IsFusedDispatch(size)) {
+    __ add(R5, R5, Immediate(size));
+    __ b(fused_second());
+    __ GenerateConstantPool();
+    return;
+  }
 // Load the next bytecode through R5 and dispatch to it.
 #ifdef DARTINO_THUMB_ONLY
   __ ldrb(R7, Address(R5, size));
@@ -23,7 +23,7 @@ namespace dartino {
 class InterpreterGenerator {
  public:
   explicit InterpreterGenerator(Assembler* assembler)
-      : assembler_(assembler) { }
+      : assembler_(assembler), fused_size_(0), fused_second_(NULL) { }
 
   void Generate();
 
@@ -47,8 +47,17 @@ class InterpreterGenerator {
  protected:
   Assembler* assembler() const { return assembler_; }
 
+  // While the handler of a superinstruction is generated, dispatching past
+  // its first bytecode jumps straight to the handler of the second one.
+  bool IsFusedDispatch(int size) const {
+    return fused_second_ != NULL && size == fused_size_;
+  }
+  const char* fused_second() const { return fused_second_; }
+
  private:
   Assembler* const assembler_;
+  int fused_size_;
+  const char* fused_second_;
 };
 
 void InterpreterGenerator::Generate() {
@@ -65,6 +74,23 @@ void InterpreterGenerator::Generate() {
   BYTECODES_DO(V)
 #undef V
 
+#define V(name, first, second)           \
+  GenerateBytecodePrologue("BC_" #name); \
+  fused_size_ = k##first##Length;        \
+  fused_second_ = "BC_" #second;         \
+  Do##first();                           \
+  fused_second_ = NULL;
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+
+  // Only the x64 interpreter specializes the handlers of quickened
+  // bytecodes. Here they run like their originals.
+#define V(name, original)                \
+  GenerateBytecodePrologue("BC_" #name); \
+  Do##original();
+  QUICKENED_DO(V)
+#undef V
+
 #define V(name)           \
   __ AlignToPowerOfTwo(3);  \
   __ Bind("", "Intrinsic_" #name); \
@@ -78,6 +104,12 @@ void InterpreterGenerator::Generate() {
   assembler()->DefineLong("BC_" #name);
   BYTECODES_DO(V)
 #undef V
+#define V(name, first, second) assembler()->DefineLong("BC_" #name);
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original) assembler()->DefineLong("BC_" #name);
+  QUICKENED_DO(V)
+#undef V
 }
 
 class InterpreterGeneratorMIPS: public InterpreterGenerator {
@@ -227,6 +259,11 @@ class InterpreterGeneratorMIPS: public InterpreterGenerator {
   virtual void DoIntrinsicListIndexGet();
   virtual void DoIntrinsicListIndexSet();
   virtual void DoIntrinsicListLength();
+  virtual void DoIntrinsicStringLength();
+  virtual void DoIntrinsicStringHashCode();
+  virtual void DoIntrinsicOneByteStringCodeUnitAt();
+  virtual void DoIntrinsicOneByteStringEqual();
+  virtual void DoIntrinsicTwoByteStringCodeUnitAt();
 
  private:
   Label done_;
@@ -1468,6 +1505,118 @@ void InterpreterGeneratorMIPS::DoIntrinsicListLength() {
   __ lw(A0, Address(A2, Array::kLengthOffset - HeapObject::kTag));  // D-slot.
 }
 
+void InterpreterGeneratorMIPS::DoIntrinsicStringLength() {
+  LoadLocal(A2, 0);  // String.
+  int length_offset = BaseArray::kLengthOffset - HeapObject::kTag;
+  __ jr(RA);
+  __ lw(A0, Address(A2, length_offset));  // Delay-slot.
+}
+
+void InterpreterGeneratorMIPS::DoIntrinsicStringHashCode() {
+  ASSERT(OneByteString::kHashValueOffset == TwoByteString::kHashValueOffset);
+  LoadLocal(A2, 0);  // String.
+  __ lw(A1, Address(A2, OneByteString::kHashValueOffset - HeapObject::kTag));
+
+  // A hash of zero has not been computed yet.
+  __ B(EQ, A1, ZR, &intrinsic_failure_);
+  __ jr(RA);
+  __ move(A0, A1);  // Delay-slot.
+}
+
+void InterpreterGeneratorMIPS::DoIntrinsicOneByteStringCodeUnitAt() {
+  LoadLocal(A1, 0);  // Index.
+  LoadLocal(A2, 1);  // String.
+
+  ASSERT(Smi::kTag == 0);
+  __ andi(T0, A1, Immediate(Smi::kTagMask));
+  __ B(NEQ, T0, ZR, &intrinsic_failure_);
+  __ B(LT, A1, ZR, &intrinsic_failure_);
+
+  // Check the index against the length.
+  __ lw(A3, Address(A2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ B(GE, A1, A3, &intrinsic_failure_);
+
+  // Load the character and smi-tag it.
+  ASSERT(Smi::kTagSize == 1);
+  __ sra(T0, A1, Immediate(1));
+  __ addu(A2, A2, T0);
+  __ lbu(A0, Address(A2, OneByteString::kSize - HeapObject::kTag));
+  __ jr(RA);
+  __ addu(A0, A0, A0);  // Delay-slot.
+}
+
+void InterpreterGeneratorMIPS::DoIntrinsicOneByteStringEqual() {
+  LoadLocal(A1, 0);  // Other.
+  LoadLocal(A2, 1);  // String.
+
+  Label equal, not_equal, loop;
+  __ B(EQ, A1, A2, &equal);
+
+  // Leave comparing with anything but another one-byte string to the native.
+  ASSERT(Smi::kTag == 0);
+  __ andi(T0, A1, Immediate(Smi::kTagMask));
+  __ B(EQ, T0, ZR, &intrinsic_failure_);
+  __ lw(T0, Address(A1, HeapObject::kClassOffset - HeapObject::kTag));
+  __ lw(T1, Address(A2, HeapObject::kClassOffset - HeapObject::kTag));
+  __ B(NEQ, T0, T1, &intrinsic_failure_);
+
+  __ lw(A3, Address(A1, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ lw(T1, Address(A2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ B(NEQ, A3, T1, &not_equal);
+  ASSERT(Smi::kTagSize == 1);
+  __ sra(A3, A3, Immediate(1));
+
+  // Strings with different hashes differ, if both hashes are computed.
+  int hash_offset = OneByteString::kHashValueOffset - HeapObject::kTag;
+  __ lw(T0, Address(A1, hash_offset));
+  __ lw(T1, Address(A2, hash_offset));
+  __ addiu(A1, A1, Immediate(OneByteString::kSize - HeapObject::kTag));
+  __ addiu(A2, A2, Immediate(OneByteString::kSize - HeapObject::kTag));
+  __ B(EQ, T0, ZR, &loop);
+  __ B(EQ, T1, ZR, &loop);
+  __ B(NEQ, T0, T1, &not_equal);
+
+  // Compare the characters from the end.
+  __ Bind(&loop);
+  __ B(EQ, A3, ZR, &equal);
+  __ addiu(A3, A3, Immediate(-1));
+  __ addu(T2, A1, A3);
+  __ lbu(T0, Address(T2, 0));
+  __ addu(T2, A2, A3);
+  __ lbu(T1, Address(T2, 0));
+  __ B(EQ, T0, T1, &loop);
+
+  __ Bind(&not_equal);
+  LoadFalse(A0);
+  __ Jr(RA);
+
+  __ Bind(&equal);
+  LoadTrue(A0);
+  __ Jr(RA);
+}
+
+void InterpreterGeneratorMIPS::DoIntrinsicTwoByteStringCodeUnitAt() {
+  LoadLocal(A1, 0);  // Index.
+  LoadLocal(A2, 1);  // String.
+
+  ASSERT(Smi::kTag == 0);
+  __ andi(T0, A1, Immediate(Smi::kTagMask));
+  __ B(NEQ, T0, ZR, &intrinsic_failure_);
+  __ B(LT, A1, ZR, &intrinsic_failure_);
+
+  // Check the index against the length.
+  __ lw(A3, Address(A2, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ B(GE, A1, A3, &intrinsic_failure_);
+
+  // The smi-tagged index is the offset of the code unit. Load it and smi-tag
+  // it.
+  ASSERT(Smi::kTagSize == 1);
+  __ addu(A2, A2, A1);
+  __ lhu(A0, Address(A2, TwoByteString::kSize - HeapObject::kTag));
+  __ jr(RA);
+  __ addu(A0, A0, A0);  // Delay-slot.
+}
+
 void InterpreterGeneratorMIPS::Pop(Register reg) {
   __ lw(reg, Address(S2, 0));
   __ addiu(S2, S2, Immediate(1 * kWordSize));
@@ -2102,6 +2251,11 @@ void InterpreterGeneratorMIPS::CheckStackOverflow(int size) {
 }
 
 void InterpreterGeneratorMIPS::Dispatch(int size) {
+  if (IsFusedDispatch(size)) {
+    __ b(fused_second());
+    __ addiu(S1, S1, Immediate(size));  // Delay-slot.
+    return;
+  }
   __ lbu(S3, Address(S1, size));
   if (size > 0) {
     __ addiu(S1, S1, Immediate(size));
@@ -9,9 +9,11 @@
 #include "src/shared/selectors.h"
 
 #include "src/vm/assembler.h"
+#include "src/vm/emitter_x64.h"
 #include "src/vm/generator.h"
 #include "src/vm/interpreter.h"
 #include "src/vm/intrinsics.h"
+#include "src/vm/jit.h"
 #include "src/vm/object.h"
 #include "src/vm/process.h"
 #include "src/vm/program.h"
@@ -22,7 +24,11 @@ namespace dartino {
 
 class InterpreterGenerator {
  public:
-  explicit InterpreterGenerator(Assembler* assembler) : assembler_(assembler) {}
+  explicit InterpreterGenerator(Assembler* assembler)
+      : assembler_(assembler),
+        fused_size_(0),
+        fused_second_(NULL),
+        fused_cached_second_(NULL) {}
 
   void Generate();
 
@@ -32,6 +38,7 @@ class InterpreterGenerator {
   virtual void GenerateMethodEntry() = 0;
 
   virtual void GenerateBytecodePrologue(const char* name) = 0;
+  virtual void GenerateCachedBytecodePrologue(const char* name) = 0;
   virtual void GenerateDebugAtBytecode() = 0;
 
 #define V(name, branching, format, size, stack_diff, print) \
@@ -39,6 +46,23 @@ class InterpreterGenerator {
   BYTECODES_DO(V)
 #undef V
 
+#define V(name, original) virtual void Do##name() = 0;
+  QUICKENED_DO(V)
+#undef V
+
+  // The handlers used while the top of the stack is cached in a register.
+  // By default they spill it and continue in the regular handler.
+#define V(name, branching, format, size, stack_diff, print) \
+  virtual void DoCached##name() { SpillTopAndJump("BC_" #name); }
+  BYTECODES_DO(V)
+#undef V
+#define V(name, original) \
+  virtual void DoCached##name() { SpillTopAndJump("BC_" #name); }
+  QUICKENED_DO(V)
+#undef V
+
+  virtual void SpillTopAndJump(const char* name) = 0;
+
 #define V(name) virtual void DoIntrinsic##name() = 0;
   INTRINSICS_DO(V)
 #undef V
@@ -46,8 +70,19 @@ class InterpreterGenerator {
  protected:
   Assembler* assembler() const { return assembler_; }
 
+  // While the handler of a superinstruction is generated, dispatching past
+  // its first bytecode jumps straight to the handler of the second one.
+  bool IsFusedDispatch(int size) const {
+    return fused_second_ != NULL && size == fused_size_;
+  }
+  const char* fused_second() const { return fused_second_; }
+  const char* fused_cached_second() const { return fused_cached_second_; }
+
  private:
   Assembler* const assembler_;
+  int fused_size_;
+  const char* fused_second_;
+  const char* fused_cached_second_;
 };
 
 void InterpreterGenerator::Generate() {
@@ -64,6 +99,44 @@ void InterpreterGenerator::Generate() {
   BYTECODES_DO(V)
 #undef V
 
+#define V(name, first, second)                 \
+  GenerateBytecodePrologue("BC_" #name);       \
+  fused_size_ = k##first##Length;              \
+  fused_second_ = "BC_" #second;               \
+  fused_cached_second_ = "Cached_BC_" #second; \
+  Do##first();                                 \
+  fused_second_ = NULL;
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+
+#define V(name, original)                \
+  GenerateBytecodePrologue("BC_" #name); \
+  Do##name();
+  QUICKENED_DO(V)
+#undef V
+
+#define V(name, branching, format, size, stack_diff, print) \
+  GenerateCachedBytecodePrologue("Cached_BC_" #name);       \
+  DoCached##name();
+  BYTECODES_DO(V)
+#undef V
+
+#define V(name, first, second)                        \
+  GenerateCachedBytecodePrologue("Cached_BC_" #name); \
+  fused_size_ = k##first##Length;                     \
+  fused_second_ = "BC_" #second;                      \
+  fused_cached_second_ = "Cached_BC_" #second;        \
+  DoCached##first();                                  \
+  fused_second_ = NULL;
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+
+#define V(name, original)                             \
+  GenerateCachedBytecodePrologue("Cached_BC_" #name); \
+  DoCached##name();
+  QUICKENED_DO(V)
+#undef V
+
 #define V(name)                              \
   assembler()->Bind("", "Intrinsic_" #name); \
   DoIntrinsic##name();
@@ -74,6 +147,29 @@ void InterpreterGenerator::Generate() {
 #define V(name, branching, format, size, stack_diff, print) \
   assembler()->RelativeDefine("Rel_BC_" #name, "BC_" #name, "LocalInterpret");
   BYTECODES_DO(V)
+#undef V
+#define V(name, first, second) \
+  assembler()->RelativeDefine("Rel_BC_" #name, "BC_" #name, "LocalInterpret");
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original) \
+  assembler()->RelativeDefine("Rel_BC_" #name, "BC_" #name, "LocalInterpret");
+  QUICKENED_DO(V)
+#undef V
+#define V(name, branching, format, size, stack_diff, print)               \
+  assembler()->RelativeDefine("Rel_Cached_BC_" #name, "Cached_BC_" #name, \
+                              "LocalInterpret");
+  BYTECODES_DO(V)
+#undef V
+#define V(name, first, second)                                            \
+  assembler()->RelativeDefine("Rel_Cached_BC_" #name, "Cached_BC_" #name, \
+                              "LocalInterpret");
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original)                                                 \
+  assembler()->RelativeDefine("Rel_Cached_BC_" #name, "Cached_BC_" #name, \
+                              "LocalInterpret");
+  QUICKENED_DO(V)
 #undef V
   puts("\n");
 
@@ -84,11 +180,32 @@ void InterpreterGenerator::Generate() {
   assembler()->DefineLong("Rel_BC_" #name);
   BYTECODES_DO(V)
 #undef V
+#define V(name, first, second) assembler()->DefineLong("Rel_BC_" #name);
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original) assembler()->DefineLong("Rel_BC_" #name);
+  QUICKENED_DO(V)
+#undef V
+
+  assembler()->BindWithPowerOfTwoAlignment("Interpret_CachedDispatchTable", 4);
+  assembler()->LocalBind("LocalInterpret_CachedDispatchTable");
+#define V(name, branching, format, size, stack_diff, print) \
+  assembler()->DefineLong("Rel_Cached_BC_" #name);
+  BYTECODES_DO(V)
+#undef V
+#define V(name, first, second) assembler()->DefineLong("Rel_Cached_BC_" #name);
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original) assembler()->DefineLong("Rel_Cached_BC_" #name);
+  QUICKENED_DO(V)
+#undef V
 
   puts("\n");
 }
 
-class InterpreterGeneratorX64 : public InterpreterGenerator {
+class InterpreterGeneratorX64
+    : public InterpreterGenerator,
+      public EmitterX64<InterpreterGeneratorX64, Label> {
  public:
   explicit InterpreterGeneratorX64(Assembler* assembler)
       : InterpreterGenerator(assembler), spill_size_(-1) {}
@@ -99,6 +216,13 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
   //   r13: bytecode pointer (callee saved)
   //   rsp: stack pointer (Dart)
   //   rbp: frame pointer
+  //   r9: top of stack (in the Cached_ handlers)
+  //
+  // Bytecodes that push a value leave it in r9 and dispatch through the
+  // cached dispatch table, so the next bytecode can consume it without a
+  // round trip through memory. Handlers that are not specialized for this
+  // push r9 first, so the stack is always complete at calls, safepoints and
+  // breakpoints.
 
   virtual void GeneratePrologue();
   virtual void GenerateEpilogue();
@@ -106,8 +230,59 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
   virtual void GenerateMethodEntry();
 
   virtual void GenerateBytecodePrologue(const char* name);
+  virtual void GenerateCachedBytecodePrologue(const char* name);
   virtual void GenerateDebugAtBytecode();
 
+  virtual void SpillTopAndJump(const char* name);
+
+  virtual void DoCachedLoadLocal0() { CachedLoadLocal(0); }
+  virtual void DoCachedLoadLocal1() { CachedLoadLocal(1); }
+  virtual void DoCachedLoadLocal2() { CachedLoadLocal(2); }
+  virtual void DoCachedLoadLocal3() { CachedLoadLocal(3); }
+  virtual void DoCachedLoadLocal4() { CachedLoadLocal(4); }
+  virtual void DoCachedLoadLocal5() { CachedLoadLocal(5); }
+  virtual void DoCachedLoadLocal();
+  virtual void DoCachedLoadField();
+  virtual void DoCachedLoadConst();
+  virtual void DoCachedLoadStaticInitialized();
+  virtual void DoCachedStoreLocal();
+  virtual void DoCachedLoadLiteralNull();
+  virtual void DoCachedLoadLiteralTrue();
+  virtual void DoCachedLoadLiteralFalse();
+  virtual void DoCachedLoadLiteral0();
+  virtual void DoCachedLoadLiteral1();
+  virtual void DoCachedLoadLiteral();
+  virtual void DoCachedPop();
+  virtual void DoCachedReturn();
+  virtual void DoCachedInvokeMethodUnfold();
+  virtual void DoCachedInvokeMethod();
+  virtual void DoCachedInvokeMethod0() { CachedInvokeMethod(0); }
+  virtual void DoCachedInvokeMethod1() { CachedInvokeMethod(1); }
+  virtual void DoCachedInvokeMethod2() { CachedInvokeMethod(2); }
+  virtual void DoCachedInvokeMethod3() { CachedInvokeMethod(3); }
+  virtual void DoCachedInvokeStatic();
+  virtual void DoCachedInvokeFactory();
+  virtual void DoCachedBranchIfTrueWide();
+  virtual void DoCachedBranchIfFalseWide();
+
+#define CACHED_INVOKE_BUILTIN(kind)                 \
+  virtual void DoCachedInvoke##kind##Unfold() {     \
+    CachedInvoke##kind("BC_Invoke" #kind "Unfold"); \
+  }                                                 \
+  virtual void DoCachedInvoke##kind() {             \
+    CachedInvoke##kind("BC_Invoke" #kind);          \
+  }
+
+  CACHED_INVOKE_BUILTIN(Eq);
+  CACHED_INVOKE_BUILTIN(Lt);
+  CACHED_INVOKE_BUILTIN(Le);
+  CACHED_INVOKE_BUILTIN(Gt);
+  CACHED_INVOKE_BUILTIN(Ge);
+  CACHED_INVOKE_BUILTIN(Add);
+  CACHED_INVOKE_BUILTIN(Sub);
+
+#undef CACHED_INVOKE_BUILTIN
+
   virtual void DoLoadLocal0();
   virtual void DoLoadLocal1();
   virtual void DoLoadLocal2();
@@ -120,6 +295,7 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
   virtual void DoLoadBoxed();
   virtual void DoLoadStatic();
   virtual void DoLoadStaticInit();
+  virtual void DoLoadStaticInitialized();
   virtual void DoLoadField();
   virtual void DoLoadFieldWide();
 
@@ -141,6 +317,10 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
 
   virtual void DoInvokeMethodUnfold();
   virtual void DoInvokeMethod();
+  virtual void DoInvokeMethod0() { InvokeMethod(false, 0); }
+  virtual void DoInvokeMethod1() { InvokeMethod(false, 1); }
+  virtual void DoInvokeMethod2() { InvokeMethod(false, 2); }
+  virtual void DoInvokeMethod3() { InvokeMethod(false, 3); }
 
   virtual void DoInvokeNoSuchMethod();
   virtual void DoInvokeTestNoSuchMethod();
@@ -235,8 +415,15 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
   virtual void DoIntrinsicListIndexGet();
   virtual void DoIntrinsicListIndexSet();
   virtual void DoIntrinsicListLength();
+  virtual void DoIntrinsicStringLength();
+  virtual void DoIntrinsicStringHashCode();
+  virtual void DoIntrinsicOneByteStringCodeUnitAt();
+  virtual void DoIntrinsicOneByteStringEqual();
+  virtual void DoIntrinsicTwoByteStringCodeUnitAt();
 
  private:
+  friend class EmitterX64<InterpreterGeneratorX64, Label>;
+
   Label done_;
   Label done_state_saved_;
   Label gc_;
@@ -246,37 +433,27 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
   Label interpreter_entry_;
   int spill_size_;
 
-  void LoadLocal(Register reg, int index);
-  void StoreLocal(Register reg, int index);
-  void StoreLocal(const Immediate& value, int index);
-
-  void Push(Register reg);
-  void Pop(Register reg);
-  void Drop(int n);
-  void Drop(Register reg);
-
-  void LoadProcess(Register reg);
-  void LoadProgram(Register reg);
-  void LoadStaticsArray(Register reg);
-  void LoadLiteralNull(Register reg);
-  void LoadLiteralTrue(Register reg);
-  void LoadLiteralFalse(Register reg);
-
-  void SwitchToDartStack();
-  void SwitchToCStack();
-
   void StoreByteCodePointer();
   void RestoreByteCodePointer();
 
-  void Return(bool is_return_null);
-
   void Allocate(bool immutable);
 
-  // This function overwrites the 'object' and 'scratch' registers!
-  void AddToRememberedSet(Register object, Register value, Register scratch);
-
   void InvokeMethodUnfold(bool test);
-  void InvokeMethod(bool test);
+  // With an [arity], the invoke is the quickened variant for it, which
+  // only decodes the selector when the inline cache misses.
+  void InvokeMethod(bool test, int arity = -1);
+
+  // Looks up the receiver class in [clazz] in the inline cache of the call
+  // site. On a hit it jumps to [hit] with the target in RAX and its code in
+  // RBX. Overwrites RAX and RSI.
+  void ProbeInlineCache(Register clazz, Label* hit);
+
+  // Makes the target in RAX with its code in RBX the first way of the
+  // inline cache of the call site for the receiver class in [clazz].
+  // Overwrites RSI, RDI, R9 and R10.
+  void UpdateInlineCache(Register clazz);
+  // Loads the address of the home entry of the call site at R13.
+  void LoadInlineCacheEntry(Register reg, Register scratch);
 
   void InvokeStatic();
 
@@ -287,6 +464,12 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
   void InvokeGe(const char* fallback);
   void InvokeCompare(const char* fallback, Condition condition);
 
+  // Replace the two arguments of an arithmetic bytecode of [size] bytes with
+  // a new large integer holding RAX or a new double holding XMM0, and
+  // dispatch to the next bytecode.
+  void StoreLargeIntegerResult(int size, const char* fallback);
+  void StoreDoubleResult(int size, const char* fallback);
+
   void InvokeAdd(const char* fallback);
   void InvokeSub(const char* fallback);
   void InvokeMod(const char* fallback);
@@ -303,10 +486,42 @@ class InterpreterGeneratorX64 : public InterpreterGenerator {
 
   void InvokeNative(bool yield, bool safepoint);
 
+  // Binds the handler [name] after its debug entry, which calls [debug].
+  void GenerateHandlerPrologue(const char* name, const char* debug);
+
+  // Pushes R9 and loads local [index], counting from the cached top.
+  void CachedLoadLocal(int index);
+
+  // The fast paths of the builtin invokes with the right operand in R9.
+  // They spill it and jump to the regular handler [fallback] otherwise.
+  void CachedInvokeEq(const char* fallback) {
+    CachedInvokeCompare(fallback, EQUAL);
+  }
+  void CachedInvokeLt(const char* fallback) {
+    CachedInvokeCompare(fallback, LESS);
+  }
+  void CachedInvokeLe(const char* fallback) {
+    CachedInvokeCompare(fallback, LESS_EQUAL);
+  }
+  void CachedInvokeGt(const char* fallback) {
+    CachedInvokeCompare(fallback, GREATER);
+  }
+  void CachedInvokeGe(const char* fallback) {
+    CachedInvokeCompare(fallback, GREATER_EQUAL);
+  }
+  void CachedInvokeCompare(const char* fallback, Condition condition);
+  void CachedInvokeMethod(int arity);
+  void CachedInvokeAdd(const char* fallback);
+  void CachedInvokeSub(const char* fallback);
+
   void CheckStackOverflow(int size);
 
   void Dispatch(int size);
 
+  // Dispatches to the handler of the next bytecode with the top of the stack
+  // in R9 rather than on the stack.
+  void DispatchCached(int size);
+
   void SaveState(Label* resume);
   void RestoreState();
 
@@ -347,6 +562,7 @@ void InterpreterGeneratorX64::GeneratePrologue() {
   // Dart stack slot.
   // We reserve two extra slots on the stack for use in DoThrowAfterSaveState.
   spill_size_ = ComputeStackPadding(10 * kWordSize, 2 * kWordSize);
+  ASSERT(spill_size_ == Jit::kInterpreterSpillSize);
   if (spill_size_ > 0) __ subq(RSP, Immediate(spill_size_));
 
   // Restore the register state and dispatch to the first bytecode.
@@ -378,17 +594,51 @@ void InterpreterGeneratorX64::GenerateEpilogue() {
   __ Bind(&interpreter_entry_);
   Dispatch(0);
 
-  // Handle GC and re-interpret current bytecode.
+  // Handle GC and re-interpret current bytecode. Compiled code gets here
+  // through InterpreterGCEntry.
+  __ Bind("", "InterpreterGCEntry");
   __ Bind(&gc_);
   SaveState(&interpreter_entry_);
   LoadProcess(RDI);
   __ call("HandleGC");
   RestoreState();
 
+  // When the compiled code of a function is discarded, the calls that
+  // activations of it are waiting for return here instead (see
+  // Jit::DiscardCode). The interpreter finishes the invoke like the handler
+  // of the bytecode would, and runs the rest of the activation.
+  __ Bind("", "InterpreterInvokeMethodReturn");
+  RestoreByteCodePointer();
+  __ movq(RDX, Address(R13, 1));
+  ASSERT(Selector::ArityField::shift() == 0);
+  __ andq(RDX, Immediate(Selector::ArityField::mask()));
+  Drop(RDX);
+  StoreLocal(RAX, 0);
+  ASSERT(kInvokeMethodLength == kInvokeMethodUnfoldLength);
+  Dispatch(kInvokeMethodLength);
+
+  __ Bind("", "InterpreterInvokeStaticReturn");
+  RestoreByteCodePointer();
+  __ movl(RDX, Address(R13, 1));
+  __ movq(RDX, Address(R13, RDX, TIMES_1));
+  __ movq(RDX, Address(RDX, Function::kArityOffset - HeapObject::kTag));
+  __ shrq(RDX, Immediate(Smi::kTagSize));
+  Drop(RDX);
+  Push(RAX);
+  ASSERT(kInvokeStaticLength == kInvokeFactoryLength);
+  Dispatch(kInvokeStaticLength);
+
+  __ Bind("", "InterpreterLoadStaticInitReturn");
+  RestoreByteCodePointer();
+  Push(RAX);
+  Dispatch(kLoadStaticInitLength);
+
   // Stack overflow handling (slow case).
   Label stay_fast, overflow, check_debug_interrupt, overflow_resume;
   __ Bind(&check_stack_overflow_0_);
   __ xorq(RAX, RAX);
+  // Compiled code gets here with the size in RAX.
+  __ Bind("", "InterpreterStackOverflowEntry");
   __ Bind(&check_stack_overflow_);
   SaveState(&overflow_resume);
 
@@ -436,9 +686,58 @@ void InterpreterGeneratorX64::GenerateMethodEntry() {
   __ leaq(R13, Address(RAX, Function::kSize - HeapObject::kTag));
   CheckStackOverflow(0);
   Dispatch(0);
+
+  // The method entry with -Xjit (see Jit::MethodEntry). Jumps to the
+  // compiled code of the function if there is any. Otherwise it counts the
+  // call, and lets the JIT have a look when the count runs out.
+  __ AlignToPowerOfTwo(3);
+  __ Bind("", "InterpreterJitMethodEntry");
+  Label count, hot;
+  ASSERT(Jit::kEntrySize == 2 << Jit::kEntryShift);
+  __ movq(RBX, RAX);
+  __ andq(RBX, Immediate((kJitEntries - 1) << Jit::kEntryShift));
+  __ LoadLabel(RCX, "JitEntries");
+  __ movq(RDX, Address(RCX, RBX, TIMES_2, Jit::kEntryCodeOffset));
+  __ cmpq(RAX, Address(RDX, JitCode::kFunctionOffset));
+  __ j(NOT_EQUAL, &count);
+  __ addq(RDX, Immediate(JitCode::kSize));
+  __ jmp(RDX);
+
+  __ Bind(&count);
+  __ addl(Address(RCX, RBX, TIMES_2, Jit::kEntryCounterOffset),
+          Immediate(-1));
+  __ j(ZERO, &hot);
+  __ jmp("LocalInterpreterMethodEntry");
+
+  // The function is callee-saved in R13 across the call.
+  __ Bind(&hot);
+  __ movq(R13, RAX);
+  LoadProcess(RDI);
+  __ movq(RSI, RAX);
+  SwitchToCStack();
+  __ call("HandleHotFunction");
+  SwitchToDartStack();
+  __ movq(RCX, RAX);
+  __ movq(RAX, R13);
+  __ testq(RCX, RCX);
+  __ j(ZERO, "LocalInterpreterMethodEntry");
+  __ jmp(RCX);
 }
 
 void InterpreterGeneratorX64::GenerateBytecodePrologue(const char* name) {
+  GenerateHandlerPrologue(name, "DebugAtBytecode");
+}
+
+void InterpreterGeneratorX64::GenerateCachedBytecodePrologue(
+    const char* name) {
+  // The debug entries of the cached handlers are at the same distance from
+  // the handlers as the regular ones, so breakpoints are set and cleared in
+  // both dispatch tables the same way.
+  GenerateHandlerPrologue(name, "DebugAtCachedBytecode");
+}
+
+void InterpreterGeneratorX64::GenerateHandlerPrologue(const char* name,
+                                                      const char* debug) {
   __ SwitchToText();
   __ AlignToPowerOfTwo(3);
   __ nop();
@@ -446,7 +745,7 @@ void InterpreterGeneratorX64::GenerateBytecodePrologue(const char* name) {
   __ nop();
   __ nop();
   __ Bind("Debug_", name);
-  __ call("DebugAtBytecode");
+  __ call(debug);
   __ AlignToPowerOfTwo(3);
   __ Bind("", name);
 }
@@ -467,49 +766,257 @@ void InterpreterGeneratorX64::GenerateDebugAtBytecode() {
   __ j(NOT_ZERO, &done_);
   __ pushq(RBX);
   __ ret();
+
+  // Spill the cached top and redo the dispatch through the regular table,
+  // which breaks in the debug entry of the bytecode.
+  __ Bind("", "DebugAtCachedBytecode");
+  __ popq(RBX);
+  __ pushq(R9);
+  Dispatch(0);
 }
 
-void InterpreterGeneratorX64::DoLoadLocal0() {
+void InterpreterGeneratorX64::SpillTopAndJump(const char* name) {
+  __ pushq(R9);
+  __ jmp(name);
+}
+
+void InterpreterGeneratorX64::CachedLoadLocal(int index) {
+  __ pushq(R9);
+  if (index > 0) LoadLocal(R9, index);
+  DispatchCached(1);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLocal() {
+  __ movzbq(RAX, Address(R13, 1));
+  __ pushq(R9);
+  __ movq(R9, Address(RSP, RAX, TIMES_WORD_SIZE));
+  DispatchCached(kLoadLocalLength);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadField() {
+  __ movzbq(RBX, Address(R13, 1));
+  __ movq(R9, Address(R9, RBX, TIMES_WORD_SIZE,
+                      Instance::kSize - HeapObject::kTag));
+  DispatchCached(kLoadFieldLength);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadConst() {
+  __ pushq(R9);
+  __ movl(RAX, Address(R13, 1));
+  __ movq(R9, Address(R13, RAX, TIMES_1));
+  DispatchCached(kLoadConstLength);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadStaticInitialized() {
+  __ pushq(R9);
+  __ movl(RAX, Address(R13, 1));
+  LoadStaticsArray(RBX);
+  __ movq(R9,
+          Address(RBX, RAX, TIMES_WORD_SIZE, Array::kSize - HeapObject::kTag));
+  DispatchCached(kLoadStaticInitializedLength);
+}
+
+void InterpreterGeneratorX64::DoCachedStoreLocal() {
+  // Local zero is R9, so the others are one slot closer to the top.
+  __ movzbq(RAX, Address(R13, 1));
+  __ movq(Address(RSP, RAX, TIMES_WORD_SIZE, -kWordSize), R9);
+  DispatchCached(2);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLiteralNull() {
+  __ pushq(R9);
+  LoadLiteralNull(R9);
+  DispatchCached(1);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLiteralTrue() {
+  __ pushq(R9);
+  LoadLiteralTrue(R9);
+  DispatchCached(1);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLiteralFalse() {
+  __ pushq(R9);
+  LoadLiteralFalse(R9);
+  DispatchCached(1);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLiteral0() {
+  __ pushq(R9);
+  __ movq(R9, Immediate(reinterpret_cast<word>(Smi::FromWord(0))));
+  DispatchCached(1);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLiteral1() {
+  __ pushq(R9);
+  __ movq(R9, Immediate(reinterpret_cast<word>(Smi::FromWord(1))));
+  DispatchCached(1);
+}
+
+void InterpreterGeneratorX64::DoCachedLoadLiteral() {
+  __ pushq(R9);
+  __ movzbq(R9, Address(R13, 1));
+  __ shll(R9, Immediate(Smi::kTagSize));
+  ASSERT(Smi::kTag == 0);
+  DispatchCached(2);
+}
+
+void InterpreterGeneratorX64::DoCachedPop() { Dispatch(kPopLength); }
+
+// Calls often follow a bytecode that left their last argument in r9. Their
+// cached handlers spill it in place rather than jumping to the regular
+// handler, which saves a jump on every call.
+void InterpreterGeneratorX64::DoCachedInvokeMethodUnfold() {
+  __ pushq(R9);
+  InvokeMethodUnfold(false);
+}
+
+void InterpreterGeneratorX64::DoCachedInvokeMethod() {
+  __ pushq(R9);
+  InvokeMethod(false);
+}
+
+void InterpreterGeneratorX64::CachedInvokeMethod(int arity) {
+  __ pushq(R9);
+  InvokeMethod(false, arity);
+}
+
+void InterpreterGeneratorX64::DoCachedInvokeStatic() {
+  __ pushq(R9);
+  InvokeStatic();
+}
+
+void InterpreterGeneratorX64::DoCachedInvokeFactory() {
+  __ pushq(R9);
+  InvokeStatic();
+}
+
+void InterpreterGeneratorX64::DoCachedReturn() {
+  __ movq(RAX, R9);
+  __ movq(RSP, RBP);
+  __ popq(RBP);
+  __ ret();
+}
+
+void InterpreterGeneratorX64::DoCachedBranchIfTrueWide() {
+  Label branch;
+  LoadLiteralTrue(RAX);
+  __ cmpq(R9, RAX);
+  __ j(EQUAL, &branch);
+  Dispatch(kBranchIfTrueWideLength);
+
+  __ Bind(&branch);
+  __ movl(RAX, Address(R13, 1));
+  __ addq(R13, RAX);
+  Dispatch(0);
+}
+
+void InterpreterGeneratorX64::DoCachedBranchIfFalseWide() {
+  Label branch;
+  LoadLiteralTrue(RAX);
+  __ cmpq(R9, RAX);
+  __ j(NOT_EQUAL, &branch);
+  Dispatch(kBranchIfFalseWideLength);
+
+  __ Bind(&branch);
+  __ movl(RAX, Address(R13, 1));
+  __ addq(R13, RAX);
+  Dispatch(0);
+}
+
+void InterpreterGeneratorX64::CachedInvokeCompare(const char* fallback,
+                                                  Condition condition) {
+  Label spill, true_case;
   LoadLocal(RAX, 0);
-  Push(RAX);
-  Dispatch(1);
+  __ testl(RAX, Immediate(Smi::kTagSize));
+  __ j(NOT_ZERO, &spill);
+  __ testl(R9, Immediate(Smi::kTagSize));
+  __ j(NOT_ZERO, &spill);
+
+  Drop(1);
+  __ cmpq(RAX, R9);
+  __ j(condition, &true_case);
+  LoadLiteralFalse(R9);
+  DispatchCached(5);
+
+  __ Bind(&true_case);
+  LoadLiteralTrue(R9);
+  DispatchCached(5);
+
+  __ Bind(&spill);
+  SpillTopAndJump(fallback);
+}
+
+void InterpreterGeneratorX64::CachedInvokeAdd(const char* fallback) {
+  Label spill;
+  LoadLocal(RAX, 0);
+  __ testl(RAX, Immediate(Smi::kTagSize));
+  __ j(NOT_ZERO, &spill);
+  __ testl(R9, Immediate(Smi::kTagSize));
+  __ j(NOT_ZERO, &spill);
+
+  __ addq(RAX, R9);
+  __ j(OVERFLOW_, &spill);
+  __ movq(R9, RAX);
+  Drop(1);
+  DispatchCached(kInvokeAddLength);
+
+  __ Bind(&spill);
+  SpillTopAndJump(fallback);
+}
+
+void InterpreterGeneratorX64::CachedInvokeSub(const char* fallback) {
+  Label spill;
+  LoadLocal(RAX, 0);
+  __ testl(RAX, Immediate(Smi::kTagSize));
+  __ j(NOT_ZERO, &spill);
+  __ testl(R9, Immediate(Smi::kTagSize));
+  __ j(NOT_ZERO, &spill);
+
+  __ subq(RAX, R9);
+  __ j(OVERFLOW_, &spill);
+  __ movq(R9, RAX);
+  Drop(1);
+  DispatchCached(kInvokeSubLength);
+
+  __ Bind(&spill);
+  SpillTopAndJump(fallback);
+}
+
+void InterpreterGeneratorX64::DoLoadLocal0() {
+  LoadLocal(R9, 0);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLocal1() {
-  LoadLocal(RAX, 1);
-  Push(RAX);
-  Dispatch(1);
+  LoadLocal(R9, 1);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLocal2() {
-  LoadLocal(RAX, 2);
-  Push(RAX);
-  Dispatch(1);
+  LoadLocal(R9, 2);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLocal3() {
-  LoadLocal(RAX, 3);
-  Push(RAX);
-  Dispatch(1);
+  LoadLocal(R9, 3);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLocal4() {
-  LoadLocal(RAX, 4);
-  Push(RAX);
-  Dispatch(1);
+  LoadLocal(R9, 4);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLocal5() {
-  LoadLocal(RAX, 5);
-  Push(RAX);
-  Dispatch(1);
+  LoadLocal(R9, 5);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLocal() {
   __ movzbq(RAX, Address(R13, 1));
-  __ movq(RAX, Address(RSP, RAX, TIMES_WORD_SIZE));
-  Push(RAX);
-  Dispatch(kLoadLocalLength);
+  __ movq(R9, Address(RSP, RAX, TIMES_WORD_SIZE));
+  DispatchCached(kLoadLocalLength);
 }
 
 void InterpreterGeneratorX64::DoLoadLocalWide() {
@@ -542,17 +1049,8 @@ void InterpreterGeneratorX64::DoLoadStaticInit() {
   __ movq(RAX,
           Address(RBX, RAX, TIMES_WORD_SIZE, Array::kSize - HeapObject::kTag));
 
-  Label done;
-  ASSERT(Smi::kTag == 0);
-  __ testl(RAX, Immediate(Smi::kTagMask));
-  __ j(ZERO, &done);
-  __ movq(RBX, Address(RAX, HeapObject::kClassOffset - HeapObject::kTag));
-  __ movq(RBX, Address(RBX, Class::kInstanceFormatOffset - HeapObject::kTag));
-
-  int type = InstanceFormat::INITIALIZER_TYPE;
-  __ andq(RBX, Immediate(InstanceFormat::TypeField::mask()));
-  __ cmpq(RBX, Immediate(type << InstanceFormat::TypeField::shift()));
-  __ j(NOT_EQUAL, &done);
+  Label initialized, done;
+  JumpIfNotInitializer(RAX, &initialized);
 
   // Invoke the initializer function.
   __ movq(RAX, Address(RAX, Initializer::kFunctionOffset - HeapObject::kTag));
@@ -560,19 +1058,36 @@ void InterpreterGeneratorX64::DoLoadStaticInit() {
   StoreByteCodePointer();
   __ call("LocalInterpreterMethodEntry");
   RestoreByteCodePointer();
+  __ jmp(&done);
+
+  // The static stays initialized, so quicken the bytecode to skip the
+  // check from now on, if the program lets us.
+  __ Bind(&initialized);
+  LoadProgram(RBX);
+  __ movq(RBX, Address(RBX, Program::kQuickenStaticLoadsOffset));
+  __ testq(RBX, RBX);
+  __ j(ZERO, &done);
+  __ movb(Address(R13, 0), Immediate(kLoadStaticInitialized));
 
   __ Bind(&done);
   Push(RAX);
   Dispatch(kLoadStaticInitLength);
 }
 
+void InterpreterGeneratorX64::DoLoadStaticInitialized() {
+  __ movl(RAX, Address(R13, 1));
+  LoadStaticsArray(RBX);
+  __ movq(R9,
+          Address(RBX, RAX, TIMES_WORD_SIZE, Array::kSize - HeapObject::kTag));
+  DispatchCached(kLoadStaticInitializedLength);
+}
+
 void InterpreterGeneratorX64::DoLoadField() {
   __ movzbq(RBX, Address(R13, 1));
-  LoadLocal(RAX, 0);
-  __ movq(RAX, Address(RAX, RBX, TIMES_WORD_SIZE,
-                       Instance::kSize - HeapObject::kTag));
-  StoreLocal(RAX, 0);
-  Dispatch(kLoadFieldLength);
+  Pop(RAX);
+  __ movq(R9, Address(RAX, RBX, TIMES_WORD_SIZE,
+                      Instance::kSize - HeapObject::kTag));
+  DispatchCached(kLoadFieldLength);
 }
 
 void InterpreterGeneratorX64::DoLoadFieldWide() {
@@ -586,9 +1101,8 @@ void InterpreterGeneratorX64::DoLoadFieldWide() {
 
 void InterpreterGeneratorX64::DoLoadConst() {
   __ movl(RAX, Address(R13, 1));
-  __ movq(RAX, Address(R13, RAX, TIMES_1));
-  Push(RAX);
-  Dispatch(kLoadConstLength);
+  __ movq(R9, Address(R13, RAX, TIMES_1));
+  DispatchCached(kLoadConstLength);
 }
 
 void InterpreterGeneratorX64::DoStoreLocal() {
@@ -652,39 +1166,35 @@ void InterpreterGeneratorX64::DoStoreFieldWide() {
 }
 
 void InterpreterGeneratorX64::DoLoadLiteralNull() {
-  LoadLiteralNull(RAX);
-  Push(RAX);
-  Dispatch(1);
+  LoadLiteralNull(R9);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLiteralTrue() {
-  LoadLiteralTrue(RAX);
-  Push(RAX);
-  Dispatch(1);
+  LoadLiteralTrue(R9);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLiteralFalse() {
-  LoadLiteralFalse(RAX);
-  Push(RAX);
-  Dispatch(1);
+  LoadLiteralFalse(R9);
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLiteral0() {
-  __ pushq(Immediate(reinterpret_cast<word>(Smi::FromWord(0))));
-  Dispatch(1);
+  __ movq(R9, Immediate(reinterpret_cast<word>(Smi::FromWord(0))));
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLiteral1() {
-  __ pushq(Immediate(reinterpret_cast<word>(Smi::FromWord(1))));
-  Dispatch(1);
+  __ movq(R9, Immediate(reinterpret_cast<word>(Smi::FromWord(1))));
+  DispatchCached(1);
 }
 
 void InterpreterGeneratorX64::DoLoadLiteral() {
-  __ movzbq(RAX, Address(R13, 1));
-  __ shll(RAX, Immediate(Smi::kTagSize));
+  __ movzbq(R9, Address(R13, 1));
+  __ shll(R9, Immediate(Smi::kTagSize));
   ASSERT(Smi::kTag == 0);
-  Push(RAX);
-  Dispatch(2);
+  DispatchCached(2);
 }
 
 void InterpreterGeneratorX64::DoLoadLiteralWide() {
@@ -808,33 +1318,65 @@ void InterpreterGeneratorX64::InvokeGe(const char* fallback) {
 }
 
 void InterpreterGeneratorX64::InvokeAdd(const char* fallback) {
+  Label not_smis, overflow;
   LoadLocal(RAX, 1);
   __ testl(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
   LoadLocal(RBX, 0);
   __ testl(RBX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
 
   __ addq(RAX, RBX);
-  __ j(OVERFLOW_, fallback);
-  StoreLocal(RAX, 1);
-  Drop(1);
-  Dispatch(kInvokeAddLength);
+  __ j(OVERFLOW_, &overflow);
+  __ movq(R9, RAX);
+  Drop(2);
+  DispatchCached(kInvokeAddLength);
+
+  // The untagged sum always fits in a large integer.
+  __ Bind(&overflow);
+  LoadLocal(RAX, 1);
+  __ sarq(RAX, Immediate(1));
+  __ sarq(RBX, Immediate(1));
+  __ addq(RAX, RBX);
+  StoreLargeIntegerResult(kInvokeAddLength, fallback);
+
+  __ Bind(&not_smis);
+  LoadLocal(RAX, 1);
+  LoadLocal(RBX, 0);
+  LoadDoubleValues(RAX, RBX, fallback);
+  __ addsd(XMM0, XMM1);
+  StoreDoubleResult(kInvokeAddLength, fallback);
 }
 
 void InterpreterGeneratorX64::InvokeSub(const char* fallback) {
+  Label not_smis, overflow;
   LoadLocal(RAX, 1);
   __ testq(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
   LoadLocal(RBX, 0);
   __ testq(RBX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
 
   __ subq(RAX, RBX);
-  __ j(OVERFLOW_, fallback);
-  StoreLocal(RAX, 1);
-  Drop(1);
-  Dispatch(kInvokeSubLength);
+  __ j(OVERFLOW_, &overflow);
+  __ movq(R9, RAX);
+  Drop(2);
+  DispatchCached(kInvokeSubLength);
+
+  // The untagged difference always fits in a large integer.
+  __ Bind(&overflow);
+  LoadLocal(RAX, 1);
+  __ sarq(RAX, Immediate(1));
+  __ sarq(RBX, Immediate(1));
+  __ subq(RAX, RBX);
+  StoreLargeIntegerResult(kInvokeSubLength, fallback);
+
+  __ Bind(&not_smis);
+  LoadLocal(RAX, 1);
+  LoadLocal(RBX, 0);
+  LoadDoubleValues(RAX, RBX, fallback);
+  __ subsd(XMM0, XMM1);
+  StoreDoubleResult(kInvokeSubLength, fallback);
 }
 
 void InterpreterGeneratorX64::InvokeMod(const char* fallback) {
@@ -843,14 +1385,16 @@ void InterpreterGeneratorX64::InvokeMod(const char* fallback) {
 }
 
 void InterpreterGeneratorX64::InvokeMul(const char* fallback) {
+  Label not_smis, overflow;
   LoadLocal(RAX, 1);
   __ testl(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
   LoadLocal(RBX, 0);
   __ testl(RBX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
 
-  // Untag and multiply.
+  // Untag and multiply. Products that do not fit in 64 bits are left to the
+  // runtime.
   __ sarq(RAX, Immediate(1));
   __ sarq(RBX, Immediate(1));
   __ imul(RBX);
@@ -860,11 +1404,27 @@ void InterpreterGeneratorX64::InvokeMul(const char* fallback) {
   // where the top two bits are 01 after the multiplication.
   ASSERT(Smi::kTagSize == 1 && Smi::kTag == 0);
   __ addq(RAX, RAX);
-  __ j(OVERFLOW_, fallback);
+  __ j(OVERFLOW_, &overflow);
 
   StoreLocal(RAX, 1);
   Drop(1);
   Dispatch(kInvokeMulLength);
+
+  // The untagged product fits in a large integer.
+  __ Bind(&overflow);
+  LoadLocal(RAX, 1);
+  LoadLocal(RBX, 0);
+  __ sarq(RAX, Immediate(1));
+  __ sarq(RBX, Immediate(1));
+  __ imul(RBX);
+  StoreLargeIntegerResult(kInvokeMulLength, fallback);
+
+  __ Bind(&not_smis);
+  LoadLocal(RAX, 1);
+  LoadLocal(RBX, 0);
+  LoadDoubleValues(RAX, RBX, fallback);
+  __ mulsd(XMM0, XMM1);
+  StoreDoubleResult(kInvokeMulLength, fallback);
 }
 
 void InterpreterGeneratorX64::InvokeTruncDiv(const char* fallback) {
@@ -872,13 +1432,7 @@ void InterpreterGeneratorX64::InvokeTruncDiv(const char* fallback) {
 }
 
 void InterpreterGeneratorX64::InvokeBitNot(const char* fallback) {
-  LoadLocal(RAX, 0);
-  __ testl(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
-
-  __ notq(RAX);
-  __ andq(RAX, Immediate(~Smi::kTagMask));
-  StoreLocal(RAX, 0);
+  SmiBitNot(fallback);
   Dispatch(kInvokeBitNotLength);
 }
 
@@ -925,61 +1479,12 @@ void InterpreterGeneratorX64::InvokeBitXor(const char* fallback) {
 }
 
 void InterpreterGeneratorX64::InvokeBitShr(const char* fallback) {
-  LoadLocal(RAX, 1);
-  __ testq(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
-  LoadLocal(RCX, 0);
-  __ testq(RCX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
-
-  // Untag the smis and do the shift.
-  __ sarq(RAX, Immediate(1));
-  __ sarq(RCX, Immediate(1));
-  __ cmpq(RCX, Immediate(64));
-  Label shift;
-  __ j(LESS, &shift);
-  __ movq(RCX, Immediate(63));
-  __ Bind(&shift);
-  __ sarq_cl(RAX);
-
-  // Re-tag the resulting smi. No need to check for overflow
-  // here, because the top two bits of eax are either 00 or 11
-  // because we've shifted eax arithmetically at least one
-  // position to the right.
-  ASSERT(Smi::kTagSize == 1 && Smi::kTag == 0);
-  __ addq(RAX, RAX);
-
-  StoreLocal(RAX, 1);
-  Drop(1);
+  SmiBitShr(fallback);
   Dispatch(kInvokeBitShrLength);
 }
 
 void InterpreterGeneratorX64::InvokeBitShl(const char* fallback) {
-  LoadLocal(RAX, 1);
-  __ testq(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
-  LoadLocal(RCX, 0);
-  __ testq(RCX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
-
-  // Untag the shift count, but not the value. If the shift
-  // count is greater than 31 (or negative), the shift is going
-  // to misbehave so we have to guard against that.
-  __ sarq(RCX, Immediate(1));
-  __ cmpq(RCX, Immediate(64));
-  __ j(ABOVE_EQUAL, fallback);
-
-  // Only allow to shift out "sign bits". If we shift
-  // out any other bit, it's an overflow.
-  __ movq(RBX, RAX);
-  __ shlq_cl(RAX);
-  __ movq(RDX, RAX);
-  __ sarq_cl(RDX);
-  __ cmpq(RBX, RDX);
-  __ j(NOT_EQUAL, fallback);
-
-  StoreLocal(RAX, 1);
-  Drop(1);
+  SmiBitShl(fallback);
   Dispatch(kInvokeBitShlLength);
 }
 
@@ -1268,34 +1773,9 @@ void InterpreterGeneratorX64::DoIdentical() {
   // TODO(ager): For now we bail out if we have two doubles or two
   // large integers and let the slow interpreter deal with it. These
   // cases could be dealt with directly here instead.
-  Label fast_case;
   Label bail_out;
+  JumpIfIdenticalByValue(&bail_out);
 
-  // If either is a smi they are not both doubles or large integers.
-  __ testq(RAX, Immediate(Smi::kTagMask));
-  __ j(ZERO, &fast_case);
-  __ testq(RBX, Immediate(Smi::kTagMask));
-  __ j(ZERO, &fast_case);
-
-  // If they do not have the same type they are not both double or
-  // large integers.
-  __ movq(RCX, Address(RAX, HeapObject::kClassOffset - HeapObject::kTag));
-  __ movq(RCX, Address(RCX, Class::kInstanceFormatOffset - HeapObject::kTag));
-  __ movq(RDX, Address(RBX, HeapObject::kClassOffset - HeapObject::kTag));
-  __ cmpq(RCX, Address(RDX, Class::kInstanceFormatOffset - HeapObject::kTag));
-  __ j(NOT_EQUAL, &fast_case);
-
-  int double_type = InstanceFormat::DOUBLE_TYPE;
-  int large_integer_type = InstanceFormat::LARGE_INTEGER_TYPE;
-  int type_field_shift = InstanceFormat::TypeField::shift();
-
-  __ andq(RCX, Immediate(InstanceFormat::TypeField::mask()));
-  __ cmpq(RCX, Immediate(double_type << type_field_shift));
-  __ j(EQUAL, &bail_out);
-  __ cmpq(RCX, Immediate(large_integer_type << type_field_shift));
-  __ j(EQUAL, &bail_out);
-
-  __ Bind(&fast_case);
   LoadProgram(RCX);
 
   Label true_case;
@@ -1475,87 +1955,131 @@ void InterpreterGeneratorX64::DoIntrinsicListLength() {
   __ ret();
 }
 
-void InterpreterGeneratorX64::Push(Register reg) { __ pushq(reg); }
+void InterpreterGeneratorX64::DoIntrinsicStringLength() {
+  LoadLocal(RCX, 1);  // String.
+  __ movq(RAX, Address(RCX, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ ret();
+}
 
-void InterpreterGeneratorX64::Pop(Register reg) { __ popq(reg); }
+void InterpreterGeneratorX64::DoIntrinsicStringHashCode() {
+  ASSERT(OneByteString::kHashValueOffset == TwoByteString::kHashValueOffset);
+  LoadLocal(RCX, 1);  // String.
+  __ movq(RBX, Address(RCX, OneByteString::kHashValueOffset -
+                                HeapObject::kTag));
 
-void InterpreterGeneratorX64::Drop(int n) {
-  __ addq(RSP, Immediate(n * kWordSize));
+  // A hash of zero has not been computed yet.
+  __ testq(RBX, RBX);
+  __ j(ZERO, &intrinsic_failure_);
+  __ movq(RAX, RBX);
+  __ ret();
 }
 
-void InterpreterGeneratorX64::Drop(Register reg) {
-  __ leaq(RSP, Address(RSP, reg, TIMES_WORD_SIZE));
-}
+void InterpreterGeneratorX64::DoIntrinsicOneByteStringCodeUnitAt() {
+  LoadLocal(RBX, 1);  // Index.
+  LoadLocal(RCX, 2);  // String.
 
-void InterpreterGeneratorX64::LoadProcess(Register reg) {
-  __ movq(reg, Address(R8, spill_size_ + kWordSize));
-}
+  ASSERT(Smi::kTag == 0);
+  __ testl(RBX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &intrinsic_failure_);
+  __ cmpq(RBX, Immediate(0));
+  __ j(LESS, &intrinsic_failure_);
 
-void InterpreterGeneratorX64::LoadProgram(Register reg) {
-  LoadProcess(reg);
-  __ movq(reg, Address(reg, Process::kProgramOffset));
-}
+  // Check the index against the length.
+  __ cmpq(RBX, Address(RCX, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ j(GREATER_EQUAL, &intrinsic_failure_);
 
-void InterpreterGeneratorX64::LoadStaticsArray(Register reg) {
-  LoadProcess(reg);
-  __ movq(reg, Address(reg, Process::kStaticsOffset));
+  // Load the character and smi-tag it.
+  ASSERT(Smi::kTagSize == 1);
+  __ sarq(RBX, Immediate(1));
+  int chars_offset = OneByteString::kSize - HeapObject::kTag;
+  __ movzbq(RAX, Address(RCX, RBX, TIMES_1, chars_offset));
+  __ addq(RAX, RAX);
+  __ ret();
 }
 
-void InterpreterGeneratorX64::LoadLiteralNull(Register reg) {
-  LoadProgram(reg);
-  __ movq(reg, Address(reg, Program::kNullObjectOffset));
-}
+void InterpreterGeneratorX64::DoIntrinsicOneByteStringEqual() {
+  LoadLocal(RBX, 1);  // Other.
+  LoadLocal(RCX, 2);  // String.
 
-void InterpreterGeneratorX64::LoadLiteralTrue(Register reg) {
-  LoadProgram(reg);
-  __ movq(reg, Address(reg, Program::kTrueObjectOffset));
-}
+  Label equal, not_equal, loop;
+  __ cmpq(RBX, RCX);
+  __ j(EQUAL, &equal);
 
-void InterpreterGeneratorX64::LoadLiteralFalse(Register reg) {
-  LoadProgram(reg);
-  __ movq(reg, Address(reg, Program::kFalseObjectOffset));
-}
+  // Leave comparing with anything but another one-byte string to the native.
+  ASSERT(Smi::kTag == 0);
+  __ testl(RBX, Immediate(Smi::kTagMask));
+  __ j(ZERO, &intrinsic_failure_);
+  __ movq(RDX, Address(RBX, HeapObject::kClassOffset - HeapObject::kTag));
+  __ cmpq(RDX, Address(RCX, HeapObject::kClassOffset - HeapObject::kTag));
+  __ j(NOT_EQUAL, &intrinsic_failure_);
 
-void InterpreterGeneratorX64::SwitchToDartStack() {
-  __ movq(R8, RSP);
-  __ movq(RSP, Address(R8, spill_size_));
-}
+  int length_offset = BaseArray::kLengthOffset - HeapObject::kTag;
+  __ movq(RDX, Address(RBX, length_offset));
+  __ cmpq(RDX, Address(RCX, length_offset));
+  __ j(NOT_EQUAL, &not_equal);
+  ASSERT(Smi::kTagSize == 1);
+  __ sarq(RDX, Immediate(1));
+
+  // Strings with different hashes differ, if both hashes are computed.
+  int hash_offset = OneByteString::kHashValueOffset - HeapObject::kTag;
+  __ movq(RSI, Address(RBX, hash_offset));
+  __ movq(RDI, Address(RCX, hash_offset));
+  __ testq(RSI, RSI);
+  __ j(ZERO, &loop);
+  __ testq(RDI, RDI);
+  __ j(ZERO, &loop);
+  __ cmpq(RSI, RDI);
+  __ j(NOT_EQUAL, &not_equal);
+
+  // Compare the characters from the end.
+  __ Bind(&loop);
+  __ testq(RDX, RDX);
+  __ j(ZERO, &equal);
+  __ subq(RDX, Immediate(1));
+  int chars_offset = OneByteString::kSize - HeapObject::kTag;
+  __ movzbq(RSI, Address(RBX, RDX, TIMES_1, chars_offset));
+  __ movzbq(RDI, Address(RCX, RDX, TIMES_1, chars_offset));
+  __ cmpq(RSI, RDI);
+  __ j(EQUAL, &loop);
+
+  __ Bind(&not_equal);
+  LoadLiteralFalse(RAX);
+  __ ret();
 
-void InterpreterGeneratorX64::SwitchToCStack() {
-  __ movq(Address(R8, spill_size_), RSP);
-  __ movq(RSP, R8);
+  __ Bind(&equal);
+  LoadLiteralTrue(RAX);
+  __ ret();
 }
 
-void InterpreterGeneratorX64::StoreByteCodePointer() {
-  __ movq(Address(RBP, -kWordSize), R13);
-}
+void InterpreterGeneratorX64::DoIntrinsicTwoByteStringCodeUnitAt() {
+  LoadLocal(RBX, 1);  // Index.
+  LoadLocal(RCX, 2);  // String.
 
-void InterpreterGeneratorX64::RestoreByteCodePointer() {
-  __ movq(R13, Address(RBP, -kWordSize));
-}
+  ASSERT(Smi::kTag == 0);
+  __ testl(RBX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &intrinsic_failure_);
+  __ cmpq(RBX, Immediate(0));
+  __ j(LESS, &intrinsic_failure_);
 
-void InterpreterGeneratorX64::LoadLocal(Register reg, int index) {
-  __ movq(reg, Address(RSP, index * kWordSize));
-}
+  // Check the index against the length.
+  __ cmpq(RBX, Address(RCX, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ j(GREATER_EQUAL, &intrinsic_failure_);
 
-void InterpreterGeneratorX64::StoreLocal(Register reg, int index) {
-  __ movq(Address(RSP, index * kWordSize), reg);
+  // The smi-tagged index is the offset of the code unit. Load it and smi-tag
+  // it.
+  ASSERT(Smi::kTagSize == 1);
+  int chars_offset = TwoByteString::kSize - HeapObject::kTag;
+  __ movzwq(RAX, Address(RCX, RBX, TIMES_1, chars_offset));
+  __ addq(RAX, RAX);
+  __ ret();
 }
 
-void InterpreterGeneratorX64::StoreLocal(const Immediate& value, int index) {
-  __ movq(Address(RSP, index * kWordSize), value);
+void InterpreterGeneratorX64::StoreByteCodePointer() {
+  __ movq(Address(RBP, -kWordSize), R13);
 }
 
-void InterpreterGeneratorX64::Return(bool is_return_null) {
-  // Materialize the result in register RAX.
-  if (is_return_null) {
-    LoadLiteralNull(RAX);
-  } else {
-    LoadLocal(RAX, 0);
-  }
-  __ movq(RSP, RBP);
-  __ popq(RBP);
-  __ ret();
+void InterpreterGeneratorX64::RestoreByteCodePointer() {
+  __ movq(R13, Address(RBP, -kWordSize));
 }
 
 void InterpreterGeneratorX64::Allocate(bool immutable) {
@@ -1563,133 +2087,100 @@ void InterpreterGeneratorX64::Allocate(bool immutable) {
   __ movl(RAX, Address(R13, 1));
   __ movq(RBX, Address(R13, RAX, TIMES_1));
 
-  // Initialization of 'allocate immutable' argument depends on [immutable].
-  __ movq(RDX, Immediate(immutable ? 1 : 0));
-
-  // Loop over all arguments and find out if all of them are immutable (then we
-  // can set the immutable bit in this object too).
-  Label allocate;
-  if (immutable) {
-    __ movq(R11, Address(RBX, Class::kInstanceFormatOffset - HeapObject::kTag));
-    __ andq(R11, Immediate(InstanceFormat::FixedSizeField::mask()));
-    int size_shift = InstanceFormat::FixedSizeField::shift() - kPointerSizeLog2;
-    __ shrq(R11, Immediate(size_shift));
-
-    // R11 = SizeOfEntireObject - Instance::kSize
-    __ subq(R11, Immediate(Instance::kSize));
-
-    // R10 = StackPointer(RSP) + NumberOfFields*kPointerSize
-    __ movq(R10, RSP);
-    __ addq(R10, R11);
-
-    Label loop;
-    Label break_loop_with_mutable_field;
-
-    // Decrement pointer to point to next field.
-    __ Bind(&loop);
-    __ subq(R10, Immediate(kPointerSize));
-
-    // Test whether R10 < RSP. If so we're done and it's immutable.
-    __ cmpq(R10, RSP);
-    __ j(BELOW, &allocate);
-
-    // If Smi, continue the loop.
-    __ movq(R11, Address(R10));
-    __ testl(R11, Immediate(Smi::kTagMask));
-    __ j(ZERO, &loop);
-
-    // Load class of object we want to test immutability of.
-    __ movq(RAX, Address(R11, HeapObject::kClassOffset - HeapObject::kTag));
-
-    // Load instance format & handle the three cases:
-    //  - never immutable (based on instance format) => not immutable
-    //  - always immutable (based on instance format) => immutable
-    //  - else (only instances) => check runtime-tracked bit
-    uword mask = InstanceFormat::ImmutableField::mask();
-    uword always_immutable_mask = InstanceFormat::ImmutableField::encode(
-        InstanceFormat::ALWAYS_IMMUTABLE);
-    uword never_immutable_mask =
-        InstanceFormat::ImmutableField::encode(InstanceFormat::NEVER_IMMUTABLE);
-
-    __ movq(RAX, Address(RAX, Class::kInstanceFormatOffset - HeapObject::kTag));
-    __ andq(RAX, Immediate(mask));
-
-    // If this is type never immutable we break the loop.
-    __ cmpq(RAX, Immediate(never_immutable_mask));
-    __ j(EQUAL, &break_loop_with_mutable_field);
-
-    // If this is type is always immutable we continue the loop.
-    __ cmpq(RAX, Immediate(always_immutable_mask));
-    __ j(EQUAL, &loop);
-
-    // Else, we must have an Instance and check the runtime-tracked
-    // immutable bit.
-    uword im_mask = Instance::FlagsImmutabilityField::encode(true);
-    __ movq(R11, Address(R11, Instance::kFlagsOffset - HeapObject::kTag));
-    __ testq(R11, Immediate(im_mask));
-    __ j(NOT_ZERO, &loop);
-
-    __ Bind(&break_loop_with_mutable_field);
-    __ movl(RDX, Immediate(0));
-    // Fall through.
-  }
+  ComputeImmutability(immutable);
 
   // TODO(kasperl): Consider inlining this in the interpreter.
-  __ Bind(&allocate);
   LoadProcess(RDI);
   SwitchToCStack();
   __ movq(RSI, RBX);
   // NOTE: The 3rd argument is already present in RDX
   __ call("HandleAllocate");
   SwitchToDartStack();
-  __ movq(R11, RAX);
-  __ andq(R11, Immediate(Failure::kTagMask | Failure::kTypeMask));
-  __ cmpq(R11, Immediate(Failure::kTag));
-  __ j(EQUAL, &gc_);
-
-  __ movq(R11, Address(RBX, Class::kInstanceFormatOffset - HeapObject::kTag));
-  __ andq(R11, Immediate(InstanceFormat::FixedSizeField::mask()));
-  // The fixed size is recorded as the number of pointers. Therefore, the
-  // size in bytes is the recorded size multiplied by kPointerSize. Instead
-  // of doing the multiplication we shift by kPointerSizeLog2 less.
-  ASSERT(InstanceFormat::FixedSizeField::shift() >= kPointerSizeLog2);
-  int size_shift = InstanceFormat::FixedSizeField::shift() - kPointerSizeLog2;
-  __ shrq(R11, Immediate(size_shift));
+  JumpIfRetryAfterGC(RAX, &gc_);
 
-  // Compute the address of the first and last instance field.
-  __ leaq(R10, Address(RAX, R11, TIMES_1, -1 * kWordSize - HeapObject::kTag));
-  __ leaq(R11, Address(RAX, Instance::kSize - HeapObject::kTag));
-
-  Label loop, done;
-  __ Bind(&loop);
-  __ cmpq(R10, R11);
-  __ j(BELOW, &done);
-  Pop(RBX);
-  // No write barrier, because newly allocated instances are always
-  // in new-space, or are already entered into the remembered set.
-  __ movq(Address(R10, 0), RBX);
-  __ subq(R10, Immediate(1 * kWordSize));
-  __ jmp(&loop);
-
-  __ Bind(&done);
-  Push(RAX);
+  PopFieldsIntoInstance();
   Dispatch(kAllocateLength);
 }
 
-void InterpreterGeneratorX64::AddToRememberedSet(Register object,
-                                                 Register value,
-                                                 Register scratch) {
-  Label smi;
-  __ testq(value, Immediate(Smi::kTagMask));
-  __ j(ZERO, &smi);
-  // TODO(erikcorry): Filter out non-new-space values.
+void InterpreterGeneratorX64::LoadInlineCacheEntry(Register reg,
+                                                   Register scratch) {
+  LoadProcess(reg);
+  __ movq(scratch, Address(reg, Process::kInlineCacheMaskOffset));
+  __ movq(reg, Address(reg, Process::kInlineCacheOffset));
+  __ andq(scratch, R13);
+  __ shlq(scratch, Immediate(InlineCache::kEntrySizeLog2));
+  __ addq(reg, scratch);
+}
+
+void InterpreterGeneratorX64::ProbeInlineCache(Register clazz, Label* hit) {
+  LoadInlineCacheEntry(RSI, RAX);
+
+  // The ways are only emitted once: a call site found in a later entry moves
+  // RSI to that entry and jumps back to them.
+  Label found, miss, next;
+  __ cmpq(R13, Address(RSI, InlineCache::kBytecodePointerOffset));
+  __ j(NOT_EQUAL, &next);
+  __ Bind(&found);
+  for (int j = 0; j < InlineCache::kWays; j++) {
+    int way = InlineCache::kWaysOffset + j * InlineCache::kWaySize;
+    Label other;
+    __ cmpq(clazz, Address(RSI, way + InlineCache::kClassOffset));
+    __ j(NOT_EQUAL, &other);
+    __ movq(RAX, Address(RSI, way + InlineCache::kTargetOffset));
+    __ movq(RBX, Address(RSI, way + InlineCache::kCodeOffset));
+    __ jmp(hit);
+    __ Bind(&other);
+  }
+  __ jmp(&miss);
+
+  __ Bind(&next);
+  for (int i = 1; i < InlineCache::kMaxProbes; i++) {
+    __ addq(RSI, Immediate(InlineCache::kEntrySize));
+    __ cmpq(R13, Address(RSI, InlineCache::kBytecodePointerOffset));
+    __ j(EQUAL, &found);
+  }
+  __ Bind(&miss);
+}
 
-  LoadProcess(scratch);
-  __ shrq(object, Immediate(GCMetadata::kCardSizeLog2));
-  __ addq(object, Address(scratch, Process::kRememberedSetBiasOffset));
-  __ movb(Address(object), Immediate(GCMetadata::kNewSpacePointers));
+void InterpreterGeneratorX64::UpdateInlineCache(Register clazz) {
+  LoadProcess(RDI);
+  __ movq(RDI, Address(RDI, Process::kInlineCacheOffset));
+  __ addq(Address(RDI, InlineCache::kMissesOffset), Immediate(1));
+
+  // Find the entry of the call site, or claim a free one for it. If all the
+  // entries it may use are taken by other call sites, it is not cached.
+  LoadInlineCacheEntry(RSI, R9);
+  Label found, done;
+  for (int i = 0; i < InlineCache::kMaxProbes; i++) {
+    int entry = i * InlineCache::kEntrySize;
+    Label next, claim, at_entry;
+    __ movq(R9, Address(RSI, entry + InlineCache::kBytecodePointerOffset));
+    __ cmpq(R9, R13);
+    __ j(EQUAL, &at_entry);
+    __ testq(R9, R9);
+    __ j(NOT_ZERO, &next);
+    __ movq(Address(RSI, entry + InlineCache::kBytecodePointerOffset), R13);
+    __ Bind(&at_entry);
+    if (entry != 0) __ addq(RSI, Immediate(entry));
+    __ jmp(&found);
+    __ Bind(&next);
+  }
+  __ jmp(&done);
 
-  __ Bind(&smi);
+  // Move the other classes down, and put the new one first.
+  __ Bind(&found);
+  for (int j = InlineCache::kWays - 1; j > 0; j--) {
+    int way = InlineCache::kWaysOffset + j * InlineCache::kWaySize;
+    for (int offset = 0; offset < InlineCache::kWaySize; offset += kWordSize) {
+      __ movq(R10, Address(RSI, way - InlineCache::kWaySize + offset));
+      __ movq(Address(RSI, way + offset), R10);
+    }
+  }
+  int first = InlineCache::kWaysOffset;
+  __ movq(Address(RSI, first + InlineCache::kClassOffset), clazz);
+  __ movq(Address(RSI, first + InlineCache::kTargetOffset), RAX);
+  __ movq(Address(RSI, first + InlineCache::kCodeOffset), RBX);
+  __ Bind(&done);
 }
 
 void InterpreterGeneratorX64::InvokeMethodUnfold(bool test) {
@@ -1716,11 +2207,12 @@ void InterpreterGeneratorX64::InvokeMethodUnfold(bool test) {
   __ j(ZERO, &smi);
   __ movq(RBX, Address(RBX, HeapObject::kClassOffset - HeapObject::kTag));
 
-  // Find the entry in the primary lookup cache.
-  Label miss, finish;
+  // Find the entry in the inline cache or the primary lookup cache.
+  Label miss, finish, call;
   ASSERT(Utils::IsPowerOfTwo(LookupCache::kPrimarySize));
   ASSERT(sizeof(LookupCache::Entry) == 1 << 5);
   __ Bind(&probe);
+  if (!test) ProbeInlineCache(RBX, &call);
   __ movq(RAX, RBX);
   __ xorq(RAX, RDX);
   __ andq(RAX, Immediate(LookupCache::kPrimarySize - 1));
@@ -1741,12 +2233,15 @@ void InterpreterGeneratorX64::InvokeMethodUnfold(bool test) {
     __ movq(RAX, Address(RAX, LookupCache::kCodeOffset));
   } else {
     __ movq(RBX, Address(RAX, LookupCache::kCodeOffset));
+    __ movq(R11, Address(RAX, LookupCache::kClassOffset));
     __ movq(RAX, Address(RAX, LookupCache::kTargetOffset));
 
     __ testq(RBX, RBX);
 
     __ LoadLabel(RCX, "LocalInterpreterMethodEntry");
     __ cmove(RBX, RCX);
+
+    UpdateInlineCache(R11);
   }
 
   if (test) {
@@ -1766,6 +2261,7 @@ void InterpreterGeneratorX64::InvokeMethodUnfold(bool test) {
     StoreLocal(RAX, 0);
     Dispatch(kInvokeTestUnfoldLength);
   } else {
+    __ Bind(&call);
     StoreByteCodePointer();
     __ call(RBX);
     RestoreByteCodePointer();
@@ -1798,29 +2294,35 @@ void InterpreterGeneratorX64::InvokeMethodUnfold(bool test) {
   __ jmp(&finish);
 }
 
-void InterpreterGeneratorX64::InvokeMethod(bool test) {
-  // Get the selector from the bytecodes.
-  __ movl(RDX, Address(R13, 1));
+void InterpreterGeneratorX64::InvokeMethod(bool test, int arity) {
+  bool quickened = arity >= 0;
+  ASSERT(!test || !quickened);
+  if (!quickened) {
+    // Get the selector from the bytecodes.
+    __ movl(RDX, Address(R13, 1));
 
-  // Fetch the dispatch table from the program.
-  LoadProgram(RCX);
-  __ movq(RCX, Address(RCX, Program::kDispatchTableOffset));
+    // Fetch the dispatch table from the program.
+    LoadProgram(RCX);
+    __ movq(RCX, Address(RCX, Program::kDispatchTableOffset));
 
-  if (!test) {
-    // Compute the arity from the selector.
-    ASSERT(Selector::ArityField::shift() == 0);
-    __ movq(RBX, RDX);
-    __ andq(RBX, Immediate(Selector::ArityField::mask()));
+    if (!test) {
+      // Compute the arity from the selector.
+      ASSERT(Selector::ArityField::shift() == 0);
+      __ movq(RBX, RDX);
+      __ andq(RBX, Immediate(Selector::ArityField::mask()));
+    }
+
+    // Compute the selector offset (smi tagged) from the selector.
+    __ movq(R12, Immediate(Selector::IdField::mask()));
+    __ andq(RDX, R12);
+    __ shrq(RDX, Immediate(Selector::IdField::shift() - Smi::kTagSize));
   }
 
-  // Compute the selector offset (smi tagged) from the selector.
-  __ movq(R12, Immediate(Selector::IdField::mask()));
-  __ andq(RDX, R12);
-  __ shrq(RDX, Immediate(Selector::IdField::shift() - Smi::kTagSize));
-
   // Get the receiver from the stack.
   if (test) {
     LoadLocal(RBX, 0);
+  } else if (quickened) {
+    LoadLocal(RBX, arity);
   } else {
     __ movq(RBX, Address(RSP, RBX, TIMES_WORD_SIZE));
   }
@@ -1832,9 +2334,23 @@ void InterpreterGeneratorX64::InvokeMethod(bool test) {
   __ j(ZERO, &smi);
   __ movq(RBX, Address(RBX, HeapObject::kClassOffset - HeapObject::kTag));
 
-  // Compute entry index: class id + selector offset.
+  // Try the inline cache before computing the entry index: class id +
+  // selector offset.
+  Label call;
   int id_offset = Class::kIdOrTransformationTargetOffset - HeapObject::kTag;
   __ Bind(&dispatch);
+  if (!test) {
+    ProbeInlineCache(RBX, &call);
+    __ movq(R11, RBX);
+  }
+  if (quickened) {
+    __ movl(RDX, Address(R13, 1));
+    LoadProgram(RCX);
+    __ movq(RCX, Address(RCX, Program::kDispatchTableOffset));
+    __ movq(R12, Immediate(Selector::IdField::mask()));
+    __ andq(RDX, R12);
+    __ shrq(RDX, Immediate(Selector::IdField::shift() - Smi::kTagSize));
+  }
   __ movq(RBX, Address(RBX, id_offset));
   __ addq(RBX, RDX);
 
@@ -1863,16 +2379,24 @@ void InterpreterGeneratorX64::InvokeMethod(bool test) {
     __ movq(
         RAX,
         Address(RCX, DispatchTableEntry::kTargetOffset - HeapObject::kTag));
+    __ movq(RBX,
+            Address(RCX, DispatchTableEntry::kCodeOffset - HeapObject::kTag));
+    UpdateInlineCache(R11);
 
+    __ Bind(&call);
     StoreByteCodePointer();
-    __ call(Address(RCX, DispatchTableEntry::kCodeOffset - HeapObject::kTag));
+    __ call(RBX);
     RestoreByteCodePointer();
 
-    __ movq(RDX, Address(R13, 1));
-    ASSERT(Selector::ArityField::shift() == 0);
-    __ andq(RDX, Immediate(Selector::ArityField::mask()));
+    if (quickened) {
+      if (arity > 0) Drop(arity);
+    } else {
+      __ movq(RDX, Address(R13, 1));
+      ASSERT(Selector::ArityField::shift() == 0);
+      __ andq(RDX, Immediate(Selector::ArityField::mask()));
 
-    Drop(RDX);
+      Drop(RDX);
+    }
 
     StoreLocal(RAX, 0);
     Dispatch(kInvokeMethodLength);
@@ -1904,8 +2428,11 @@ void InterpreterGeneratorX64::InvokeStatic() {
   __ movl(RAX, Address(R13, 1));
   __ movq(RAX, Address(R13, RAX, TIMES_1));
 
+  // Static methods are called through the entry of the JIT with -Xjit, so
+  // they get hot and run their compiled code.
   StoreByteCodePointer();
-  __ call("LocalInterpreterMethodEntry");
+  __ LoadLabel(RCX, "InterpreterStaticMethodEntry");
+  __ call(Address(RCX, 0));
   RestoreByteCodePointer();
 
   __ movl(RDX, Address(R13, 1));
@@ -1923,27 +2450,47 @@ void InterpreterGeneratorX64::InvokeStatic() {
 
 void InterpreterGeneratorX64::InvokeCompare(const char* fallback,
                                             Condition condition) {
+  Label not_smis, true_case, false_case;
   LoadLocal(RAX, 0);
   __ testl(RAX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
   LoadLocal(RBX, 1);
   __ testl(RBX, Immediate(Smi::kTagSize));
-  __ j(NOT_ZERO, fallback);
+  __ j(NOT_ZERO, &not_smis);
 
-  Label true_case;
   __ cmpq(RBX, RAX);
   __ j(condition, &true_case);
 
-  LoadLiteralFalse(RAX);
-  StoreLocal(RAX, 1);
-  Drop(1);
-  Dispatch(5);
+  __ Bind(&false_case);
+  LoadLiteralFalse(R9);
+  Drop(2);
+  DispatchCached(5);
 
   __ Bind(&true_case);
-  LoadLiteralTrue(RAX);
-  StoreLocal(RAX, 1);
-  Drop(1);
-  Dispatch(5);
+  LoadLiteralTrue(R9);
+  Drop(2);
+  DispatchCached(5);
+
+  // Compare doubles with the left operand in XMM0. The comparison is
+  // unordered if either is NaN, which sets the parity, zero and carry flags
+  // and makes every comparison false.
+  __ Bind(&not_smis);
+  LoadLocal(RAX, 0);
+  LoadLocal(RBX, 1);
+  LoadDoubleValues(RBX, RAX, fallback);
+  CompareDoubles(condition, &true_case, &false_case);
+}
+
+void InterpreterGeneratorX64::StoreLargeIntegerResult(int size,
+                                                      const char* fallback) {
+  ReplaceOperandsWithLargeInteger(fallback);
+  Dispatch(size);
+}
+
+void InterpreterGeneratorX64::StoreDoubleResult(int size,
+                                                const char* fallback) {
+  ReplaceOperandsWithDouble(fallback);
+  Dispatch(size);
 }
 
 void InterpreterGeneratorX64::InvokeDivision(const char* fallback,
@@ -2049,6 +2596,11 @@ void InterpreterGeneratorX64::CheckStackOverflow(int size) {
 }
 
 void InterpreterGeneratorX64::Dispatch(int size) {
+  if (IsFusedDispatch(size)) {
+    __ addq(R13, Immediate(size));
+    __ jmp(fused_second());
+    return;
+  }
   __ movzbq(RBX, Address(R13, size));
   if (size > 0) {
     __ addq(R13, Immediate(size));
@@ -2056,6 +2608,19 @@ void InterpreterGeneratorX64::Dispatch(int size) {
   __ jmp("LocalInterpret_DispatchTable", RBX, TIMES_WORD_SIZE, RAX);
 }
 
+void InterpreterGeneratorX64::DispatchCached(int size) {
+  if (IsFusedDispatch(size)) {
+    __ addq(R13, Immediate(size));
+    __ jmp(fused_cached_second());
+    return;
+  }
+  __ movzbq(RBX, Address(R13, size));
+  if (size > 0) {
+    __ addq(R13, Immediate(size));
+  }
+  __ jmp("LocalInterpret_CachedDispatchTable", RBX, TIMES_WORD_SIZE, RAX);
+}
+
 void InterpreterGeneratorX64::SaveState(Label* resume) {
   // Save the bytecode pointer at the bcp slot.
   StoreByteCodePointer();
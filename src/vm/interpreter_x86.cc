@@ -22,7 +22,8 @@ namespace dartino {
 
 class InterpreterGenerator {
  public:
-  explicit InterpreterGenerator(Assembler* assembler) : assembler_(assembler) {}
+  explicit InterpreterGenerator(Assembler* assembler)
+      : assembler_(assembler), fused_size_(0), fused_second_(NULL) {}
 
   void Generate();
 
@@ -46,8 +47,17 @@ class InterpreterGenerator {
  protected:
   Assembler* assembler() const { return assembler_; }
 
+  // While the handler of a superinstruction is generated, dispatching past
+  // its first bytecode jumps straight to the handler of the second one.
+  bool IsFusedDispatch(int size) const {
+    return fused_second_ != NULL && size == fused_size_;
+  }
+  const char* fused_second() const { return fused_second_; }
+
  private:
   Assembler* const assembler_;
+  int fused_size_;
+  const char* fused_second_;
 };
 
 void InterpreterGenerator::Generate() {
@@ -64,6 +74,23 @@ void InterpreterGenerator::Generate() {
   BYTECODES_DO(V)
 #undef V
 
+#define V(name, first, second)           \
+  GenerateBytecodePrologue("BC_" #name); \
+  fused_size_ = k##first##Length;        \
+  fused_second_ = "BC_" #second;         \
+  Do##first();                           \
+  fused_second_ = NULL;
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+
+  // Only the x64 interpreter specializes the handlers of quickened
+  // bytecodes. Here they run like their originals.
+#define V(name, original)                \
+  GenerateBytecodePrologue("BC_" #name); \
+  Do##original();
+  QUICKENED_DO(V)
+#undef V
+
 #define V(name)                              \
   assembler()->SwitchToText(); \
   assembler()->AlignToPowerOfTwo(4);         \
@@ -78,6 +105,12 @@ void InterpreterGenerator::Generate() {
   assembler()->DefineLong("BC_" #name);
   BYTECODES_DO(V)
 #undef V
+#define V(name, first, second) assembler()->DefineLong("BC_" #name);
+  SUPERINSTRUCTIONS_DO(V)
+#undef V
+#define V(name, original) assembler()->DefineLong("BC_" #name);
+  QUICKENED_DO(V)
+#undef V
 
   puts("\n");
 }
@@ -230,6 +263,11 @@ class InterpreterGeneratorX86 : public InterpreterGenerator {
   virtual void DoIntrinsicListIndexGet();
   virtual void DoIntrinsicListIndexSet();
   virtual void DoIntrinsicListLength();
+  virtual void DoIntrinsicStringLength();
+  virtual void DoIntrinsicStringHashCode();
+  virtual void DoIntrinsicOneByteStringCodeUnitAt();
+  virtual void DoIntrinsicOneByteStringEqual();
+  virtual void DoIntrinsicTwoByteStringCodeUnitAt();
 
  private:
   Label done_;
@@ -292,6 +330,18 @@ class InterpreterGeneratorX86 : public InterpreterGenerator {
   void InvokeTruncDiv(const char* fallback);
   void InvokeDivision(const char* fallback, bool quotient);
 
+  // Loads the two smi operands untagged into eax and ebx.
+  void LoadUntaggedOperands();
+
+  // Allocates a LargeInteger in new space by bumping the top of the space,
+  // and leaves it in ecx. Overwrites eax, ebx and edx. Jumps to [fallback]
+  // if the space is exhausted or the allocation is due to be sampled.
+  void AllocateLargeInteger(const char* fallback);
+
+  // Stores edx:eax in the LargeInteger in ecx, replaces the two operands
+  // with it and dispatches.
+  void StoreLargeIntegerResult(int size);
+
   void InvokeBitNot(const char* fallback);
   void InvokeBitAnd(const char* fallback);
   void InvokeBitOr(const char* fallback);
@@ -804,11 +854,20 @@ void InterpreterGeneratorX86::InvokeAdd(const char* fallback) {
   __ testl(EBX, Immediate(Smi::kTagSize));
   __ j(NOT_ZERO, fallback);
 
+  Label overflow;
   __ addl(EAX, EBX);
-  __ j(OVERFLOW_, fallback);
+  __ j(OVERFLOW_, &overflow);
   StoreLocal(EAX, 1);
   Drop(1);
   Dispatch(kInvokeAddLength);
+
+  // The sum of the untagged operands fits in 32 bits.
+  __ Bind(&overflow);
+  AllocateLargeInteger(fallback);
+  LoadUntaggedOperands();
+  __ addl(EAX, EBX);
+  __ cdq();
+  StoreLargeIntegerResult(kInvokeAddLength);
 }
 
 void InterpreterGeneratorX86::InvokeSub(const char* fallback) {
@@ -819,11 +878,19 @@ void InterpreterGeneratorX86::InvokeSub(const char* fallback) {
   __ testl(EBX, Immediate(Smi::kTagSize));
   __ j(NOT_ZERO, fallback);
 
+  Label overflow;
   __ subl(EAX, EBX);
-  __ j(OVERFLOW_, fallback);
+  __ j(OVERFLOW_, &overflow);
   StoreLocal(EAX, 1);
   Drop(1);
   Dispatch(kInvokeSubLength);
+
+  __ Bind(&overflow);
+  AllocateLargeInteger(fallback);
+  LoadUntaggedOperands();
+  __ subl(EAX, EBX);
+  __ cdq();
+  StoreLargeIntegerResult(kInvokeSubLength);
 }
 
 void InterpreterGeneratorX86::InvokeMod(const char* fallback) {
@@ -840,20 +907,28 @@ void InterpreterGeneratorX86::InvokeMul(const char* fallback) {
   __ j(NOT_ZERO, fallback);
 
   // Untag and multiply.
+  Label overflow;
   __ sarl(EAX, Immediate(1));
   __ sarl(EBX, Immediate(1));
   __ imul(EBX);
-  __ j(OVERFLOW_, fallback);
+  __ j(OVERFLOW_, &overflow);
 
   // Re-tag. We need to check for overflow to handle the case
   // where the top two bits are 01 after the multiplication.
   ASSERT(Smi::kTagSize == 1 && Smi::kTag == 0);
   __ addl(EAX, EAX);
-  __ j(OVERFLOW_, fallback);
+  __ j(OVERFLOW_, &overflow);
 
   StoreLocal(EAX, 1);
   Drop(1);
   Dispatch(kInvokeMulLength);
+
+  // The full product of the untagged operands is in edx:eax.
+  __ Bind(&overflow);
+  AllocateLargeInteger(fallback);
+  LoadUntaggedOperands();
+  __ imul(EBX);
+  StoreLargeIntegerResult(kInvokeMulLength);
 }
 
 void InterpreterGeneratorX86::InvokeTruncDiv(const char* fallback) {
@@ -1468,6 +1543,130 @@ void InterpreterGeneratorX86::DoIntrinsicListLength() {
   __ ret();
 }
 
+void InterpreterGeneratorX86::DoIntrinsicStringLength() {
+  LoadLocal(ECX, 1);  // String.
+  __ movl(EAX, Address(ECX, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ ret();
+}
+
+void InterpreterGeneratorX86::DoIntrinsicStringHashCode() {
+  ASSERT(OneByteString::kHashValueOffset == TwoByteString::kHashValueOffset);
+  LoadLocal(ECX, 1);  // String.
+  __ movl(EBX, Address(ECX, OneByteString::kHashValueOffset -
+                                HeapObject::kTag));
+
+  // A hash of zero has not been computed yet.
+  __ testl(EBX, EBX);
+  __ j(ZERO, &intrinsic_failure_);
+  __ movl(EAX, EBX);
+  __ ret();
+}
+
+void InterpreterGeneratorX86::DoIntrinsicOneByteStringCodeUnitAt() {
+  LoadLocal(EBX, 1);  // Index.
+  LoadLocal(ECX, 2);  // String.
+
+  ASSERT(Smi::kTag == 0);
+  __ testl(EBX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &intrinsic_failure_);
+  __ cmpl(EBX, Immediate(0));
+  __ j(LESS, &intrinsic_failure_);
+
+  // Check the index against the length.
+  __ cmpl(EBX, Address(ECX, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ j(GREATER_EQUAL, &intrinsic_failure_);
+
+  // Load the character and smi-tag it.
+  ASSERT(Smi::kTagSize == 1);
+  __ sarl(EBX, Immediate(1));
+  int chars_offset = OneByteString::kSize - HeapObject::kTag;
+  __ movzbl(EAX, Address(ECX, EBX, TIMES_1, chars_offset));
+  __ addl(EAX, EAX);
+  __ ret();
+}
+
+void InterpreterGeneratorX86::DoIntrinsicOneByteStringEqual() {
+  LoadLocal(EBX, 1);  // Other.
+  LoadLocal(ECX, 2);  // String.
+
+  Label equal, not_equal, compare, loop, done;
+  __ cmpl(EBX, ECX);
+  __ j(EQUAL, &equal);
+
+  // Leave comparing with anything but another one-byte string to the native.
+  ASSERT(Smi::kTag == 0);
+  __ testl(EBX, Immediate(Smi::kTagMask));
+  __ j(ZERO, &intrinsic_failure_);
+  __ movl(EDX, Address(EBX, HeapObject::kClassOffset - HeapObject::kTag));
+  __ cmpl(EDX, Address(ECX, HeapObject::kClassOffset - HeapObject::kTag));
+  __ j(NOT_EQUAL, &intrinsic_failure_);
+
+  int length_offset = BaseArray::kLengthOffset - HeapObject::kTag;
+  __ movl(EDX, Address(EBX, length_offset));
+  __ cmpl(EDX, Address(ECX, length_offset));
+  __ j(NOT_EQUAL, &not_equal);
+  ASSERT(Smi::kTagSize == 1);
+  __ sarl(EDX, Immediate(1));
+
+  // Strings with different hashes differ, if both hashes are computed.
+  int hash_offset = OneByteString::kHashValueOffset - HeapObject::kTag;
+  __ movl(EAX, Address(EBX, hash_offset));
+  __ testl(EAX, EAX);
+  __ j(ZERO, &compare);
+  __ cmpl(Address(ECX, hash_offset), Immediate(0));
+  __ j(EQUAL, &compare);
+  __ cmpl(EAX, Address(ECX, hash_offset));
+  __ j(NOT_EQUAL, &not_equal);
+
+  // Compare the characters from the end. ESI is the only other register
+  // to spare; preserve the bytecode pointer on the stack.
+  __ Bind(&compare);
+  __ pushl(ESI);
+  __ Bind(&loop);
+  __ testl(EDX, EDX);
+  __ j(ZERO, &done);
+  __ subl(EDX, Immediate(1));
+  int chars_offset = OneByteString::kSize - HeapObject::kTag;
+  __ movzbl(EAX, Address(EBX, EDX, TIMES_1, chars_offset));
+  __ movzbl(ESI, Address(ECX, EDX, TIMES_1, chars_offset));
+  __ cmpl(EAX, ESI);
+  __ j(EQUAL, &loop);
+  __ popl(ESI);
+
+  __ Bind(&not_equal);
+  LoadLiteralFalse(EAX);
+  __ ret();
+
+  __ Bind(&done);
+  __ popl(ESI);
+  __ Bind(&equal);
+  LoadLiteralTrue(EAX);
+  __ ret();
+}
+
+void InterpreterGeneratorX86::DoIntrinsicTwoByteStringCodeUnitAt() {
+  LoadLocal(EBX, 1);  // Index.
+  LoadLocal(ECX, 2);  // String.
+
+  ASSERT(Smi::kTag == 0);
+  __ testl(EBX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &intrinsic_failure_);
+  __ cmpl(EBX, Immediate(0));
+  __ j(LESS, &intrinsic_failure_);
+
+  // Check the index against the length.
+  __ cmpl(EBX, Address(ECX, BaseArray::kLengthOffset - HeapObject::kTag));
+  __ j(GREATER_EQUAL, &intrinsic_failure_);
+
+  // The smi-tagged index is the offset of the code unit. Load it and smi-tag
+  // it.
+  ASSERT(Smi::kTagSize == 1);
+  int chars_offset = TwoByteString::kSize - HeapObject::kTag;
+  __ movzwl(EAX, Address(ECX, EBX, TIMES_1, chars_offset));
+  __ addl(EAX, EAX);
+  __ ret();
+}
+
 void InterpreterGeneratorX86::Push(Register reg) { __ pushl(reg); }
 
 void InterpreterGeneratorX86::Pop(Register reg) { __ popl(reg); }
@@ -1966,6 +2165,49 @@ void InterpreterGeneratorX86::InvokeCompare(const char* fallback,
   Dispatch(5);
 }
 
+void InterpreterGeneratorX86::LoadUntaggedOperands() {
+  LoadLocal(EAX, 1);
+  __ sarl(EAX, Immediate(1));
+  LoadLocal(EBX, 0);
+  __ sarl(EBX, Immediate(1));
+}
+
+void InterpreterGeneratorX86::AllocateLargeInteger(const char* fallback) {
+  int size = LargeInteger::AllocationSize();
+  __ movl(EBX, Address(EDI, Process::kHeapOffset));
+
+  // Leave allocations that are due to be sampled to the runtime, which
+  // counts them again.
+  __ cmpl(Address(EBX, Heap::kAllocationCountdownOffset), Immediate(size));
+  __ j(LESS, fallback);
+
+  // Like SemiSpace::TryAllocate, keep room for the sentinel at the end of
+  // the chunk.
+  __ movl(EAX, Address(EBX, Heap::kSpaceOffset));
+  __ movl(ECX, Address(EAX, Space::kTopOffset));
+  __ leal(EDX, Address(ECX, size));
+  __ cmpl(EDX, Address(EAX, Space::kLimitOffset));
+  __ j(ABOVE_EQUAL, fallback);
+
+  __ subl(Address(EBX, Heap::kAllocationCountdownOffset), Immediate(size));
+  __ movl(Address(EAX, Space::kTopOffset), EDX);
+  __ movl(Address(EDX, 0), Immediate(0));
+
+  LoadProgram(EBX);
+  __ movl(EBX, Address(EBX, Program::kLargeIntegerClassOffset));
+  __ movl(Address(ECX, HeapObject::kClassOffset), EBX);
+  __ addl(ECX, Immediate(HeapObject::kTag));
+}
+
+void InterpreterGeneratorX86::StoreLargeIntegerResult(int size) {
+  int offset = LargeInteger::kValueOffset - HeapObject::kTag;
+  __ movl(Address(ECX, offset), EAX);
+  __ movl(Address(ECX, offset + kWordSize), EDX);
+  StoreLocal(ECX, 1);
+  Drop(1);
+  Dispatch(size);
+}
+
 void InterpreterGeneratorX86::InvokeDivision(const char* fallback,
                                              bool quotient) {
   LoadLocal(EAX, 1);
@@ -2099,6 +2341,11 @@ void InterpreterGeneratorX86::CheckStackOverflow(int size) {
 }
 
 void InterpreterGeneratorX86::Dispatch(int size) {
+  if (IsFusedDispatch(size)) {
+    __ addl(ESI, Immediate(size));
+    __ jmp(fused_second());
+    return;
+  }
   // Load the next bytecode through esi and dispatch to it.
   __ movzbl(EBX, Address(ESI, size));
   if (size > 0) {
@@ -9,13 +9,18 @@
 
 namespace dartino {
 
-#define INTRINSICS_DO(V) \
-  V(ObjectEquals)        \
-  V(GetField)            \
-  V(SetField)            \
-  V(ListIndexGet)        \
-  V(ListIndexSet)        \
-  V(ListLength)
+#define INTRINSICS_DO(V)     \
+  V(ObjectEquals)            \
+  V(GetField)                \
+  V(SetField)                \
+  V(ListIndexGet)            \
+  V(ListIndexSet)            \
+  V(ListLength)              \
+  V(StringLength)            \
+  V(StringHashCode)          \
+  V(OneByteStringCodeUnitAt) \
+  V(OneByteStringEqual)      \
+  V(TwoByteStringCodeUnitAt)
 
 #define DECLARE_EXTERN(name) extern "C" void Intrinsic_##name();
 INTRINSICS_DO(DECLARE_EXTERN)
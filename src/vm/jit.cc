@@ -0,0 +1,346 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/jit.h"
+
+#include <stddef.h>
+
+#include "src/shared/bytecodes.h"
+#include "src/shared/flags.h"
+#include "src/shared/platform.h"
+#include "src/shared/utils.h"
+#include "src/vm/bytecode_profiler.h"
+#include "src/vm/frame.h"
+#include "src/vm/native_interpreter.h"
+#include "src/vm/object.h"
+#include "src/vm/process.h"
+#include "src/vm/program.h"
+
+namespace dartino {
+
+static_assert(sizeof(JitEntry) == Jit::kEntrySize, "Unexpected entry size");
+static_assert(offsetof(JitEntry, counter) == Jit::kEntryCounterOffset,
+              "Unexpected counter offset");
+
+JitEntry JitEntries[kJitEntries];
+
+void* InterpreterStaticMethodEntry =
+    reinterpret_cast<void*>(InterpreterMethodEntry);
+
+#if defined(DARTINO_TARGET_X64)
+extern "C" void InterpreterJitMethodEntry();
+#endif
+
+Jit* Jit::jit_ = NULL;
+JitCode Jit::no_code_;
+
+// The code space is reserved when the first function is compiled, and
+// committed in chunks as it fills up.
+static const uword kCodeSpaceSize = 32 * MB;
+static const uword kCommitSize = 64 * KB;
+static const int kCodeAlignment = 16;
+
+// The number of bytes code of [code_size] bytes takes in the code space.
+static uword BlockSize(uword code_size) {
+  return Utils::RoundUp(JitCode::kSize + code_size, kCodeAlignment);
+}
+
+static bool LowerAddress(JitCode* const& a, JitCode* const& b) {
+  return a < b;
+}
+
+static int32 Threshold() {
+  return Flags::jit_threshold > 0 ? Flags::jit_threshold : 1;
+}
+
+void Jit::Setup() {
+  ASSERT(jit_ == NULL);
+  jit_ = new Jit();
+#if defined(DARTINO_TARGET_X64)
+  if (Flags::jit) {
+    InterpreterStaticMethodEntry =
+        reinterpret_cast<void*>(InterpreterJitMethodEntry);
+  }
+#endif
+}
+
+void Jit::TearDown() {
+  ASSERT(jit_ != NULL);
+  delete jit_;
+  jit_ = NULL;
+  InterpreterStaticMethodEntry =
+      reinterpret_cast<void*>(InterpreterMethodEntry);
+}
+
+bool Jit::IsMethodEntry(void* code) {
+#if defined(DARTINO_TARGET_X64)
+  if (code == reinterpret_cast<void*>(InterpreterJitMethodEntry)) return true;
+#endif
+  return code == reinterpret_cast<void*>(InterpreterMethodEntry);
+}
+
+Jit::Jit()
+    : mutex_(Platform::CreateMutex()),
+      memory_(NULL),
+      top_(0),
+      committed_(0),
+      full_(false) {
+  for (int i = 0; i < kJitEntries; i++) {
+    JitEntries[i].code = &no_code_;
+    JitEntries[i].counter = Threshold();
+  }
+}
+
+Jit::~Jit() {
+  for (int i = 0; i < kJitEntries; i++) JitEntries[i].code = &no_code_;
+  delete memory_;
+  delete mutex_;
+}
+
+bool Jit::ShouldCompile(Process* process, Function* function) {
+  JitEntry* entry = EntryOf(function);
+  // Breakpoints, single stepping and the bytecode profiler need the
+  // interpreter.
+  if (!Flags::jit || full_ || process->program()->debug_info() != NULL ||
+      BytecodeProfiler::GlobalInstance() != NULL) {
+    entry->counter = kNeverHot;
+    return false;
+  }
+  entry->counter = Threshold();
+  return true;
+}
+
+JitCode* Jit::Lookup(Function* function) {
+  ScopedLock locker(mutex_);
+  auto it = installed_.Find(function);
+  return it == installed_.End() ? NULL : it->second;
+}
+
+JitCode* Jit::NewCode(Program* program, Function* function, int size) {
+  uword needed = BlockSize(size);
+  ScopedLock locker(mutex_);
+#if defined(DARTINO_TARGET_X64)
+  JitCode* code = AllocateFromFreeBlocks(needed);
+  if (code != NULL) {
+    code->function_ = function;
+    code->program_ = program;
+    code->size_ = size;
+    return code;
+  }
+  if (memory_ == NULL) {
+    memory_ = new VirtualMemory(kCodeSpaceSize);
+    if (!memory_->IsReserved()) {
+      full_ = true;
+      return NULL;
+    }
+    top_ = committed_ = reinterpret_cast<uword>(memory_->address());
+  }
+  uword end = reinterpret_cast<uword>(memory_->address()) + memory_->size();
+  if (full_ || top_ + needed > end) {
+    full_ = true;
+    return NULL;
+  }
+  if (top_ + needed > committed_) {
+    uword size = Utils::RoundUp(top_ + needed - committed_, kCommitSize);
+    if (!memory_->Commit(reinterpret_cast<void*>(committed_), size, true)) {
+      full_ = true;
+      return NULL;
+    }
+    committed_ += size;
+  }
+  code = reinterpret_cast<JitCode*>(top_);
+  top_ += needed;
+  code->function_ = function;
+  code->program_ = program;
+  code->size_ = size;
+  return code;
+#else
+  // Only x64 has a compiler.
+  full_ = true;
+  return NULL;
+#endif
+}
+
+bool Jit::Install(JitCode* code) {
+  ScopedLock locker(mutex_);
+  // A debugger may have attached while the function was being compiled.
+  if (code->program()->debug_info() != NULL) return false;
+  Function* function = code->function();
+  auto it = installed_.Find(function);
+  if (it == installed_.End()) {
+    code_.PushBack(code);
+    installed_[function] = code;
+  } else {
+    code = it->second;
+  }
+  EntryOf(function)->code = code;
+  return true;
+}
+
+void Jit::DiscardCode(Program* program) {
+  ResumeInInterpreter(program);
+  ScopedLock locker(mutex_);
+  RemoveEntries(program);
+  Vector<JitCode*> kept;
+  Vector<JitCode*> discarded;
+  for (size_t i = 0; i < code_.size(); i++) {
+    JitCode* code = code_[i];
+    if (code->program() != program) {
+      kept.PushBack(code);
+    } else {
+      discarded.PushBack(code);
+    }
+  }
+  code_.Swap(kept);
+  RebuildInstalled();
+  FreeBlocks(&discarded);
+}
+
+void Jit::IterateProgramPointers(Program* program, PointerVisitor* visitor) {
+  ScopedLock locker(mutex_);
+  RemoveEntries(program);
+  for (size_t i = 0; i < code_.size(); i++) {
+    JitCode* code = code_[i];
+    if (code->program() != program) continue;
+    visitor->Visit(reinterpret_cast<Object**>(&code->function_));
+    EntryOf(code->function())->code = code;
+  }
+  RebuildInstalled();
+}
+
+int Jit::compiled_functions() {
+  ScopedLock locker(mutex_);
+  return code_.size();
+}
+
+#if defined(DARTINO_TARGET_X64)
+extern "C" void InterpreterInvokeMethodReturn();
+extern "C" void InterpreterInvokeStaticReturn();
+extern "C" void InterpreterLoadStaticInitReturn();
+
+// Returns where the interpreter finishes the call made by the bytecode at
+// [bcp].
+static void* InterpreterReturnAddress(uint8* bcp) {
+  switch (Bytecode::Unfuse(static_cast<Opcode>(*bcp))) {
+    case kLoadStaticInit:
+      return reinterpret_cast<void*>(InterpreterLoadStaticInitReturn);
+    case kInvokeStatic:
+    case kInvokeFactory:
+      return reinterpret_cast<void*>(InterpreterInvokeStaticReturn);
+    default:
+      // All other calls are made by the method invokes.
+      return reinterpret_cast<void*>(InterpreterInvokeMethodReturn);
+  }
+}
+#endif
+
+void Jit::ResumeInInterpreter(Program* program) {
+#if defined(DARTINO_TARGET_X64)
+  Vector<JitCode*> discarded;
+  {
+    ScopedLock locker(mutex_);
+    for (size_t i = 0; i < code_.size(); i++) {
+      if (code_[i]->program() == program) discarded.PushBack(code_[i]);
+    }
+  }
+  if (discarded.IsEmpty() || program->process_list()->IsEmpty()) return;
+
+  // A compiled activation is only ever suspended in a call, so the return
+  // addresses into the code are all there is to patch. The frames are
+  // those of the interpreter, with the bytecode pointer stored before the
+  // call.
+  int number_of_stacks = program->CollectMutableGarbageAndChainStacks();
+  Object* current = program->stack_chain();
+  for (int i = 0; i < number_of_stacks; i++) {
+    Stack* stack = Stack::cast(current);
+    for (Frame frame(stack); frame.MovePrevious();) {
+      void* return_address = frame.ReturnAddress();
+      for (size_t j = 0; j < discarded.size(); j++) {
+        if (!discarded[j]->Contains(return_address)) continue;
+        Frame caller = frame;
+        caller.MovePrevious();
+        frame.SetReturnAddress(
+            InterpreterReturnAddress(caller.ByteCodePointer()));
+        break;
+      }
+    }
+    current = stack->next();
+    // Unchain stacks.
+    stack->set_next(Smi::FromWord(0));
+  }
+  ASSERT(current == NULL);
+  program->ClearStackChain();
+#endif
+}
+
+void Jit::RemoveEntries(Program* program) {
+  for (int i = 0; i < kJitEntries; i++) {
+    if (JitEntries[i].code->program() != program) continue;
+    JitEntries[i].code = &no_code_;
+    JitEntries[i].counter = Threshold();
+  }
+}
+
+void Jit::RebuildInstalled() {
+  installed_.Clear();
+  for (size_t i = 0; i < code_.size(); i++) {
+    installed_[code_[i]->function()] = code_[i];
+  }
+}
+
+JitCode* Jit::AllocateFromFreeBlocks(uword size) {
+  for (size_t i = 0; i < free_.size(); i++) {
+    JitCode* block = free_[i];
+    uword available = block->size_;
+    if (available < size) continue;
+    if (available - size < BlockSize(0)) {
+      free_.Remove(i);
+    } else {
+      // Split the block, and keep its end.
+      JitCode* rest =
+          reinterpret_cast<JitCode*>(reinterpret_cast<uword>(block) + size);
+      rest->size_ = available - size;
+      free_[i] = rest;
+    }
+    return block;
+  }
+  return NULL;
+}
+
+void Jit::FreeBlocks(Vector<JitCode*>* code) {
+  if (code->IsEmpty()) return;
+  for (size_t i = 0; i < code->size(); i++) {
+    JitCode* block = (*code)[i];
+    block->function_ = NULL;
+    block->program_ = NULL;
+    block->size_ = BlockSize(block->size_);
+    free_.PushBack(block);
+  }
+  free_.Sort(LowerAddress);
+  Vector<JitCode*> merged;
+  for (size_t i = 0; i < free_.size(); i++) {
+    JitCode* block = free_[i];
+    if (!merged.IsEmpty()) {
+      JitCode* last = merged.Back();
+      if (reinterpret_cast<uword>(last) + last->size_ ==
+          reinterpret_cast<uword>(block)) {
+        last->size_ += block->size_;
+        continue;
+      }
+    }
+    merged.PushBack(block);
+  }
+  if (!merged.IsEmpty()) {
+    JitCode* last = merged.Back();
+    if (reinterpret_cast<uword>(last) + last->size_ == top_) {
+      top_ = reinterpret_cast<uword>(last);
+      merged.PopBack();
+    }
+  }
+  free_.Swap(merged);
+  // The freed space may fit the functions that did not fit before.
+  full_ = false;
+}
+
+}  // namespace dartino
@@ -0,0 +1,174 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_JIT_H_
+#define SRC_VM_JIT_H_
+
+#include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
+#include "src/vm/vector.h"
+
+namespace dartino {
+
+class Function;
+class Mutex;
+class PointerVisitor;
+class Process;
+class Program;
+class VirtualMemory;
+
+// The machine code of a compiled function. It follows a small header that
+// points back to the function, so the method entry of the JIT can
+// check that the code it finds in the table below is for the function it is
+// about to run.
+class JitCode {
+ public:
+  Function* function() const { return function_; }
+  Program* program() const { return program_; }
+
+  uint8* entry() { return reinterpret_cast<uint8*>(this) + kSize; }
+
+  // Whether [address] is in the machine code.
+  bool Contains(void* address) {
+    uint8* pc = reinterpret_cast<uint8*>(address);
+    return pc >= entry() && pc < entry() + size_;
+  }
+
+  static const int kFunctionOffset = 0;
+  // Padded, so the machine code stays aligned.
+  static const int kSize = 4 * kPointerSize;
+
+ private:
+  Function* function_;
+  Program* program_;
+  uword size_;
+
+  friend class Jit;
+};
+
+// An entry of the table the method entry of the JIT consults for
+// every call. Functions are hashed into it by address. The counter of an
+// entry runs down with the calls of the functions hashed to it; when it hits
+// zero the interpreter calls HandleHotFunction.
+struct JitEntry {
+  JitCode* code;
+  int32 counter;
+};
+
+static const int kJitEntryBits = 12;
+static const int kJitEntries = 1 << kJitEntryBits;
+
+extern "C" JitEntry JitEntries[kJitEntries];
+
+// Called by the method entry of the JIT when the counter of the entry
+// of [function] runs out. Returns the code to run instead of interpreting
+// the function, or NULL. Only defined where there is a compiler.
+extern "C" void* HandleHotFunction(Process* process, Function* function);
+
+// The method entry the interpreter calls static methods through. It is the
+// entry of the JIT with -Xjit, and the plain InterpreterMethodEntry
+// otherwise, so calls don't pay for the JIT unless it is on.
+extern "C" void* InterpreterStaticMethodEntry;
+
+// The Jit owns the machine code of all compiled functions and decides which
+// functions to compile. The compiler itself lives with the interpreter (see
+// jit_x64.cc) and only exists on x64. The code space of discarded code is
+// reused for new code.
+class Jit {
+ public:
+  static const int kEntryCodeOffset = 0;
+  static const int kEntryCounterOffset = kPointerSize;
+  static const int kEntrySize = 2 * kPointerSize;
+
+  // The padding the interpreter puts on the C stack below the Dart stack
+  // slot, the process and the target port (see GeneratePrologue in
+  // interpreter_x64.cc). Compiled code finds the process through it.
+  static const int kInterpreterSpillSize = 2 * kPointerSize;
+
+  // The counter of an entry that never gets hot again.
+  static const int32 kNeverHot = 0x7fffffff;
+
+  static void Setup();
+  static void TearDown();
+  static Jit* GlobalInstance() { return jit_; }
+
+  // The method entry for the dispatch table. See
+  // InterpreterStaticMethodEntry.
+  static void* MethodEntry() { return InterpreterStaticMethodEntry; }
+
+  // Whether [code] is one of the method entries.
+  static bool IsMethodEntry(void* code);
+
+  // Functions are hashed by the address bits above the object alignment.
+  static const int kEntryShift = kPointerSizeLog2;
+
+  static JitEntry* EntryOf(Function* function) {
+    uword address = reinterpret_cast<uword>(function);
+    return &JitEntries[(address >> kEntryShift) & (kJitEntries - 1)];
+  }
+
+  Jit();
+  ~Jit();
+
+  // Called when [function] got hot in [process]. Returns whether it should
+  // be compiled. If not, it keeps [function] from getting hot again.
+  bool ShouldCompile(Process* process, Function* function);
+
+  // Returns the code compiled for [function] or NULL.
+  JitCode* Lookup(Function* function);
+
+  // Returns uninitialized code for [function] with room for [size] bytes
+  // of machine code, or NULL if the code space is exhausted.
+  JitCode* NewCode(Program* program, Function* function, int size);
+
+  // Makes the method entry run [code] for its function. Returns false if
+  // the program of the function is being debugged.
+  bool Install(JitCode* code);
+
+  // Drops all code compiled for [program], e.g. because its bytecodes
+  // change or a debugger attached, and frees its space. Activations that are
+  // running the code continue in the interpreter when their current call
+  // returns. Must be called while the processes of [program] are stopped.
+  void DiscardCode(Program* program);
+
+  // Visits the functions [program] has code for, and rehashes their entries.
+  // Part of a program GC.
+  void IterateProgramPointers(Program* program, PointerVisitor* visitor);
+
+  // The number of functions that have code installed.
+  int compiled_functions();
+
+ private:
+  static Jit* jit_;
+  static JitCode no_code_;
+
+  Mutex* mutex_;
+  VirtualMemory* memory_;
+  uword top_;
+  uword committed_;
+  // Set when the code space cannot hold more code.
+  bool full_;
+  Vector<JitCode*> code_;
+  // The blocks of discarded code, sorted by address. Their size_ covers the
+  // whole block.
+  Vector<JitCode*> free_;
+  HashMap<Function*, JitCode*> installed_;
+
+  // Resets the entries of the code of [program] in JitEntries.
+  void RemoveEntries(Program* program);
+  // Makes the calls that activations of the code of [program] wait for
+  // return to the interpreter.
+  void ResumeInInterpreter(Program* program);
+  // Rebuilds installed_ from code_.
+  void RebuildInstalled();
+  // Returns a free block of [size] bytes, or NULL.
+  JitCode* AllocateFromFreeBlocks(uword size);
+  // Adds the blocks of the discarded [code] to free_. Merges adjacent free
+  // blocks and gives the last one back to the bump allocator.
+  void FreeBlocks(Vector<JitCode*>* code);
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_JIT_H_
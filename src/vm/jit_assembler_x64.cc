@@ -0,0 +1,381 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#if defined(DARTINO_TARGET_X64)
+
+#include "src/vm/jit_assembler_x64.h"
+
+#include <string.h>
+
+namespace dartino {
+
+void JitAssembler::CopyTo(uint8* destination) const {
+  if (buffer_.size() > 0) memcpy(destination, buffer_.Data(), buffer_.size());
+}
+
+void JitAssembler::pushq(Register reg) {
+  if (reg > 7) EmitUint8(0x41);
+  EmitUint8(0x50 | (reg & 7));
+}
+
+void JitAssembler::pushq(const Immediate& immediate) {
+  if (immediate.is_int8()) {
+    EmitUint8(0x6A);
+    EmitUint8(static_cast<int>(immediate.value()));
+  } else {
+    ASSERT(immediate.is_int32());
+    EmitUint8(0x68);
+    EmitInt32(static_cast<int32>(immediate.value()));
+  }
+}
+
+void JitAssembler::popq(Register reg) {
+  if (reg > 7) EmitUint8(0x41);
+  EmitUint8(0x58 | (reg & 7));
+}
+
+void JitAssembler::negq(Register reg) { EmitOp(true, 0xF7, 3, reg); }
+
+void JitAssembler::notq(Register reg) { EmitOp(true, 0xF7, 2, reg); }
+
+void JitAssembler::imul(Register dst, Register src) {
+  EmitTwoByteOp(true, 0xAF, dst, Operand(src));
+}
+
+void JitAssembler::movl(Register dst, const Immediate& immediate) {
+  ASSERT(immediate.is_int32() || Utils::IsUint32(immediate.value()));
+  if (dst > 7) EmitUint8(0x41);
+  EmitUint8(0xB8 | (dst & 7));
+  EmitInt32(static_cast<int32>(immediate.value()));
+}
+
+void JitAssembler::movl(Register dst, const Address& address) {
+  EmitOp(false, 0x8B, dst, address);
+}
+
+void JitAssembler::movq(Register dst, const Immediate& immediate) {
+  if (immediate.is_int32()) {
+    EmitOp(true, 0xC7, 0, dst);
+    EmitInt32(static_cast<int32>(immediate.value()));
+  } else {
+    EmitRex(true, 0, dst > 7 ? 1 : 0);
+    EmitUint8(0xB8 | (dst & 7));
+    EmitInt64(immediate.value());
+  }
+}
+
+void JitAssembler::movq(Register dst, Register src) {
+  EmitOp(true, 0x89, src, dst);
+}
+
+void JitAssembler::movq(Register dst, const Address& address) {
+  EmitOp(true, 0x8B, dst, address);
+}
+
+void JitAssembler::movq(const Address& address, Register src) {
+  EmitOp(true, 0x89, src, address);
+}
+
+void JitAssembler::movq(const Address& address, const Immediate& immediate) {
+  ASSERT(immediate.is_int32());
+  EmitOp(true, 0xC7, 0, address);
+  EmitInt32(static_cast<int32>(immediate.value()));
+}
+
+void JitAssembler::movb(const Address& address, const Immediate& immediate) {
+  ASSERT(immediate.is_int8() || Utils::IsUint8(immediate.value()));
+  EmitOp(false, 0xC6, 0, address);
+  EmitUint8(static_cast<int>(immediate.value()));
+}
+
+void JitAssembler::movzbq(Register dst, const Address& address) {
+  EmitTwoByteOp(true, 0xB6, dst, address);
+}
+
+void JitAssembler::cmove(Register dst, Register src) {
+  EmitTwoByteOp(true, 0x44, dst, Operand(src));
+}
+
+void JitAssembler::leaq(Register dst, const Address& address) {
+  EmitOp(true, 0x8D, dst, address);
+}
+
+void JitAssembler::addq(Register dst, Register src) {
+  EmitOp(true, 0x01, src, dst);
+}
+
+void JitAssembler::addq(Register dst, const Immediate& immediate) {
+  EmitArithmetic(kAdd, dst, immediate);
+}
+
+void JitAssembler::addq(Register dst, const Address& address) {
+  EmitOp(true, 0x03, dst, address);
+}
+
+void JitAssembler::subq(Register dst, Register src) {
+  EmitOp(true, 0x29, src, dst);
+}
+
+void JitAssembler::subq(Register dst, const Immediate& immediate) {
+  EmitArithmetic(kSub, dst, immediate);
+}
+
+void JitAssembler::andq(Register dst, Register src) {
+  EmitOp(true, 0x21, src, dst);
+}
+
+void JitAssembler::andq(Register dst, const Immediate& immediate) {
+  EmitArithmetic(kAnd, dst, immediate);
+}
+
+void JitAssembler::orq(Register dst, Register src) {
+  EmitOp(true, 0x09, src, dst);
+}
+
+void JitAssembler::xorq(Register dst, Register src) {
+  EmitOp(true, 0x31, src, dst);
+}
+
+void JitAssembler::cmpq(Register left, Register right) {
+  EmitOp(true, 0x39, right, left);
+}
+
+void JitAssembler::cmpq(Register left, const Immediate& immediate) {
+  EmitArithmetic(kCmp, left, immediate);
+}
+
+void JitAssembler::cmpq(Register left, const Address& address) {
+  EmitOp(true, 0x3B, left, address);
+}
+
+void JitAssembler::cmpq(const Address& address, const Immediate& immediate) {
+  if (immediate.is_int8()) {
+    EmitOp(true, 0x83, kCmp, address);
+    EmitUint8(static_cast<int>(immediate.value()));
+  } else {
+    ASSERT(immediate.is_int32());
+    EmitOp(true, 0x81, kCmp, address);
+    EmitInt32(static_cast<int32>(immediate.value()));
+  }
+}
+
+void JitAssembler::testq(Register left, Register right) {
+  EmitOp(true, 0x85, right, left);
+}
+
+void JitAssembler::testq(Register reg, const Immediate& immediate) {
+  ASSERT(immediate.is_int32());
+  EmitOp(true, 0xF7, 0, reg);
+  EmitInt32(static_cast<int32>(immediate.value()));
+}
+
+void JitAssembler::movsd(Register dst, const Address& address) {
+  EmitSseOp(0xF2, 0x10, dst, address);
+}
+
+void JitAssembler::movsd(const Address& address, Register src) {
+  EmitSseOp(0xF2, 0x11, src, address);
+}
+
+void JitAssembler::addsd(Register dst, Register src) {
+  EmitSseOp(0xF2, 0x58, dst, src);
+}
+
+void JitAssembler::subsd(Register dst, Register src) {
+  EmitSseOp(0xF2, 0x5C, dst, src);
+}
+
+void JitAssembler::mulsd(Register dst, Register src) {
+  EmitSseOp(0xF2, 0x59, dst, src);
+}
+
+void JitAssembler::ucomisd(Register left, Register right) {
+  EmitSseOp(0x66, 0x2E, left, right);
+}
+
+void JitAssembler::shlq(Register reg, const Immediate& immediate) {
+  EmitShift(kShl, reg, immediate);
+}
+
+void JitAssembler::shrq(Register reg, const Immediate& immediate) {
+  EmitShift(kShr, reg, immediate);
+}
+
+void JitAssembler::sarq(Register reg, const Immediate& immediate) {
+  EmitShift(kSar, reg, immediate);
+}
+
+void JitAssembler::shlq_cl(Register reg) { EmitOp(true, 0xD3, kShl, reg); }
+
+void JitAssembler::sarq_cl(Register reg) { EmitOp(true, 0xD3, kSar, reg); }
+
+void JitAssembler::call(Register reg) { EmitOp(false, 0xFF, 2, reg); }
+
+void JitAssembler::call(const Address& address) {
+  EmitOp(false, 0xFF, 2, address);
+}
+
+void JitAssembler::jmp(Register reg) { EmitOp(false, 0xFF, 4, reg); }
+
+void JitAssembler::j(Condition condition, JitLabel* label) {
+  if (label->is_bound()) {
+    int offset = label->position() - (size() + 2);
+    if (Utils::IsInt8(offset)) {
+      EmitUint8(0x70 | condition);
+      EmitUint8(offset);
+      return;
+    }
+  }
+  EmitUint8(0x0F);
+  EmitUint8(0x80 | condition);
+  EmitLabel(label);
+}
+
+void JitAssembler::jmp(JitLabel* label) {
+  if (label->is_bound()) {
+    int offset = label->position() - (size() + 2);
+    if (Utils::IsInt8(offset)) {
+      EmitUint8(0xEB);
+      EmitUint8(offset);
+      return;
+    }
+  }
+  EmitUint8(0xE9);
+  EmitLabel(label);
+}
+
+void JitAssembler::ret() { EmitUint8(0xC3); }
+
+void JitAssembler::int3() { EmitUint8(0xCC); }
+
+void JitAssembler::nop() { EmitUint8(0x90); }
+
+void JitAssembler::Bind(JitLabel* label) {
+  ASSERT(!label->is_bound());
+  int position = size();
+  int link = label->link_;
+  while (link >= 0) {
+    int next = ReadInt32(link);
+    PatchInt32(link, position - (link + 4));
+    link = next;
+  }
+  label->position_ = position;
+  label->link_ = -1;
+}
+
+void JitAssembler::CallAbsolute(const void* target) {
+  movq(R11, Immediate(reinterpret_cast<int64>(target)));
+  call(R11);
+}
+
+void JitAssembler::JumpAbsolute(const void* target) {
+  movq(R11, Immediate(reinterpret_cast<int64>(target)));
+  jmp(R11);
+}
+
+void JitAssembler::EmitInt32(int32 value) {
+  uint32 bits = static_cast<uint32>(value);
+  for (int i = 0; i < 4; i++) EmitUint8((bits >> (8 * i)) & 0xFF);
+}
+
+void JitAssembler::EmitInt64(int64 value) {
+  uint64 bits = static_cast<uint64>(value);
+  for (int i = 0; i < 8; i++) EmitUint8((bits >> (8 * i)) & 0xFF);
+}
+
+void JitAssembler::EmitRex(bool wide, int reg, int rm_rex) {
+  int rex = 0x40 | (wide ? 8 : 0) | (reg > 7 ? 4 : 0) | rm_rex;
+  if (rex != 0x40) EmitUint8(rex);
+}
+
+void JitAssembler::EmitOperand(int reg, const Operand& operand) {
+  EmitUint8(operand.EncodingAt(0) | ((reg & 7) << 3));
+  for (int i = 1; i < operand.length_; i++) {
+    EmitUint8(operand.EncodingAt(i));
+  }
+}
+
+void JitAssembler::EmitOp(bool wide, int opcode, int reg,
+                          const Operand& operand) {
+  EmitRex(wide, reg, operand.rex_);
+  EmitUint8(opcode);
+  EmitOperand(reg, operand);
+}
+
+void JitAssembler::EmitOp(bool wide, int opcode, int reg, Register rm) {
+  EmitOp(wide, opcode, reg, Operand(rm));
+}
+
+void JitAssembler::EmitTwoByteOp(bool wide, int opcode, int reg,
+                                 const Operand& operand) {
+  EmitRex(wide, reg, operand.rex_);
+  EmitUint8(0x0F);
+  EmitUint8(opcode);
+  EmitOperand(reg, operand);
+}
+
+void JitAssembler::EmitSseOp(int prefix, int opcode, Register xmm,
+                             const Operand& operand) {
+  ASSERT(xmm >= XMM0 && xmm <= XMM15);
+  // The prefix goes before the REX prefix.
+  EmitUint8(prefix);
+  EmitTwoByteOp(false, opcode, xmm - XMM0, operand);
+}
+
+void JitAssembler::EmitSseOp(int prefix, int opcode, Register xmm,
+                             Register rm) {
+  ASSERT(rm >= XMM0 && rm <= XMM15);
+  EmitSseOp(prefix, opcode, xmm, Operand(static_cast<Register>(rm - XMM0)));
+}
+
+void JitAssembler::EmitArithmetic(ArithmeticOp op, Register dst,
+                                  const Immediate& immediate) {
+  if (immediate.is_int8()) {
+    EmitOp(true, 0x83, op, dst);
+    EmitUint8(static_cast<int>(immediate.value()));
+  } else {
+    ASSERT(immediate.is_int32());
+    EmitOp(true, 0x81, op, dst);
+    EmitInt32(static_cast<int32>(immediate.value()));
+  }
+}
+
+void JitAssembler::EmitShift(ShiftOp op, Register reg,
+                             const Immediate& immediate) {
+  if (immediate.value() == 1) {
+    EmitOp(true, 0xD1, op, reg);
+  } else {
+    EmitOp(true, 0xC1, op, reg);
+    EmitUint8(static_cast<int>(immediate.value()));
+  }
+}
+
+void JitAssembler::EmitLabel(JitLabel* label) {
+  if (label->is_bound()) {
+    EmitInt32(label->position() - (size() + 4));
+  } else {
+    int position = size();
+    EmitInt32(label->link_);
+    label->link_ = position;
+  }
+}
+
+void JitAssembler::PatchInt32(int position, int32 value) {
+  uint32 bits = static_cast<uint32>(value);
+  for (int i = 0; i < 4; i++) {
+    buffer_[position + i] = (bits >> (8 * i)) & 0xFF;
+  }
+}
+
+int32 JitAssembler::ReadInt32(int position) const {
+  uint32 bits = 0;
+  for (int i = 0; i < 4; i++) {
+    bits |= static_cast<uint32>(buffer_[position + i]) << (8 * i);
+  }
+  return static_cast<int32>(bits);
+}
+
+}  // namespace dartino
+
+#endif  // defined(DARTINO_TARGET_X64)
@@ -0,0 +1,171 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_JIT_ASSEMBLER_X64_H_
+#define SRC_VM_JIT_ASSEMBLER_X64_H_
+
+#if defined(DARTINO_TARGET_X64)
+
+#include "src/shared/globals.h"
+#include "src/vm/assembler.h"
+#include "src/vm/vector.h"
+
+namespace dartino {
+
+// A label in the code of a JitAssembler. Jumps to an unbound label are
+// chained through their 32-bit displacements until the label is bound.
+class JitLabel {
+ public:
+  JitLabel() : position_(-1), link_(-1) {}
+
+  bool is_bound() const { return position_ >= 0; }
+  int position() const { return position_; }
+
+ private:
+  int position_;
+  int link_;
+
+  friend class JitAssembler;
+};
+
+// The JitAssembler encodes x64 machine code into a buffer. It shares the
+// registers, operands and conditions of the Assembler that generates the
+// interpreter, and its instructions have the same names, so the templates of
+// the JIT read like the interpreter they are derived from.
+class JitAssembler {
+ public:
+  JitAssembler() {}
+
+  int size() const { return buffer_.size(); }
+
+  // Copies the code to [destination], which must have room for size() bytes.
+  void CopyTo(uint8* destination) const;
+
+  void pushq(Register reg);
+  void pushq(const Immediate& immediate);
+  void popq(Register reg);
+
+  void negq(Register reg);
+  void notq(Register reg);
+  void imul(Register dst, Register src);
+
+  void movl(Register dst, const Immediate& immediate);
+  void movl(Register dst, const Address& address);
+
+  void movq(Register dst, const Immediate& immediate);
+  void movq(Register dst, Register src);
+  void movq(Register dst, const Address& address);
+  void movq(const Address& address, Register src);
+  void movq(const Address& address, const Immediate& immediate);
+
+  void movb(const Address& address, const Immediate& immediate);
+  void movzbq(Register dst, const Address& address);
+
+  void cmove(Register dst, Register src);
+
+  void leaq(Register dst, const Address& address);
+
+  void addq(Register dst, Register src);
+  void addq(Register dst, const Immediate& immediate);
+  void addq(Register dst, const Address& address);
+  void subq(Register dst, Register src);
+  void subq(Register dst, const Immediate& immediate);
+  void andq(Register dst, Register src);
+  void andq(Register dst, const Immediate& immediate);
+  void orq(Register dst, Register src);
+  void xorq(Register dst, Register src);
+
+  void cmpq(Register left, Register right);
+  void cmpq(Register left, const Immediate& immediate);
+  void cmpq(Register left, const Address& address);
+  void cmpq(const Address& address, const Immediate& immediate);
+
+  void testq(Register left, Register right);
+  void testq(Register reg, const Immediate& immediate);
+
+  // Scalar double instructions on the XMM registers.
+  void movsd(Register dst, const Address& address);
+  void movsd(const Address& address, Register src);
+  void addsd(Register dst, Register src);
+  void subsd(Register dst, Register src);
+  void mulsd(Register dst, Register src);
+  void ucomisd(Register left, Register right);
+
+  void shlq(Register reg, const Immediate& immediate);
+  void shrq(Register reg, const Immediate& immediate);
+  void sarq(Register reg, const Immediate& immediate);
+  void shlq_cl(Register reg);
+  void sarq_cl(Register reg);
+
+  void call(Register reg);
+  void call(const Address& address);
+  void jmp(Register reg);
+
+  void j(Condition condition, JitLabel* label);
+  void jmp(JitLabel* label);
+
+  void ret();
+  void int3();
+  void nop();
+
+  void Bind(JitLabel* label);
+
+  // Calls or jumps to an absolute address through R11.
+  void CallAbsolute(const void* target);
+  void JumpAbsolute(const void* target);
+
+ private:
+  // The opcode extensions of the arithmetic group.
+  enum ArithmeticOp {
+    kAdd = 0,
+    kOr = 1,
+    kAnd = 4,
+    kSub = 5,
+    kXor = 6,
+    kCmp = 7
+  };
+
+  // The opcode extensions of the shift group.
+  enum ShiftOp { kShl = 4, kShr = 5, kSar = 7 };
+
+  void EmitUint8(int value) { buffer_.PushBack(static_cast<uint8>(value)); }
+  void EmitInt32(int32 value);
+  void EmitInt64(int64 value);
+
+  // Emits a REX prefix if any of its bits are needed.
+  void EmitRex(bool wide, int reg, int rm_rex);
+  // Emits the ModRM byte (and SIB and displacement) of [operand] with
+  // [reg] in its reg field.
+  void EmitOperand(int reg, const Operand& operand);
+
+  // Emits [opcode] with a register [reg] (or opcode extension) and the
+  // r/m operand [operand], including prefixes.
+  void EmitOp(bool wide, int opcode, int reg, const Operand& operand);
+  void EmitOp(bool wide, int opcode, int reg, Register rm);
+  void EmitTwoByteOp(bool wide, int opcode, int reg, const Operand& operand);
+  // Emits the mandatory [prefix] and the two-byte [opcode] of an SSE
+  // instruction with the XMM register [xmm] in its reg field.
+  void EmitSseOp(int prefix, int opcode, Register xmm, const Operand& operand);
+  void EmitSseOp(int prefix, int opcode, Register xmm, Register rm);
+
+  void EmitArithmetic(ArithmeticOp op, Register dst,
+                      const Immediate& immediate);
+  void EmitShift(ShiftOp op, Register reg, const Immediate& immediate);
+
+  // Emits the 32-bit displacement of a jump to [label].
+  void EmitLabel(JitLabel* label);
+
+  void PatchInt32(int position, int32 value);
+  int32 ReadInt32(int position) const;
+
+  Vector<uint8> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitAssembler);
+};
+
+}  // namespace dartino
+
+#endif  // defined(DARTINO_TARGET_X64)
+
+#endif  // SRC_VM_JIT_ASSEMBLER_X64_H_
@@ -0,0 +1,469 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#if defined(DARTINO_TARGET_X64)
+
+#include "src/shared/assert.h"
+#include "src/shared/bytecodes.h"
+#include "src/shared/flags.h"
+#include "src/shared/test_case.h"
+#include "src/shared/utils.h"
+#include "src/vm/frame.h"
+#include "src/vm/interpreter.h"
+#include "src/vm/jit.h"
+#include "src/vm/jit_assembler_x64.h"
+#include "src/vm/object.h"
+#include "src/vm/process.h"
+#include "src/vm/program.h"
+#include "src/vm/scheduler.h"
+
+namespace dartino {
+
+static void ExpectBytes(const JitAssembler& assembler, const uint8* expected,
+                        int length) {
+  EXPECT_EQ(length, assembler.size());
+  uint8 buffer[32];
+  ASSERT(length <= static_cast<int>(sizeof(buffer)));
+  assembler.CopyTo(buffer);
+  for (int i = 0; i < length; i++) {
+    EXPECT_EQ(static_cast<int>(expected[i]), static_cast<int>(buffer[i]));
+  }
+}
+
+TEST_CASE(JitAssemblerEncoding) {
+  {
+    JitAssembler assembler;
+    assembler.pushq(R13);
+    assembler.popq(RAX);
+    const uint8 expected[] = {0x41, 0x55, 0x58};
+    ExpectBytes(assembler, expected, sizeof(expected));
+  }
+
+  {
+    // R13 needs a displacement even if it is zero.
+    JitAssembler assembler;
+    assembler.movq(RAX, Address(R13, 0));
+    assembler.movq(Address(RBP, -8), R11);
+    const uint8 expected[] = {0x49, 0x8B, 0x45, 0x00, 0x4C, 0x89, 0x5D, 0xF8};
+    ExpectBytes(assembler, expected, sizeof(expected));
+  }
+
+  {
+    JitAssembler assembler;
+    assembler.addq(RCX, Immediate(1));
+    assembler.cmpq(RAX, Immediate(0x1000));
+    const uint8 expected[] = {0x48, 0x83, 0xC1, 0x01, 0x48, 0x81,
+                              0xF8, 0x00, 0x10, 0x00, 0x00};
+    ExpectBytes(assembler, expected, sizeof(expected));
+  }
+
+  {
+    // The mandatory prefix of SSE instructions goes before the REX prefix.
+    JitAssembler assembler;
+    assembler.movsd(XMM0, Address(RAX, 8));
+    assembler.movsd(XMM8, Address(R13, 0));
+    assembler.movsd(Address(RDX, 7), XMM1);
+    assembler.addsd(XMM0, XMM1);
+    assembler.ucomisd(XMM1, XMM0);
+    const uint8 expected[] = {0xF2, 0x0F, 0x10, 0x40, 0x08, 0xF2, 0x45,
+                              0x0F, 0x10, 0x45, 0x00, 0xF2, 0x0F, 0x11,
+                              0x4A, 0x07, 0xF2, 0x0F, 0x58, 0xC1, 0x66,
+                              0x0F, 0x2E, 0xC8};
+    ExpectBytes(assembler, expected, sizeof(expected));
+  }
+}
+
+typedef word (*BinaryFunction)(word, word);
+
+// Stands in for the program and function the code is compiled for.
+static word dummy;
+
+// Copies the code of [assembler] into the code space of the JIT.
+static BinaryFunction Finalize(const JitAssembler& assembler) {
+  Program* program = reinterpret_cast<Program*>(&dummy);
+  Function* function = reinterpret_cast<Function*>(&dummy);
+  JitCode* code = Jit::GlobalInstance()->NewCode(program, function,
+                                                 assembler.size());
+  ASSERT(code != NULL);
+  assembler.CopyTo(code->entry());
+  return reinterpret_cast<BinaryFunction>(code->entry());
+}
+
+TEST_CASE(JitAssemblerRun) {
+  {
+    // Sums the numbers from [n] down to one.
+    JitAssembler assembler;
+    JitLabel loop, done;
+    assembler.movq(RAX, Immediate(0));
+    assembler.movq(RCX, RDI);
+    assembler.Bind(&loop);
+    assembler.testq(RCX, RCX);
+    assembler.j(ZERO, &done);
+    assembler.addq(RAX, RCX);
+    assembler.subq(RCX, Immediate(1));
+    assembler.jmp(&loop);
+    assembler.Bind(&done);
+    assembler.ret();
+    BinaryFunction sum = Finalize(assembler);
+    EXPECT_EQ(0, sum(0, 0));
+    EXPECT_EQ(5050, sum(100, 0));
+  }
+
+  {
+    // Adds the two words at [address], and multiplies the result by [factor].
+    JitAssembler assembler;
+    assembler.pushq(R13);
+    assembler.movq(R13, RDI);
+    assembler.movq(RAX, Address(R13, 0));
+    assembler.movq(RCX, Immediate(1));
+    assembler.addq(RAX, Address(R13, RCX, TIMES_8, 0));
+    assembler.imul(RAX, RSI);
+    assembler.popq(R13);
+    assembler.ret();
+    BinaryFunction run = Finalize(assembler);
+    word words[] = {3, 4};
+    EXPECT_EQ(70, run(reinterpret_cast<word>(words), 10));
+  }
+}
+
+// Builds the bytecodes of a function.
+class BytecodeBuilder {
+ public:
+  int position() const { return bytes_.size(); }
+
+  void Emit(Opcode opcode) { bytes_.PushBack(opcode); }
+
+  void Emit(Opcode opcode, uint8 operand) {
+    Emit(opcode);
+    bytes_.PushBack(operand);
+  }
+
+  void EmitInt32(Opcode opcode, int32 operand) {
+    Emit(opcode);
+    for (int i = 0; i < 4; i++) bytes_.PushBack((operand >> (8 * i)) & 0xff);
+  }
+
+  // Emits a bytecode whose operand is the offset of literal [index].
+  void EmitLiteral(Opcode opcode, int index) {
+    literals_.PushBack(position());
+    literals_.PushBack(index);
+    EmitInt32(opcode, 0);
+  }
+
+  // Emits a forward branch, to be bound with Bind.
+  int EmitBranch(Opcode opcode) {
+    int at = position();
+    EmitInt32(opcode, 0);
+    return at;
+  }
+
+  void Bind(int branch) {
+    Utils::WriteInt32(&bytes_[branch + 1], position() - branch);
+  }
+
+  void EmitBranchBack(int target) {
+    EmitInt32(kBranchBackWide, position() - target);
+  }
+
+  Function* Finish(Program* program, int arity, int number_of_literals) {
+    EmitInt32(kMethodEnd, position() << 1);
+    List<uint8> bytes(bytes_.Data(), bytes_.size());
+    Function* function = Function::cast(
+        program->CreateFunction(arity, bytes, number_of_literals));
+    for (size_t i = 0; i < literals_.size(); i += 2) {
+      uint8* bcp = function->bytecode_address_for(literals_[i]);
+      uint8* literal = reinterpret_cast<uint8*>(
+          function->literal_address_for(literals_[i + 1]));
+      Utils::WriteInt32(bcp + 1, literal - bcp);
+    }
+    return function;
+  }
+
+ private:
+  Vector<uint8> bytes_;
+  // Pairs of bytecode offsets and literal indices.
+  Vector<int> literals_;
+};
+
+// Emits a check that the value on top of the stack is [expected]. If it is
+// not, the process exits with a compile-time error.
+static void EmitExpect(BytecodeBuilder* builder, int expected) {
+  builder->EmitInt32(kLoadLiteralWide, expected);
+  builder->EmitInt32(kInvokeEq, 0);
+  int ok = builder->EmitBranch(kBranchIfTrueWide);
+  builder->Emit(kLoadLiteral, Interpreter::kCompileTimeError);
+  builder->Emit(kProcessYield);
+  builder->Bind(ok);
+}
+
+// Builds a program that computes with loops, recursion, doubles and lazily
+// initialized statics, and checks the results.
+static Program* NewTestProgram(bool fuse) {
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_dispatch_table(Array::cast(program->CreateArray(0)));
+
+  // sum(n) { var s = 0; while (n > 0) { s = s + n * static; n = n - 1; }
+  // return s; }
+  BytecodeBuilder sum;
+  sum.Emit(kLoadLiteral0);
+  int loop = sum.position();
+  sum.Emit(kLoadLocal4);
+  sum.Emit(kLoadLiteral0);
+  sum.EmitInt32(kInvokeGt, 0);
+  int done = sum.EmitBranch(kBranchIfFalseWide);
+  sum.Emit(kLoadLocal0);
+  sum.Emit(kLoadLocal5);
+  sum.EmitInt32(kLoadStaticInit, 0);
+  sum.EmitInt32(kInvokeMul, 0);
+  sum.EmitInt32(kInvokeAdd, 0);
+  sum.Emit(kStoreLocal, 1);
+  sum.Emit(kPop);
+  sum.Emit(kLoadLocal4);
+  sum.Emit(kLoadLiteral1);
+  sum.EmitInt32(kInvokeSub, 0);
+  sum.Emit(kStoreLocal, 5);
+  sum.Emit(kPop);
+  sum.EmitBranchBack(loop);
+  sum.Bind(done);
+  sum.Emit(kReturn);
+  Function* sum_function = sum.Finish(program, 1, 0);
+
+  // fib(n) => n < 2 ? sum(n) : fib(n - 1) + fib(n - 2). The static is one,
+  // so sum(n) is n for the base cases. Calling it makes it hot.
+  BytecodeBuilder fib;
+  fib.Emit(kLoadLocal3);
+  fib.Emit(kLoadLiteral, 2);
+  fib.EmitInt32(kInvokeLt, 0);
+  int recurse = fib.EmitBranch(kBranchIfFalseWide);
+  fib.Emit(kLoadLocal3);
+  fib.EmitLiteral(kInvokeStatic, 1);
+  fib.Emit(kReturn);
+  fib.Bind(recurse);
+  fib.Emit(kLoadLocal3);
+  fib.Emit(kLoadLiteral1);
+  fib.EmitInt32(kInvokeSub, 0);
+  fib.EmitLiteral(kInvokeStatic, 0);
+  fib.Emit(kLoadLocal4);
+  fib.Emit(kLoadLiteral, 2);
+  fib.EmitInt32(kInvokeSub, 0);
+  fib.EmitLiteral(kInvokeStatic, 0);
+  fib.EmitInt32(kInvokeAdd, 0);
+  fib.Emit(kReturn);
+  Function* fib_function = fib.Finish(program, 1, 2);
+  fib_function->set_literal_at(0, fib_function);
+  fib_function->set_literal_at(1, sum_function);
+
+  // halves(n) { var d = 1.0; while (n > 0) { d = d * 0.5 + 0.25; n = n - 1; }
+  // return d == 0.5 + 0.5^(n + 1) && d < 0.75 && d > 0.5 ? 1 : 0; }
+  BytecodeBuilder halves;
+  halves.EmitLiteral(kLoadConst, 0);
+  int halves_loop = halves.position();
+  halves.Emit(kLoadLocal4);
+  halves.Emit(kLoadLiteral0);
+  halves.EmitInt32(kInvokeGt, 0);
+  int halves_done = halves.EmitBranch(kBranchIfFalseWide);
+  halves.Emit(kLoadLocal0);
+  halves.EmitLiteral(kLoadConst, 1);
+  halves.EmitInt32(kInvokeMul, 0);
+  halves.EmitLiteral(kLoadConst, 2);
+  halves.EmitInt32(kInvokeAdd, 0);
+  halves.Emit(kStoreLocal, 1);
+  halves.Emit(kPop);
+  halves.Emit(kLoadLocal4);
+  halves.Emit(kLoadLiteral1);
+  halves.EmitInt32(kInvokeSub, 0);
+  halves.Emit(kStoreLocal, 5);
+  halves.Emit(kPop);
+  halves.EmitBranchBack(halves_loop);
+  halves.Bind(halves_done);
+  halves.Emit(kLoadLocal0);
+  halves.EmitLiteral(kLoadConst, 3);
+  halves.EmitInt32(kInvokeEq, 0);
+  int not_equal = halves.EmitBranch(kBranchIfFalseWide);
+  halves.Emit(kLoadLocal0);
+  halves.EmitLiteral(kLoadConst, 4);
+  halves.EmitInt32(kInvokeLt, 0);
+  int not_less = halves.EmitBranch(kBranchIfFalseWide);
+  halves.Emit(kLoadLocal0);
+  halves.EmitLiteral(kLoadConst, 1);
+  halves.EmitInt32(kInvokeGt, 0);
+  int not_greater = halves.EmitBranch(kBranchIfFalseWide);
+  halves.Emit(kLoadLiteral1);
+  halves.Emit(kReturn);
+  halves.Bind(not_equal);
+  halves.Bind(not_less);
+  halves.Bind(not_greater);
+  halves.Emit(kLoadLiteral0);
+  halves.Emit(kReturn);
+  Function* halves_function = halves.Finish(program, 1, 5);
+  halves_function->set_literal_at(0, program->CreateDouble(1.0));
+  halves_function->set_literal_at(1, program->CreateDouble(0.5));
+  halves_function->set_literal_at(2, program->CreateDouble(0.25));
+  halves_function->set_literal_at(3, program->CreateDouble(0.5 + 1.0 / 2048));
+  halves_function->set_literal_at(4, program->CreateDouble(0.75));
+
+  // The initializer of the static.
+  BytecodeBuilder initializer;
+  initializer.Emit(kLoadLiteral1);
+  initializer.Emit(kReturn);
+  Function* initializer_function = initializer.Finish(program, 0, 0);
+
+  BytecodeBuilder entry;
+  entry.Emit(kLoadLiteral, 20);
+  entry.EmitLiteral(kInvokeStatic, 0);
+  EmitExpect(&entry, 6765);
+  entry.EmitInt32(kLoadLiteralWide, 1000);
+  entry.EmitLiteral(kInvokeStatic, 1);
+  EmitExpect(&entry, 500500);
+  // Call halves(10) often enough to make it hot, but not so often that the
+  // doubles it allocates fill new space: the test program has no methods
+  // to fall back on.
+  entry.Emit(kLoadLiteral, 20);
+  int calls = entry.position();
+  entry.Emit(kLoadLocal0);
+  entry.Emit(kLoadLiteral0);
+  entry.EmitInt32(kInvokeGt, 0);
+  int calls_done = entry.EmitBranch(kBranchIfFalseWide);
+  entry.Emit(kLoadLiteral, 10);
+  entry.EmitLiteral(kInvokeStatic, 2);
+  EmitExpect(&entry, 1);
+  entry.Emit(kLoadLocal0);
+  entry.Emit(kLoadLiteral1);
+  entry.EmitInt32(kInvokeSub, 0);
+  entry.Emit(kStoreLocal, 1);
+  entry.Emit(kPop);
+  entry.EmitBranchBack(calls);
+  entry.Bind(calls_done);
+  entry.Emit(kLoadLiteral, Interpreter::kTerminate);
+  entry.Emit(kProcessYield);
+  Function* entry_function = entry.Finish(program, 0, 3);
+  entry_function->set_literal_at(0, fib_function);
+  entry_function->set_literal_at(1, sum_function);
+  entry_function->set_literal_at(2, halves_function);
+  program->set_entry(entry_function);
+
+  Array* statics = Array::cast(program->CreateArray(1));
+  statics->set(0, program->CreateInitializer(initializer_function));
+  program->set_static_fields(statics);
+
+  if (fuse) program->FuseBytecodes();
+  return program;
+}
+
+// Runs the test program and returns its exit code. Sets [compiled] to the
+// number of its functions that got compiled.
+static const int kTestThreshold = 10;
+
+static int RunTestProgram(bool jit, bool fuse, int* compiled) {
+  // The JIT decides on the method entry when it is set up.
+  bool old_jit = Flags::jit;
+  int old_threshold = Flags::jit_threshold;
+  Jit::TearDown();
+  Flags::jit = jit;
+  Flags::jit_threshold = kTestThreshold;
+  Jit::Setup();
+  Program* program = NewTestProgram(fuse);
+  SimpleProgramRunner runner;
+  int exitcode = -1;
+  runner.Run(1, &exitcode, &program, 0, NULL);
+  *compiled = Jit::GlobalInstance()->compiled_functions();
+  delete program;
+  Jit::TearDown();
+  Flags::jit = old_jit;
+  Flags::jit_threshold = old_threshold;
+  Jit::Setup();
+  return exitcode;
+}
+
+// Runs the same programs interpreted and compiled. Whatever the compiler
+// does not handle like the templates of the interpreter shows up here.
+TEST_CASE(JitCompiledFunctions) {
+  for (int fuse = 0; fuse < 2; fuse++) {
+    int compiled = -1;
+    EXPECT_EQ(0, RunTestProgram(false, fuse, &compiled));
+    EXPECT_EQ(0, compiled);
+    // Fib, sum and halves get hot.
+    EXPECT_EQ(0, RunTestProgram(true, fuse, &compiled));
+    EXPECT_EQ(3, compiled);
+  }
+}
+
+extern "C" void InterpreterInvokeStaticReturn();
+
+TEST_CASE(JitDiscardedCodeReturnsToInterpreter) {
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_static_fields(Array::cast(program->CreateArray(0)));
+
+  BytecodeBuilder caller;
+  caller.Emit(kLoadLiteral0);
+  int invoke = caller.position();
+  caller.EmitLiteral(kInvokeStatic, 0);
+  caller.Emit(kReturn);
+  Function* function = caller.Finish(program, 0, 1);
+  function->set_literal_at(0, function);
+
+  Jit* jit = Jit::GlobalInstance();
+  JitCode* code = jit->NewCode(program, function, 16);
+  ASSERT(code != NULL);
+  EXPECT(jit->Install(code));
+  void* return_address = code->entry() + 8;
+
+  // A process stopped in a function called from the compiled code.
+  Process* process = program->SpawnProcess(NULL);
+  Frame frame(process->stack());
+  frame.PushSentinelFrame();
+  frame.PushFrame(0, 0);
+  frame.SetByteCodePointer(function->bytecode_address_for(invoke));
+  frame.PushFrame(0, 0);
+  frame.SetReturnAddress(return_address);
+  frame.PushSafePoint(function->bytecode_address_for(0), NULL);
+
+  jit->DiscardCode(program);
+  EXPECT(jit->Lookup(function) == NULL);
+
+  Frame callee(process->stack());
+  EXPECT(callee.MovePrevious());
+  EXPECT_EQ(reinterpret_cast<void*>(InterpreterInvokeStaticReturn),
+            callee.ReturnAddress());
+
+  process->ChangeState(Process::kSleeping, Process::kWaitingForChildren);
+  program->ScheduleProcessForDeletion(process, Signal::kTerminated);
+  delete program;
+}
+
+TEST_CASE(JitDiscardedCodeIsReused) {
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  Function* functions[2];
+  for (int i = 0; i < 2; i++) {
+    BytecodeBuilder builder;
+    builder.Emit(kLoadLiteralNull);
+    builder.Emit(kReturn);
+    functions[i] = builder.Finish(program, 0, 0);
+  }
+  Function* first = functions[0];
+  Function* second = functions[1];
+
+  Jit* jit = Jit::GlobalInstance();
+  int compiled = jit->compiled_functions();
+  JitCode* code = jit->NewCode(program, first, 100);
+  ASSERT(code != NULL);
+  EXPECT(jit->Install(code));
+  JitCode* other = jit->NewCode(program, second, 40);
+  ASSERT(other != NULL);
+  EXPECT(jit->Install(other));
+  EXPECT_EQ(compiled + 2, jit->compiled_functions());
+
+  // The space of both is free again, and the first block is reused.
+  jit->DiscardCode(program);
+  EXPECT_EQ(compiled, jit->compiled_functions());
+  EXPECT(jit->NewCode(program, second, 120) == code);
+  delete program;
+}
+
+}  // namespace dartino
+
+#endif  // defined(DARTINO_TARGET_X64)
@@ -0,0 +1,1013 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#if defined(DARTINO_TARGET_X64)
+
+#include "src/vm/jit.h"
+
+#include "src/shared/bytecodes.h"
+#include "src/shared/selectors.h"
+#include "src/shared/utils.h"
+
+#include "src/vm/emitter_x64.h"
+#include "src/vm/interpreter.h"
+#include "src/vm/jit_assembler_x64.h"
+#include "src/vm/native_interpreter.h"
+#include "src/vm/object.h"
+#include "src/vm/process.h"
+#include "src/vm/program.h"
+
+#define __ assembler()->
+
+namespace dartino {
+
+extern "C" void InterpreterGCEntry();
+extern "C" void InterpreterJitMethodEntry();
+extern "C" void InterpreterStackOverflowEntry();
+
+// The JitCompiler translates the bytecodes of a function to the templates of
+// InterpreterGeneratorX64, one after the other. The code keeps the frame and
+// registers of the interpreter, except that R13 points to the first bytecode
+// of the function for the whole activation rather than to the current one.
+// There is no dispatch, and the operands of the bytecodes are constants.
+//
+// Whatever the code does not handle itself, it leaves to the interpreter: it
+// points R13 at the bytecode and jumps to the interpreter, which runs the
+// rest of the activation. Bytecodes that need the runtime (GC, stack
+// overflow, interrupts) exit the same way, and the interpreter redoes them.
+//
+// The templates that do not depend on how the operands are decoded or how
+// the next bytecode is reached live in EmitterX64, which the interpreter
+// generator shares. What is left here differs from the interpreter: its
+// operands are constants, it falls through to the next bytecode instead of
+// dispatching, and it calls the runtime by address. The switch in
+// CompileBytecode has no default, so new bytecodes do not compile until
+// they are handled here, and JitCompiledFunctions in jit_test.cc runs the
+// same program interpreted and compiled. Some work of the interpreter is
+// deliberately not done here:
+//
+// - Inline caches: the selector of an invoke is a constant here, so the
+//   dispatch table lookup is already as cheap as a cache probe.
+// - Top-of-stack caching: it saves stores around the dispatch, and there
+//   is no dispatch here.
+// - Quickening: ReadOpcode compiles quickened bytecodes like their
+//   originals. The arity of an invoke is a constant anyway, and
+//   LoadStaticInit keeps its check, because spawning a second process
+//   reverts quickened static loads.
+class JitCompiler : public EmitterX64<JitCompiler, JitLabel> {
+ public:
+  JitCompiler(JitAssembler* assembler, Function* function)
+      : assembler_(assembler),
+        bytecodes_(function->bytecode_address_for(0)),
+        labels_(NULL),
+        starts_(NULL),
+        end_(0) {}
+
+  ~JitCompiler() {
+    delete[] labels_;
+    delete[] starts_;
+    for (size_t i = 0; i < exits_.size(); i++) delete exits_[i];
+  }
+
+  // Returns false if the function is not worth compiling, because the
+  // code would leave it to the interpreter right away.
+  bool Compile();
+
+ private:
+  friend class EmitterX64<JitCompiler, JitLabel>;
+
+  enum ExitKind { kInterpret, kGC, kStackOverflow };
+
+  struct Exit {
+    JitLabel label;
+    int offset;
+    ExitKind kind;
+    int size;
+  };
+
+  JitAssembler* assembler() const { return assembler_; }
+
+  uint8 ReadByte(int offset) const { return bytecodes_[offset]; }
+  // Superinstructions compile like their first bytecode.
+  Opcode ReadOpcode(int offset) const {
+    return Bytecode::Unfuse(static_cast<Opcode>(ReadByte(offset)));
+  }
+  int32 ReadInt32(int offset) const {
+    return Utils::ReadInt32(bytecodes_ + offset);
+  }
+  int Size(int offset) const {
+    return Bytecode::Size(ReadOpcode(offset));
+  }
+
+  // Returns the label of the bytecode at [offset], or NULL if there is no
+  // bytecode there.
+  JitLabel* LabelAt(int offset);
+
+  // Returns a label that leaves the function to the interpreter at the
+  // bytecode at [offset].
+  JitLabel* NewExit(int offset, ExitKind kind, int size = 0);
+
+  bool IsSupported(Opcode opcode);
+  void CompileBytecode(int offset);
+
+  void StoreByteCodePointer(int offset);
+  void RestoreByteCodePointer(int offset);
+
+  void CheckStackOverflow(int offset);
+  void CheckFailure(Register reg, int offset);
+
+  void Branch(int target);
+  void BranchIf(int target, bool value);
+
+  void Allocate(int offset, bool immutable);
+
+  void InvokeMethod(int offset, bool test);
+  void InvokeStatic(int offset);
+  void InvokeLeafNative(int offset);
+
+  void InvokeCompare(int offset, Condition condition);
+  void InvokeArithmetic(int offset, Opcode opcode);
+  void InvokeBitNot(int offset);
+  void InvokeBitShr(int offset);
+  void InvokeBitShl(int offset);
+
+  void Identical(int offset);
+  void IdenticalNonNumeric();
+
+  JitAssembler* const assembler_;
+  uint8* const bytecodes_;
+  JitLabel* labels_;
+  // Whether a bytecode starts at an offset.
+  bool* starts_;
+  int end_;
+  Vector<Exit*> exits_;
+};
+
+bool JitCompiler::Compile() {
+  // Find the end of the bytecodes, and check that the function is worth
+  // compiling.
+  Opcode first = ReadOpcode(0);
+  if (!IsSupported(first)) return false;
+  for (int offset = 0;; offset += Size(offset)) {
+    Opcode opcode = ReadOpcode(offset);
+    // Unfolded programs have no dispatch table.
+    if (Bytecode::IsInvokeUnfold(opcode)) return false;
+    if (opcode == kMethodEnd) {
+      end_ = offset;
+      break;
+    }
+  }
+  labels_ = new JitLabel[end_];
+  starts_ = new bool[end_]();
+  for (int offset = 0; offset < end_; offset += Size(offset)) {
+    starts_[offset] = true;
+  }
+
+  __ pushq(RBP);
+  __ movq(RBP, RSP);
+  __ pushq(Immediate(0));
+  __ leaq(R13, Address(RAX, Function::kSize - HeapObject::kTag));
+  CheckStackOverflow(0);
+
+  for (int offset = 0; offset < end_; offset += Size(offset)) {
+    __ Bind(&labels_[offset]);
+    CompileBytecode(offset);
+  }
+
+  // The exits point R13 at their bytecode and enter the interpreter.
+  void* gc_entry = reinterpret_cast<void*>(InterpreterGCEntry);
+  void* overflow_entry = reinterpret_cast<void*>(InterpreterStackOverflowEntry);
+  for (size_t i = 0; i < exits_.size(); i++) {
+    Exit* exit = exits_[i];
+    __ Bind(&exit->label);
+    if (exit->offset != 0) {
+      __ leaq(R13, Address(R13, exit->offset));
+    }
+    switch (exit->kind) {
+      case kInterpret:
+        __ JumpAbsolute(reinterpret_cast<void*>(InterpreterEntry));
+        break;
+      case kGC:
+        __ JumpAbsolute(gc_entry);
+        break;
+      case kStackOverflow:
+        __ movq(RAX, Immediate(exit->size));
+        __ JumpAbsolute(overflow_entry);
+        break;
+    }
+  }
+  return true;
+}
+
+JitLabel* JitCompiler::LabelAt(int offset) {
+  if (offset < 0 || offset >= end_ || !starts_[offset]) return NULL;
+  return &labels_[offset];
+}
+
+JitLabel* JitCompiler::NewExit(int offset, ExitKind kind, int size) {
+  Exit* exit = new Exit();
+  exit->offset = offset;
+  exit->kind = kind;
+  exit->size = size;
+  exits_.PushBack(exit);
+  return &exit->label;
+}
+
+bool JitCompiler::IsSupported(Opcode opcode) {
+  switch (opcode) {
+    case kInvokeNative:
+    case kInvokeNativeYield:
+    case kInvokeSelector:
+    case kThrow:
+    case kSubroutineCall:
+    case kSubroutineReturn:
+    case kProcessYield:
+    case kCoroutineChange:
+    case kEnterNoSuchMethod:
+    case kExitNoSuchMethod:
+    case kMethodEnd:
+      return false;
+    default:
+      return !Bytecode::IsInvokeUnfold(opcode);
+  }
+}
+
+void JitCompiler::CompileBytecode(int offset) {
+  Opcode opcode = ReadOpcode(offset);
+  if (!IsSupported(opcode)) {
+    __ jmp(NewExit(offset, kInterpret));
+    return;
+  }
+
+  switch (opcode) {
+    case kLoadLocal0:
+    case kLoadLocal1:
+    case kLoadLocal2:
+    case kLoadLocal3:
+    case kLoadLocal4:
+    case kLoadLocal5:
+      LoadLocal(RAX, opcode - kLoadLocal0);
+      Push(RAX);
+      break;
+
+    case kLoadLocal:
+      LoadLocal(RAX, ReadByte(offset + 1));
+      Push(RAX);
+      break;
+
+    case kLoadLocalWide:
+      LoadLocal(RAX, ReadInt32(offset + 1));
+      Push(RAX);
+      break;
+
+    case kLoadBoxed:
+      LoadLocal(RBX, ReadByte(offset + 1));
+      __ movq(RAX, Address(RBX, Boxed::kValueOffset - HeapObject::kTag));
+      Push(RAX);
+      break;
+
+    case kLoadStatic:
+    case kLoadStaticInit: {
+      int index = ReadInt32(offset + 1);
+      LoadStaticsArray(RBX);
+      __ movq(RAX, Address(RBX, Array::kSize - HeapObject::kTag +
+                                    index * kWordSize));
+      if (opcode == kLoadStaticInit) {
+        JitLabel done;
+        JumpIfNotInitializer(RAX, &done);
+
+        // Invoke the initializer function.
+        __ movq(RAX,
+                Address(RAX, Initializer::kFunctionOffset - HeapObject::kTag));
+
+        StoreByteCodePointer(offset);
+        __ CallAbsolute(reinterpret_cast<void*>(InterpreterMethodEntry));
+        RestoreByteCodePointer(offset);
+
+        __ Bind(&done);
+      }
+      Push(RAX);
+      break;
+    }
+
+    case kLoadField:
+    case kLoadFieldWide: {
+      int index = opcode == kLoadField ? ReadByte(offset + 1)
+                                       : ReadInt32(offset + 1);
+      LoadLocal(RAX, 0);
+      __ movq(RAX, Address(RAX, Instance::kSize - HeapObject::kTag +
+                                    index * kWordSize));
+      StoreLocal(RAX, 0);
+      break;
+    }
+
+    case kLoadConst:
+      __ movq(RAX, Address(R13, offset + ReadInt32(offset + 1)));
+      Push(RAX);
+      break;
+
+    case kStoreLocal:
+      LoadLocal(RBX, 0);
+      StoreLocal(RBX, ReadByte(offset + 1));
+      break;
+
+    case kStoreBoxed:
+      LoadLocal(RCX, 0);
+      LoadLocal(RBX, ReadByte(offset + 1));
+      __ movq(Address(RBX, Boxed::kValueOffset - HeapObject::kTag), RCX);
+      AddToRememberedSet(RBX, RCX, RAX);
+      break;
+
+    case kStoreStatic: {
+      int index = ReadInt32(offset + 1);
+      LoadLocal(RCX, 0);
+      LoadStaticsArray(RBX);
+      __ movq(Address(RBX, Array::kSize - HeapObject::kTag +
+                               index * kWordSize),
+              RCX);
+      AddToRememberedSet(RBX, RCX, RAX);
+      break;
+    }
+
+    case kStoreField:
+    case kStoreFieldWide: {
+      int index = opcode == kStoreField ? ReadByte(offset + 1)
+                                        : ReadInt32(offset + 1);
+      LoadLocal(RCX, 0);
+      LoadLocal(RAX, 1);
+      __ movq(Address(RAX, Instance::kSize - HeapObject::kTag +
+                               index * kWordSize),
+              RCX);
+      StoreLocal(RCX, 1);
+      Drop(1);
+      AddToRememberedSet(RAX, RCX, RBX);
+      break;
+    }
+
+    case kLoadLiteralNull:
+      LoadLiteralNull(RAX);
+      Push(RAX);
+      break;
+
+    case kLoadLiteralTrue:
+      LoadLiteralTrue(RAX);
+      Push(RAX);
+      break;
+
+    case kLoadLiteralFalse:
+      LoadLiteralFalse(RAX);
+      Push(RAX);
+      break;
+
+    case kLoadLiteral0:
+    case kLoadLiteral1:
+    case kLoadLiteral:
+    case kLoadLiteralWide: {
+      word value = opcode == kLoadLiteral0 ? 0 : opcode == kLoadLiteral1 ? 1
+                 : opcode == kLoadLiteral ? ReadByte(offset + 1)
+                 : static_cast<uint32>(ReadInt32(offset + 1));
+      __ movq(RAX, Immediate(reinterpret_cast<word>(Smi::FromWord(value))));
+      Push(RAX);
+      break;
+    }
+
+    case kInvokeMethod:
+      InvokeMethod(offset, false);
+      break;
+
+    case kInvokeTest:
+      InvokeMethod(offset, true);
+      break;
+
+    case kInvokeEq:
+      InvokeCompare(offset, EQUAL);
+      break;
+
+    case kInvokeLt:
+      InvokeCompare(offset, LESS);
+      break;
+
+    case kInvokeLe:
+      InvokeCompare(offset, LESS_EQUAL);
+      break;
+
+    case kInvokeGt:
+      InvokeCompare(offset, GREATER);
+      break;
+
+    case kInvokeGe:
+      InvokeCompare(offset, GREATER_EQUAL);
+      break;
+
+    case kInvokeAdd:
+    case kInvokeSub:
+    case kInvokeMul:
+    case kInvokeBitAnd:
+    case kInvokeBitOr:
+    case kInvokeBitXor:
+      InvokeArithmetic(offset, opcode);
+      break;
+
+    case kInvokeMod:
+    case kInvokeTruncDiv:
+      // The interpreter has no fast case for these either.
+      InvokeMethod(offset, false);
+      break;
+
+    case kInvokeBitNot:
+      InvokeBitNot(offset);
+      break;
+
+    case kInvokeBitShr:
+      InvokeBitShr(offset);
+      break;
+
+    case kInvokeBitShl:
+      InvokeBitShl(offset);
+      break;
+
+    case kInvokeStatic:
+    case kInvokeFactory:
+      InvokeStatic(offset);
+      break;
+
+    case kAllocate:
+      Allocate(offset, false);
+      break;
+
+    case kAllocateImmutable:
+      Allocate(offset, true);
+      break;
+
+    case kInvokeNoSuchMethod:
+      // Rare enough to leave to the interpreter.
+      __ jmp(NewExit(offset, kInterpret));
+      break;
+
+    case kInvokeTestNoSuchMethod:
+      LoadLiteralFalse(RAX);
+      StoreLocal(RAX, 0);
+      break;
+
+    case kInvokeLeafNative:
+      InvokeLeafNative(offset);
+      break;
+
+    case kPop:
+      Drop(1);
+      break;
+
+    case kDrop:
+      Drop(ReadByte(offset + 1));
+      break;
+
+    case kReturn:
+      Return(false);
+      break;
+
+    case kReturnNull:
+      Return(true);
+      break;
+
+    case kBranchWide:
+      Branch(offset + ReadInt32(offset + 1));
+      break;
+
+    case kBranchIfTrueWide:
+      BranchIf(offset + ReadInt32(offset + 1), true);
+      break;
+
+    case kBranchIfFalseWide:
+      BranchIf(offset + ReadInt32(offset + 1), false);
+      break;
+
+    case kBranchBack:
+      CheckStackOverflow(offset);
+      Branch(offset - ReadByte(offset + 1));
+      break;
+
+    case kBranchBackIfTrue:
+      CheckStackOverflow(offset);
+      BranchIf(offset - ReadByte(offset + 1), true);
+      break;
+
+    case kBranchBackIfFalse:
+      CheckStackOverflow(offset);
+      BranchIf(offset - ReadByte(offset + 1), false);
+      break;
+
+    case kBranchBackWide:
+      CheckStackOverflow(offset);
+      Branch(offset - ReadInt32(offset + 1));
+      break;
+
+    case kBranchBackIfTrueWide:
+      CheckStackOverflow(offset);
+      BranchIf(offset - ReadInt32(offset + 1), true);
+      break;
+
+    case kBranchBackIfFalseWide:
+      CheckStackOverflow(offset);
+      BranchIf(offset - ReadInt32(offset + 1), false);
+      break;
+
+    case kPopAndBranchWide:
+      Drop(ReadByte(offset + 1));
+      Branch(offset + ReadInt32(offset + 2));
+      break;
+
+    case kPopAndBranchBackWide:
+      CheckStackOverflow(offset);
+      Drop(ReadByte(offset + 1));
+      Branch(offset - ReadInt32(offset + 2));
+      break;
+
+    case kAllocateBoxed:
+      LoadLocal(RSI, 0);
+      LoadProcess(RDI);
+      SwitchToCStack();
+      __ CallAbsolute(reinterpret_cast<void*>(HandleAllocateBoxed));
+      SwitchToDartStack();
+      CheckFailure(RAX, offset);
+      StoreLocal(RAX, 0);
+      break;
+
+    case kNegate: {
+      JitLabel store;
+      LoadLocal(RBX, 0);
+      LoadProgram(RCX);
+      __ movq(RAX, Address(RCX, Program::kTrueObjectOffset));
+      __ cmpq(RBX, RAX);
+      __ j(NOT_EQUAL, &store);
+      __ movq(RAX, Address(RCX, Program::kFalseObjectOffset));
+      __ Bind(&store);
+      StoreLocal(RAX, 0);
+      break;
+    }
+
+    case kStackOverflowCheck: {
+      int size = ReadInt32(offset + 1);
+      LoadProcess(RBX);
+      __ movq(RBX, Address(RBX, Process::kStackLimitOffset));
+      __ leaq(RCX, Address(RSP, -size * kWordSize));
+      __ cmpq(RCX, RBX);
+      __ j(BELOW_EQUAL, NewExit(offset, kStackOverflow, size));
+      break;
+    }
+
+    case kIdentical:
+      Identical(offset);
+      break;
+
+    case kIdenticalNonNumeric:
+      IdenticalNonNumeric();
+      break;
+
+    // The switch has no default, so the compiler points out every bytecode
+    // added to the interpreter that the JIT does not know about yet. The
+    // bytecodes below never get here: IsSupported leaves them to the
+    // interpreter, Compile rejects unfolded programs, and ReadOpcode
+    // unfuses superinstructions and quickened bytecodes.
+    case kInvokeNative:
+    case kInvokeNativeYield:
+    case kInvokeSelector:
+    case kThrow:
+    case kSubroutineCall:
+    case kSubroutineReturn:
+    case kProcessYield:
+    case kCoroutineChange:
+    case kEnterNoSuchMethod:
+    case kExitNoSuchMethod:
+    case kMethodEnd:
+#define UNFOLD_CASE(name, branching, format, length, stack_diff, print) \
+    case k##name:
+    INVOKES_DO(UNFOLD_CASE, Unfold, "unfold ")
+#undef UNFOLD_CASE
+#define SUPERINSTRUCTION_CASE(name, first, second) case k##name:
+    SUPERINSTRUCTIONS_DO(SUPERINSTRUCTION_CASE)
+#undef SUPERINSTRUCTION_CASE
+#define QUICKENED_CASE(name, original) case k##name:
+    QUICKENED_DO(QUICKENED_CASE)
+#undef QUICKENED_CASE
+      UNREACHABLE();
+      break;
+  }
+}
+
+void JitCompiler::StoreByteCodePointer(int offset) {
+  // The frame holds the real bytecode pointer, so the runtime can walk it
+  // and the interpreter can continue it.
+  __ leaq(R11, Address(R13, offset));
+  __ movq(Address(RBP, -kWordSize), R11);
+}
+
+void JitCompiler::RestoreByteCodePointer(int offset) {
+  // The function may have been moved by a program GC.
+  __ movq(R13, Address(RBP, -kWordSize));
+  if (offset != 0) __ subq(R13, Immediate(offset));
+}
+
+void JitCompiler::CheckStackOverflow(int offset) {
+  LoadProcess(RBX);
+  __ movq(RBX, Address(RBX, Process::kStackLimitOffset));
+  __ cmpq(RSP, RBX);
+  __ j(BELOW_EQUAL, NewExit(offset, kStackOverflow));
+}
+
+void JitCompiler::CheckFailure(Register reg, int offset) {
+  JumpIfRetryAfterGC(reg, NewExit(offset, kGC));
+}
+
+void JitCompiler::Branch(int target) {
+  JitLabel* label = LabelAt(target);
+  if (label == NULL) label = NewExit(target, kInterpret);
+  __ jmp(label);
+}
+
+void JitCompiler::BranchIf(int target, bool value) {
+  JitLabel* label = LabelAt(target);
+  if (label == NULL) label = NewExit(target, kInterpret);
+  Pop(RBX);
+  LoadLiteralTrue(RAX);
+  __ cmpq(RBX, RAX);
+  __ j(value ? EQUAL : NOT_EQUAL, label);
+}
+
+void JitCompiler::Allocate(int offset, bool immutable) {
+  // Load the class into register rbx.
+  __ movq(RBX, Address(R13, offset + ReadInt32(offset + 1)));
+
+  ComputeImmutability(immutable);
+
+  LoadProcess(RDI);
+  SwitchToCStack();
+  __ movq(RSI, RBX);
+  // NOTE: The 3rd argument is already present in RDX
+  __ CallAbsolute(reinterpret_cast<void*>(HandleAllocate));
+  SwitchToDartStack();
+  CheckFailure(RAX, offset);
+
+  PopFieldsIntoInstance();
+}
+
+void JitCompiler::InvokeMethod(int offset, bool test) {
+  uword selector = static_cast<uint32>(ReadInt32(offset + 1));
+  int arity = Selector::ArityField::decode(selector);
+  // The selector offset into the dispatch table, smi tagged.
+  word table_offset = reinterpret_cast<word>(
+      Smi::FromWord(Selector::IdField::decode(selector)));
+
+  // Fetch the dispatch table from the program.
+  LoadProgram(RCX);
+  __ movq(RCX, Address(RCX, Program::kDispatchTableOffset));
+
+  // Get the receiver from the stack.
+  LoadLocal(RBX, test ? 0 : arity);
+
+  // Compute the receiver class.
+  JitLabel smi, dispatch, invalid, validated, done;
+  ASSERT(Smi::kTag == 0);
+  __ testq(RBX, Immediate(Smi::kTagMask));
+  __ j(ZERO, &smi);
+  __ movq(RBX, Address(RBX, HeapObject::kClassOffset - HeapObject::kTag));
+
+  // Compute entry index: class id + selector offset.
+  int id_offset = Class::kIdOrTransformationTargetOffset - HeapObject::kTag;
+  __ Bind(&dispatch);
+  __ movq(RBX, Address(RBX, id_offset));
+  __ addq(RBX, Immediate(table_offset));
+
+  // Fetch the entry from the table. Because the index is smi tagged
+  // we only multiply by four -- not eight -- when indexing.
+  ASSERT(Smi::kTagSize == 1);
+  __ movq(RCX, Address(RCX, RBX, TIMES_4, Array::kSize - HeapObject::kTag));
+
+  // Validate that the offset stored in the entry matches the offset
+  // we used to find it.
+  __ cmpq(Address(RCX, DispatchTableEntry::kOffsetOffset - HeapObject::kTag),
+          Immediate(table_offset));
+  __ j(NOT_EQUAL, &invalid);
+
+  if (test) {
+    // Valid entry: The answer is true.
+    LoadLiteralTrue(RAX);
+    StoreLocal(RAX, 0);
+    __ jmp(&done);
+  } else {
+    // Load the target from the entry.
+    __ Bind(&validated);
+    __ movq(RAX,
+            Address(RCX, DispatchTableEntry::kTargetOffset - HeapObject::kTag));
+
+    StoreByteCodePointer(offset);
+    __ call(Address(RCX, DispatchTableEntry::kCodeOffset - HeapObject::kTag));
+    RestoreByteCodePointer(offset);
+
+    Drop(arity);
+    StoreLocal(RAX, 0);
+    __ jmp(&done);
+  }
+
+  __ Bind(&smi);
+  LoadProgram(RBX);
+  __ movq(RBX, Address(RBX, Program::kSmiClassOffset));
+  __ jmp(&dispatch);
+
+  __ Bind(&invalid);
+  if (test) {
+    // Invalid entry: The answer is false.
+    LoadLiteralFalse(RAX);
+    StoreLocal(RAX, 0);
+  } else {
+    // Invalid entry: Use the noSuchMethod entry from entry zero of
+    // the virtual table.
+    LoadProgram(RCX);
+    __ movq(RCX, Address(RCX, Program::kDispatchTableOffset));
+    __ movq(RCX, Address(RCX, Array::kSize - HeapObject::kTag));
+    __ jmp(&validated);
+  }
+
+  __ Bind(&done);
+}
+
+void JitCompiler::InvokeStatic(int offset) {
+  int literal = offset + ReadInt32(offset + 1);
+  __ movq(RAX, Address(R13, literal));
+
+  // Compiled code only runs with -Xjit, so static calls go through the
+  // entry of the JIT.
+  StoreByteCodePointer(offset);
+  __ CallAbsolute(reinterpret_cast<void*>(InterpreterJitMethodEntry));
+  RestoreByteCodePointer(offset);
+
+  // Read the arity from the function. Note that the arity is smi tagged.
+  __ movq(RDX, Address(R13, literal));
+  __ movq(RDX, Address(RDX, Function::kArityOffset - HeapObject::kTag));
+  __ shrq(RDX, Immediate(Smi::kTagSize));
+
+  Drop(RDX);
+
+  Push(RAX);
+}
+
+void JitCompiler::InvokeLeafNative(int offset) {
+  int arity = ReadByte(offset + 1);
+  int native = ReadByte(offset + 2);
+
+  __ movq(RAX, Immediate(reinterpret_cast<word>(kNativeTable[native])));
+
+  // Extract address for first argument (note we skip two empty slots).
+  __ leaq(RSI, Address(RSP, (arity + 2) * kWordSize));
+  LoadProcess(RDI);
+
+  SwitchToCStack();
+  __ call(RAX);
+  SwitchToDartStack();
+
+  JitLabel failure, done;
+  __ movq(RCX, RAX);
+  __ andq(RCX, Immediate(Failure::kTagMask));
+  __ cmpq(RCX, Immediate(Failure::kTag));
+  __ j(EQUAL, &failure);
+
+  __ movq(RSP, RBP);
+  __ popq(RBP);
+  __ ret();
+
+  // Failure: Check if it's a request to garbage collect. If not,
+  // just continue running the failure block.
+  __ Bind(&failure);
+  CheckFailure(RAX, offset);
+
+  LoadProcess(RDI);
+  SwitchToCStack();
+  __ movq(RSI, RAX);
+  __ CallAbsolute(reinterpret_cast<void*>(HandleObjectFromFailure));
+  SwitchToDartStack();
+
+  Push(RAX);
+}
+
+void JitCompiler::InvokeCompare(int offset, Condition condition) {
+  JitLabel fallback, not_smis, true_case, false_case, done;
+  LoadLocal(RAX, 0);
+  __ testq(RAX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &not_smis);
+  LoadLocal(RBX, 1);
+  __ testq(RBX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &not_smis);
+
+  __ cmpq(RBX, RAX);
+  __ j(condition, &true_case);
+
+  __ Bind(&false_case);
+  LoadLiteralFalse(RAX);
+  StoreLocal(RAX, 1);
+  Drop(1);
+  __ jmp(&done);
+
+  __ Bind(&true_case);
+  LoadLiteralTrue(RAX);
+  StoreLocal(RAX, 1);
+  Drop(1);
+  __ jmp(&done);
+
+  // Compare doubles with the left operand in XMM0.
+  __ Bind(&not_smis);
+  LoadLocal(RAX, 0);
+  LoadLocal(RBX, 1);
+  LoadDoubleValues(RBX, RAX, &fallback);
+  CompareDoubles(condition, &true_case, &false_case);
+
+  __ Bind(&fallback);
+  InvokeMethod(offset, false);
+  __ Bind(&done);
+}
+
+void JitCompiler::InvokeArithmetic(int offset, Opcode opcode) {
+  JitLabel fallback, not_smis, overflow, done;
+  LoadLocal(RAX, 1);
+  __ testq(RAX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &not_smis);
+  LoadLocal(RBX, 0);
+  __ testq(RBX, Immediate(Smi::kTagMask));
+  __ j(NOT_ZERO, &not_smis);
+
+  switch (opcode) {
+    case kInvokeAdd:
+      __ addq(RAX, RBX);
+      __ j(OVERFLOW_, &overflow);
+      break;
+    case kInvokeSub:
+      __ subq(RAX, RBX);
+      __ j(OVERFLOW_, &overflow);
+      break;
+    case kInvokeMul:
+      // Untag and multiply. Products that do not fit in 64 bits are left to
+      // the fallback.
+      __ sarq(RAX, Immediate(1));
+      __ sarq(RBX, Immediate(1));
+      __ imul(RAX, RBX);
+      __ j(OVERFLOW_, &fallback);
+      // Re-tag. We need to check for overflow to handle the case
+      // where the top two bits are 01 after the multiplication.
+      ASSERT(Smi::kTagSize == 1 && Smi::kTag == 0);
+      __ addq(RAX, RAX);
+      __ j(OVERFLOW_, &overflow);
+      break;
+    case kInvokeBitAnd:
+      __ andq(RAX, RBX);
+      break;
+    case kInvokeBitOr:
+      __ orq(RAX, RBX);
+      break;
+    case kInvokeBitXor:
+      __ xorq(RAX, RBX);
+      break;
+    default:
+      UNREACHABLE();
+  }
+
+  StoreLocal(RAX, 1);
+  Drop(1);
+  __ jmp(&done);
+
+  if (opcode == kInvokeAdd || opcode == kInvokeSub || opcode == kInvokeMul) {
+    // The untagged result always fits in a large integer.
+    __ Bind(&overflow);
+    LoadLocal(RAX, 1);
+    LoadLocal(RBX, 0);
+    __ sarq(RAX, Immediate(1));
+    __ sarq(RBX, Immediate(1));
+    if (opcode == kInvokeAdd) {
+      __ addq(RAX, RBX);
+    } else if (opcode == kInvokeSub) {
+      __ subq(RAX, RBX);
+    } else {
+      __ imul(RAX, RBX);
+    }
+    ReplaceOperandsWithLargeInteger(&fallback);
+    __ jmp(&done);
+
+    __ Bind(&not_smis);
+    LoadLocal(RAX, 1);
+    LoadLocal(RBX, 0);
+    LoadDoubleValues(RAX, RBX, &fallback);
+    if (opcode == kInvokeAdd) {
+      __ addsd(XMM0, XMM1);
+    } else if (opcode == kInvokeSub) {
+      __ subsd(XMM0, XMM1);
+    } else {
+      __ mulsd(XMM0, XMM1);
+    }
+    ReplaceOperandsWithDouble(&fallback);
+    __ jmp(&done);
+  } else {
+    __ Bind(&not_smis);
+  }
+
+  __ Bind(&fallback);
+  InvokeMethod(offset, false);
+  __ Bind(&done);
+}
+
+void JitCompiler::InvokeBitNot(int offset) {
+  JitLabel fallback, done;
+  SmiBitNot(&fallback);
+  __ jmp(&done);
+
+  __ Bind(&fallback);
+  InvokeMethod(offset, false);
+  __ Bind(&done);
+}
+
+void JitCompiler::InvokeBitShr(int offset) {
+  JitLabel fallback, done;
+  SmiBitShr(&fallback);
+  __ jmp(&done);
+
+  __ Bind(&fallback);
+  InvokeMethod(offset, false);
+  __ Bind(&done);
+}
+
+void JitCompiler::InvokeBitShl(int offset) {
+  JitLabel fallback, done;
+  SmiBitShl(&fallback);
+  __ jmp(&done);
+
+  __ Bind(&fallback);
+  InvokeMethod(offset, false);
+  __ Bind(&done);
+}
+
+void JitCompiler::Identical(int offset) {
+  LoadLocal(RAX, 0);
+  LoadLocal(RBX, 1);
+
+  JitLabel bail_out, true_case, done;
+  JumpIfIdenticalByValue(&bail_out);
+
+  LoadProgram(RCX);
+  __ cmpq(RBX, RAX);
+  __ j(EQUAL, &true_case);
+  __ movq(RAX, Address(RCX, Program::kFalseObjectOffset));
+  __ jmp(&done);
+
+  __ Bind(&true_case);
+  __ movq(RAX, Address(RCX, Program::kTrueObjectOffset));
+  __ jmp(&done);
+
+  __ Bind(&bail_out);
+  LoadProcess(RDI);
+  SwitchToCStack();
+  __ movq(RSI, RBX);
+  __ movq(RDX, RAX);
+  __ CallAbsolute(reinterpret_cast<void*>(HandleIdentical));
+  SwitchToDartStack();
+
+  __ Bind(&done);
+  StoreLocal(RAX, 1);
+  Drop(1);
+}
+
+void JitCompiler::IdenticalNonNumeric() {
+  JitLabel true_case, done;
+  LoadLocal(RAX, 0);
+  LoadLocal(RBX, 1);
+  LoadProgram(RCX);
+  __ cmpq(RAX, RBX);
+  __ j(EQUAL, &true_case);
+  __ movq(RAX, Address(RCX, Program::kFalseObjectOffset));
+  __ jmp(&done);
+
+  __ Bind(&true_case);
+  __ movq(RAX, Address(RCX, Program::kTrueObjectOffset));
+
+  __ Bind(&done);
+  StoreLocal(RAX, 1);
+  Drop(1);
+}
+
+extern "C" void* HandleHotFunction(Process* process, Function* function) {
+  Jit* jit = Jit::GlobalInstance();
+  if (!jit->ShouldCompile(process, function)) return NULL;
+  JitCode* code = jit->Lookup(function);
+  if (code == NULL) {
+    JitAssembler assembler;
+    JitCompiler compiler(&assembler, function);
+    if (!compiler.Compile()) {
+      Jit::EntryOf(function)->counter = Jit::kNeverHot;
+      return NULL;
+    }
+    code = jit->NewCode(process->program(), function, assembler.size());
+    if (code == NULL) return NULL;
+    assembler.CopyTo(code->entry());
+  }
+  return jit->Install(code) ? code->entry() : NULL;
+}
+
+}  // namespace dartino
+
+#endif  // defined(DARTINO_TARGET_X64)
@@ -7,6 +7,7 @@
 #include <stddef.h>  // for size_t
 
 #include "include/dartino_api.h"
+#include "include/dartino_relocation_api.h"
 #include "include/socket_connection_api.h"
 
 #include "src/shared/flags.h"
@@ -79,6 +80,10 @@ static void PrintUsage() {
   Print::Out("Run snapshot interactively, run right away:\n");
   Print::Out("  dartino-vm --interactive --no-wait [--port=<port>] "
       "[--host=<address>] snapshot-file\n\n");
+  Print::Out("Write a program image of a snapshot:\n");
+  Print::Out("  dartino-vm --write-image=<image-file> snapshot-file\n\n");
+  Print::Out("Run program image non-interactively:\n");
+  Print::Out("  dartino-vm image-file\n\n");
   Print::Out("Run interactively without snapshot:\n");
   Print::Out("  dartino-vm [--interactive] [--port=<port>] "
       "[--host=<address>]\n\n");
@@ -97,6 +102,10 @@ static void PrintUsage() {
   Print::Out(
       "  --port: specifies which port to listen on. Defaults "
       "to a random available port.\n");
+  Print::Out(
+      "  --write-image: writes the program of the snapshot to a program\n"
+      "    image instead of running it. Processes that run the same image\n"
+      "    share the memory of its program.\n");
   Print::Out("  --help: print out 'dartino-vm' usage.\n");
   Print::Out("  --version: print the version.\n");
   Print::Out("\n");
@@ -120,6 +129,7 @@ static int Main(int argc, char** argv) {
   const char* port_file = NULL;
   int port = 0;
   const char* input = NULL;
+  const char* image_output = NULL;
 
   // We run a snapshot only if the arguments contain a file name.
   bool run_snapshot = false;
@@ -151,6 +161,8 @@ static int Main(int argc, char** argv) {
       log_dir = argument + 10;
     } else if (StartsWith(argument, "--port-file=")) {
       port_file = argument + 12;
+    } else if (StartsWith(argument, "--write-image=")) {
+      image_output = argument + 14;
     } else if (strcmp(argument, "--interactive") == 0) {
       interactive = true;
     } else if (strcmp(argument, "--no-wait") == 0) {
@@ -170,6 +182,12 @@ static int Main(int argc, char** argv) {
     invalid_option = true;
   }
 
+  if (image_output != NULL && (!run_snapshot || interactive)) {
+    Print::Out("Invalid option: '--write-image' requires a snapshot and "
+               "cannot be interactive.");
+    invalid_option = true;
+  }
+
   if (invalid_option) {
     // Don't continue if one or more invalid/unknown options were passed.
     Print::Out("\n");
@@ -189,10 +207,16 @@ static int Main(int argc, char** argv) {
     Print::RegisterPrintInterceptor(new LogPrintInterceptor(log_path));
   }
 
-  DartinoProgram program;
+  DartinoProgram program = NULL;
+
+  // Check if we're passed a program image directly. Program images are
+  // read-only, so they do not run interactively.
+  if (run_snapshot && !interactive && image_output == NULL) {
+    program = DartinoLoadProgramImage(input);
+  }
 
   // Check if we're passed an snapshot file directly.
-  if (run_snapshot) {
+  if (program == NULL && run_snapshot) {
     List<uint8> bytes = Platform::LoadFile(input);
     if (bytes.is_empty()) {
       Print::Out("\n");  // Separate error from Platform::LoadFile from usage.
@@ -211,7 +235,7 @@ static int Main(int argc, char** argv) {
       exit(1);
     }
     bytes.Delete();
-  } else {
+  } else if (program == NULL) {
     dartino::Program *p =
         new dartino::Program(dartino::Program::kBuiltViaSession);
     p->Initialize();
@@ -220,7 +244,12 @@ static int Main(int argc, char** argv) {
     interactive = true;
   }
 
-  if (interactive) {
+  if (image_output != NULL) {
+    if (!DartinoWriteProgramImage(program, image_output)) {
+      Print::Out("Could not write the program image '%s'.\n", image_output);
+      result = 1;
+    }
+  } else if (interactive) {
     struct ConnectionArguments* listener_arguments = new ConnectionArguments();
     listener_arguments->host = host;
     listener_arguments->port = port;
@@ -5,6 +5,8 @@
 #ifndef SRC_VM_MARK_SWEEP_H_
 #define SRC_VM_MARK_SWEEP_H_
 
+#include "src/shared/atomic.h"
+#include "src/shared/platform.h"
 #include "src/shared/utils.h"
 #include "src/vm/object.h"
 #include "src/vm/program.h"
@@ -12,33 +14,85 @@
 
 namespace dartino {
 
+// A segment of the marking stack. Segments are chained together so the
+// stack can grow as deep as the object graph requires.
+struct MarkingStackSegment {
+  static const int kCapacity = 1023;
+
+  MarkingStackSegment* previous;
+  HeapObject* objects[kCapacity];
+};
+
+// The marking stack grows by adding segments, taken from a pool that is
+// shared by all marking stacks. Only if no segment can be had do objects get
+// marked as overflowed, in which case Process rescans the spaces for them.
+// Marking stacks live on the native stack of the collecting thread, so even
+// the first segment comes from the pool.
 class MarkingStack {
  public:
-  MarkingStack() : next_(&backing_[0]), limit_(&backing_[kChunkSize]) {}
+  MarkingStack();
+
+  ~MarkingStack();
 
   void Push(HeapObject* object) {
     ASSERT(GCMetadata::IsMarked(object));
     if (next_ < limit_) {
       *(next_++) = object;
     } else {
-      overflowed_ = true;
-      GCMetadata::MarkStackOverflow(object);
+      PushSlow(object);
     }
   }
 
-  bool IsEmpty() { return next_ == &backing_[0]; }
+  bool IsEmpty() {
+    return next_ == base_ && (segment_ == NULL || segment_->previous == NULL);
+  }
   bool IsOverflowed() { return overflowed_; }
   void ClearOverflow() { overflowed_ = false; }
 
   void Empty(PointerVisitor* visitor);
   void Process(PointerVisitor* visitor, Space* old_space, Space* new_space);
 
+  // Number of objects that did not fit on any marking stack since startup.
+  static uword overflow_count() { return overflow_count_; }
+
+  static void Setup();
+  static void TearDown();
+
  private:
-  static const int kChunkSize = 128;
+  // Limits the size of a single marking stack to 64MB on 64 bit platforms.
+  static const int kMaxSegments = 8 * 1024;
+  // The number of unused segments kept around for the next GC.
+  static const int kMaxPooledSegments = 16;
+
+  void UseSegment(MarkingStackSegment* segment) {
+    segment_ = segment;
+    base_ = &segment->objects[0];
+    limit_ = &segment->objects[MarkingStackSegment::kCapacity];
+    next_ = base_;
+  }
+
+  void PushSlow(HeapObject* object);
+  bool PopSegment();
+
+  static MarkingStackSegment* AllocateSegment();
+  static void FreeSegment(MarkingStackSegment* segment);
+
   HeapObject** next_;
+  HeapObject** base_;
   HeapObject** limit_;
-  HeapObject* backing_[kChunkSize];
+  // NULL only if not even the first segment could be allocated, in which
+  // case every push overflows.
+  MarkingStackSegment* segment_;
+  int segment_count_;
+  // The most recently popped segment is kept to avoid going to the pool when
+  // the stack depth moves back and forth across a segment boundary.
+  MarkingStackSegment* spare_;
   bool overflowed_ = false;
+
+  static Mutex* pool_mutex_;
+  static MarkingStackSegment* pool_;
+  static int pool_size_;
+  static Atomic<uword> overflow_count_;
 };
 
 class MarkingVisitor : public PointerVisitor {
@@ -85,106 +139,112 @@ class MarkingVisitor : public PointerVisitor {
   int number_of_stacks_;
 };
 
+// Segregated free list for the old space. Small free chunks are kept in
+// exact size classes, one per word size, so that small allocations can be
+// satisfied from a hole of (nearly) the right size in constant time.
+// Larger free chunks are kept in power-of-two buckets. Bitmaps of the
+// non-empty classes and buckets make finding the best fitting class or the
+// largest bucket a couple of bit operations rather than a linear search.
 class FreeList {
  public:
-#if defined(_MSC_VER)
-  // Work around Visual Studo 2013 bug 802058
-  FreeList(void) {
-    memset(buckets_, 0, kNumberOfBuckets * sizeof(FreeListChunk*));
-  }
-#endif
+  FreeList() { Clear(); }
 
-  void AddChunk(uword free_start, uword free_size) {
-    // If the chunk is too small to be turned into an actual
-    // free list chunk we turn it into fillers to be coalesced
-    // with other free chunks later.
+  // Turn free memory into something that can be iterated over, without
+  // making it available for allocation.
+  static void MakeFiller(uword free_start, uword free_size) {
     if (free_size < FreeListChunk::kSize) {
       ASSERT(free_size <= 2 * kPointerSize);
       Object** free_address = reinterpret_cast<Object**>(free_start);
       for (uword i = 0; i * kPointerSize < free_size; i++) {
         free_address[i] = StaticClassStructures::one_word_filler_class();
       }
+    } else {
+      FreeListChunk* filler = FreeListChunk::CreateAt(free_start, free_size);
+      filler->set_next_chunk(NULL);
+    }
+  }
+
+  void AddChunk(uword free_start, uword free_size) {
+    // If the chunk is too small to be turned into an actual
+    // free list chunk we turn it into fillers to be coalesced
+    // with other free chunks later.
+    if (free_size < FreeListChunk::kSize) {
+      MakeFiller(free_start, free_size);
       return;
     }
     // Large enough to add a free list chunk.
     FreeListChunk* result = FreeListChunk::CreateAt(free_start, free_size);
-    int bucket = Utils::HighestBit(free_size) - 1;
-    if (bucket >= kNumberOfBuckets) bucket = kNumberOfBuckets - 1;
-    result->set_next_chunk(buckets_[bucket]);
-    buckets_[bucket] = result;
+    if (free_size < kSmallLimit) {
+      int size_class = free_size >> kPointerSizeLog2;
+      result->set_next_chunk(small_[size_class]);
+      small_[size_class] = result;
+      small_mask_ |= static_cast<uint64>(1) << size_class;
+    } else {
+      int bucket = Utils::HighestBit(free_size);
+      result->set_next_chunk(buckets_[bucket]);
+      buckets_[bucket] = result;
+      bucket_mask_ |= static_cast<uint64>(1) << bucket;
+    }
   }
 
-  FreeListChunk* GetChunk(uword min_size) {
-    int smallest_bucket = Utils::HighestBit(min_size);
-    ASSERT(smallest_bucket > 0);
-
-    // Locate largest chunk in free list guaranteed to satisfy the
-    // allocation.
-    for (int i = kNumberOfBuckets - 1; i >= smallest_bucket; i--) {
-      FreeListChunk* result = buckets_[i];
-      if (result != NULL) {
-        ASSERT(result->size() >= min_size);
-        FreeListChunk* next_chunk =
-            reinterpret_cast<FreeListChunk*>(result->next_chunk());
-        result->set_next_chunk(NULL);
-        buckets_[i] = next_chunk;
-        return result;
-      }
-    }
+  // Get a free chunk of at least min_size bytes, preferring the one that
+  // fits best: the smallest non-empty size class for small sizes, otherwise
+  // a chunk from the smallest fitting bucket. This way holes are reused
+  // before large free chunks are split. Returns NULL if no chunk fits.
+  FreeListChunk* GetChunk(uword min_size);
 
-    // Search the bucket containing chunks that could, but are not
-    // guaranteed to, satisfy the allocation.
-    if (smallest_bucket > kNumberOfBuckets) smallest_bucket = kNumberOfBuckets;
-    FreeListChunk* previous = reinterpret_cast<FreeListChunk*>(NULL);
-    FreeListChunk* current = buckets_[smallest_bucket - 1];
-    while (current != NULL) {
-      if (current->size() >= min_size) {
-        if (previous != NULL) {
-          previous->set_next_chunk(current->next_chunk());
-        } else {
-          buckets_[smallest_bucket - 1] =
-              reinterpret_cast<FreeListChunk*>(current->next_chunk());
-        }
-        current->set_next_chunk(NULL);
-        return current;
-      }
-      previous = current;
-      current = reinterpret_cast<FreeListChunk*>(current->next_chunk());
-    }
+  // Size of the largest free chunk. Used for fragmentation statistics.
+  uword LargestChunkSize();
 
-    return NULL;
-  }
+  // Discard the pages inside free chunks of at least min_size bytes. Returns
+  // the number of bytes discarded.
+  uword DiscardUnusedPages(uword min_size);
 
   void Clear() {
-    for (int i = 0; i < kNumberOfBuckets; i++) {
-      buckets_[i] = NULL;
-    }
+    for (int i = 0; i < kNumberOfSizeClasses; i++) small_[i] = NULL;
+    for (int i = 0; i < kNumberOfBuckets; i++) buckets_[i] = NULL;
+    small_mask_ = 0;
+    bucket_mask_ = 0;
   }
 
   void Merge(FreeList* other) {
+    for (int i = 0; i < kNumberOfSizeClasses; i++) {
+      small_[i] = Append(other->small_[i], small_[i]);
+    }
     for (int i = 0; i < kNumberOfBuckets; i++) {
-      FreeListChunk* chunk = other->buckets_[i];
-      if (chunk != NULL) {
-        FreeListChunk* last_chunk = chunk;
-        while (last_chunk->next_chunk() != NULL) {
-          last_chunk = FreeListChunk::cast(last_chunk->next_chunk());
-        }
-        last_chunk->set_next_chunk(buckets_[i]);
-        buckets_[i] = chunk;
-      }
+      buckets_[i] = Append(other->buckets_[i], buckets_[i]);
     }
+    small_mask_ |= other->small_mask_;
+    bucket_mask_ |= other->bucket_mask_;
+    other->Clear();
   }
 
  private:
-  // Buckets of power of two sized free lists chunks. Bucket i
-  // contains chunks of size larger than 2 ** (i + 1).
-  static const int kNumberOfBuckets = 12;
-#if defined(_MSC_VER)
-  // Work around Visual Studo 2013 bug 802058
+  // Chunks smaller than kSmallLimit bytes go in size class (size / word
+  // size). Larger chunks go in bucket i if their size is in [2 ** i,
+  // 2 ** (i + 1)).
+  static const int kNumberOfSizeClasses = 32;
+  static const uword kSmallLimit = kNumberOfSizeClasses * kPointerSize;
+  static const int kNumberOfBuckets = kBitsPerPointer;
+
+  // Only this many chunks of a bucket that may not fit are examined before
+  // we move on to a bucket where the first chunk is guaranteed to fit.
+  static const int kMaxBucketScan = 8;
+
+  static int LowestBit(uint64 mask) {
+    ASSERT(mask != 0);
+    return Utils::HighestBit(static_cast<int64>(mask & (~mask + 1)));
+  }
+
+  static FreeListChunk* Append(FreeListChunk* list, FreeListChunk* tail);
+
+  FreeListChunk* TakeFirst(FreeListChunk** list, uint64* mask, int index);
+  FreeListChunk* TakeFromBucket(int bucket, uword min_size, int max_scan);
+
+  FreeListChunk* small_[kNumberOfSizeClasses];
   FreeListChunk* buckets_[kNumberOfBuckets];
-#else
-  FreeListChunk* buckets_[kNumberOfBuckets] = {NULL};
-#endif
+  uint64 small_mask_;
+  uint64 bucket_mask_;
 };
 
 class FixPointersVisitor : public PointerVisitor {
@@ -208,6 +268,7 @@ class CompactingVisitor : public HeapObjectVisitor {
   CompactingVisitor(OldSpace* space, FixPointersVisitor* fix_pointers_visitor);
 
   virtual void ChunkStart(Chunk* chunk) {
+    large_object_chunk_ = chunk->is_large_object();
     GCMetadata::InitializeStartsForChunk(chunk);
     uint32* last_bits = GCMetadata::MarkBitsFor(chunk->usable_end());
     // When compacting the heap, we skip dead objects.  In order to do this
@@ -227,6 +288,7 @@ class CompactingVisitor : public HeapObjectVisitor {
   uword used_;
   GCMetadata::Destination dest_;
   FixPointersVisitor* fix_pointers_visitor_;
+  bool large_object_chunk_ = false;
 };
 
 class SweepingVisitor : public HeapObjectVisitor {
@@ -234,12 +296,18 @@ class SweepingVisitor : public HeapObjectVisitor {
   explicit SweepingVisitor(OldSpace* space);
 
   virtual void ChunkStart(Chunk* chunk) {
+    large_object_chunk_ = chunk->is_large_object();
     GCMetadata::InitializeStartsForChunk(chunk);
   }
 
   virtual uword Visit(HeapObject* object);
 
   virtual void ChunkEnd(Chunk* chunk, uword end) {
+    if (free_start_ == chunk->start()) {
+      chunk->set_idle_gcs(chunk->idle_gcs() + 1);
+    } else {
+      chunk->set_idle_gcs(0);
+    }
     AddFreeListChunk(end);
     GCMetadata::ClearMarkBitsFor(chunk);
   }
@@ -252,6 +320,7 @@ class SweepingVisitor : public HeapObjectVisitor {
   FreeList* free_list_;
   uword free_start_;
   int used_;
+  bool large_object_chunk_ = false;
 };
 
 }  // namespace dartino
@@ -11,6 +11,13 @@ namespace dartino {
 extern "C"
 uword Interpret_DispatchTable[];
 
+#if defined(DARTINO_TARGET_X64)
+// The x64 interpreter has a second table for when the top of the stack is
+// cached in a register. Its debug entries are laid out like the regular ones.
+extern "C"
+uword Interpret_CachedDispatchTable[];
+#endif
+
 extern "C"
 void BC_InvokeStatic();
 
@@ -20,21 +27,31 @@ void Debug_BC_InvokeStatic();
 const uword kDebugDiff = reinterpret_cast<uword>(BC_InvokeStatic) -
     reinterpret_cast<uword>(Debug_BC_InvokeStatic);
 
+static void SetBreak(uword* table, Opcode opcode) {
+  uword value = table[opcode];
+  if ((value & 4) == 0) table[opcode] = value - kDebugDiff;
+}
+
+static void ClearBreak(uword* table, Opcode opcode) {
+  uword value = table[opcode];
+  if ((value & 4) != 0) table[opcode] = value + kDebugDiff;
+}
+
 void SetBytecodeBreak(Opcode opcode) {
   ASSERT((reinterpret_cast<uword>(Debug_BC_InvokeStatic) & 0x4) == 4);
   ASSERT((reinterpret_cast<uword>(BC_InvokeStatic) & 0x4) == 0);
 
-  uword value = Interpret_DispatchTable[opcode];
-  if ((value & 4) == 0) {
-    Interpret_DispatchTable[opcode] = value - kDebugDiff;
-  }
+  SetBreak(Interpret_DispatchTable, opcode);
+#if defined(DARTINO_TARGET_X64)
+  SetBreak(Interpret_CachedDispatchTable, opcode);
+#endif
 }
 
 void ClearBytecodeBreak(Opcode opcode) {
-  uword value = Interpret_DispatchTable[opcode];
-  if ((value & 4) != 0) {
-    Interpret_DispatchTable[opcode] = value + kDebugDiff;
-  }
+  ClearBreak(Interpret_DispatchTable, opcode);
+#if defined(DARTINO_TARGET_X64)
+  ClearBreak(Interpret_CachedDispatchTable, opcode);
+#endif
 }
 
 }  // namespace dartino
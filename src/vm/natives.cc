@@ -983,7 +983,7 @@ static Process* SpawnProcessInternal(Program* program, Process* process,
   Function* entry = FunctionForClosure(entrypoint, 2);
   ASSERT(entry != NULL);
 
-  Process* child = program->SpawnProcess(process);
+  Process* child = program->SpawnProcess(process, Flags::private_heaps);
   if (child == NULL) return NULL;
 
   Stack* stack = child->stack();
@@ -1045,6 +1045,14 @@ BEGIN_LEAF_NATIVE(ProcessSpawn) {
     return Failure::index_out_of_bounds();
   }
 
+  // The child refers to the closure and the argument from its stack.
+  if (Flags::private_heaps || process->has_private_heap()) {
+    if (!process->EnsureShareable(closure) ||
+        !process->EnsureShareable(argument)) {
+      return Failure::retry_after_gc(0);
+    }
+  }
+
   Object* dart_process = process->NewInstance(program->process_class(), true);
   if (dart_process->IsRetryAfterGCFailure()) return dart_process;
 
@@ -1139,6 +1147,16 @@ BEGIN_LEAF_NATIVE(CoroutineNewStack) {
 }
 END_NATIVE()
 
+BEGIN_LEAF_NATIVE(CoroutineReleaseStack) {
+  // The coroutine is done, so nothing refers to its stack any more.
+  Coroutine* coroutine = Coroutine::cast(arguments[0]);
+  if (!coroutine->has_stack()) return process->program()->null_object();
+  process->ReleaseStack(coroutine->stack());
+  coroutine->set_stack(process->program()->null_object());
+  return process->program()->null_object();
+}
+END_NATIVE()
+
 BEGIN_LEAF_NATIVE(StopwatchFrequency) { return Smi::FromWord(1000000); }
 END_NATIVE()
 
@@ -1183,6 +1201,15 @@ BEGIN_LEAF_NATIVE(StringLength) {
 }
 END_NATIVE()
 
+BEGIN_LEAF_NATIVE(StringHashCode) {
+  Object* x = arguments[0];
+  if (x->IsOneByteString()) {
+    return Smi::FromWord(OneByteString::cast(x)->Hash());
+  }
+  return Smi::FromWord(TwoByteString::cast(x)->Hash());
+}
+END_NATIVE()
+
 BEGIN_LEAF_NATIVE(OneByteStringAdd) {
   OneByteString* x = OneByteString::cast(arguments[0]);
   Object* other = arguments[1];
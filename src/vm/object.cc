@@ -10,6 +10,7 @@
 #include "src/shared/bytecodes.h"
 #include "src/shared/flags.h"
 
+#include "src/vm/catch_table.h"
 #include "src/vm/frame.h"
 #include "src/vm/intrinsics.h"
 #include "src/vm/natives.h"
@@ -138,6 +139,9 @@ void Function::Initialize(List<uint8> bytecodes) {
   set_bytecode_size(bytecodes.length());
   uint8* bytecodes_address = bytecode_address_for(0);
   memcpy(bytecodes_address, bytecodes.data(), bytecodes.length());
+  int table_offset;
+  FromBytecodePointer(bytecodes_address, &table_offset);
+  if (table_offset != -1) CatchTable::Sort(bytecode_address_for(table_offset));
 }
 
 Function* Function::FromBytecodePointer(uint8* bcp, int* frame_ranges_offset) {
@@ -161,28 +165,45 @@ Function* Function::FromBytecodePointer(uint8* bcp, int* frame_ranges_offset) {
 void* Function::ComputeIntrinsic(IntrinsicsTable* table) {
   int length = bytecode_size();
   uint8* bytecodes = bytecode_address_for(0);
+  // Folded programs may start with a superinstruction.
+  Opcode first = Bytecode::Unfuse(static_cast<Opcode>(bytecodes[0]));
   void* result = NULL;
-  if (length >= 4 && bytecodes[0] == kLoadLocal3 &&
+  if (length >= 4 && first == kLoadLocal3 &&
       bytecodes[1] == kLoadField && bytecodes[3] == kReturn) {
     result = reinterpret_cast<void*>(table->GetField());
-  } else if (length >= 4 && bytecodes[0] == kLoadLocal4 &&
+  } else if (length >= 4 && first == kLoadLocal4 &&
              bytecodes[1] == kLoadLocal4 &&
              bytecodes[2] == kIdenticalNonNumeric && bytecodes[3] == kReturn) {
     // TODO(ajohnsen): Investigate what pattern we generate for this now.
     UNIMPLEMENTED();
-  } else if (length >= 5 && bytecodes[0] == kLoadLocal4 &&
+  } else if (length >= 5 && first == kLoadLocal4 &&
              bytecodes[1] == kLoadLocal4 && bytecodes[2] == kStoreField &&
              bytecodes[4] == kReturn) {
     result = reinterpret_cast<void*>(table->SetField());
-  } else if (length >= 3 && bytecodes[0] == kInvokeNative &&
+  } else if (length >= 3 && first == kInvokeNative &&
              bytecodes[2] == kListIndexGet) {
     result = reinterpret_cast<void*>(table->ListIndexGet());
-  } else if (length >= 3 && bytecodes[0] == kInvokeNative &&
+  } else if (length >= 3 && first == kInvokeNative &&
              bytecodes[2] == kListIndexSet) {
     result = reinterpret_cast<void*>(table->ListIndexSet());
-  } else if (length >= 3 && bytecodes[0] == kInvokeNative &&
+  } else if (length >= 3 && first == kInvokeNative &&
              bytecodes[2] == kListLength) {
     result = reinterpret_cast<void*>(table->ListLength());
+  } else if (length >= 3 && first == kInvokeNative &&
+             bytecodes[2] == kStringLength) {
+    result = reinterpret_cast<void*>(table->StringLength());
+  } else if (length >= 3 && first == kInvokeNative &&
+             bytecodes[2] == kStringHashCode) {
+    result = reinterpret_cast<void*>(table->StringHashCode());
+  } else if (length >= 3 && first == kInvokeNative &&
+             bytecodes[2] == kOneByteStringCodeUnitAt) {
+    result = reinterpret_cast<void*>(table->OneByteStringCodeUnitAt());
+  } else if (length >= 3 && first == kInvokeNative &&
+             bytecodes[2] == kOneByteStringEqual) {
+    result = reinterpret_cast<void*>(table->OneByteStringEqual());
+  } else if (length >= 3 && first == kInvokeNative &&
+             bytecodes[2] == kTwoByteStringCodeUnitAt) {
+    result = reinterpret_cast<void*>(table->TwoByteStringCodeUnitAt());
   }
   return result;
 }
@@ -275,7 +296,7 @@ char* TwoByteString::ToCString() {
   return result;
 }
 
-Instance* Instance::CloneTransformed(Heap* heap) {
+Instance* Instance::CloneTransformed(Heap* heap, bool in_old_space) {
   ASSERT(!HasForwardingAddress());
   Class* old_class = get_class();
   Class* new_class = old_class->TransformationTarget();
@@ -284,7 +305,14 @@ Instance* Instance::CloneTransformed(Heap* heap) {
   // NOTE: We do not pass 'immmutable = get_immutable()' here, since the
   // immutability bit and the identity hascode will get copied via the flags
   // word.
-  Object* clone = heap->CreateInstance(new_class, Smi::FromWord(0), false);
+  Object* clone;
+  if (in_old_space) {
+    ASSERT(heap->IsTwoSpaceHeap());
+    clone = reinterpret_cast<TwoSpaceHeap*>(heap)->CreateOldSpaceInstance(
+        new_class, Smi::FromWord(0));
+  } else {
+    clone = heap->CreateInstance(new_class, Smi::FromWord(0), false);
+  }
   if (clone->IsRetryAfterGCFailure()) {
     // We can only get an allocation failure on the new-space in a two-space
     // heap, since there is a NoAllocationFailureScope on the program heap
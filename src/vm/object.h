@@ -682,8 +682,9 @@ class Instance : public HeapObject {
     return (size - kSize) / kPointerSize;
   }
 
-  // Schema change support.
-  Instance* CloneTransformed(Heap* heap);
+  // Schema change support. The clone is allocated in the old-space of
+  // [heap] if [in_old_space] is set.
+  Instance* CloneTransformed(Heap* heap, bool in_old_space);
 
   // Snapshotting.
   void IterateEverything(PointerVisitor* visitor);
@@ -34,11 +34,11 @@ Chunk::~Chunk() {
   // and let the embedder deallocate it.
   if (is_external()) return;
   GCMetadata::MarkPagesForChunk(this, kUnknownSpacePage);
-  Platform::FreePages(reinterpret_cast<void*>(start_), size());
+  ObjectMemory::ReleaseMemory(start_, size());
 }
 
 Space::~Space() {
-  WeakPointer::ForceCallbacks(&weak_pointers_);
+  weak_pointers_.ForceCallbacks();
   FreeAllChunks();
 }
 
@@ -205,16 +205,58 @@ void Space::CompleteTransformations(PointerVisitor* visitor) {
 }
 
 Atomic<uword> ObjectMemory::allocated_;
+Mutex* ObjectMemory::pool_mutex_ = NULL;
+ObjectMemory::PooledMemory* ObjectMemory::pool_ = NULL;
+uword ObjectMemory::pooled_ = 0;
 
 void ObjectMemory::Setup() {
   allocated_ = 0;
+  pool_mutex_ = Platform::CreateMutex();
   GCMetadata::Setup();
+  MarkingStack::Setup();
 }
 
 void ObjectMemory::TearDown() {
+  MarkingStack::TearDown();
+  while (pool_ != NULL) {
+    PooledMemory* memory = pool_;
+    pool_ = memory->next;
+    Platform::FreePages(memory, memory->size);
+  }
+  pooled_ = 0;
+  delete pool_mutex_;
+  pool_mutex_ = NULL;
   GCMetadata::TearDown();
 }
 
+void* ObjectMemory::TakePooledMemory(uword size) {
+  ScopedLock lock(pool_mutex_);
+  for (PooledMemory** link = &pool_; *link != NULL; link = &(*link)->next) {
+    PooledMemory* memory = *link;
+    if (memory->size == size) {
+      *link = memory->next;
+      pooled_ -= size;
+      return memory;
+    }
+  }
+  return NULL;
+}
+
+void ObjectMemory::ReleaseMemory(uword start, uword size) {
+  {
+    ScopedLock lock(pool_mutex_);
+    if (pooled_ + size <= kMaxPooledBytes) {
+      PooledMemory* memory = reinterpret_cast<PooledMemory*>(start);
+      memory->next = pool_;
+      memory->size = size;
+      pool_ = memory;
+      pooled_ += size;
+      return;
+    }
+  }
+  Platform::FreePages(reinterpret_cast<void*>(start), size);
+}
+
 #ifdef DEBUG
 void Chunk::Scramble() {
   void* p = reinterpret_cast<void*>(start_);
@@ -240,8 +282,10 @@ Chunk* ObjectMemory::AllocateChunk(Space* owner, uword size) {
   ASSERT(owner != NULL);
 
   size = Utils::RoundUp(size, Platform::kPageSize);
-  void* memory =
-      Platform::AllocatePages(size, GCMetadata::heap_allocation_arena());
+  void* memory = TakePooledMemory(size);
+  if (memory == NULL) {
+    memory = Platform::AllocatePages(size, GCMetadata::heap_allocation_arena());
+  }
   uword lowest = GCMetadata::lowest_old_space_address();
   USE(lowest);
   if (memory == NULL) return NULL;
@@ -299,7 +343,12 @@ void OldSpace::RebuildAfterTransformations() {
         }
       } else {
         if (free_start != 0) {
-          free_list_->AddChunk(free_start, current - free_start);
+          // Large-object chunks never hold more than their one object.
+          if (chunk->is_large_object()) {
+            FreeList::MakeFiller(free_start, current - free_start);
+          } else {
+            free_list_->AddChunk(free_start, current - free_start);
+          }
           free_start = 0;
         }
         current += object->Size();
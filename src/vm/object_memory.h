@@ -5,6 +5,7 @@
 #ifndef SRC_VM_OBJECT_MEMORY_H_
 #define SRC_VM_OBJECT_MEMORY_H_
 
+#include "src/shared/flags.h"
 #include "src/shared/globals.h"
 #include "src/shared/platform.h"
 #include "src/shared/utils.h"
@@ -68,12 +69,20 @@ class Chunk : public ChunkList::Entry {
 
   void set_compaction_top(uword top) { compaction_top_ = top; }
 
+  // The number of successive old-space GCs that found this chunk empty.
+  int idle_gcs() const { return idle_gcs_; }
+  void set_idle_gcs(int value) { idle_gcs_ = value; }
+
   // Returns the size of this chunk in bytes.
   uword size() const { return end_ - start_; }
 
   // Is the chunk externally allocated by the embedder.
   bool is_external() const { return external_; }
 
+  // Is the chunk a large-object chunk. These hold a single object that is
+  // never moved, and the whole chunk is freed when the object dies.
+  bool is_large_object() const { return large_object_; }
+
   // Test for inclusion.
   bool Includes(uword address) {
     return (address >= start_) && (address < end_);
@@ -101,13 +110,17 @@ class Chunk : public ChunkList::Entry {
   const bool external_;
   uword scavenge_pointer_;
   uword compaction_top_;
+  bool large_object_ = false;
+  int idle_gcs_ = 0;
 
   Chunk(Space* owner, uword start, uword size, bool external = false);
   ~Chunk();
 
   void set_owner(Space* value) { owner_ = value; }
+  void set_large_object() { large_object_ = true; }
 
   friend class ObjectMemory;
+  friend class OldSpace;
   friend class SemiSpace;
   friend class Space;
 };
@@ -193,10 +206,11 @@ class Space {
   static uword DefaultChunkSize(uword heap_size) {
     // We return a value between kDefaultMinimumChunkSize and
     // kDefaultMaximumChunkSize - and try to keep the chunks smaller than 20% of
-    // the heap.
+    // the heap. With huge pages, big heaps grow a whole huge page at a time.
+    uword maximum = Flags::huge_pages ? Platform::kHugePageSize
+                                      : kDefaultMaximumChunkSize;
     return Utils::Minimum(
-        Utils::Maximum(kDefaultMinimumChunkSize, heap_size / 5),
-        kDefaultMaximumChunkSize);
+        Utils::Maximum(kDefaultMinimumChunkSize, heap_size / 5), maximum);
   }
 
   // Obtain the offset of [object] from the start of the chunk. We assume
@@ -228,10 +242,15 @@ class Space {
     return chunk_list_.First();
   }
 
-  WeakPointerList* weak_pointers() { return &weak_pointers_; }
+  WeakPointerTable* weak_pointers() { return &weak_pointers_; }
 
   PageType page_type() { return page_type_; }
 
+  // If you change these, remember to update the static_asserts in
+  // object_memory_copying.cc.
+  static const uword kTopOffset = kWordSize;
+  static const uword kLimitOffset = kTopOffset + kWordSize;
+
  protected:
   explicit Space(Resizing resizeable, PageType page_type);
 
@@ -257,10 +276,12 @@ class Space {
     --no_allocation_failure_nesting_;
   }
 
-  ChunkList chunk_list_;
-  uword used_;              // Allocated bytes.
+  // Put these first so the interpreters can bump-allocate without issues
+  // around object layout.
   uword top_;               // Allocation top in current chunk.
   uword limit_;             // Allocation limit in current chunk.
+  ChunkList chunk_list_;
+  uword used_;              // Allocated bytes.
   // The allocation budget can be used to trigger a GC early, eg. in response
   // to large amounts of external allocation. If the allocation budget is not
   // hit, we may still trigger a GC because we are getting close to the limit
@@ -269,8 +290,8 @@ class Space {
   int no_allocation_failure_nesting_;
   bool resizeable_;
 
-  // Linked list of weak pointers to heap objects in this space.
-  WeakPointerList weak_pointers_;
+  // Weak pointers to heap objects in this space.
+  WeakPointerTable weak_pointers_;
   PageType page_type_;
 };
 
@@ -315,6 +336,17 @@ class SemiSpace : public Space {
 
   void SetReadOnly() { top_ = limit_ = 0; }
 
+  // Lowers the allocation limit of the current chunk so that at most [size]
+  // bytes (counted from the start of the chunk) can be allocated before the
+  // next GC.  There is always room left for an allocation of half that size
+  // above the objects already in the space.
+  void LimitAllocationTo(uword size);
+
+  // Replaces the chunk of an empty semispace with a new chunk of [size]
+  // bytes.  Returns false and leaves the space unchanged if the new chunk
+  // could not be allocated.
+  bool ReplaceChunk(uword size);
+
   void ProcessWeakPointers(SemiSpace* to_space, OldSpace* old_space);
 
  private:
@@ -349,9 +381,17 @@ class OldSpace : public Space {
   // there is no room to allocate the object.
   uword Allocate(uword size);
 
+  // Allocate a raw object in a chunk of its own that is never compacted.
+  // Returns 0 if a garbage collection is needed or the heap limit is hit.
+  uword AllocateLargeObject(uword size);
+
+  // Free the large-object chunks whose object was not marked live.
+  void FreeDeadLargeObjects();
+
   FreeList* free_list() { return free_list_; }
 
   void ClearFreeList();
+  // Also releases chunks that have been empty for a number of GCs.
   void MarkChunkEndsFree();
   void ZapObjectStarts();
 
@@ -373,6 +413,14 @@ class OldSpace : public Space {
 
   void ComputeCompactionDestinations();
 
+  // Lets the OS reclaim the pages inside large free-list chunks. Called after
+  // the free list has been rebuilt by a GC.
+  void DiscardFreeMemory();
+
+  // Bytes of free memory given back to the OS by the last GC. They are still
+  // committed, but not resident until they are allocated again.
+  uword discarded() const { return discarded_; }
+
 #ifdef DEBUG
   void Verify();
 #endif
@@ -389,6 +437,16 @@ class OldSpace : public Space {
   void ReportNewSpaceProgress(uword bytes_collected);
 
  private:
+  // Minimum length of a free list run used for promotion.
+  static const uword kMinimumPromotionRun = 4096 * kPointerSize;
+
+  // Free list runs at least this long have their pages discarded after GC.
+  static const uword kMinimumDiscardedRun = 64 * KB;
+
+  // A chunk that is still empty after this many GCs is returned to the OS.
+  // Waiting a little avoids giving memory back just before it is needed.
+  static const int kIdleGCsBeforeRelease = 2;
+
   uword AllocateFromFreeList(uword size);
   uword AllocateInNewChunk(uword size);
   Chunk* AllocateAndUseChunk(uword size);
@@ -405,6 +463,7 @@ class OldSpace : public Space {
   int successive_pointless_gcs_ = 0;
   uword used_after_last_gc_ = 0;
   bool hard_limit_hit_ = false;
+  uword discarded_ = 0;
 };
 
 class NoAllocationFailureScope {
@@ -456,12 +515,33 @@ class ObjectMemory {
 
   static uword Allocated() { return allocated_; }
 
+  // Memory of freed chunks kept for reuse.
+  static uword Pooled() { return pooled_; }
+
  private:
+  // Freed chunk memory is kept, up to this many bytes, and handed out again
+  // without going to the OS. This helps spaces that shrink and grow again
+  // and heaps that come and go with their processes.
+  static const uword kMaxPooledBytes = 4 * MB;
+
+  // Header written into the memory of a pooled chunk.
+  struct PooledMemory {
+    PooledMemory* next;
+    uword size;
+  };
+
   // Use some already-existing memory for a chunk.
   static Chunk* CreateFixedChunk(Space* space, void* heap_space, uword size);
 
+  static void* TakePooledMemory(uword size);
+  static void ReleaseMemory(uword start, uword size);
+
   static Atomic<uword> allocated_;
+  static Mutex* pool_mutex_;
+  static PooledMemory* pool_;
+  static uword pooled_;
 
+  friend class Chunk;
   friend class SemiSpace;
   friend class Space;
 };
@@ -4,6 +4,8 @@
 
 #include "src/vm/object_memory.h"
 
+#include <stddef.h>
+
 #include "src/vm/heap.h"
 #include "src/vm/object.h"
 
@@ -15,13 +17,16 @@ static void WriteSentinelAt(uword address) {
 }
 
 Space::Space(Space::Resizing resizeable, PageType page_type)
-    : used_(0),
-      top_(0),
+    : top_(0),
       limit_(0),
+      used_(0),
       allocation_budget_(0),
       no_allocation_failure_nesting_(0),
       resizeable_(resizeable == kCanResize),
-      page_type_(page_type) {}
+      page_type_(page_type) {
+  static_assert(kTopOffset == offsetof(Space, top_), "top_");
+  static_assert(kLimitOffset == offsetof(Space, limit_), "limit_");
+}
 
 SemiSpace::SemiSpace(Space::Resizing resizeable, PageType page_type,
                      uword maximum_initial_size)
@@ -57,7 +62,9 @@ void SemiSpace::UpdateBaseAndLimit(Chunk* chunk, uword top) {
 }
 
 void SemiSpace::Flush() {
-  if (!is_empty()) {
+  // The sentinel of a read-only space was written before it was made
+  // read-only.
+  if (!is_empty() && limit_ != 0) {
     // Set sentinel at allocation end.
     ASSERT(top_ < limit_);
     WriteSentinelAt(top_);
@@ -102,6 +109,27 @@ void SemiSpace::Append(Chunk* chunk) {
   chunk_list_.Append(chunk);
 }
 
+void SemiSpace::LimitAllocationTo(uword size) {
+  Chunk* current = chunk();
+  uword limit = Utils::Maximum(current->start() + size, top_ + (size >> 1));
+  limit_ = Utils::Minimum(limit, current->end());
+}
+
+bool SemiSpace::ReplaceChunk(uword size) {
+  ASSERT(!resizeable_);
+  ASSERT(weak_pointers_.IsEmpty());
+  Chunk* old_chunk = chunk();
+  Chunk* new_chunk = ObjectMemory::AllocateChunk(this, size);
+  if (new_chunk == NULL) return false;
+  chunk_list_.Remove(old_chunk);
+  ObjectMemory::FreeChunk(old_chunk);
+  chunk_list_.Append(new_chunk);
+  used_ = 0;
+  top_ = limit_ = 0;
+  UpdateBaseAndLimit(new_chunk, new_chunk->start());
+  return true;
+}
+
 uword SemiSpace::TryAllocate(uword size) {
   // Make sure there is room for chunk end sentinel by using > instead of >=.
   // Use this ordering of the comparison to avoid very large allocations
@@ -190,8 +218,7 @@ bool SemiSpace::CompleteScavengeGenerational(
 
 void SemiSpace::ProcessWeakPointers(SemiSpace* to_space, OldSpace* old_space) {
   ASSERT(this != to_space);  // This should be from-space.
-  WeakPointer::ProcessAndMoveSurvivors(&weak_pointers_, this, to_space,
-                                       old_space);
+  weak_pointers_.ProcessAndMoveSurvivors(this, to_space, old_space);
 }
 
 }  // namespace dartino
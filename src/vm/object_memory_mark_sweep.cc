@@ -11,6 +11,12 @@
 //   We skip PromotedTrack areas because we know we will get to them later and
 //   they contain uninitialized memory.
 
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #include "src/shared/flags.h"
 #include "src/shared/utils.h"
 #include "src/vm/mark_sweep.h"
@@ -164,8 +170,17 @@ uword OldSpace::AllocateFromFreeList(uword size) {
   // Flush the rest of the active chunk into the free list.
   Flush();
 
-  FreeListChunk* chunk = free_list_->GetChunk(
-      tracking_allocations_ ? size + PromotedTrack::kHeaderSize : size);
+  FreeListChunk* chunk;
+  if (tracking_allocations_) {
+    // When promoting, bump allocate in a run long enough to amortize the
+    // promoted track header over many objects, but use the smallest such
+    // run so large free chunks are kept intact.
+    uword needed = size + PromotedTrack::kHeaderSize;
+    chunk = free_list_->GetChunk(Utils::Maximum(needed, kMinimumPromotionRun));
+    if (chunk == NULL) chunk = free_list_->GetChunk(needed);
+  } else {
+    chunk = free_list_->GetChunk(size);
+  }
   if (chunk != NULL) {
     top_ = chunk->address();
     limit_ = top_ + chunk->size();
@@ -211,6 +226,40 @@ uword OldSpace::Allocate(uword size) {
   return result;
 }
 
+uword OldSpace::AllocateLargeObject(uword size) {
+  ASSERT(Utils::IsAligned(size, kPointerSize));
+  if (!in_no_allocation_failure_scope() && needs_garbage_collection()) {
+    return 0;
+  }
+
+  uword chunk_size = Utils::RoundUp(size + kSentinelSize, Platform::kPageSize);
+  Chunk* chunk = NULL;
+  if (chunk_size <= heap_->MaxExpansion()) {
+    chunk = ObjectMemory::AllocateChunk(this, chunk_size);
+  }
+  if (chunk == NULL) {
+    hard_limit_hit_ = true;
+    allocation_budget_ = -1;  // Trigger GC.
+    return 0;
+  }
+  chunk->set_large_object();
+  Append(chunk);
+  GCMetadata::InitializeStartsForChunk(chunk);
+  GCMetadata::InitializeRememberedSetForChunk(chunk);
+  GCMetadata::ClearMarkBitsFor(chunk);
+
+  // The rest of the chunk is never allocated in.
+  uword result = chunk->start();
+  uword end = chunk->usable_end();
+  *reinterpret_cast<Object**>(end) = chunk_end_sentinel();
+  FreeList::MakeFiller(result + size, end - (result + size));
+
+  GCMetadata::RecordStart(result);
+  used_ += size;
+  allocation_budget_ -= size;
+  return result;
+}
+
 uword OldSpace::Used() { return used_; }
 
 void OldSpace::StartTrackingAllocations() {
@@ -228,16 +277,41 @@ void OldSpace::EndTrackingAllocations() {
 
 void OldSpace::ComputeCompactionDestinations() {
   if (is_empty()) return;
-  auto it = chunk_list_.Begin();
-  GCMetadata::Destination dest(it, it->start(), it->usable_end());
-  for (auto chunk : chunk_list_) {
-    dest = GCMetadata::CalculateObjectDestinations(chunk, dest);
+  auto it = GCMetadata::Destination::SkipLargeObjectChunks(chunk_list_.Begin(),
+                                                           chunk_list_.End());
+  if (it != chunk_list_.End()) {
+    GCMetadata::Destination dest(it, it->start(), it->usable_end());
+    for (auto chunk : chunk_list_) {
+      if (chunk->is_large_object()) continue;
+      dest = GCMetadata::CalculateObjectDestinations(chunk, dest);
+    }
+    dest.chunk()->set_compaction_top(dest.address);
+    while (dest.HasNextChunk()) {
+      dest = dest.NextChunk();
+      Chunk* unused = dest.chunk();
+      unused->set_compaction_top(unused->start());
+    }
+  }
+  // The object in a large-object chunk is at the start of the chunk, so
+  // using the chunk itself as destination leaves it where it is.
+  for (it = chunk_list_.Begin(); it != chunk_list_.End(); ++it) {
+    if (!it->is_large_object()) continue;
+    GCMetadata::Destination dest(it, it->start(), it->usable_end());
+    dest = GCMetadata::CalculateObjectDestinations(*it, dest);
+    it->set_compaction_top(dest.address);
   }
-  dest.chunk()->set_compaction_top(dest.address);
-  while (dest.HasNextChunk()) {
-    dest = dest.NextChunk();
-    Chunk* unused = dest.chunk();
-    unused->set_compaction_top(unused->start());
+}
+
+void OldSpace::FreeDeadLargeObjects() {
+  for (auto it = chunk_list_.Begin(); it != chunk_list_.End();) {
+    Chunk* chunk = *it;
+    if (chunk->is_large_object() &&
+        !GCMetadata::IsMarked(HeapObject::FromAddress(chunk->start()))) {
+      it = chunk_list_.Erase(it);
+      ObjectMemory::FreeChunk(chunk);
+    } else {
+      ++it;
+    }
   }
 }
 
@@ -247,83 +321,121 @@ void OldSpace::ZapObjectStarts() {
   }
 }
 
+// Returns the first card in [from, to) that may have new-space pointers, or
+// [to] if all of them are clean. Most cards are clean, so they are skipped 32
+// at a time with SSE2 and a word at a time elsewhere.
+static inline uint8* FindDirtyCard(uint8* from, uint8* to) {
+  ASSERT(GCMetadata::kNoNewSpacePointers == 0);
+#if defined(__SSE2__) || defined(_M_X64)
+  const uword kVectorSize = sizeof(__m128i);
+  while (from < to && !Utils::IsAligned(reinterpret_cast<uword>(from),
+                                        kVectorSize)) {
+    if (*from != 0) return from;
+    from++;
+  }
+  const __m128i zero = _mm_setzero_si128();
+  while (static_cast<uword>(to - from) >= 2 * kVectorSize) {
+    __m128i low = _mm_load_si128(reinterpret_cast<__m128i*>(from));
+    __m128i high =
+        _mm_load_si128(reinterpret_cast<__m128i*>(from + kVectorSize));
+    __m128i clean = _mm_cmpeq_epi8(_mm_or_si128(low, high), zero);
+    if (_mm_movemask_epi8(clean) != 0xffff) break;
+    from += 2 * kVectorSize;
+  }
+#else
+  while (from < to && !Utils::IsAligned(reinterpret_cast<uword>(from),
+                                        sizeof(uword))) {
+    if (*from != 0) return from;
+    from++;
+  }
+  while (static_cast<uword>(to - from) >= sizeof(uword) &&
+         *reinterpret_cast<uword*>(from) == 0) {
+    from += sizeof(uword);
+  }
+#endif
+  // At most one block is left to look at byte by byte.
+  for (; from < to; from++) {
+    if (*from != 0) return from;
+  }
+  return to;
+}
+
 void OldSpace::VisitRememberedSet(GenerationalScavengeVisitor* visitor) {
   Flush();
   for (auto chunk : chunk_list_) {
+    if (chunk->is_large_object()) {
+      // The write barrier only dirties the card of the object header, so for
+      // a large-object chunk there is just one card to look at.
+      uint8* byte = GCMetadata::RememberedSetFor(chunk->start());
+      if (*byte != GCMetadata::kNoNewSpacePointers) {
+        *byte = GCMetadata::kNoNewSpacePointers;
+        visitor->set_record_new_space_pointers(byte);
+        HeapObject::FromAddress(chunk->start())->IteratePointers(visitor);
+      }
+      continue;
+    }
     // Scan the byte-map for cards that may have new-space pointers.
     uword current = chunk->start();
-    uword bytes =
-        reinterpret_cast<uword>(GCMetadata::RememberedSetFor(current));
+    uint8* bytes = GCMetadata::RememberedSetFor(current);
+    uint8* bytes_limit = GCMetadata::RememberedSetFor(chunk->end());
     uword earliest_iteration_start = current;
-    while (current < chunk->end()) {
-      if (Utils::IsAligned(bytes, sizeof(uword))) {
-        uword* words = reinterpret_cast<uword*>(bytes);
-        // Skip blank cards n at a time.
-        ASSERT(GCMetadata::kNoNewSpacePointers == 0);
-        if (*words == 0) {
-          do {
-            bytes += sizeof *words;
-            words++;
-            current += sizeof(*words) * GCMetadata::kCardSize;
-          } while (current < chunk->end() && *words == 0);
-          continue;
+    while (true) {
+      uint8* byte = FindDirtyCard(bytes, bytes_limit);
+      if (byte == bytes_limit) break;
+      current += (byte - bytes) * GCMetadata::kCardSize;
+      bytes = byte;
+      uint8* starts = GCMetadata::StartsFor(current);
+      // Since there is a dirty object starting in this card, we would like
+      // to assert that there is an object starting in this card.
+      // Unfortunately, the sweeper does not clean the dirty object bytes,
+      // and we don't want to slow down the sweeper, so we cannot make this
+      // assertion in the case where a dirty object died and was made into
+      // free-list.
+      uword iteration_start = current;
+      if (starts != GCMetadata::StartsFor(chunk->start())) {
+        // If we are not at the start of the chunk, step back into previous
+        // card to find a place to start iterating from that is guaranteed to
+        // be before the start of the card.  We have to do this because the
+        // starts-table can contain the start offset of any object in the
+        // card, including objects that have higher addresses than the one(s)
+        // with new-space pointers in them.
+        do {
+          starts--;
+          iteration_start -= GCMetadata::kCardSize;
+          // Step back across object-start entries that have not been filled
+          // in (because of large objects).
+        } while (iteration_start > earliest_iteration_start &&
+                 *starts == GCMetadata::kNoObjectStart);
+
+        if (iteration_start > earliest_iteration_start) {
+          uint8 iteration_low_byte = static_cast<uint8>(iteration_start);
+          iteration_start -= iteration_low_byte;
+          iteration_start += *starts;
+        } else {
+          // Do not step back to before the end of an object that we already
+          // scanned. This is both for efficiency, and also to avoid backing
+          // into a PromotedTrack object, which contains newly allocated
+          // objects inside it, which are not yet traversable.
+          iteration_start = earliest_iteration_start;
         }
       }
-      uint8* byte = reinterpret_cast<uint8*>(bytes);
-      if (*byte != GCMetadata::kNoNewSpacePointers) {
-        uint8* starts = GCMetadata::StartsFor(current);
-        // Since there is a dirty object starting in this card, we would like
-        // to assert that there is an object starting in this card.
-        // Unfortunately, the sweeper does not clean the dirty object bytes,
-        // and we don't want to slow down the sweeper, so we cannot make this
-        // assertion in the case where a dirty object died and was made into
-        // free-list.
-        uword iteration_start = current;
-        if (starts != GCMetadata::StartsFor(chunk->start())) {
-          // If we are not at the start of the chunk, step back into previous
-          // card to find a place to start iterating from that is guaranteed to
-          // be before the start of the card.  We have to do this because the
-          // starts-table can contain the start offset of any object in the
-          // card, including objects that have higher addresses than the one(s)
-          // with new-space pointers in them.
-          do {
-            starts--;
-            iteration_start -= GCMetadata::kCardSize;
-            // Step back across object-start entries that have not been filled
-            // in (because of large objects).
-          } while (iteration_start > earliest_iteration_start &&
-                   *starts == GCMetadata::kNoObjectStart);
-
-          if (iteration_start > earliest_iteration_start) {
-            uint8 iteration_low_byte = static_cast<uint8>(iteration_start);
-            iteration_start -= iteration_low_byte;
-            iteration_start += *starts;
-          } else {
-            // Do not step back to before the end of an object that we already
-            // scanned. This is both for efficiency, and also to avoid backing
-            // into a PromotedTrack object, which contains newly allocated
-            // objects inside it, which are not yet traversable.
-            iteration_start = earliest_iteration_start;
-          }
-        }
-        // Skip objects that start in the previous card.
-        while (iteration_start < current) {
-          if (HasSentinelAt(iteration_start)) break;
-          HeapObject* object = HeapObject::FromAddress(iteration_start);
-          iteration_start += object->Size();
-        }
-        // Reset in case there are no new-space pointers any more.
-        *byte = GCMetadata::kNoNewSpacePointers;
-        visitor->set_record_new_space_pointers(byte);
-        // Iterate objects that start in the relevant card.
-        while (iteration_start < current + GCMetadata::kCardSize) {
-          if (HasSentinelAt(iteration_start)) break;
-          HeapObject* object = HeapObject::FromAddress(iteration_start);
-          object->IteratePointers(visitor);
-          iteration_start += object->Size();
-        }
-        earliest_iteration_start = iteration_start;
+      // Skip objects that start in the previous card.
+      while (iteration_start < current) {
+        if (HasSentinelAt(iteration_start)) break;
+        HeapObject* object = HeapObject::FromAddress(iteration_start);
+        iteration_start += object->Size();
       }
+      // Reset in case there are no new-space pointers any more.
+      *byte = GCMetadata::kNoNewSpacePointers;
+      visitor->set_record_new_space_pointers(byte);
+      // Iterate objects that start in the relevant card.
+      while (iteration_start < current + GCMetadata::kCardSize) {
+        if (HasSentinelAt(iteration_start)) break;
+        HeapObject* object = HeapObject::FromAddress(iteration_start);
+        object->IteratePointers(visitor);
+        iteration_start += object->Size();
+      }
+      earliest_iteration_start = iteration_start;
       current += GCMetadata::kCardSize;
       bytes++;
     }
@@ -373,19 +485,149 @@ bool OldSpace::CompleteScavengeGenerational(
   return found_work;
 }
 
+FreeListChunk* FreeList::GetChunk(uword min_size) {
+  ASSERT(min_size >= HeapObject::kSize);
+  if (min_size < kSmallLimit) {
+    int size_class = Utils::RoundUp(min_size, kPointerSize) >> kPointerSizeLog2;
+    uint64 fitting = small_mask_ & (~static_cast<uint64>(0) << size_class);
+    if (fitting != 0) {
+      int i = LowestBit(fitting);
+      return TakeFirst(&small_[i], &small_mask_, i);
+    }
+    // All chunks in the buckets are large enough.
+    if (bucket_mask_ == 0) return NULL;
+    int i = LowestBit(bucket_mask_);
+    return TakeFirst(&buckets_[i], &bucket_mask_, i);
+  }
+
+  // Chunks in the bucket of min_size may fit, chunks in any larger bucket
+  // are guaranteed to.
+  int bucket = Utils::HighestBit(min_size);
+  FreeListChunk* result = TakeFromBucket(bucket, min_size, kMaxBucketScan);
+  if (result != NULL) return result;
+  uint64 larger = bucket_mask_ & (~static_cast<uint64>(1) << bucket);
+  if (larger != 0) {
+    int i = LowestBit(larger);
+    return TakeFirst(&buckets_[i], &bucket_mask_, i);
+  }
+  // Last resort: search the rest of the bucket of min_size.
+  return TakeFromBucket(bucket, min_size, -1);
+}
+
+uword FreeList::LargestChunkSize() {
+  if (bucket_mask_ != 0) {
+    uword largest = 0;
+    FreeListChunk* chunk = buckets_[Utils::HighestBit(bucket_mask_)];
+    for (; chunk != NULL;
+         chunk = reinterpret_cast<FreeListChunk*>(chunk->next_chunk())) {
+      largest = Utils::Maximum(largest, chunk->size());
+    }
+    return largest;
+  }
+  if (small_mask_ != 0) {
+    return Utils::HighestBit(small_mask_) << kPointerSizeLog2;
+  }
+  return 0;
+}
+
+FreeListChunk* FreeList::Append(FreeListChunk* list, FreeListChunk* tail) {
+  if (list == NULL) return tail;
+  FreeListChunk* last_chunk = list;
+  while (last_chunk->next_chunk() != NULL) {
+    last_chunk = FreeListChunk::cast(last_chunk->next_chunk());
+  }
+  last_chunk->set_next_chunk(tail);
+  return list;
+}
+
+FreeListChunk* FreeList::TakeFirst(FreeListChunk** list, uint64* mask,
+                                   int index) {
+  FreeListChunk* result = *list;
+  ASSERT(result != NULL);
+  *list = reinterpret_cast<FreeListChunk*>(result->next_chunk());
+  if (*list == NULL) *mask &= ~(static_cast<uint64>(1) << index);
+  result->set_next_chunk(NULL);
+  return result;
+}
+
+uword FreeList::DiscardUnusedPages(uword min_size) {
+  uword discarded = 0;
+  for (int i = Utils::HighestBit(min_size); i < kNumberOfBuckets; i++) {
+    FreeListChunk* chunk = buckets_[i];
+    for (; chunk != NULL;
+         chunk = reinterpret_cast<FreeListChunk*>(chunk->next_chunk())) {
+      if (chunk->size() < min_size) continue;
+      // The header of the chunk has to stay intact.
+      uword start = Utils::RoundUp(chunk->address() + FreeListChunk::kSize,
+                                   Platform::kPageSize);
+      uword end = Utils::RoundDown(chunk->address() + chunk->size(),
+                                   Platform::kPageSize);
+      if (start >= end) continue;
+      Platform::DiscardPages(reinterpret_cast<void*>(start), end - start);
+      discarded += end - start;
+    }
+  }
+  return discarded;
+}
+
+FreeListChunk* FreeList::TakeFromBucket(int bucket, uword min_size,
+                                        int max_scan) {
+  FreeListChunk* previous = NULL;
+  FreeListChunk* current = buckets_[bucket];
+  for (int i = 0; current != NULL && i != max_scan; i++) {
+    FreeListChunk* next =
+        reinterpret_cast<FreeListChunk*>(current->next_chunk());
+    if (current->size() >= min_size) {
+      if (previous != NULL) {
+        previous->set_next_chunk(next);
+      } else {
+        buckets_[bucket] = next;
+        if (next == NULL) bucket_mask_ &= ~(static_cast<uint64>(1) << bucket);
+      }
+      current->set_next_chunk(NULL);
+      return current;
+    }
+    previous = current;
+    current = next;
+  }
+  return NULL;
+}
+
 void OldSpace::ClearFreeList() { free_list_->Clear(); }
 
 void OldSpace::MarkChunkEndsFree() {
-  for (auto chunk : chunk_list_) {
+  for (auto it = chunk_list_.Begin(); it != chunk_list_.End();) {
+    Chunk* chunk = *it;
     uword top = chunk->compaction_top();
     uword end = chunk->usable_end();
-    if (top != end) free_list_->AddChunk(top, end - top);
+    if (top == chunk->start() && !chunk->is_large_object()) {
+      chunk->set_idle_gcs(chunk->idle_gcs() + 1);
+      if (chunk->idle_gcs() > kIdleGCsBeforeRelease) {
+        it = chunk_list_.Erase(it);
+        ObjectMemory::FreeChunk(chunk);
+        continue;
+      }
+    } else {
+      chunk->set_idle_gcs(0);
+    }
+    ++it;
+    if (top != end) {
+      if (chunk->is_large_object()) {
+        FreeList::MakeFiller(top, end - top);
+      } else {
+        free_list_->AddChunk(top, end - top);
+      }
+    }
     top = Utils::RoundUp(top, GCMetadata::kCardSize);
     GCMetadata::InitializeStartsForChunk(chunk, top);
     GCMetadata::InitializeRememberedSetForChunk(chunk, top);
   }
 }
 
+void OldSpace::DiscardFreeMemory() {
+  discarded_ = free_list_->DiscardUnusedPages(kMinimumDiscardedRun);
+}
+
 void FixPointersVisitor::VisitBlock(Object** start, Object** end) {
   for (Object** current = start; current < end; current++) {
     Object* object = *current;
@@ -431,7 +673,9 @@ static int ALWAYS_INLINE FindFirstSet(uint32 x) {
 CompactingVisitor::CompactingVisitor(OldSpace* space,
                                      FixPointersVisitor* fix_pointers_visitor)
     : used_(0),
-      dest_(space->ChunkListBegin(), space->ChunkListEnd()),
+      dest_(GCMetadata::Destination::SkipLargeObjectChunks(
+                space->ChunkListBegin(), space->ChunkListEnd()),
+            space->ChunkListEnd()),
       fix_pointers_visitor_(fix_pointers_visitor) {}
 
 uword CompactingVisitor::Visit(HeapObject* object) {
@@ -456,6 +700,16 @@ uword CompactingVisitor::Visit(HeapObject* object) {
 
   // Object is marked.
   uword size = object->Size();
+  if (large_object_chunk_) {
+    // Objects in large-object chunks are not moved, only their pointers are
+    // fixed.
+    ASSERT(GCMetadata::GetDestination(object) == object->address());
+    GCMetadata::RecordStart(object->address());
+    fix_pointers_visitor_->set_source_address(object->address());
+    object->IteratePointers(fix_pointers_visitor_);
+    used_ += size;
+    return size;
+  }
   // Unless we have large objects and small chunks max one iteration of this
   // loop is needed to move on to the next destination chunk.
   while (dest_.address + size > dest_.limit) {
@@ -490,7 +744,11 @@ SweepingVisitor::SweepingVisitor(OldSpace* space)
 void SweepingVisitor::AddFreeListChunk(uword free_end) {
   if (free_start_ != 0) {
     uword free_size = free_end - free_start_;
-    free_list_->AddChunk(free_start_, free_size);
+    if (large_object_chunk_) {
+      FreeList::MakeFiller(free_start_, free_size);
+    } else {
+      free_list_->AddChunk(free_start_, free_size);
+    }
     free_start_ = 0;
   }
 }
@@ -515,7 +773,7 @@ void FixPointersVisitor::AboutToVisitStack(Stack* stack) {
 }
 
 void OldSpace::ProcessWeakPointers() {
-  WeakPointer::Process(&weak_pointers_, this);
+  weak_pointers_.Process(this);
 }
 
 #ifdef DEBUG
@@ -557,12 +815,118 @@ void OldSpace::Verify() {
 }
 #endif
 
-void MarkingStack::Empty(PointerVisitor* visitor) {
-  while (!IsEmpty()) {
-    HeapObject* object = *--next_;
-    GCMetadata::MarkAll(object, object->Size());
-    object->IteratePointers(visitor);
+Mutex* MarkingStack::pool_mutex_ = NULL;
+MarkingStackSegment* MarkingStack::pool_ = NULL;
+int MarkingStack::pool_size_ = 0;
+Atomic<uword> MarkingStack::overflow_count_;
+
+void MarkingStack::Setup() {
+  pool_mutex_ = Platform::CreateMutex();
+  overflow_count_ = 0;
+}
+
+void MarkingStack::TearDown() {
+  while (pool_ != NULL) {
+    MarkingStackSegment* segment = pool_;
+    pool_ = segment->previous;
+    free(segment);
+  }
+  pool_size_ = 0;
+  delete pool_mutex_;
+  pool_mutex_ = NULL;
+}
+
+MarkingStackSegment* MarkingStack::AllocateSegment() {
+  {
+    ScopedLock lock(pool_mutex_);
+    if (pool_ != NULL) {
+      MarkingStackSegment* segment = pool_;
+      pool_ = segment->previous;
+      pool_size_--;
+      return segment;
+    }
+  }
+  return reinterpret_cast<MarkingStackSegment*>(
+      malloc(sizeof(MarkingStackSegment)));
+}
+
+void MarkingStack::FreeSegment(MarkingStackSegment* segment) {
+  {
+    ScopedLock lock(pool_mutex_);
+    if (pool_size_ < kMaxPooledSegments) {
+      segment->previous = pool_;
+      pool_ = segment;
+      pool_size_++;
+      return;
+    }
+  }
+  free(segment);
+}
+
+MarkingStack::MarkingStack()
+    : next_(NULL),
+      base_(NULL),
+      limit_(NULL),
+      segment_(NULL),
+      segment_count_(0),
+      spare_(NULL) {
+  MarkingStackSegment* segment = AllocateSegment();
+  if (segment != NULL) {
+    segment->previous = NULL;
+    segment_count_ = 1;
+    UseSegment(segment);
+  }
+}
+
+MarkingStack::~MarkingStack() {
+  while (PopSegment()) {
+  }
+  if (segment_ != NULL) FreeSegment(segment_);
+  if (spare_ != NULL) FreeSegment(spare_);
+}
+
+void MarkingStack::PushSlow(HeapObject* object) {
+  MarkingStackSegment* segment = spare_;
+  spare_ = NULL;
+  if (segment == NULL && segment_count_ < kMaxSegments) {
+    segment = AllocateSegment();
   }
+  if (segment == NULL) {
+    // Last resort: remember the object in the overflow bits and find it
+    // again by scanning the heap once the stack has been emptied.
+    overflowed_ = true;
+    overflow_count_++;
+    GCMetadata::MarkStackOverflow(object);
+    return;
+  }
+  segment->previous = segment_;
+  segment_count_++;
+  UseSegment(segment);
+  *(next_++) = object;
+}
+
+// Drops the current, empty, segment and continues with the previous one,
+// which is full. Returns false if the stack is down to its first segment.
+bool MarkingStack::PopSegment() {
+  ASSERT(next_ == base_);
+  if (segment_ == NULL || segment_->previous == NULL) return false;
+  MarkingStackSegment* empty = segment_;
+  UseSegment(empty->previous);
+  next_ = limit_;
+  segment_count_--;
+  if (spare_ != NULL) FreeSegment(spare_);
+  spare_ = empty;
+  return true;
+}
+
+void MarkingStack::Empty(PointerVisitor* visitor) {
+  do {
+    while (next_ > base_) {
+      HeapObject* object = *--next_;
+      GCMetadata::MarkAll(object, object->Size());
+      object->IteratePointers(visitor);
+    }
+  } while (PopSegment());
 }
 
 void MarkingStack::Process(PointerVisitor* visitor, Space* old_space,
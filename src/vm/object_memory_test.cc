@@ -3,8 +3,15 @@
 // BSD-style license that can be found in the LICENSE.md file.
 
 #include "src/shared/assert.h"
+#include "src/vm/finalizer_queue.h"
+#include "src/vm/frame.h"
 #include "src/vm/heap.h"
+#include "src/vm/heap_census.h"
+#include "src/vm/interpreter.h"
+#include "src/vm/mark_sweep.h"
 #include "src/vm/object_memory.h"
+#include "src/vm/process.h"
+#include "src/vm/program.h"
 #include "src/shared/test_case.h"
 
 namespace dartino {
@@ -38,4 +45,281 @@ TEST_CASE(ObjectMemory) {
   ObjectMemory::FreeChunk(second);
 }
 
+static uword free_list_memory[2048];
+
+static uword FreeWords(int offset) {
+  return reinterpret_cast<uword>(&free_list_memory[offset]);
+}
+
+TEST_CASE(FreeList) {
+  const uword kWordSize = kPointerSize;
+  FreeList free_list;
+  free_list.AddChunk(FreeWords(0), 5 * kWordSize);
+  free_list.AddChunk(FreeWords(16), 9 * kWordSize);
+  free_list.AddChunk(FreeWords(64), 40 * kWordSize);
+  free_list.AddChunk(FreeWords(128), 100 * kWordSize);
+  free_list.AddChunk(FreeWords(512), 1000 * kWordSize);
+  EXPECT_EQ(1000 * kWordSize, free_list.LargestChunkSize());
+
+  // Small sizes take the best fitting size class, then the smallest bucket.
+  EXPECT_EQ(FreeWords(0), free_list.GetChunk(4 * kWordSize)->address());
+  EXPECT_EQ(FreeWords(16), free_list.GetChunk(4 * kWordSize)->address());
+  EXPECT_EQ(FreeWords(64), free_list.GetChunk(4 * kWordSize)->address());
+
+  // Large sizes take the smallest bucket that fits.
+  EXPECT_EQ(FreeWords(128), free_list.GetChunk(50 * kWordSize)->address());
+  EXPECT(free_list.GetChunk(2000 * kWordSize) == NULL);
+  EXPECT_EQ(FreeWords(512),
+            free_list.GetChunk(1000 * kWordSize)->address());
+  EXPECT_EQ(0u, free_list.LargestChunkSize());
+}
+
+static Array* NewArray(Program* program, Process* process, int length) {
+  Object* result = process->NewArray(length);
+  // Live objects are only promoted on their second survival, so it can take
+  // two scavenges to make room.
+  while (result->IsRetryAfterGCFailure()) {
+    program->CollectNewSpace(process);
+    result = process->NewArray(length);
+  }
+  return Array::cast(result);
+}
+
+TEST_CASE(MarkingStackGrows) {
+  // All the elements of a wide array are pushed on the marking stack at
+  // once. It must grow rather than overflow.
+  const int kLength = 100000;
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_static_fields(Array::cast(program->CreateArray(1)));
+  Process* process = program->SpawnProcess(NULL);
+  process->statics()->set(0, NewArray(program, process, kLength));
+  GCMetadata::InsertIntoRememberedSet(process->statics()->address());
+  for (int i = 0; i < kLength; i++) {
+    Array* element = NewArray(program, process, 1);
+    element->set(0, Smi::FromWord(i));
+    Array* wide = Array::cast(process->statics()->get(0));
+    wide->set(i, element);
+    GCMetadata::InsertIntoRememberedSet(wide->address());
+  }
+
+  uword overflows = MarkingStack::overflow_count();
+  program->CollectOldSpace();
+  EXPECT_EQ(overflows, MarkingStack::overflow_count());
+
+  Array* wide = Array::cast(process->statics()->get(0));
+  for (int i = 0; i < kLength; i++) {
+    EXPECT_EQ(Smi::FromWord(i), Array::cast(wide->get(i))->get(0));
+  }
+
+  process->ChangeState(Process::kSleeping, Process::kWaitingForChildren);
+  program->ScheduleProcessForDeletion(process, Signal::kTerminated);
+  delete program;
+}
+
+TEST_CASE(GCStatistics) {
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_static_fields(Array::cast(program->CreateArray(1)));
+  Process* process = program->SpawnProcess(NULL);
+  process->statics()->set(0, NewArray(program, process, 100));
+
+  DartinoGCStatistics before;
+  program->gc_statistics()->Get(&before);
+  // The array survives the first scavenge and is promoted by the second.
+  program->CollectNewSpace(process);
+  program->CollectNewSpace(process);
+  program->CollectOldSpace();
+  DartinoGCStatistics after;
+  program->gc_statistics()->Get(&after);
+
+  EXPECT_EQ(before.scavenges + 2, after.scavenges);
+  EXPECT_EQ(before.old_space_gcs + 1, after.old_space_gcs);
+  EXPECT_EQ(after.scavenges, after.scavenge_pauses.count);
+  EXPECT_EQ(after.scavenges,
+            after.phase_pauses[DARTINO_GC_PHASE_SCAVENGE_COPY].count);
+  EXPECT_EQ(after.old_space_gcs,
+            after.phase_pauses[DARTINO_GC_PHASE_MARK].count);
+  EXPECT(after.bytes_survived > before.bytes_survived);
+  EXPECT(after.bytes_promoted > before.bytes_promoted);
+  EXPECT(after.old_space_used > 0);
+
+  uint64_t buckets = 0;
+  for (int i = 0; i < DARTINO_GC_PAUSE_BUCKETS; i++) {
+    buckets += after.scavenge_pauses.buckets[i];
+  }
+  EXPECT_EQ(after.scavenge_pauses.count, buckets);
+
+  process->ChangeState(Process::kSleeping, Process::kWaitingForChildren);
+  program->ScheduleProcessForDeletion(process, Signal::kTerminated);
+  delete program;
+}
+
+TEST_CASE(HeapCensus) {
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_static_fields(Array::cast(program->CreateArray(1)));
+  Process* process = program->SpawnProcess(NULL);
+  process->statics()->set(0, NewArray(program, process, 3));
+
+  // Build A -> {X, Y}, X -> Z and Y -> Z. Z is only retained through A.
+  Object* bytes = process->NewByteArray(100);
+  while (bytes->IsRetryAfterGCFailure()) {
+    program->CollectNewSpace(process);
+    bytes = process->NewByteArray(100);
+  }
+  Array* a = Array::cast(process->statics()->get(0));
+  a->set(2, bytes);
+  GCMetadata::InsertIntoRememberedSet(a->address());
+  for (int i = 0; i < 2; i++) {
+    Array* element = NewArray(program, process, 1);
+    a = Array::cast(process->statics()->get(0));
+    element->set(0, a->get(2));
+    a->set(i, element);
+    GCMetadata::InsertIntoRememberedSet(a->address());
+  }
+  a->set(2, Smi::FromWord(0));
+  ByteArray* z = ByteArray::cast(Array::cast(a->get(0))->get(0));
+  // Garbage that has not been collected yet is not part of the census.
+  EXPECT(!process->NewByteArray(200)->IsFailure());
+
+  HeapCensus census(program);
+  census.Take();
+  bool found_byte_arrays = false;
+  bool found_arrays = false;
+  for (unsigned i = 0; i < census.classes().size(); i++) {
+    const HeapCensus::ClassEntry& entry = census.classes()[i];
+    EXPECT(entry.size <= census.size());
+    EXPECT(entry.retained <= census.size());
+    if (entry.klass == program->byte_array_class()) {
+      found_byte_arrays = true;
+      EXPECT_EQ(1u, entry.count);
+      EXPECT_EQ(z->Size(), entry.size);
+      EXPECT_EQ(z->Size(), entry.retained);
+    } else if (entry.klass == program->array_class()) {
+      found_arrays = true;
+      uword graph = a->Size() + 2 * Array::cast(a->get(0))->Size() + z->Size();
+      EXPECT(entry.retained >= graph);
+    }
+  }
+  EXPECT(found_byte_arrays);
+  EXPECT(found_arrays);
+
+  process->ChangeState(Process::kSleeping, Process::kWaitingForChildren);
+  program->ScheduleProcessForDeletion(process, Signal::kTerminated);
+  delete program;
+}
+
+TEST_CASE(AllocationProfiler) {
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_static_fields(Array::cast(program->CreateArray(1)));
+  Process* process = program->SpawnProcess(NULL);
+  AllocationSampler* sampler = process->heap()->allocation_sampler();
+  sampler->Enable(program->allocation_profiler(), 1 * KB);
+
+  // Give the process a walkable stack, as if it had started running.
+  uint8 bcp = 0;
+  Frame frame(process->stack());
+  frame.PushInitialDartEntryFrames(0, &bcp, NULL);
+
+  // Sampled allocations fail once so the interpreter can record the stack.
+  uword allocated = 0;
+  for (int i = 0; i < 1000; i++) {
+    Object* result = process->NewArray(10);
+    while (result->IsRetryAfterGCFailure()) {
+      HandleGC(process);
+      result = process->NewArray(10);
+    }
+    allocated += Array::cast(result)->Size();
+  }
+  sampler->FinishSample();
+
+  AllocationProfiler* profiler = program->allocation_profiler();
+  uword samples = profiler->samples();
+  EXPECT(samples > 0);
+  EXPECT_EQ(allocated / KB, samples);
+  EXPECT_EQ(samples, profiler->SamplesOf(program->array_class()));
+
+  process->ChangeState(Process::kSleeping, Process::kWaitingForChildren);
+  program->ScheduleProcessForDeletion(process, Signal::kTerminated);
+  delete program;
+}
+
+static int finalized = 0;
+
+static void CountFinalizer(void* arg) { finalized++; }
+
+static void OtherFinalizer(void* arg) { finalized++; }
+
+// The number of finalizers registered on object [i] in the Finalizers test.
+static int FinalizersOf(int i, int first_removed, int last_removed) {
+  int count = (i % 3 == 0) ? 0 : 1;
+  if (i % 2 == 0 && !(first_removed <= i && i < last_removed)) count++;
+  return count;
+}
+
+TEST_CASE(Finalizers) {
+  const int kObjects = 300;
+  Program* program = new Program(Program::kBuiltViaSession);
+  program->Initialize();
+  program->set_static_fields(Array::cast(program->CreateArray(1)));
+  Process* process = program->SpawnProcess(NULL);
+  process->statics()->set(0, NewArray(program, process, kObjects));
+
+  finalized = 0;
+  for (int i = 0; i < kObjects; i++) {
+    Array* object = NewArray(program, process, 2);
+    Array::cast(process->statics()->get(0))->set(i, object);
+    process->RegisterExternalFinalizer(object, CountFinalizer, NULL);
+    if (i % 2 == 0) {
+      process->RegisterExternalFinalizer(object, OtherFinalizer, NULL);
+    }
+  }
+  // Remove the first finalizers of some objects, so the table fills the holes
+  // and relinks the second ones.
+  for (int i = 0; i < kObjects; i += 3) {
+    HeapObject* object =
+        HeapObject::cast(Array::cast(process->statics()->get(0))->get(i));
+    EXPECT(process->UnregisterExternalFinalizer(object, CountFinalizer));
+    EXPECT(!process->UnregisterExternalFinalizer(object, CountFinalizer));
+  }
+
+  // Objects that die young are finalized by a scavenge.
+  int expected = 0;
+  for (int i = 0; i < 100; i++) {
+    Array::cast(process->statics()->get(0))->set(i, Smi::zero());
+    expected += FinalizersOf(i, 0, 0);
+  }
+  program->CollectNewSpace(process);
+  // External finalizers run on the finalizer thread after the GC.
+  FinalizerQueue::GlobalInstance()->WaitUntilIdle();
+  EXPECT_EQ(expected, finalized);
+
+  // The survivors' finalizers move to the old-space table on promotion and
+  // can still be removed there.
+  program->CollectNewSpace(process);
+  program->CollectNewSpace(process);
+  EXPECT_EQ(expected, finalized);
+  for (int i = 100; i < 150; i += 2) {
+    HeapObject* object =
+        HeapObject::cast(Array::cast(process->statics()->get(0))->get(i));
+    EXPECT(process->UnregisterExternalFinalizer(object, OtherFinalizer));
+  }
+  for (int i = 100; i < 200; i++) {
+    Array::cast(process->statics()->get(0))->set(i, Smi::zero());
+    expected += FinalizersOf(i, 100, 150);
+  }
+  program->CollectOldSpace();
+  FinalizerQueue::GlobalInstance()->WaitUntilIdle();
+  EXPECT_EQ(expected, finalized);
+
+  // The remaining finalizers run when the heap goes away.
+  for (int i = 200; i < kObjects; i++) expected += FinalizersOf(i, 0, 0);
+  process->ChangeState(Process::kSleeping, Process::kWaitingForChildren);
+  program->ScheduleProcessForDeletion(process, Signal::kTerminated);
+  delete program;
+  EXPECT_EQ(expected, finalized);
+}
+
 }  // namespace dartino
@@ -140,6 +140,12 @@ BEGIN_NATIVE(PortSend) {
 
     port->Lock();
     Process* port_process = port->process();
+    if (port_process != NULL && port_process->heap() != process->heap() &&
+        !process->EnsureShareable(message)) {
+      port->Unlock();
+      delete entry;
+      return Failure::retry_after_gc(0);
+    }
     if (port_process != NULL) {
       port_process->mailbox()->EnqueueEntry(entry);
       entry = NULL;
@@ -170,6 +176,12 @@ BEGIN_NATIVE(PortSendExit) {
   if (port_process != NULL && port_process != process) {
     Object* message = arguments[1];
 
+    if (port_process->heap() != process->heap() &&
+        !process->EnsureShareable(message)) {
+      port->Unlock();
+      return Failure::retry_after_gc(0);
+    }
+
     // Enqueue the exit message and return the locked port. This
     // will allow the scheduler to schedule the owner of the port,
     // while it's still alive.
@@ -0,0 +1,55 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/pretenuring.h"
+
+#include "src/shared/assert.h"
+
+namespace dartino {
+
+void PretenuringTable::UpdateDecisions() {
+  for (int i = 0; i < kCapacity; i++) {
+    Entry* entry = &entries_[i];
+    if (entry->klass == NULL || entry->allocated < kMinimumSamples) continue;
+    uint64 survived = static_cast<uint64>(entry->survived) * 100;
+    if (survived >= static_cast<uint64>(entry->allocated) * kPretenurePercent) {
+      entry->pretenure = true;
+    } else if (survived < static_cast<uint64>(entry->allocated) *
+                              kTenurePercent) {
+      entry->pretenure = false;
+    }
+    entry->allocated = 0;
+    entry->survived = 0;
+  }
+}
+
+void PretenuringTable::Clear() {
+  for (int i = 0; i < kCapacity; i++) {
+    entries_[i].klass = NULL;
+    entries_[i].allocated = 0;
+    entries_[i].survived = 0;
+    entries_[i].probe = 0;
+    entries_[i].pretenure = false;
+  }
+  size_ = 0;
+}
+
+PretenuringTable::Entry* PretenuringTable::Find(Class* klass, bool insert) {
+  uword hash = reinterpret_cast<uword>(klass) >> kPointerSizeLog2;
+  int index = static_cast<int>((hash * 0x9E3779B1u) & (kCapacity - 1));
+  while (true) {
+    Entry* entry = &entries_[index];
+    if (entry->klass == klass) return entry;
+    if (entry->klass == NULL) {
+      // When the table is full, classes not seen yet are simply not tracked.
+      if (!insert || size_ == kMaxSize) return NULL;
+      entry->klass = klass;
+      size_++;
+      return entry;
+    }
+    index = (index + 1) & (kCapacity - 1);
+  }
+}
+
+}  // namespace dartino
@@ -0,0 +1,79 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_PRETENURING_H_
+#define SRC_VM_PRETENURING_H_
+
+#include "src/shared/globals.h"
+
+namespace dartino {
+
+class Class;
+
+// Tracks, per class, how many of the instances allocated in new-space
+// survive their first scavenge. Instances of classes where nearly all of
+// them survive are allocated directly in old-space, so they are not copied
+// by the scavenger before being promoted anyway.
+//
+// While a class is pretenured, one in kProbeInterval of its instances is
+// still allocated in new-space. The survival rate of those is used to
+// switch back to new-space allocation if the behavior of the program
+// changes.
+class PretenuringTable {
+ public:
+  PretenuringTable() { Clear(); }
+
+  // Returns true if the instance should be allocated in old-space. Otherwise
+  // counts a new-space allocation of the class.
+  bool ShouldPretenure(Class* klass) {
+    Entry* entry = Find(klass, true);
+    if (entry == NULL) return false;
+    if (entry->pretenure && (++entry->probe % kProbeInterval) != 0) {
+      return true;
+    }
+    entry->allocated++;
+    return false;
+  }
+
+  // Called by the scavenger for each instance that survives its first
+  // scavenge.
+  void RecordSurvivor(Class* klass) {
+    Entry* entry = Find(klass, false);
+    if (entry != NULL) entry->survived++;
+  }
+
+  // Called after each scavenge to update the per-class decisions.
+  void UpdateDecisions();
+
+  // Forget everything. Must be called when classes have moved.
+  void Clear();
+
+ private:
+  struct Entry {
+    Class* klass;
+    uint32 allocated;
+    uint32 survived;
+    uint32 probe;
+    bool pretenure;
+  };
+
+  static const int kCapacity = 1024;
+  static const int kMaxSize = kCapacity - (kCapacity >> 2);
+
+  // Number of new-space allocations needed before a decision is made.
+  static const uint32 kMinimumSamples = 100;
+  // Survival percentages at which to start and stop pretenuring.
+  static const uint32 kPretenurePercent = 90;
+  static const uint32 kTenurePercent = 50;
+  static const uint32 kProbeInterval = 16;
+
+  Entry* Find(Class* klass, bool insert);
+
+  Entry entries_[kCapacity];
+  int size_;
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_PRETENURING_H_
@@ -13,6 +13,7 @@
 #include "src/shared/selectors.h"
 
 #include "src/vm/event_handler.h"
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/frame.h"
 #include "src/vm/gc_metadata.h"
 #include "src/vm/heap_validator.h"
@@ -29,7 +30,7 @@ static uword kPreemptMarker = 1 << 0;
 static uword kDebugInterruptMarker = 1 << 1;
 static uword kMaxStackMarker = ~static_cast<uword>((1 << 2) - 1);
 
-Process::Process(Program* program, Process* parent)
+Process::Process(Program* program, Process* parent, TwoSpaceHeap* heap)
     : native_stack_(NULL),
       coroutine_(NULL),
       stack_limit_(0),
@@ -38,6 +39,9 @@ Process::Process(Program* program, Process* parent)
       exception_(program->null_object()),
       primary_lookup_cache_(NULL),
       remembered_set_bias_(GCMetadata::remembered_set_bias()),
+      inline_cache_(NULL),
+      inline_cache_mask_(0),
+      heap_(heap),
       large_integer_(program->null_object()),
       random_(program->random()->NextUInt32() + 1),
       state_(kSleeping),
@@ -48,6 +52,8 @@ Process::Process(Program* program, Process* parent)
       parent_(parent),
       errno_cache_(0),
       debug_info_(NULL),
+      profiled_bcp_(NULL),
+      catch_table_cache_(NULL),
       scheduler_(NULL)
 #ifdef DEBUG
       ,
@@ -76,6 +82,11 @@ Process::Process(Program* program, Process* parent)
   static_assert(
       kRememberedSetBiasOffset == offsetof(Process, remembered_set_bias_),
       "primary_lookup_cache_");
+  static_assert(kInlineCacheOffset == offsetof(Process, inline_cache_),
+                "inline_cache_");
+  static_assert(kInlineCacheMaskOffset == offsetof(Process, inline_cache_mask_),
+                "inline_cache_mask_");
+  static_assert(kHeapOffset == offsetof(Process, heap_), "heap_");
 
   Array* static_fields = program->static_fields();
   int length = static_fields->length();
@@ -104,10 +115,13 @@ Process::~Process() {
   if (signal != NULL) Signal::DecrementRef(signal);
 
   delete debug_info_;
+  delete catch_table_cache_;
   for (int i = 0; i < arguments_.length(); i++) {
     arguments_[i].Delete();
   }
   arguments_.Delete();
+
+  if (has_private_heap()) delete heap_;
 }
 
 void Process::Cleanup(Signal::Kind kind) {
@@ -175,18 +189,26 @@ Process::StackCheckResult Process::HandleStackOverflow(int addition) {
     }
   }
 
-  int size_increase = Utils::RoundUpToPowerOfTwo(addition);
-  size_increase = Utils::Maximum(256, size_increase);
-  int new_size = stack()->length() + size_increase;
-  if (new_size > Platform::MaxStackSizeInWords()) return kStackCheckOverflow;
-
+  // Grow the stack to the next power of two that fits, so deep recursions
+  // copy it a logarithmic number of times, and the stacks it gives up fit
+  // in the stack pool.
+  int old_size = stack()->length();
+  int max_size = Platform::MaxStackSizeInWords();
+  int size_increase = Utils::Maximum(256, addition);
+  if (old_size + size_increase > max_size) return kStackCheckOverflow;
+  int new_size = Utils::RoundUpToPowerOfTwo(old_size + size_increase);
+  new_size = Utils::Minimum(new_size, max_size);
+
+  int collections = 0;
   Object* new_stack_object = NewStack(new_size);
   if (new_stack_object->IsRetryAfterGCFailure()) {
-    program()->CollectNewSpace();
+    program()->CollectNewSpace(this);
+    collections++;
     new_stack_object = NewStack(new_size);
     if (new_stack_object->IsRetryAfterGCFailure()) {
       program()->CollectOldSpace();
-      program()->CollectNewSpace();
+      program()->CollectNewSpace(this);
+      collections += 2;
       new_stack_object = NewStack(new_size);
       if (new_stack_object->IsRetryAfterGCFailure()) {
         return kStackCheckOverflow;
@@ -196,17 +218,21 @@ Process::StackCheckResult Process::HandleStackOverflow(int addition) {
 
   NoAllocationScope scope(heap());  // Protect new_stack.
 
+  Stack* old_stack = stack();
   Stack* new_stack = Stack::cast(new_stack_object);
-  word height = stack()->length() - stack()->top();
+  word height = old_stack->length() - old_stack->top();
   ASSERT(height >= 0);
   new_stack->set_top(new_stack->length() - height);
-  memcpy(new_stack->Pointer(new_stack->top()), stack()->Pointer(stack()->top()),
-         height * kWordSize);
-  new_stack->UpdateFramePointers(stack());
+  memcpy(new_stack->Pointer(new_stack->top()),
+         old_stack->Pointer(old_stack->top()), height * kWordSize);
+  new_stack->UpdateFramePointers(old_stack);
   ASSERT(coroutine_->has_stack());
   coroutine_->set_stack(new_stack);
   GCMetadata::InsertIntoRememberedSet(coroutine_->stack()->address());
+  ReleaseStack(old_stack);
   UpdateStackLimit();
+  program()->gc_statistics()->RecordStackGrowth(new_size, height,
+                                                collections);
   return kStackCheckContinue;
 }
 
@@ -333,16 +359,69 @@ Object* Process::ToInteger(int64 value) {
 }
 
 Object* Process::NewStack(int length) {
-  RegisterProcessAllocation();
-  Class* stack_class = program()->stack_class();
-  Object* result = heap()->CreateStack(stack_class, length);
-
-  if (result->IsFailure()) return result;
+  Object* result = stack_pool_.Take(length);
+  if (result == NULL) {
+    RegisterProcessAllocation();
+    Class* stack_class = program()->stack_class();
+    result = heap()->CreateStack(stack_class, length);
+    if (result->IsFailure()) return result;
+  }
   GCMetadata::InsertIntoRememberedSet(HeapObject::cast(result)->address());
   return result;
 }
 
+// Looks for new-space objects reachable from a message through old-space
+// objects. Gives up after a bounded amount of work, in which case the message
+// is assumed to reach into new-space.
+class NewSpaceReferenceFinder : public PointerVisitor {
+ public:
+  NewSpaceReferenceFinder() : found_(false), count_(0), visited_(0) {}
+
+  bool Find(Object* message) {
+    Visit(&message);
+    while (!found_ && count_ > 0) {
+      if (++visited_ > kMaxVisited) return true;
+      worklist_[--count_]->IteratePointers(this);
+    }
+    return found_;
+  }
+
+  virtual void VisitBlock(Object** start, Object** end) {
+    for (Object** p = start; p < end && !found_; p++) {
+      PageType page_type = GCMetadata::GetPageType(*p);
+      if (page_type == kNewSpacePage) {
+        found_ = true;
+      } else if (page_type == kOldSpacePage) {
+        if (count_ == kWorklistSize) {
+          found_ = true;
+        } else {
+          worklist_[count_++] = HeapObject::cast(*p);
+        }
+      }
+    }
+  }
+
+ private:
+  static const int kWorklistSize = 64;
+  static const int kMaxVisited = 256;
+
+  bool found_;
+  int count_;
+  int visited_;
+  HeapObject* worklist_[kWorklistSize];
+};
+
+bool Process::EnsureShareable(Object* message) {
+  if (heap()->HasEmptyNewSpace()) return true;
+  NewSpaceReferenceFinder finder;
+  if (!finder.Find(message)) return true;
+  heap()->PromoteAllOnNextScavenge();
+  return false;
+}
+
 void Process::IterateRoots(PointerVisitor* visitor) {
+  // The pooled stacks are garbage, and the collection may free them.
+  stack_pool_.Clear();
   visitor->Visit(reinterpret_cast<Object**>(&statics_));
   visitor->Visit(reinterpret_cast<Object**>(&coroutine_));
   visitor->Visit(reinterpret_cast<Object**>(&exception_));
@@ -355,6 +434,8 @@ void Process::IterateRoots(PointerVisitor* visitor) {
 void Process::IterateProgramPointers(PointerVisitor* visitor) {
   // TODO(erikcorry): Somehow assert that the stacks are cooked (there's no
   // simple way to tell in a multiple-processes-per-heap world).
+  // The class pointers of the pooled stacks are not updated.
+  stack_pool_.Clear();
   if (debug_info_ != NULL) debug_info_->VisitProgramPointers(visitor);
   visitor->Visit(&exception_);
   mailbox_.IteratePointers(visitor);
@@ -362,6 +443,12 @@ void Process::IterateProgramPointers(PointerVisitor* visitor) {
 
 void Process::TakeLookupCache() {
   ASSERT(primary_lookup_cache_ == NULL);
+#if defined(DARTINO_TARGET_X64)
+  // Only the x64 interpreter has inline caches.
+  InlineCache* inline_cache = program()->EnsureInlineCache();
+  inline_cache_ = inline_cache->entries();
+  inline_cache_mask_ = inline_cache->capacity() - 1;
+#endif
   if (program()->is_optimized()) return;
   LookupCache* cache = program()->EnsureCache();
   primary_lookup_cache_ = cache->primary();
@@ -469,6 +556,15 @@ void Process::UpdateBreakpoints() {
   }
 }
 
+CatchTableCache* Process::EnsureCatchTableCache() {
+  if (catch_table_cache_ == NULL) catch_table_cache_ = new CatchTableCache();
+  return catch_table_cache_;
+}
+
+void Process::ClearCatchTableCache() {
+  if (catch_table_cache_ != NULL) catch_table_cache_->Clear();
+}
+
 void Process::RegisterFinalizer(HeapObject* object,
                                 WeakPointerCallback callback, void* arg) {
   heap()->AddWeakPointer(object, callback, arg);
@@ -493,7 +589,7 @@ void Process::FinalizeForeign(HeapObject* foreign, void* arg) {
   Instance* instance = Instance::cast(foreign);
   uword value = instance->GetConsecutiveSmis(0);
   uword length = Smi::cast(instance->GetInstanceField(2))->value();
-  free(reinterpret_cast<void*>(value));
+  FinalizerQueue::Schedule(free, reinterpret_cast<void*>(value));
   reinterpret_cast<TwoSpaceHeap*>(arg)->FreedForeignMemory(length);
 }
 
@@ -656,7 +752,7 @@ BEGIN_NATIVE(ProcessQueueGetMessage) {
       foreign->SetInstanceField(2, Smi::FromWord(size));
       if (kind == Message::FOREIGN_FINALIZED) {
         process->RegisterFinalizer(foreign, Process::FinalizeForeign,
-                                   process->heap());
+                                   process->program()->process_heap());
         process->heap()->AllocatedForeignMemory(size);
       }
       result = foreign;
@@ -8,9 +8,11 @@
 #include "src/shared/atomic.h"
 #include "src/shared/random.h"
 
+#include "src/vm/catch_table.h"
 #include "src/vm/debug_info.h"
 #include "src/vm/gc_metadata.h"
 #include "src/vm/heap.h"
+#include "src/vm/inline_cache.h"
 #include "src/vm/links.h"
 #include "src/vm/lookup_cache.h"
 #include "src/vm/message_mailbox.h"
@@ -18,6 +20,7 @@
 #include "src/vm/process_handle.h"
 #include "src/vm/program.h"
 #include "src/vm/signal.h"
+#include "src/vm/stack_pool.h"
 #include "src/vm/thread.h"
 
 namespace dartino {
@@ -87,7 +90,8 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
   Array* statics() const { return statics_; }
   Object* exception() const { return exception_; }
   void set_exception(Object* object) { exception_ = object; }
-  TwoSpaceHeap* heap() { return program()->process_heap(); }
+  TwoSpaceHeap* heap() { return heap_; }
+  bool has_private_heap() { return heap_->is_private(); }
 
   Coroutine* coroutine() const { return coroutine_; }
   void UpdateCoroutine(Coroutine* coroutine);
@@ -173,6 +177,14 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
   // Returns either a Smi or a LargeInteger.
   Object* ToInteger(int64 value);
 
+  // Messages are passed by reference. A process only finds the new-space
+  // objects of its own heap, so a message to or from a process with a
+  // private heap must not reach into a new-space. Returns false if
+  // [message] may do so, after arranging for the next scavenge of this
+  // process' heap to promote everything. The caller should then return a
+  // retry-after-GC failure.
+  bool EnsureShareable(Object* message);
+
   // Iterate all pointers reachable from this process object.
   void IterateRoots(PointerVisitor* visitor);
 
@@ -197,13 +209,31 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
   ProcessDebugInfo* debug_info() { return debug_info_; }
   bool is_debugging() const { return debug_info_ != NULL; }
 
+  // The bytecode the bytecode profiler last saw this process run.
+  uint8* profiled_bcp() const { return profiled_bcp_; }
+  void set_profiled_bcp(uint8* bcp) { profiled_bcp_ = bcp; }
+
   void TakeLookupCache();
-  void ReleaseLookupCache() { primary_lookup_cache_ = NULL; }
+  void ReleaseLookupCache() {
+    primary_lookup_cache_ = NULL;
+    inline_cache_ = NULL;
+    inline_cache_mask_ = 0;
+  }
 
   // Program GC support. Update breakpoints after having moved function.
   // Bytecode pointers need to be updated.
   void UpdateBreakpoints();
 
+  // The cache of the catch tables of the frames exceptions were thrown
+  // through. It is created by the first throw, and cleared when the program
+  // GC moves functions.
+  CatchTableCache* EnsureCatchTableCache();
+  void ClearCatchTableCache();
+
+  // Gives a stack the process no longer uses to its stack pool, from which
+  // [NewStack] takes stacks before it allocates new ones.
+  void ReleaseStack(Stack* stack) { stack_pool_.Give(stack); }
+
   // Change the state from 'from' to 'to. Return 'true' if the operation was
   // successful.
   inline bool ChangeState(State from, State to);
@@ -273,6 +303,9 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
   static const uword kPrimaryLookupCacheOffset = kExceptionOffset + kWordSize;
   static const uword kRememberedSetBiasOffset =
       kPrimaryLookupCacheOffset + kWordSize;
+  static const uword kInlineCacheOffset = kRememberedSetBiasOffset + kWordSize;
+  static const uword kInlineCacheMaskOffset = kInlineCacheOffset + kWordSize;
+  static const uword kHeapOffset = kInlineCacheMaskOffset + kWordSize;
 
   bool AllocationFailed() { return statics_ == NULL; }
   void SetAllocationFailed() { statics_ = NULL; }
@@ -286,7 +319,7 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
   friend class Program;
 
   // Creation and deletion of processes is managed by a [Program].
-  Process(Program* program, Process* parent);
+  Process(Program* program, Process* parent, TwoSpaceHeap* heap);
   ~Process();
 
   // Must be called before deletion. After this method is done cleaning up,
@@ -316,6 +349,16 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
   // it quickly.
   uword remembered_set_bias_;
 
+  // The entries of the inline caches of the program, while interpreting.
+  InlineCache::Entry* inline_cache_;
+  // The mask that computes the home index of a call site in them. It is kept
+  // here so the interpreter does not have to load it through inline_cache_.
+  uword inline_cache_mask_;
+
+  // Either the heap shared by the processes of the program or a private heap
+  // owned by this process. The interpreter allocates numbers in it directly.
+  TwoSpaceHeap* heap_;
+
   Object* large_integer_;
 
   RandomXorShift random_;
@@ -342,6 +385,12 @@ class Process : public ProcessList::Entry, public ProcessQueueList::Entry {
 
   ProcessDebugInfo* debug_info_;
 
+  uint8* profiled_bcp_;
+
+  CatchTableCache* catch_table_cache_;
+
+  StackPool stack_pool_;
+
   List<List<uint8>> arguments_;
 
   // The scheduler that is currently executing an interpreter in this process.
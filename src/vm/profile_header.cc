@@ -0,0 +1,26 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/profile_header.h"
+
+#include "src/shared/assert.h"
+#include "src/shared/globals.h"
+
+namespace dartino {
+
+const char* MemoryModel() {
+  if (kPointerSize == 8 && sizeof(dartino_double) == 8) return "b64double";
+  if (kPointerSize == 8 && sizeof(dartino_double) == 4) return "b64float";
+  if (kPointerSize == 4 && sizeof(dartino_double) == 8) return "b32double";
+  ASSERT(kPointerSize == 4 && sizeof(dartino_double) == 4);
+  return "b32float";
+}
+
+void WriteProfileHeader(FILE* file, const char* title, int hashtag) {
+  fprintf(file, "# %s from the Dartino VM.\n", title);
+  fprintf(file, "model=%s\n", MemoryModel());
+  fprintf(file, "hashtag=%d\n", hashtag);
+}
+
+}  // namespace dartino
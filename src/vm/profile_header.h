@@ -0,0 +1,23 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_PROFILE_HEADER_H_
+#define SRC_VM_PROFILE_HEADER_H_
+
+#include <stdio.h>
+
+namespace dartino {
+
+// Returns the name of the object layout of this VM, such as "b64double".
+// The tools need it to decode the offsets in tick, census and profile files.
+const char* MemoryModel();
+
+// Writes the [title] comment followed by the model= and hashtag= lines that
+// start the census and profile files. A [hashtag] of 0 means the program was
+// not loaded from a snapshot.
+void WriteProfileHeader(FILE* file, const char* title, int hashtag);
+
+}  // namespace dartino
+
+#endif  // SRC_VM_PROFILE_HEADER_H_
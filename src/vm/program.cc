@@ -4,6 +4,7 @@
 
 #include "src/vm/program.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -15,13 +16,17 @@
 #include "src/shared/selectors.h"
 #include "src/shared/utils.h"
 
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/frame.h"
+#include "src/vm/heap_census.h"
 #include "src/vm/heap_validator.h"
+#include "src/vm/jit.h"
 #include "src/vm/mark_sweep.h"
 #include "src/vm/native_interpreter.h"
 #include "src/vm/object.h"
 #include "src/vm/port.h"
 #include "src/vm/process.h"
+#include "src/vm/program_image.h"
 #include "src/vm/session.h"
 #include "src/vm/snapshot.h"
 
@@ -40,10 +45,13 @@ Program::Program(ProgramSource source, int snapshot_hash)
 #define CONSTRUCTOR_NULL(type, name, CamelName) name##_(NULL),
       ROOTS_DO(CONSTRUCTOR_NULL)
 #undef CONSTRUCTOR_NULL
-          process_list_mutex_(Platform::CreateMutex()),
+          quicken_static_loads_(Flags::quickening ? 1 : 0),
+      spawned_processes_(0),
+      process_list_mutex_(Platform::CreateMutex()),
       random_(0),
       heap_(&random_),
       process_heap_(),
+      allocation_profiler_(this),
       scheduler_(NULL),
       session_(NULL),
       entry_(NULL),
@@ -54,8 +62,11 @@ Program::Program(ProgramSource source, int snapshot_hash)
       exit_kind_(Signal::kTerminated),
       stack_chain_(NULL),
       cache_(NULL),
+      inline_cache_(NULL),
       debug_info_(NULL),
-      group_mask_(0) {
+      image_(NULL),
+      group_mask_(0),
+      heap_census_path_(NULL) {
 // These asserts need to hold when running on the target, but they don't need
 // to hold on the host (the build machine, where the interpreter-generating
 // program runs).  We put these asserts here on the assumption that the
@@ -64,18 +75,38 @@ Program::Program(ProgramSource source, int snapshot_hash)
   static_assert(k##CamelName##Offset == offsetof(Program, name##_), #name);
   ROOTS_DO(ASSERT_OFFSET)
 #undef ASSERT_OFFSET
+  static_assert(kQuickenStaticLoadsOffset ==
+                    offsetof(Program, quicken_static_loads_),
+                "quicken_static_loads_");
   ASSERT(loaded_from_snapshot_ || snapshot_hash_ == 0);
   if (!process_heap_.Initialize()) {
     // TODO(erikcorry): We need to trigger a GC in the other programs (if any)
     // and make sure they return extra memory to the OS.
     FATAL("Out of memory");
   }
+  if (Flags::allocation_sample_interval > 0) {
+    process_heap_.allocation_sampler()->Enable(
+        &allocation_profiler_, Flags::allocation_sample_interval);
+  }
 }
 
 Program::~Program() {
+  if (Flags::allocation_sample_interval > 0 &&
+      !WriteAllocationProfile(Flags::allocation_profile_file)) {
+    Print::Error("Could not write allocation profile to '%s'\n",
+                 Flags::allocation_profile_file);
+  }
+  free(heap_census_path_.exchange(NULL));
+  Jit* jit = Jit::GlobalInstance();
+  if (jit != NULL) jit->DiscardCode(this);
   delete process_list_mutex_;
+  if (Flags::print_inline_cache_statistics && inline_cache_ != NULL) {
+    inline_cache_->PrintStatistics();
+  }
   delete cache_;
+  delete inline_cache_;
   delete debug_info_;
+  delete image_;
   ASSERT(process_list_.IsEmpty());
 }
 
@@ -100,12 +131,27 @@ int Program::ExitCode() {
   return 0;
 }
 
-Process* Program::SpawnProcess(Process* parent) {
-  Process* process = new Process(this, parent);
+Process* Program::SpawnProcess(Process* parent, bool private_heap) {
+  // Each process has its own statics, so the static loads an earlier
+  // process quickened would not initialize those of the new one. That
+  // process is not running the interpreter now: it is either gone, or the
+  // parent spawning this one.
+  if (spawned_processes_++ > 0) StopQuickeningStaticLoads();
+
+  TwoSpaceHeap* heap = process_heap();
+  if (private_heap) {
+    heap = new TwoSpaceHeap(process_heap());
+    if (!heap->Initialize()) {
+      delete heap;
+      heap = process_heap();
+    }
+  }
+
+  Process* process = new Process(this, parent, heap);
   if (process->AllocationFailed()) {
     // Delete the half-built process, we will retry after a GC.
     process->Cleanup(Signal::kTerminated);
-    delete process;
+    DeleteProcess(process);
     return NULL;
   }
 
@@ -113,7 +159,7 @@ Process* Program::SpawnProcess(Process* parent) {
   if (process->AllocationFailed()) {
     // Delete the half-built process, we will retry after a GC.
     process->Cleanup(Signal::kTerminated);
-    delete process;
+    DeleteProcess(process);
     return NULL;
   }
 
@@ -177,13 +223,31 @@ bool Program::ScheduleProcessForDeletion(Process* process, Signal::Kind kind) {
     }
 
     RemoveFromProcessList(current);
-    delete current;
+    DeleteProcess(current);
 
     current = parent;
   }
   return true;
 }
 
+void Program::DeleteProcess(Process* process) {
+  ASSERT(!process_list_.IsInList(process));
+  if (process->has_private_heap()) {
+    // The private new-space can only be referenced from the process and from
+    // old-space objects, and the process is dead. Old-space garbage may
+    // still point into it, though, so promote whatever that reaches before
+    // the new-space is freed.
+    TwoSpaceHeap* heap = process->heap();
+    heap->PromoteAllOnNextScavenge();
+    {
+      NoAllocationFailureScope scope(heap->old_space());
+      ScavengeNewSpace(heap);
+    }
+    ASSERT(heap->HasEmptyNewSpace());
+  }
+  delete process;
+}
+
 void Program::VisitProcesses(ProcessVisitor* visitor) {
   for (auto process : process_list_) {
     visitor->VisitProcess(process);
@@ -297,6 +361,9 @@ void Program::PrepareProgramGC() {
   // 2) A new-space GC, which will be precise, due to the old-space GC.
   //    (No floating garbage with pointers from old- to new-space.)
   CollectNewSpace();
+  for (auto private_heap : *process_heap()->private_heaps()) {
+    ScavengeNewSpace(private_heap);
+  }
   //    Now we have no floating garbage stacks.  We do:
   // 3) An old-space GC which (in the generational config) will find no
   //    garbage, but as a side effect it will chain up all the stacks (also
@@ -328,6 +395,10 @@ void Program::PerformProgramGC(SemiSpace* to, PointerVisitor* visitor) {
     // Iterate program roots.
     IterateRoots(visitor);
 
+    // Compiled code is kept across program GCs, and its functions move.
+    Jit* jit = Jit::GlobalInstance();
+    if (jit != NULL) jit->IterateProgramPointers(this, visitor);
+
     // Iterate all pointers from processes to program space.
     IterateProgramPointersVisitor process_visitor(visitor);
     VisitProcesses(&process_visitor);
@@ -335,6 +406,9 @@ void Program::PerformProgramGC(SemiSpace* to, PointerVisitor* visitor) {
     // Iterate all pointers from the process heap to program space.
     CookedHeapObjectPointerVisitor flaf(visitor);
     process_heap()->IterateObjects(&flaf);
+    for (auto private_heap : *process_heap()->private_heaps()) {
+      private_heap->IterateObjects(&flaf);
+    }
 
     // Finish collection.
     ASSERT(!to->is_empty());
@@ -347,6 +421,7 @@ class FinishProgramGCVisitor : public ProcessVisitor {
  public:
   virtual void VisitProcess(Process* process) {
     process->UpdateBreakpoints();
+    process->ClearCatchTableCache();
   }
 };
 
@@ -357,6 +432,15 @@ void Program::FinishProgramGC() {
   FinishProgramGCVisitor visitor;
   VisitProcesses(&visitor);
 
+  // The pretenuring decisions are keyed by class, and classes have moved.
+  process_heap()->ClearPretenuring();
+  for (auto private_heap : *process_heap()->private_heaps()) {
+    private_heap->ClearPretenuring();
+  }
+
+  // The inline caches are keyed by bytecode pointer, and functions have moved.
+  if (inline_cache_ != NULL) inline_cache_->Clear(CountCallSites());
+
   if (debug_info_ != NULL) debug_info_->UpdateBreakpoints();
 
   VerifyObjectPlacements();
@@ -402,6 +486,12 @@ void Program::ValidateSharedHeap() {
 
   process_heap()->IterateObjects(&pointer_visitor);
   process_heap()->VisitWeakObjectPointers(&validator);
+
+  for (auto private_heap : *process_heap()->private_heaps()) {
+    HeapPointerValidator private_validator(&heap_, private_heap);
+    HeapObjectPointerVisitor private_pointer_visitor(&private_validator);
+    private_heap->IterateObjects(&private_pointer_visitor);
+  }
 #endif
 }
 
@@ -554,16 +644,100 @@ ProcessHandle* Program::MainProcess() {
 
 void Program::EnsureDebuggerAttached() {
   if (debug_info_ == NULL) {
+    // Breakpoints only work in the interpreter, and stop at every bytecode.
+    Jit* jit = Jit::GlobalInstance();
+    if (jit != NULL) jit->DiscardCode(this);
+    UnfuseBytecodes();
+    quicken_static_loads_ = 0;
     debug_info_ = new ProgramDebugInfo();
   }
 }
 
+// Rewrites the bytecodes of all functions: the first bytecode of all pairs
+// that have a superinstruction, or the bytecodes that have a quickened
+// variant, and back.
+class FunctionRewritingVisitor : public HeapObjectVisitor {
+ public:
+  enum Mode { kFuse, kUnfuse, kQuicken, kDequickenStaticLoads };
+
+  explicit FunctionRewritingVisitor(Mode mode) : mode_(mode) {}
+
+  virtual uword Visit(HeapObject* object) {
+    uword size = object->Size();
+    if (object->IsFunction()) Process(Function::cast(object));
+    return size;
+  }
+
+ private:
+  const Mode mode_;
+
+  void Process(Function* function) {
+    uint8* bcp = function->bytecode_address_for(0);
+    while (*bcp != kMethodEnd) {
+      Opcode opcode = Bytecode::Unfuse(static_cast<Opcode>(*bcp));
+      uint8* next = bcp + Bytecode::Size(opcode);
+      switch (mode_) {
+        case kFuse:
+          *bcp = Bytecode::Fuse(opcode,
+                                Bytecode::Unfuse(static_cast<Opcode>(*next)));
+          break;
+        case kUnfuse:
+          *bcp = opcode;
+          break;
+        case kQuicken:
+          if (*bcp == kInvokeMethod) *bcp = QuickenInvokeMethod(bcp);
+          break;
+        case kDequickenStaticLoads:
+          if (*bcp == kLoadStaticInitialized) *bcp = kLoadStaticInit;
+          break;
+      }
+      bcp = next;
+    }
+  }
+
+  static Opcode QuickenInvokeMethod(uint8* bcp) {
+    int arity = Selector::ArityField::decode(Utils::ReadInt32(bcp + 1));
+    if (arity >= Bytecode::kNumInvokeMethodArities) return kInvokeMethod;
+    return static_cast<Opcode>(kInvokeMethod0 + arity);
+  }
+};
+
+void Program::FuseBytecodes() {
+  FunctionRewritingVisitor visitor(FunctionRewritingVisitor::kFuse);
+  heap()->IterateObjects(&visitor);
+}
+
+void Program::UnfuseBytecodes() {
+  FunctionRewritingVisitor visitor(FunctionRewritingVisitor::kUnfuse);
+  heap()->IterateObjects(&visitor);
+}
+
+void Program::QuickenBytecodes() {
+  FunctionRewritingVisitor visitor(FunctionRewritingVisitor::kQuicken);
+  heap()->IterateObjects(&visitor);
+}
+
+void Program::DequickenStaticLoads() {
+  FunctionRewritingVisitor visitor(
+      FunctionRewritingVisitor::kDequickenStaticLoads);
+  heap()->IterateObjects(&visitor);
+}
+
+void Program::StopQuickeningStaticLoads() {
+  if (quicken_static_loads_ == 0) return;
+  quicken_static_loads_ = 0;
+  DequickenStaticLoads();
+}
+
 struct SharedHeapUsage {
   uint64 timestamp = 0;
   uword shared_used = 0;
   uword shared_size = 0;
   uword shared_used_2 = 0;
   uword shared_size_2 = 0;
+  uword largest_free_2 = 0;
+  uword resident_2 = 0;
+  uword mark_overflows = 0;
 };
 
 static void GetSharedHeapUsage(TwoSpaceHeap* heap,
@@ -573,6 +747,11 @@ static void GetSharedHeapUsage(TwoSpaceHeap* heap,
   heap_usage->shared_size = heap->space()->Size();
   heap_usage->shared_used_2 = heap->old_space()->Used();
   heap_usage->shared_size_2 = heap->old_space()->Size();
+  heap_usage->largest_free_2 =
+      heap->old_space()->free_list()->LargestChunkSize();
+  heap_usage->resident_2 =
+      heap_usage->shared_size_2 - heap->old_space()->discarded();
+  heap_usage->mark_overflows = MarkingStack::overflow_count();
 }
 
 static void PrintProgramGCInfo(SharedHeapUsage* before,
@@ -581,9 +760,14 @@ static void PrintProgramGCInfo(SharedHeapUsage* before,
   Print::Error(
       "Old-space-GC(%i):   "
       "\t%lli us,   "
-      "\t\t\t\t\t%lu/%lu -> %lu/%lu\n",
+      "\t\t\t\t\t%lu/%lu -> %lu/%lu,   "
+      "\tlargest free %lu,   "
+      "\tresident %lu,   "
+      "\tmarking stack overflows %lu\n",
       count++, after->timestamp - before->timestamp, before->shared_used_2,
-      before->shared_size_2, after->shared_used_2, after->shared_size_2);
+      before->shared_size_2, after->shared_used_2, after->shared_size_2,
+      after->largest_free_2, after->resident_2,
+      after->mark_overflows - before->mark_overflows);
 }
 
 void Program::CollectOldSpace() {
@@ -597,6 +781,7 @@ void Program::CollectOldSpace() {
   }
 
   PerformSharedGarbageCollection();
+  TakeRequestedHeapCensus();
 
   if (Flags::print_heap_statistics) {
     SharedHeapUsage usage_after;
@@ -617,12 +802,20 @@ void Program::PerformSharedGarbageCollection() {
   TwoSpaceHeap* heap = process_heap();
   OldSpace* old_space = heap->old_space();
   SemiSpace* new_space = heap->space();
+  GCPhaseTimer timer;
+
+  // Compaction can move sampled objects that are not yet recorded.
+  heap->allocation_sampler()->FinishSample();
+  for (auto private_heap : *heap->private_heaps()) {
+    private_heap->allocation_sampler()->FinishSample();
+  }
   MarkingStack stack;
   MarkingVisitor marking_visitor(new_space, &stack);
 
   IterateSharedHeapRoots(&marking_visitor);
 
-  stack.Process(&marking_visitor, old_space, new_space);
+  ProcessMarkingStack(&stack, &marking_visitor);
+  timer.EndPhase(DARTINO_GC_PHASE_MARK);
 
   if (old_space->compacting()) {
     // If the last GC was compacting we don't have fragmentation, so it
@@ -631,22 +824,24 @@ void Program::PerformSharedGarbageCollection() {
     old_space->EvaluatePointlessness();
     old_space->clear_hard_limit_hit();
     // Do a non-compacting GC this time for speed.
-    SweepSharedHeap();
+    SweepSharedHeap(&timer);
   } else {
     // Last GC was sweeping, so we do a compaction this time to avoid
     // fragmentation.
     old_space->clear_hard_limit_hit();
-    CompactSharedHeap();
+    CompactSharedHeap(&timer);
   }
 
   heap->AdjustOldAllocationBudget();
+  gc_statistics_.RecordOldSpaceGC(timer, heap);
+  FinalizerQueue::Dispatch();
 
 #ifdef DEBUG
   if (Flags::validate_heaps) old_space->Verify();
 #endif
 }
 
-void Program::SweepSharedHeap() {
+void Program::SweepSharedHeap(GCPhaseTimer* timer) {
   TwoSpaceHeap* heap = process_heap();
   OldSpace* old_space = heap->old_space();
   SemiSpace* new_space = heap->space();
@@ -658,14 +853,21 @@ void Program::SweepSharedHeap() {
   for (auto process : process_list_) {
     process->set_ports(Port::CleanupPorts(old_space, process->ports()));
   }
+  timer->EndPhase(DARTINO_GC_PHASE_MARK_WEAK);
+
+  old_space->FreeDeadLargeObjects();
 
   // Sweep over the old-space and rebuild the freelist.
   SweepingVisitor sweeping_visitor(old_space);
   old_space->IterateObjects(&sweeping_visitor);
+  old_space->DiscardFreeMemory();
 
   // These are only needed during the mark phase, we can clear them without
   // looking at them.
   new_space->ClearMarkBits();
+  for (auto private_heap : *heap->private_heaps()) {
+    private_heap->space()->ClearMarkBits();
+  }
 
   for (auto process : process_list_) process->UpdateStackLimit();
 
@@ -673,9 +875,10 @@ void Program::SweepSharedHeap() {
   old_space->set_used(used_after);
   old_space->set_used_after_last_gc(used_after);
   heap->AdjustOldAllocationBudget();
+  timer->EndPhase(DARTINO_GC_PHASE_SWEEP);
 }
 
-void Program::CompactSharedHeap() {
+void Program::CompactSharedHeap(GCPhaseTimer* timer) {
   TwoSpaceHeap* heap = process_heap();
   OldSpace* old_space = heap->old_space();
   SemiSpace* new_space = heap->space();
@@ -686,6 +889,8 @@ void Program::CompactSharedHeap() {
 
   old_space->ClearFreeList();
 
+  timer->EndPhase(DARTINO_GC_PHASE_COMPACT);
+
   // Weak processing when the destination addresses have been calculated, but
   // before they are moved (which ruins the liveness data).
   old_space->ProcessWeakPointers();
@@ -693,6 +898,9 @@ void Program::CompactSharedHeap() {
   for (auto process : process_list_) {
     process->set_ports(Port::CleanupPorts(old_space, process->ports()));
   }
+  timer->EndPhase(DARTINO_GC_PHASE_MARK_WEAK);
+
+  old_space->FreeDeadLargeObjects();
 
   old_space->ZapObjectStarts();
 
@@ -706,12 +914,18 @@ void Program::CompactSharedHeap() {
 
   HeapObjectPointerVisitor new_space_visitor(&fix);
   new_space->IterateObjects(&new_space_visitor);
+  for (auto private_heap : *heap->private_heaps()) {
+    private_heap->space()->IterateObjects(&new_space_visitor);
+    private_heap->space()->ClearMarkBits();
+  }
 
   IterateSharedHeapRoots(&fix);
 
   new_space->ClearMarkBits();
   old_space->ClearMarkBits();
   old_space->MarkChunkEndsFree();
+  old_space->DiscardFreeMemory();
+  timer->EndPhase(DARTINO_GC_PHASE_COMPACT);
 }
 
 class StatisticsVisitor : public HeapObjectVisitor {
@@ -1082,6 +1296,7 @@ void Program::VerifyObjectPlacements() {
 
 void Program::IterateRoots(PointerVisitor* visitor) {
   IterateRootsIgnoringSession(visitor);
+  allocation_profiler_.VisitProgramPointers(visitor);
   if (debug_info_ != NULL) {
     debug_info_->VisitProgramPointers(visitor);
   }
@@ -1152,6 +1367,7 @@ struct HeapUsage {
   uword immutable_size = 0;
   uword program_used = 0;
   uword program_size = 0;
+  uword semispace_size = 0;
 
   uword TotalUsed() { return process_used + immutable_used + program_used; }
   uword TotalSize() { return process_used + immutable_size + program_size; }
@@ -1163,6 +1379,7 @@ static void GetHeapUsage(TwoSpaceHeap* heap, HeapUsage* heap_usage) {
   heap_usage->process_size = heap->space()->Size();
   heap_usage->program_used = heap->old_space()->Used();
   heap_usage->program_size = heap->old_space()->Size();
+  heap_usage->semispace_size = heap->semispace_size();
 }
 
 void PrintProcessGCInfo(HeapUsage* before, HeapUsage* after) {
@@ -1171,29 +1388,37 @@ void PrintProcessGCInfo(HeapUsage* before, HeapUsage* after) {
     Print::Error(
         "New-space-GC,\t\tElapsed, "
         "\tNew-space use/sizeu,"
-        "\t\tOld-space use/size\n");
+        "\t\tOld-space use/size,"
+        "\tSemispace size\n");
   }
   Print::Error(
       "New-space-GC(%i): "
       "\t%lli us,   "
       "\t%lu/%lu -> %lu/%lu,   "
-      "\t%lu/%lu -> %lu/%lu\n",
+      "\t%lu/%lu -> %lu/%lu,   "
+      "\t%lu -> %lu\n",
       count++, after->timestamp - before->timestamp, before->process_used,
       before->process_size, after->process_used, after->process_size,
       before->program_used, before->program_size, after->program_used,
-      after->program_size);
+      after->program_size, before->semispace_size, after->semispace_size);
 }
 
 // Somewhat misnamed - it does a scavenge of the data area used by the
 // processes, not the code area used by the program.
-void Program::CollectNewSpace() {
-  HeapUsage usage_before;
+void Program::CollectNewSpace() { ScavengeNewSpace(process_heap()); }
 
-  TwoSpaceHeap* data_heap = process_heap();
+void Program::CollectNewSpace(Process* process) {
+  ScavengeNewSpace(process->heap());
+}
+
+void Program::ScavengeNewSpace(TwoSpaceHeap* data_heap) {
+  HeapUsage usage_before;
 
   SemiSpace* from = data_heap->space();
   OldSpace* old = data_heap->old_space();
 
+  data_heap->allocation_sampler()->FinishSample();
+
   if (data_heap->HasEmptyNewSpace()) {
     CollectOldSpaceIfNeeded(false);
     return;
@@ -1213,6 +1438,7 @@ void Program::CollectNewSpace() {
   SemiSpace* to = data_heap->unused_space();
 
   uword old_used = old->Used();
+  GCPhaseTimer timer;
 
   to->set_used(0);
   // Allocate from start of to-space..
@@ -1222,9 +1448,11 @@ void Program::CollectNewSpace() {
   to->StartScavenge();
   old->StartScavenge();
 
-  IterateSharedHeapRoots(&visitor);
+  IterateHeapRoots(data_heap, &visitor);
+  timer.EndPhase(DARTINO_GC_PHASE_SCAVENGE_ROOTS);
 
   old->VisitRememberedSet(&visitor);
+  timer.EndPhase(DARTINO_GC_PHASE_SCAVENGE_REMEMBERED_SET);
 
   bool work_found = true;
   while (work_found) {
@@ -1232,15 +1460,24 @@ void Program::CollectNewSpace() {
     work_found |= old->CompleteScavengeGenerational(&visitor);
   }
   old->EndScavenge();
+  timer.EndPhase(DARTINO_GC_PHASE_SCAVENGE_COPY);
 
   from->ProcessWeakPointers(to, old);
 
   for (auto process : process_list_) {
     process->set_ports(Port::CleanupPorts(from, process->ports()));
   }
+  timer.EndPhase(DARTINO_GC_PHASE_SCAVENGE_WEAK);
 
-  // Second space argument is used to size the new-space.
+  uword from_used = from->Used();
+  uword promoted = old->Used() - old_used;
+  uword survived = to->Used() + promoted;
   data_heap->SwapSemiSpaces();
+  data_heap->AdjustSemiSpaceSize(from_used, survived, timer.start());
+  if (Flags::pretenure) data_heap->UpdatePretenuring();
+  gc_statistics_.RecordScavenge(timer, from_used, survived - promoted,
+                                promoted, data_heap);
+  FinalizerQueue::Dispatch();
 
   if (Flags::print_heap_statistics) {
     HeapUsage usage_after;
@@ -1252,9 +1489,9 @@ void Program::CollectNewSpace() {
   if (Flags::validate_heaps) old->Verify();
 #endif
 
-  ASSERT(from->Used() >= to->Used());
+  ASSERT(from_used >= to->Used());
   // Find out how much garbage was found.
-  word progress = (from->Used() - to->Used()) - (old->Used() - old_used);
+  word progress = from_used - survived;
   // There's a little overhead when allocating in old space which was not there
   // in new space, so we might overstate the number of promoted bytes a little,
   // which could result in an understatement of the garbage found, even to make
@@ -1268,7 +1505,7 @@ void Program::CollectNewSpace() {
 
 void Program::CollectOldSpaceIfNeeded(bool force) {
   OldSpace* old = process_heap_.old_space();
-  if (force || old->needs_garbage_collection()) {
+  if (force || old->needs_garbage_collection() || HeapCensusRequested()) {
     old->Flush();
     CollectOldSpace();
 #ifdef DEBUG
@@ -1277,35 +1514,90 @@ void Program::CollectOldSpaceIfNeeded(bool force) {
   }
 }
 
+void Program::RequestHeapCensus(const char* path) {
+  free(heap_census_path_.exchange(strdup(path)));
+}
+
+bool Program::WriteAllocationProfile(const char* path) {
+  return allocation_profiler_.WriteToFile(path,
+                                          Flags::allocation_sample_interval);
+}
+
+bool Program::HeapCensusRequested() {
+  return heap_census_path_ != NULL || HeapCensus::signal_pending();
+}
+
+void Program::TakeRequestedHeapCensus() {
+  char* path = heap_census_path_.exchange(NULL);
+  if (path == NULL && HeapCensus::TakeSignalRequest()) {
+    static Atomic<int> signal_census_count(0);
+    int count = signal_census_count++;
+    int length = strlen(Flags::heap_census_file) + 16;
+    path = static_cast<char*>(malloc(length));
+    snprintf(path, length, "%s.%d", Flags::heap_census_file, count);
+  }
+  if (path == NULL) return;
+  HeapCensus census(this);
+  census.Take();
+  if (!census.WriteToFile(path)) {
+    Print::Error("Could not write heap census to '%s'\n", path);
+  }
+  free(path);
+}
+
 void Program::UpdateStackLimits() {
   for (auto process : process_list_) process->UpdateStackLimit();
 }
 
 void Program::IterateSharedHeapRoots(PointerVisitor* visitor) {
-  // All processes share the same heap, so we need to iterate all roots from
-  // all processes.
+  // All processes share the same old-space, so we need to iterate all roots
+  // from all processes.
   for (auto process : process_list_) process->IterateRoots(visitor);
   visitor->Visit(reinterpret_cast<Object**>(&stack_chain_));
 }
 
+void Program::IterateHeapRoots(TwoSpaceHeap* heap, PointerVisitor* visitor) {
+  // Only the owner of a private heap can reach its new-space, and processes
+  // allocating in the shared heap never reach into a private new-space.
+  for (auto process : process_list_) {
+    if (process->heap() == heap) process->IterateRoots(visitor);
+  }
+  visitor->Visit(reinterpret_cast<Object**>(&stack_chain_));
+}
+
+void Program::ProcessMarkingStack(MarkingStack* stack,
+                                  PointerVisitor* visitor) {
+  TwoSpaceHeap* heap = process_heap();
+  // Objects in the private new-spaces can overflow the marking stack too, so
+  // keep going until none of the spaces has overflowed objects left.
+  do {
+    stack->Process(visitor, heap->old_space(), heap->space());
+    for (auto private_heap : *heap->private_heaps()) {
+      private_heap->space()->IterateOverflowedObjects(visitor, stack);
+    }
+  } while (!stack->IsEmpty() || stack->IsOverflowed());
+}
+
 int Program::CollectMutableGarbageAndChainStacks() {
   // Mark all reachable objects.
-  OldSpace* old_space = process_heap()->old_space();
   SemiSpace* new_space = process_heap()->space();
+  GCPhaseTimer timer;
   MarkingStack marking_stack;
   ASSERT(stack_chain_ == NULL);
   MarkingVisitor marking_visitor(new_space, &marking_stack, &stack_chain_);
 
   IterateSharedHeapRoots(&marking_visitor);
 
-  marking_stack.Process(&marking_visitor, old_space, new_space);
+  ProcessMarkingStack(&marking_stack, &marking_visitor);
+  timer.EndPhase(DARTINO_GC_PHASE_MARK);
 
-  CompactSharedHeap();
+  CompactSharedHeap(&timer);
+  gc_statistics_.RecordOldSpaceGC(timer, process_heap());
 
   UpdateStackLimits();
 
 #ifdef DEBUG
-  if (Flags::validate_heaps) old_space->Verify();
+  if (Flags::validate_heaps) process_heap()->old_space()->Verify();
 #endif
 
   return marking_visitor.number_of_stacks();
@@ -1363,8 +1655,44 @@ LookupCache* Program::EnsureCache() {
   return cache_;
 }
 
+class CallSiteCountingVisitor : public HeapObjectVisitor {
+ public:
+  CallSiteCountingVisitor() : count_(0) {}
+
+  int count() const { return count_; }
+
+  virtual uword Visit(HeapObject* object) {
+    if (object->IsFunction()) Count(Function::cast(object));
+    return object->Size();
+  }
+
+ private:
+  int count_;
+
+  void Count(Function* function) {
+    uint8* bcp = function->bytecode_address_for(0);
+    while (*bcp != kMethodEnd) {
+      Opcode opcode = Bytecode::Unfuse(static_cast<Opcode>(*bcp));
+      if (opcode == kInvokeMethod || opcode == kInvokeMethodUnfold) count_++;
+      bcp += Bytecode::Size(opcode);
+    }
+  }
+};
+
+int Program::CountCallSites() {
+  CallSiteCountingVisitor visitor;
+  heap()->IterateObjects(&visitor);
+  return visitor.count();
+}
+
+InlineCache* Program::EnsureInlineCache() {
+  if (inline_cache_ == NULL) inline_cache_ = new InlineCache(CountCallSites());
+  return inline_cache_;
+}
+
 void Program::ClearCache() {
   if (cache_ != NULL) cache_->Clear();
+  if (inline_cache_ != NULL) inline_cache_->Clear(CountCallSites());
 }
 
 #ifdef DEBUG
@@ -7,9 +7,12 @@
 
 #include "src/shared/globals.h"
 #include "src/shared/random.h"
+#include "src/vm/allocation_profiler.h"
 #include "src/vm/debug_info.h"
 #include "src/vm/double_list.h"
+#include "src/vm/gc_statistics.h"
 #include "src/vm/heap.h"
+#include "src/vm/inline_cache.h"
 #include "src/vm/lookup_cache.h"
 #include "src/vm/links.h"
 #include "src/vm/program_folder.h"
@@ -21,10 +24,12 @@ typedef void (*ProgramExitListener)(Program*, int exitcode, void* data);
 
 class Class;
 class Function;
+class MarkingStack;
 class Method;
 class PopularityCounter;
 class Process;
 class ProcessVisitor;
+class ProgramImage;
 class ProgramTableRewriter;
 class Scheduler;
 class Session;
@@ -259,7 +264,10 @@ class Program : public ProgramList::Entry {
     return NULL;
   }
 
-  Process* SpawnProcess(Process* parent);
+  // A process spawned with [private_heap] gets a new-space of its own,
+  // which is scavenged without visiting the other processes and freed when
+  // the process is deleted.
+  Process* SpawnProcess(Process* parent, bool private_heap = false);
   Process* ProcessSpawnForMain(List<List<uint8>> arguments);
   // Returns [true] if this was the last process (i.e. main process).
   bool ScheduleProcessForDeletion(Process* process, Signal::Kind kind);
@@ -292,10 +300,24 @@ class Program : public ProgramList::Entry {
   void CollectOldSpace();
   void CollectOldSpaceIfNeeded(bool force);
   void CollectNewSpace();
+  // Collect the new-space [process] allocates in.
+  void CollectNewSpace(Process* process);
   void PerformSharedGarbageCollection();
 
   void PrintStatistics();
 
+  GCStatistics* gc_statistics() { return &gc_statistics_; }
+
+  // Ask for a heap census to be written to [path] after the next old-space
+  // GC, which the request brings forward to the next scavenge.
+  void RequestHeapCensus(const char* path);
+
+  AllocationProfiler* allocation_profiler() { return &allocation_profiler_; }
+
+  // Writes the allocation samples taken so far to [path]. Returns false if
+  // the file could not be written.
+  bool WriteAllocationProfile(const char* path);
+
   // Iterates over all roots in the program.
   void IterateRoots(PointerVisitor* visitor);
   void IterateRootsIgnoringSession(PointerVisitor* visitor);
@@ -323,6 +345,10 @@ class Program : public ProgramList::Entry {
   ROOTS_DO(ROOT_ACCESSOR)
 #undef ROOT_ACCESSOR
 
+  // The word the interpreter checks before it quickens a static load.
+  static const int kQuickenStaticLoadsOffset =
+      kFirstRootOffset + sizeof(void*) * kNumberOfRoots;
+
   RandomXorShift* random() { return &random_; }
 
   void PrepareProgramGC();
@@ -345,18 +371,47 @@ class Program : public ProgramList::Entry {
 
   LookupCache* cache() const { return cache_; }
   LookupCache* EnsureCache();
+  // Clears the lookup cache and the inline caches.
   void ClearCache();
 
+  InlineCache* inline_cache() const { return inline_cache_; }
+  // Creates the inline caches, with room for all call sites of the program.
+  InlineCache* EnsureInlineCache();
+
   ProcessHandle* MainProcess();
 
   ProgramDebugInfo* debug_info() { return debug_info_; }
   void EnsureDebuggerAttached();
 
+  // Rewrites common pairs of bytecodes in all functions into
+  // superinstructions, and back. The bytecodes keep their size and offsets.
+  // Unfusing also reverts quickened bytecodes.
+  void FuseBytecodes();
+  void UnfuseBytecodes();
+
+  // Rewrites the invokes of methods with few arguments in all functions
+  // into the quickened variants for their arity.
+  void QuickenBytecodes();
+
+  // Reverts the static loads the interpreter has quickened. Their statics
+  // are only known to be initialized in the process that ran them.
+  void DequickenStaticLoads();
+  // Reverts them, and keeps the interpreter from quickening them again.
+  void StopQuickeningStaticLoads();
+  // Keeps the interpreter from quickening static loads, without looking for
+  // quickened ones. For programs with a read-only heap.
+  void DisableStaticLoadQuickening() { quicken_static_loads_ = 0; }
+
+  // The program image the heap is mapped from, if any. The program unmaps it
+  // when it is deleted.
+  void set_image(ProgramImage* image) { image_ = image; }
+
 #ifdef DEBUG
   void Find(uword address);
 #endif
 
  private:
+  friend class HeapCensus;
   friend class ProgramGroups;
 
   // Program GC support. Cook the stack to rewrite bytecode pointers
@@ -367,9 +422,18 @@ class Program : public ProgramList::Entry {
   void UncookAndUnchainStacks();
   bool stacks_are_cooked() { return !cooked_stack_deltas_.is_empty(); }
   void UpdateStackLimits();
-  void CompactSharedHeap();
-  void SweepSharedHeap();
+  void CompactSharedHeap(GCPhaseTimer* timer);
+  void SweepSharedHeap(GCPhaseTimer* timer);
   void IterateSharedHeapRoots(PointerVisitor* visitor);
+  // Iterate the roots of the processes that allocate in [heap].
+  void IterateHeapRoots(TwoSpaceHeap* heap, PointerVisitor* visitor);
+  void ScavengeNewSpace(TwoSpaceHeap* data_heap);
+  bool HeapCensusRequested();
+  void TakeRequestedHeapCensus();
+  void ProcessMarkingStack(MarkingStack* stack, PointerVisitor* visitor);
+  void DeleteProcess(Process* process);
+  // The number of method invocations in the functions of the program.
+  int CountCallSites();
 
   // Access to the address of the first and last root.
   Object** first_root_address() {
@@ -390,6 +454,12 @@ class Program : public ProgramList::Entry {
   ROOTS_DO(ROOT_DECLARATION)
 #undef ROOT_DECLARATION
 
+  // Non-zero while the interpreter may quicken static loads. Static loads
+  // are only quickened in the first process of the program, as each process
+  // has its own statics.
+  uword quicken_static_loads_;
+  int spawned_processes_;
+
   // Chained doubly linked list of all processes protected by a lock.
   Mutex* process_list_mutex_;
   ProcessList process_list_;
@@ -398,6 +468,8 @@ class Program : public ProgramList::Entry {
 
   OneSpaceHeap heap_;
   TwoSpaceHeap process_heap_;
+  GCStatistics gc_statistics_;
+  AllocationProfiler allocation_profiler_;
 
   Scheduler* scheduler_;
   ProgramState program_state_;
@@ -420,10 +492,16 @@ class Program : public ProgramList::Entry {
   List<List<int>> cooked_stack_deltas_;
 
   LookupCache* cache_;
+  InlineCache* inline_cache_;
 
   ProgramDebugInfo* debug_info_;
 
+  ProgramImage* image_;
+
   uword group_mask_;
+
+  // The file the next heap census goes to, or NULL if none is requested.
+  Atomic<char*> heap_census_path_;
 };
 
 }  // namespace dartino
@@ -11,8 +11,10 @@
 #include "src/shared/names.h"
 #include "src/shared/selectors.h"
 
+#include "src/vm/bytecode_profiler.h"
 #include "src/vm/hash_map.h"
 #include "src/vm/heap.h"
+#include "src/vm/jit.h"
 #include "src/vm/program.h"
 #include "src/vm/selector_row.h"
 #include "src/vm/vector.h"
@@ -344,6 +346,10 @@ void ProgramFolder::Fold() {
   // the program is stopped?
   ASSERT(!program_->is_optimized());
 
+  // The compiled code is for the bytecodes that are about to be rewritten.
+  Jit* jit = Jit::GlobalInstance();
+  if (jit != NULL) jit->DiscardCode(program_);
+
   ClassLocatingVisitor class_locator;
   program_->heap()->IterateObjects(&class_locator);
 
@@ -363,7 +369,18 @@ void ProgramFolder::Fold() {
     FunctionOptimizingVisitor visitor(&rewriter);
     program()->heap()->IterateObjects(&visitor);
 
-    program()->SetupDispatchTableIntrinsics();
+    // Superinstructions would hide bytecodes from a debugger and from the
+    // bytecode profiler.
+    if (Flags::superinstructions && program()->debug_info() == NULL &&
+        BytecodeProfiler::GlobalInstance() == NULL) {
+      program()->FuseBytecodes();
+    }
+    if (Flags::quickening && program()->debug_info() == NULL) {
+      program()->QuickenBytecodes();
+    }
+
+    program()->SetupDispatchTableIntrinsics(IntrinsicsTable::GetDefault(),
+                                            Jit::MethodEntry());
   }
 }
 
@@ -373,9 +390,17 @@ void ProgramFolder::Unfold() {
   // the program is stopped?
   ASSERT(program_->is_optimized());
 
+  // The compiled code is for the bytecodes that are about to be rewritten.
+  Jit* jit = Jit::GlobalInstance();
+  if (jit != NULL) jit->DiscardCode(program_);
+
   // Ensure the tick sampler knows the program has changed.
   program_->set_snapshot_hash(0);
 
+  // The rewriting below only knows the bytecodes the compiler emits.
+  // Unfusing also reverts the quickened ones.
+  program_->UnfuseBytecodes();
+
   // Run through the dispatch table and compute a map from selector offsets
   // to the original selectors. This is used when rewriting the
   // bytecodes back to the original invoke-method bytecodes.
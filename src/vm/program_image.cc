@@ -0,0 +1,155 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/program_image.h"
+
+#include <string.h>
+
+#include "src/shared/platform.h"
+#include "src/shared/utils.h"
+#include "src/shared/version.h"
+#include "src/vm/intrinsics.h"
+#include "src/vm/jit.h"
+#include "src/vm/object_memory.h"
+#include "src/vm/program.h"
+#include "src/vm/program_info_block.h"
+
+namespace dartino {
+
+#ifdef DARTINO64
+const uword ProgramImage::kBase = UWORD_C(0x200000000000);
+#else
+const uword ProgramImage::kBase = UWORD_C(0x60000000);
+#endif
+
+ProgramImage::~ProgramImage() { Platform::UnmapFile(address_, size_); }
+
+void ProgramImage::InitializeHeader(Header* header, uword heap_size,
+                                    uword section_size,
+                                    uword relocation_count) {
+  memset(header, 0, sizeof(*header));
+  header->magic = kMagic;
+  header->word_size = kWordSize;
+  strncpy(header->version, GetVersion(), sizeof(header->version) - 1);
+  header->base = kBase;
+  header->heap_offset = Platform::kPageSize;
+  header->heap_size = heap_size;
+  header->section_size = section_size;
+  header->relocations_offset = header->heap_offset + section_size;
+  header->relocation_count = relocation_count;
+}
+
+static bool IsCompatible(const ProgramImage::Header& header) {
+  if (header.magic != ProgramImage::kMagic) return false;
+  if (header.word_size != kWordSize) return false;
+  const char* version = GetVersion();
+  if (!Version::Check(version, strlen(version), header.version,
+                      strnlen(header.version, sizeof(header.version)))) {
+    return false;
+  }
+  return header.heap_offset % Platform::kPageSize == 0 &&
+         header.relocations_offset % Platform::kPageSize == 0 &&
+         header.heap_size + sizeof(ProgramInfoBlock) <= header.section_size;
+}
+
+// Rebases the pointers in the heap part of the image at [path], which is
+// mapped at [heap] instead of at its base address.
+static bool Rebase(const char* path, const ProgramImage::Header& header,
+                   uint8* heap) {
+  uword size = header.relocation_count * sizeof(uint32);
+  if (size == 0) return true;
+  void* relocations =
+      Platform::MapFile(path, header.relocations_offset, size, NULL);
+  if (relocations == NULL) return false;
+  uint32* offsets = reinterpret_cast<uint32*>(relocations);
+  uword delta = reinterpret_cast<uword>(heap) - header.base;
+  bool valid = true;
+  for (uword i = 0; i < header.relocation_count; i++) {
+    if (offsets[i] > header.section_size - kWordSize) {
+      valid = false;
+      break;
+    }
+    *reinterpret_cast<uword*>(heap + offsets[i]) += delta;
+  }
+  Platform::UnmapFile(relocations, size);
+  return valid;
+}
+
+// The dispatch table holds the addresses of the intrinsics and the method
+// entry of the VM that wrote the image, which move with the VM binary. Only
+// the entries that differ are written, but that saves little: a VM built as
+// a position-independent executable is loaded at a random address on every
+// run, so nearly every entry differs and every page of the table becomes
+// private. The pages only stay shared when the VM binary is loaded at a
+// fixed address, and the writing VM was the same binary.
+static void UpdateDispatchTableCode(Program* program) {
+  Array* table = program->dispatch_table();
+  IntrinsicsTable* intrinsics = IntrinsicsTable::GetDefault();
+  void* method_entry = Jit::MethodEntry();
+  for (int i = 0; i < table->length(); i++) {
+    DispatchTableEntry* entry = DispatchTableEntry::cast(table->get(i));
+    void* code = entry->target()->ComputeIntrinsic(intrinsics);
+    if (code == NULL) code = method_entry;
+    if (entry->code() != code) entry->set_code(code);
+  }
+}
+
+Program* ProgramImage::Load(const char* path) { return Load(path, true); }
+
+Program* ProgramImage::LoadRebasedForTesting(const char* path) {
+  return Load(path, false);
+}
+
+// Platform::MapFile fails for files that end before the part it maps, so
+// truncated images are rejected rather than faulting when a page past the
+// end of the file is touched.
+Program* ProgramImage::Load(const char* path, bool at_base) {
+  void* first_page = Platform::MapFile(path, 0, Platform::kPageSize, NULL);
+  if (first_page == NULL) return NULL;
+  Header header;
+  memcpy(&header, first_page, sizeof(header));
+  Platform::UnmapFile(first_page, Platform::kPageSize);
+  if (!IsCompatible(header)) return NULL;
+
+  void* base = reinterpret_cast<void*>(header.base);
+  uint8* heap = reinterpret_cast<uint8*>(Platform::MapFile(
+      path, header.heap_offset, header.section_size, at_base ? base : NULL));
+  if (heap == NULL) return NULL;
+  Program* program = NULL;
+  if (heap == base || Rebase(path, header, heap)) {
+    program = ProgramFromRelocatedHeap(
+        heap, header.heap_size + sizeof(ProgramInfoBlock));
+  }
+  if (program == NULL) {
+    Platform::UnmapFile(heap, header.section_size);
+    return NULL;
+  }
+
+  UpdateDispatchTableCode(program);
+  Platform::ProtectMappedFile(heap, header.section_size);
+  program->set_image(new ProgramImage(heap, header.section_size));
+  return program;
+}
+
+Program* ProgramImage::ProgramFromRelocatedHeap(void* heap, uword size) {
+  // The info block is appended at the end of the heap.
+  uword heap_size = size - sizeof(ProgramInfoBlock);
+  uword block_address = reinterpret_cast<uword>(heap) + heap_size;
+  ProgramInfoBlock* program_info =
+      reinterpret_cast<ProgramInfoBlock*>(block_address);
+  if (!ProgramInfoBlock::MightBeProgramInfoBlock(program_info)) {
+    return NULL;
+  }
+  Program* program = new Program(Program::kLoadedFromSnapshot);
+  program_info->WriteToProgram(program);
+  Chunk* memory =
+      ObjectMemory::CreateFlashChunk(program->heap()->space(), heap, heap_size);
+
+  program->heap()->space()->Append(memory);
+  program->heap()->space()->SetReadOnly();
+  program->DisableStaticLoadQuickening();
+  return program;
+}
+
+}  // namespace dartino
@@ -0,0 +1,89 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_PROGRAM_IMAGE_H_
+#define SRC_VM_PROGRAM_IMAGE_H_
+
+#include "src/shared/globals.h"
+
+namespace dartino {
+
+class Program;
+
+// A program image is a file with a relocated program heap, which the VM maps
+// into memory instead of reading and decoding a snapshot. Programs then start
+// in about the same time whatever their size, and VMs that run the same image
+// share its pages. An image holds, each part starting at a page boundary:
+//
+//   header:      the magic, the VM version, the base address of the heap and
+//                the offsets and sizes of the other parts
+//   heap:        the program heap relocated to the base address, followed by
+//                its ProgramInfoBlock, as for a program heap in flash
+//   relocations: the offsets into the heap part of the words that point into
+//                the heap, as 32 bit integers
+//
+// The loader maps the heap at its base address if that range is free, and
+// then does not look at the relocations. Otherwise it rebases the pointers
+// where the heap was mapped, which makes the pages it writes private to the
+// VM. Either way it points the dispatch table at the intrinsics of the
+// running VM, which with address space randomization writes, and makes
+// private, every page of the table. Then it makes the heap read-only. Images are written by the
+// ProgramImageWriter of the relocation library.
+class ProgramImage {
+ public:
+  struct Header {
+    uint32 magic;
+    uint32 word_size;
+    char version[128];
+    uint64 base;
+    uint64 heap_offset;
+    // The size of the program heap, without its info block.
+    uint64 heap_size;
+    // The size of the heap part, with the info block and up to a page
+    // boundary.
+    uint64 section_size;
+    uint64 relocations_offset;
+    uint64 relocation_count;
+  };
+
+  static const uint32 kMagic = 0xDA1E1A6E;
+
+  // The address images are relocated to when they are written.
+  static const uword kBase;
+
+  ~ProgramImage();
+
+  // Fills in the header of an image with [section_size] bytes of heap part,
+  // which holds a program heap of [heap_size] bytes, and [relocation_count]
+  // relocations.
+  static void InitializeHeader(Header* header, uword heap_size,
+                               uword section_size, uword relocation_count);
+
+  // Returns the program of the image at [path], or NULL if the file is not
+  // an image for this VM or could not be mapped. The program owns the
+  // mapping of the image.
+  static Program* Load(const char* path);
+
+  // Like Load, but leaves it to the system where to map the heap, so the
+  // loader rebases it unless the system picks the base address. For testing.
+  static Program* LoadRebasedForTesting(const char* path);
+
+  // Returns the program of the relocated program heap at [heap], which is
+  // followed by its ProgramInfoBlock, [size] bytes in all. Returns NULL if
+  // there is no info block. The program does not write to or free [heap].
+  static Program* ProgramFromRelocatedHeap(void* heap, uword size);
+
+ private:
+  ProgramImage(void* address, uword size) : address_(address), size_(size) {}
+
+  // Maps the heap at its base address if [at_base] is set.
+  static Program* Load(const char* path, bool at_base);
+
+  void* address_;
+  uword size_;
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_PROGRAM_IMAGE_H_
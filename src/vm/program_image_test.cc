@@ -0,0 +1,191 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "src/shared/assert.h"
+#include "src/shared/bytecodes.h"
+#include "src/shared/platform.h"
+#include "src/shared/random.h"
+#include "src/shared/test_case.h"
+#include "src/shared/utils.h"
+#include "src/vm/interpreter.h"
+#include "src/vm/jit.h"
+#include "src/vm/object.h"
+#include "src/vm/program.h"
+#include "src/vm/program_image.h"
+#include "src/vm/program_relocator.h"
+#include "src/vm/scheduler.h"
+
+namespace dartino {
+
+static Function* NewFunction(Program* program, int arity, uint8* bytecodes,
+                             int length) {
+  // Append the method end, which holds the offset of itself.
+  uint8 bytes[64];
+  ASSERT(length + kMethodEndLength <= static_cast<int>(sizeof(bytes)));
+  memcpy(bytes, bytecodes, length);
+  bytes[length] = kMethodEnd;
+  Utils::WriteInt32(&bytes[length + 1], length << 1);
+  List<uint8> list(bytes, length + kMethodEndLength);
+  return Function::cast(program->CreateFunction(arity, list, 0));
+}
+
+// Writes an image of a program that checks that its lazily initialized
+// static is 42, and returns its path.
+static char* WriteTestImage() {
+  Program* program = new Program(Program::kLoadedFromSnapshot);
+  program->Initialize();
+
+  uint8 initializer[] = {kLoadLiteral, 42, kReturn};
+  Function* initializer_function =
+      NewFunction(program, 0, initializer, sizeof(initializer));
+  // A literal string and a const instance, hashed by ProgramImageHashes.
+  Array* statics = Array::cast(program->CreateArray(3));
+  statics->set(0, program->CreateInitializer(initializer_function));
+  statics->set(1, program->CreateStringFromAscii(List<const char>("key", 3)));
+  Class* klass = Class::cast(program->CreateClass(0));
+  statics->set(2, program->CreateInstance(klass));
+  program->set_static_fields(statics);
+
+  uint8 entry[] = {
+      kLoadStaticInit, 0, 0, 0, 0,
+      kLoadLiteral, 42,
+      kInvokeEq, 0, 0, 0, 0,
+      kBranchIfTrueWide, 8, 0, 0, 0,
+      kLoadLiteral, Interpreter::kCompileTimeError,
+      kProcessYield,
+      kLoadLiteral, Interpreter::kTerminate,
+      kProcessYield};
+  Function* entry_function = NewFunction(program, 0, entry, sizeof(entry));
+  program->set_entry(entry_function);
+
+  // The loader points the dispatch table at the method entry of this VM.
+  Array* table = Array::cast(program->CreateArray(1));
+  DispatchTableEntry* table_entry =
+      DispatchTableEntry::cast(program->CreateDispatchTableEntry());
+  table_entry->set_target(initializer_function);
+  table_entry->set_code(NULL);
+  table->set(0, table_entry);
+  program->set_dispatch_table(table);
+
+  char* path = strdup("/tmp/program_image_XXXXXX");
+  int fd = mkstemp(path);
+  EXPECT(fd >= 0);
+  close(fd);
+  EXPECT(ProgramImageWriter::Write(program, path));
+  delete program;
+  return path;
+}
+
+// Runs the program of an image, and returns its exit code.
+static int RunImage(Program* program) {
+  DispatchTableEntry* table_entry =
+      DispatchTableEntry::cast(program->dispatch_table()->get(0));
+  EXPECT(table_entry->code() == Jit::MethodEntry());
+  SimpleProgramRunner runner;
+  int exitcode = -1;
+  runner.Run(1, &exitcode, &program, 0, NULL);
+  delete program;
+  return exitcode;
+}
+
+static uword HeapStart(Program* program) {
+  return program->heap()->space()->start();
+}
+
+TEST_CASE(ProgramImageRunAtBase) {
+  char* path = WriteTestImage();
+  // Nothing else in the test is mapped at the base address.
+  Program* program = ProgramImage::Load(path);
+  EXPECT(program != NULL);
+  EXPECT_EQ(ProgramImage::kBase, HeapStart(program));
+  EXPECT_EQ(0, RunImage(program));
+  unlink(path);
+  free(path);
+}
+
+TEST_CASE(ProgramImageRunRebased) {
+  char* path = WriteTestImage();
+  Program* program = ProgramImage::LoadRebasedForTesting(path);
+  EXPECT(program != NULL);
+  EXPECT(HeapStart(program) != ProgramImage::kBase);
+  EXPECT_EQ(0, RunImage(program));
+  unlink(path);
+  free(path);
+}
+
+// The heap of an image is read-only, so hashing its strings and instances
+// must not store the hash.
+TEST_CASE(ProgramImageHashes) {
+  char* path = WriteTestImage();
+  Program* program = ProgramImage::Load(path);
+  EXPECT(program != NULL);
+  Array* statics = program->static_fields();
+  OneByteString* string = OneByteString::cast(statics->get(1));
+  EXPECT(string->hash_value() != 0);
+  EXPECT_EQ(string->hash_value(), string->Hash());
+  Instance* instance = Instance::cast(statics->get(2));
+  RandomXorShift random;
+  Smi* hash_code = instance->LazyIdentityHashCode(&random);
+  EXPECT(hash_code->value() != 0);
+  EXPECT_EQ(hash_code, instance->LazyIdentityHashCode(&random));
+  delete program;
+  unlink(path);
+  free(path);
+}
+
+// Stores the first [length] bytes of [image] at [path].
+static void StoreTruncated(const char* path, List<uint8> image, int length) {
+  List<uint8> truncated(image.data(), length);
+  EXPECT(Platform::StoreFile(path, truncated));
+}
+
+TEST_CASE(ProgramImageRejectsInvalidImages) {
+  char* path = WriteTestImage();
+  List<uint8> image = Platform::LoadFile(path);
+  ProgramImage::Header header;
+  memcpy(&header, image.data(), sizeof(header));
+  int heap_end = static_cast<int>(header.heap_offset + header.section_size);
+  int relocations_end = static_cast<int>(
+      header.relocations_offset + header.relocation_count * sizeof(uint32));
+  EXPECT_EQ(relocations_end, image.length());
+  EXPECT(header.relocation_count > 0);
+
+  // Images of other VMs.
+  ProgramImage::Header* stored =
+      reinterpret_cast<ProgramImage::Header*>(image.data());
+  stored->magic++;
+  EXPECT(Platform::StoreFile(path, image));
+  EXPECT(ProgramImage::Load(path) == NULL);
+  stored->magic--;
+  stored->version[0]++;
+  EXPECT(Platform::StoreFile(path, image));
+  EXPECT(ProgramImage::Load(path) == NULL);
+  stored->version[0]--;
+
+  // Files that end before the parts the header describes.
+  StoreTruncated(path, image, Platform::kPageSize / 2);
+  EXPECT(ProgramImage::Load(path) == NULL);
+  StoreTruncated(path, image, heap_end - Platform::kPageSize);
+  EXPECT(ProgramImage::Load(path) == NULL);
+  EXPECT(ProgramImage::LoadRebasedForTesting(path) == NULL);
+  // The relocations are only read when the heap is rebased.
+  StoreTruncated(path, image, relocations_end - 4);
+  EXPECT(ProgramImage::LoadRebasedForTesting(path) == NULL);
+
+  // The image itself is fine.
+  EXPECT(Platform::StoreFile(path, image));
+  Program* program = ProgramImage::LoadRebasedForTesting(path);
+  EXPECT(program != NULL);
+  EXPECT_EQ(0, RunImage(program));
+
+  image.Delete();
+  unlink(path);
+  free(path);
+}
+
+}  // namespace dartino
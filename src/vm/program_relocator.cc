@@ -3,9 +3,14 @@
 // BSD-style license that can be found in the LICENSE.md file.
 
 #include "src/shared/assert.h"
+#include "src/shared/platform.h"
+#include "src/shared/random.h"
+#include "src/shared/utils.h"
 
+#include "src/vm/program_image.h"
 #include "src/vm/program_info_block.h"
 #include "src/vm/program_relocator.h"
+#include "src/vm/vector.h"
 
 #ifdef VERBOSE
 #define DEBUG_PRINT(...) fprintf(stderr, __VA_ARGS__)
@@ -162,4 +167,95 @@ int ProgramHeapRelocator::Relocate() {
   return total_size;
 }
 
+// Helper class that can be used as a visitor when iterating pointers to
+// record the offsets, from [base], of the slots that hold heap pointers.
+class RelocationRecordingVisitor : public PointerVisitor {
+ public:
+  RelocationRecordingVisitor(uword base, Vector<uint32>* offsets)
+      : base_(base), offsets_(offsets) {}
+
+  void VisitBlock(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) {
+      if (!(*p)->IsHeapObject()) continue;
+      offsets_->PushBack(reinterpret_cast<uword>(p) - base_);
+    }
+  }
+
+ private:
+  uword base_;
+  Vector<uint32>* offsets_;
+};
+
+// Computes the hashes that are otherwise stored lazily into strings and
+// instances the first time they are asked for, since the heap of an image
+// is mapped read-only.
+class HashPrecomputingVisitor : public HeapObjectVisitor {
+ public:
+  virtual uword Visit(HeapObject* object) {
+    if (object->IsOneByteString()) {
+      OneByteString::cast(object)->Hash();
+    } else if (object->IsTwoByteString()) {
+      TwoByteString::cast(object)->Hash();
+    } else if (object->IsInstance()) {
+      Instance::cast(object)->LazyIdentityHashCode(&random_);
+    }
+    return object->Size();
+  }
+
+ private:
+  // A fixed seed keeps images of the same program identical.
+  RandomXorShift random_;
+};
+
+bool ProgramImageWriter::Write(Program* program, const char* path) {
+  ASSERT(program->is_optimized());
+  // The interpreter only quickens static loads for the process that ran
+  // them, and it does not write to the heap of an image.
+  program->DequickenStaticLoads();
+
+  HashPrecomputingVisitor hasher;
+  program->heap()->IterateObjects(&hasher);
+
+  SemiSpace* space = program->heap()->space();
+  uword heap_size = program->program_heap_size();
+  uword section_size = Utils::RoundUp(heap_size + sizeof(ProgramInfoBlock),
+                                      Platform::kPageSize);
+
+  Vector<uint32> relocations;
+  RelocationRecordingVisitor heap_recorder(space->start(), &relocations);
+  HeapObjectPointerVisitor visitor(&heap_recorder);
+  space->IterateObjects(&visitor);
+
+  List<uint8> section = List<uint8>::New(section_size);
+  memset(section.data(), 0, section_size);
+  ProgramHeapRelocator relocator(program, section.data(), ProgramImage::kBase);
+  relocator.Relocate();
+
+  // The roots in the info block point into the heap too.
+  uword section_start = reinterpret_cast<uword>(section.data());
+  ProgramInfoBlock* program_info =
+      reinterpret_cast<ProgramInfoBlock*>(section_start + heap_size);
+  RelocationRecordingVisitor roots_recorder(section_start, &relocations);
+  roots_recorder.VisitBlock(
+      program_info->roots(),
+      reinterpret_cast<Object**>(program_info->end_of_roots()));
+
+  ProgramImage::Header header;
+  ProgramImage::InitializeHeader(&header, heap_size, section_size,
+                                 relocations.size());
+  uword relocations_size = relocations.size() * sizeof(uint32);
+  List<uint8> image =
+      List<uint8>::New(header.relocations_offset + relocations_size);
+  memset(image.data(), 0, header.heap_offset);
+  memcpy(image.data(), &header, sizeof(header));
+  memcpy(image.data() + header.heap_offset, section.data(), section_size);
+  memcpy(image.data() + header.relocations_offset, relocations.Data(),
+         relocations_size);
+  section.Delete();
+
+  bool result = Platform::StoreFile(path, image);
+  image.Delete();
+  return result;
+}
+
 }  // namespace dartino
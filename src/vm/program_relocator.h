@@ -33,6 +33,14 @@ class ProgramHeapRelocator {
   void* method_entry_;
 };
 
+// Writes program images, see ProgramImage.
+class ProgramImageWriter {
+ public:
+  // Writes the optimized [program] as an image to the file at [path].
+  // Returns false if the file could not be written.
+  static bool Write(Program* program, const char* path);
+};
+
 }  // namespace dartino
 
 #endif  // SRC_VM_PROGRAM_RELOCATOR_H_
@@ -15,6 +15,7 @@
 #include "src/shared/version.h"
 
 #include "src/vm/frame.h"
+#include "src/vm/heap_census.h"
 #include "src/vm/heap_validator.h"
 #include "src/vm/native_interpreter.h"
 #include "src/vm/links.h"
@@ -185,6 +186,46 @@ static void MessageProcessingError(const char* message) {
   Platform::Exit(-1);
 }
 
+static void WriteGCPauseHistogram(WriteBuffer* buffer,
+                                  const DartinoGCPauseHistogram& histogram) {
+  buffer->WriteInt64(histogram.count);
+  buffer->WriteInt64(histogram.total_us);
+  buffer->WriteInt64(histogram.max_us);
+  for (int i = 0; i < DARTINO_GC_PAUSE_BUCKETS; i++) {
+    buffer->WriteInt64(histogram.buckets[i]);
+  }
+}
+
+// Writes the fields of [statistics] in declaration order, preceded by the
+// number of histogram buckets and phases.
+static void WriteGCStatistics(WriteBuffer* buffer,
+                              const DartinoGCStatistics& statistics) {
+  buffer->WriteInt(DARTINO_GC_PAUSE_BUCKETS);
+  buffer->WriteInt(DARTINO_GC_PHASE_COUNT);
+  buffer->WriteInt64(statistics.scavenges);
+  buffer->WriteInt64(statistics.old_space_gcs);
+  WriteGCPauseHistogram(buffer, statistics.scavenge_pauses);
+  WriteGCPauseHistogram(buffer, statistics.old_space_pauses);
+  for (int i = 0; i < DARTINO_GC_PHASE_COUNT; i++) {
+    WriteGCPauseHistogram(buffer, statistics.phase_pauses[i]);
+  }
+  buffer->WriteInt64(statistics.bytes_scavenged);
+  buffer->WriteInt64(statistics.bytes_survived);
+  buffer->WriteInt64(statistics.bytes_promoted);
+  buffer->WriteInt64(statistics.new_space_used);
+  buffer->WriteInt64(statistics.new_space_size);
+  buffer->WriteInt64(statistics.old_space_used);
+  buffer->WriteInt64(statistics.old_space_size);
+  buffer->WriteInt64(statistics.old_space_resident);
+  buffer->WriteInt64(statistics.old_space_free);
+  buffer->WriteInt64(statistics.old_space_largest_free);
+  buffer->WriteInt64(statistics.foreign_memory);
+  buffer->WriteInt64(statistics.stack_growths);
+  buffer->WriteInt64(statistics.stack_words_copied);
+  buffer->WriteInt64(statistics.stack_growth_gcs);
+  buffer->WriteInt64(statistics.largest_stack);
+}
+
 // The initial session state is the state awaiting a handshake.
 class InitialState : public SessionState {
  public:
@@ -868,6 +909,15 @@ SessionState* SessionState::ProcessMessage(Connection::Opcode opcode) {
       break;
     }
 
+    case Connection::kGCStatistics: {
+      DartinoGCStatistics statistics;
+      program()->gc_statistics()->Get(&statistics);
+      WriteBuffer buffer;
+      WriteGCStatistics(&buffer, statistics);
+      connection()->Send(Connection::kGCStatisticsResult, buffer);
+      break;
+    }
+
 #ifdef DARTINO_ENABLE_LIVE_CODING
     case Connection::kSetEntryPoint: {
       program()->set_entry(Function::cast(session()->Pop()));
@@ -1322,6 +1372,22 @@ SessionState* PausedState::ProcessMessage(Connection::Opcode opcode) {
   process()->EnsureDebuggerAttached();
   ASSERT(!process()->debug_info()->is_stepping());
   switch (opcode) {
+    case Connection::kHeapCensus: {
+      HeapCensus census(program());
+      census.Take();
+      const Vector<HeapCensus::ClassEntry>& classes = census.classes();
+      WriteBuffer buffer;
+      buffer.WriteInt(classes.size());
+      for (size_t i = 0; i < classes.size(); i++) {
+        buffer.WriteInt64(session()->ClassMessage(classes[i].klass));
+        buffer.WriteInt64(classes[i].count);
+        buffer.WriteInt64(classes[i].size);
+        buffer.WriteInt64(classes[i].retained);
+      }
+      connection()->Send(Connection::kHeapCensusResult, buffer);
+      break;
+    }
+
     case Connection::kProcessDeleteOneShotBreakpoint: {
       WriteBuffer buffer;
       int process_id = connection()->ReadInt();
@@ -1601,6 +1667,9 @@ bool Session::CreateSnapshot(
 
   program()->VerifyObjectPlacements();
 
+  // The statics of processes running the snapshot start out uninitialized.
+  program()->DequickenStaticLoads();
+
   SnapshotWriter writer(function_offsets, class_offsets);
   List<uint8> snapshot = writer.WriteProgram(program());
   bool success = writeToDisk
@@ -1994,8 +2063,25 @@ bool Session::CommitChanges(int count) {
 
   // Free up as much space as possible so we don't run out of space when
   // transforming instances.
-  program()->CollectNewSpace();
-  program()->CollectNewSpace();
+  TwoSpaceHeap* process_heap = program()->process_heap();
+  if (!process_heap->private_heaps()->IsEmpty()) {
+    // Instances in a private new-space are only reachable from its process.
+    // Empty all the new-spaces into the shared old-space, where the
+    // transformed clones go too, so no process ends up pointing into the
+    // new-space of another.
+    NoAllocationFailureScope scope(process_heap->old_space());
+    process_heap->PromoteAllOnNextScavenge();
+    program()->CollectNewSpace();
+    for (auto process : *program()->process_list()) {
+      if (!process->has_private_heap()) continue;
+      process->heap()->PromoteAllOnNextScavenge();
+      program()->CollectNewSpace(process);
+      ASSERT(process->heap()->HasEmptyNewSpace());
+    }
+  } else {
+    program()->CollectNewSpace();
+    program()->CollectNewSpace();
+  }
   program()->PerformSharedGarbageCollection();
 
   if (count != PostponedChange::number_of_changes()) {
@@ -2170,8 +2256,10 @@ void Session::ChangeState(SessionState* new_state) {
 
 class TransformInstancesPointerVisitor : public PointerVisitor {
  public:
-  explicit TransformInstancesPointerVisitor(Heap* heap)
-      : heap_(heap) {}
+  // If [old_space_clones] is set, [heap] must be a TwoSpaceHeap and the
+  // clones are allocated in its old-space.
+  TransformInstancesPointerVisitor(Heap* heap, bool old_space_clones)
+      : heap_(heap), old_space_clones_(old_space_clones) {}
 
   virtual void VisitClass(Object** p) {
     // The class pointer in the header of an object should not
@@ -2197,7 +2285,7 @@ class TransformInstancesPointerVisitor : public PointerVisitor {
                      instance->address()));
           // TODO(erikcorry): We should clone old-space objects into
           // old-space to avoid having up update the remembered set.
-          clone = instance->CloneTransformed(heap_);
+          clone = instance->CloneTransformed(heap_, old_space_clones_);
           instance->set_forwarding_address(clone);
           *p = clone;
           if (GCMetadata::GetPageType(clone->address()) == kNewSpacePage) {
@@ -2215,6 +2303,7 @@ class TransformInstancesPointerVisitor : public PointerVisitor {
 
  private:
   Heap* const heap_;
+  const bool old_space_clones_;
   uword current_object_address_;
 };
 
@@ -2232,7 +2321,7 @@ void Session::TransformInstances() {
 
   SemiSpace* space = program()->heap()->space();
   NoAllocationFailureScope scope(space);
-  TransformInstancesPointerVisitor program_visitor(program()->heap());
+  TransformInstancesPointerVisitor program_visitor(program()->heap(), false);
   program()->IterateRoots(&program_visitor);
   ASSERT(!space->is_empty());
   space->CompleteTransformations(&program_visitor);
@@ -2245,7 +2334,11 @@ void Session::TransformInstances() {
   // When we rewrite objects we just expand the old space, so don't allow
   // allocations to fail there.
   NoAllocationFailureScope scope2(process_heap->old_space());
-  TransformInstancesPointerVisitor process_heap_visitor(process_heap);
+  // With private heaps, CommitChanges has emptied the new-spaces, and the
+  // clones go to the old-space that all the processes share.
+  bool has_private_heaps = !process_heap->private_heaps()->IsEmpty();
+  TransformInstancesPointerVisitor process_heap_visitor(process_heap,
+                                                        has_private_heaps);
 
   for (auto process : *program()->process_list()) {
     process->IterateRoots(&process_heap_visitor);
@@ -14,6 +14,7 @@
 #include "src/shared/utils.h"
 #include "src/shared/version.h"
 
+#include "src/vm/jit.h"
 #include "src/vm/object.h"
 #include "src/vm/program.h"
 
@@ -439,6 +440,8 @@ word SnapshotReader::ReadWord() {
     } else if (opcode == kSnapshotSmi) {
       return x;
     } else if (opcode == kSnapshotExternal) {
+      // The method entry depends on whether the JIT is on.
+      if (x == 0) return reinterpret_cast<word>(Jit::MethodEntry());
       return intrinsics_table_[x];
     } else {
       ASSERT(opcode == kSnapshotRaw);
@@ -627,10 +630,7 @@ class ObjectWriter : public PointerVisitor {
   }
     INTRINSICS_DO(V)
 #undef V
-    if (intrinsic == 0) {
-      void* method_entry = reinterpret_cast<void*>(InterpreterMethodEntry);
-      ASSERT(code == method_entry);
-    }
+    if (intrinsic == 0) ASSERT(Jit::IsMethodEntry(code));
     WriteOpcode(kSnapshotExternal, intrinsic);
     current_ += kWordSize;
   }
@@ -0,0 +1,38 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/stack_pool.h"
+
+#include "src/shared/utils.h"
+#include "src/vm/object.h"
+
+namespace dartino {
+
+Stack* StackPool::Take(int length) {
+  int index = IndexOf(length);
+  if (index < 0 || counts_[index] == 0) return NULL;
+  Stack* stack = stacks_[index][--counts_[index]];
+  ASSERT(stack->length() == length);
+  stack->set_top(0);
+  stack->set_next(Smi::FromWord(0));
+  return stack;
+}
+
+void StackPool::Give(Stack* stack) {
+  int index = IndexOf(stack->length());
+  if (index < 0 || counts_[index] == kStacksPerLength) return;
+  stacks_[index][counts_[index]++] = stack;
+}
+
+void StackPool::Clear() {
+  for (int i = 0; i < kLengths; i++) counts_[i] = 0;
+}
+
+int StackPool::IndexOf(int length) {
+  if (length < kSmallestLength || !Utils::IsPowerOfTwo(length)) return -1;
+  int index = Utils::HighestBit(length) - Utils::HighestBit(kSmallestLength);
+  return index < kLengths ? index : -1;
+}
+
+}  // namespace dartino
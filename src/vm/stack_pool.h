@@ -0,0 +1,51 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_STACK_POOL_H_
+#define SRC_VM_STACK_POOL_H_
+
+#include "src/shared/globals.h"
+
+namespace dartino {
+
+class Stack;
+
+// The stacks a process has stopped using, by length, so the next stack of
+// the same length does not have to be allocated. A process gives up a stack
+// when it grows it, when a coroutine is done, and when a throw unwinds
+// coroutines. Only lengths of a power of two words from the initial stack
+// size up are pooled, which are the lengths new stacks and grown stacks get.
+//
+// Nothing else refers to the stacks in the pool, so the GC does not visit
+// it. Instead the process empties it whenever its heap is collected.
+class StackPool {
+ public:
+  static const int kSmallestLength = 256;
+  static const int kLengths = 6;
+  static const int kStacksPerLength = 4;
+
+  StackPool() { Clear(); }
+
+  // Returns a stack of [length] words from the pool, or NULL if there is
+  // none. The contents of the stack are undefined.
+  Stack* Take(int length);
+
+  // Adds [stack] to the pool, unless its length is not pooled or the pool
+  // already has enough stacks of that length.
+  void Give(Stack* stack);
+
+  void Clear();
+
+ private:
+  // Returns the index into [stacks_] of [length], or -1 if stacks of that
+  // length are not pooled.
+  static int IndexOf(int length);
+
+  int counts_[kLengths];
+  Stack* stacks_[kLengths][kStacksPerLength];
+};
+
+}  // namespace dartino
+
+#endif  // SRC_VM_STACK_POOL_H_
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <sys/time.h>
 
+#include "src/shared/flags.h"
 #include "src/shared/platform.h"
 #include "src/shared/utils.h"
 
@@ -48,6 +49,7 @@ void Thread::SetupOSSignals() {
   sigset_t set;
   sigfillset(&set);
   sigdelset(&set, SIGPROF);
+  if (Flags::heap_census_signal) sigdelset(&set, SIGUSR2);
   if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
     FATAL("Failed to block signal on thread");
   }
@@ -16,6 +16,7 @@
 #include "src/shared/utils.h"
 
 #include "src/vm/process.h"
+#include "src/vm/profile_header.h"
 #include "src/vm/tick_queue.h"
 #include "src/vm/thread.h"
 
@@ -118,18 +119,7 @@ class TickProcessor {
       FATAL("Tick file could not be opened for writing");
     }
     fprintf(file, "# Tick samples from the Dartino VM.\n");
-    const char* model;
-    if (kPointerSize == 8 && sizeof(dartino_double) == 8) {
-      model = "b64double";
-    } else if (kPointerSize == 8 && sizeof(dartino_double) == 4) {
-      model = "b64float";
-    } else if (kPointerSize == 4 && sizeof(dartino_double) == 8) {
-      model = "b32double";
-    } else {
-      ASSERT(kPointerSize == 4 && sizeof(dartino_double) == 4);
-      model = "b32float";
-    }
-    fprintf(file, "model=%s\n", model);
+    fprintf(file, "model=%s\n", MemoryModel());
     bool timed_out;
     do {
       { // Ensure the monitor is locked before calling wait.
@@ -46,6 +46,12 @@
         }],
       ],
       'sources': [
+        'allocation_profiler.cc',
+        'allocation_profiler.h',
+        'bytecode_profiler.cc',
+        'bytecode_profiler.h',
+        'catch_table.cc',
+        'catch_table.h',
         'dartino_api_impl.cc',
         'dartino_api_impl.h',
         'dartino.cc',
@@ -64,17 +70,27 @@
         'event_handler_macos.cc',
         'event_handler_posix.cc',
         'event_handler_windows.cc',
+        'finalizer_queue.cc',
+        'finalizer_queue.h',
         'gc_metadata.cc',
         'gc_metadata.h',
+        'gc_statistics.cc',
+        'gc_statistics.h',
         'hash_map.h',
         'hash_set.h',
         'hash_table.h',
         'heap.cc',
+        'heap_census.cc',
+        'heap_census.h',
         'heap.h',
         'heap_validator.cc',
         'heap_validator.h',
+        'inline_cache.cc',
+        'inline_cache.h',
         'intrinsics.cc',
         'intrinsics.h',
+        'jit.cc',
+        'jit.h',
         'links.cc',
         'links.h',
         'log_print_interceptor.cc',
@@ -107,12 +123,16 @@
         'pair.h',
         'port.cc',
         'port.h',
+        'pretenuring.cc',
+        'pretenuring.h',
         'priority_heap.h',
         'process.cc',
         'process.h',
         'process_handle.cc',
         'process_handle.h',
         'process_queue.h',
+        'profile_header.cc',
+        'profile_header.h',
         'program.cc',
         'program_folder.cc',
         'program_folder.h',
@@ -120,6 +140,8 @@
         'program_groups.cc',
         'program_groups.h',
         'program.h',
+        'program_image.cc',
+        'program_image.h',
         'program_info_block.cc',
         'program_info_block.h',
         'scheduler.cc',
@@ -138,6 +160,8 @@
         'socket_connection_api_impl.h',
         'sort.cc',
         'sort.h',
+        'stack_pool.cc',
+        'stack_pool.h',
         'thread_cmsis.cc',
         'thread_cmsis.h',
         'thread.h',
@@ -194,6 +218,7 @@
       ],
       'sources': [
         '<(INTERMEDIATE_DIR)/generated<(asm_file_extension)',
+        'emitter_x64.h',
         'ffi.cc',
         'ffi.h',
         'ffi_callback.cc',
@@ -206,6 +231,9 @@
         'ffi_windows.cc',
         'interpreter.cc',
         'interpreter.h',
+        'jit_assembler_x64.cc',
+        'jit_assembler_x64.h',
+        'jit_x64.cc',
         'native_interpreter.cc',
         'native_interpreter.h',
         'preempter.cc',
@@ -309,6 +337,7 @@
         'assembler_x86_linux.cc',
         'assembler_x86_macos.cc',
         'assembler_x86_win.cc',
+        'emitter_x64.h',
         'ffi_bridge_arm.cc',
         'ffi_bridge_x64.cc',
         'ffi_bridge_x86.cc',
@@ -326,6 +355,7 @@
       'type': 'executable',
       'dependencies': [
         'libdartino',
+        'dartino_relocation_library',
       ],
       'sources': [
         'main.cc',
@@ -347,6 +377,7 @@
       'type': 'executable',
       'dependencies': [
         'libdartino',
+        'dartino_relocation_library',
         '../shared/shared.gyp:cc_test_base',
       ],
       'defines': [
@@ -356,13 +387,19 @@
       ],
       'sources': [
         # TODO(ahe): Add header (.h) files.
+        'bytecode_profiler_test.cc',
+        'catch_table_test.cc',
         'double_list_tests.cc',
+        'finalizer_queue_test.cc',
         'hash_table_test.cc',
+        'inline_cache_test.cc',
+        'jit_test.cc',
         'object_map_test.cc',
         'object_memory_test.cc',
         'object_test.cc',
         'platform_test.cc',
         'priority_heap_test.cc',
+        'program_image_test.cc',
         'vector_test.cc',
       ],
     },
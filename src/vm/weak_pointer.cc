@@ -4,8 +4,7 @@
 
 #include "src/vm/weak_pointer.h"
 
-#include <stdlib.h>
-
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/object.h"
 #include "src/vm/object_memory.h"
 
@@ -16,6 +15,7 @@ WeakPointer::WeakPointer(HeapObject* object, WeakPointerCallback callback,
     : object_(object),
       callback_(reinterpret_cast<void*>(callback)),
       arg_(arg),
+      next_(-1),
       external_(false) {}
 
 WeakPointer::WeakPointer(HeapObject* object,
@@ -23,6 +23,7 @@ WeakPointer::WeakPointer(HeapObject* object,
     : object_(object),
       callback_(reinterpret_cast<void*>(callback)),
       arg_(arg),
+      next_(-1),
       external_(true) {}
 
 void WeakPointer::Invoke() {
@@ -33,78 +34,153 @@ void WeakPointer::Invoke() {
   }
 }
 
-void WeakPointer::ProcessAndMoveSurvivors(WeakPointerList* pointers,
-                                          Space* from_space, Space* to_space,
-                                          Space* old_space) {
-  for (auto it = pointers->Begin(); it != pointers->End();) {
-    HeapObject* current_object = it->object_;
-    auto previous = *it;
-    it = pointers->Erase(it);
+void WeakPointerTable::Add(const WeakPointer& weak_pointer) {
+  int index = entries_.size();
+  entries_.PushBack(weak_pointer);
+  Index(index);
+}
+
+void WeakPointerTable::Index(int index) {
+  WeakPointer& weak_pointer = entries_[index];
+  uword key = KeyOf(weak_pointer.object_);
+  auto it = index_.Find(key);
+  if (it == index_.End()) {
+    weak_pointer.next_ = -1;
+    index_[key] = index;
+  } else {
+    weak_pointer.next_ = it->second;
+    it->second = index;
+  }
+}
+
+void WeakPointerTable::RebuildIndex() {
+  index_.Clear();
+  for (size_t i = 0; i < entries_.size(); i++) Index(i);
+}
+
+bool WeakPointerTable::Remove(HeapObject* object,
+                              ExternalWeakPointerCallback callback) {
+  auto it = index_.Find(KeyOf(object));
+  if (it == index_.End()) return false;
+  int previous = -1;
+  int index = it->second;
+  while (index != -1) {
+    WeakPointer& weak_pointer = entries_[index];
+    if ((weak_pointer.arg_ == NULL && callback == NULL) ||
+        weak_pointer.callback_ == reinterpret_cast<void*>(callback)) {
+      break;
+    }
+    previous = index;
+    index = weak_pointer.next_;
+  }
+  if (index == -1) return false;
+
+  // Unlink the weak pointer from the weak pointers to its object.
+  int next = entries_[index].next_;
+  if (previous != -1) {
+    entries_[previous].next_ = next;
+  } else if (next != -1) {
+    it->second = next;
+  } else {
+    index_.Erase(it);
+  }
+
+  // Fill the hole with the last weak pointer and redirect the link to it.
+  int last = entries_.size() - 1;
+  if (index != last) {
+    entries_[index] = entries_[last];
+    auto moved = index_.Find(KeyOf(entries_[index].object_));
+    ASSERT(moved != index_.End());
+    if (moved->second == last) {
+      moved->second = index;
+    } else {
+      int i = moved->second;
+      while (entries_[i].next_ != last) i = entries_[i].next_;
+      entries_[i].next_ = index;
+    }
+  }
+  entries_.PopBack();
+  return true;
+}
+
+// External callbacks only get their argument, so they can run after the GC
+// on the finalizer thread. The other callbacks get the dead object and run
+// now, but they queue their expensive parts as well.
+void WeakPointerTable::Finalize(Vector<WeakPointer>* dead) {
+  for (size_t i = 0; i < dead->size(); i++) {
+    WeakPointer& weak_pointer = (*dead)[i];
+    if (weak_pointer.external_) {
+      FinalizerQueue::Schedule(
+          reinterpret_cast<FinalizerQueue::Callback>(weak_pointer.callback_),
+          weak_pointer.arg_);
+    } else {
+      weak_pointer.Invoke();
+    }
+  }
+}
+
+// The callbacks are invoked after the tables have been updated, so they see
+// consistent tables if they register or remove weak pointers.
+void WeakPointerTable::ProcessAndMoveSurvivors(Space* from_space,
+                                               Space* to_space,
+                                               Space* old_space) {
+  Vector<WeakPointer> dead;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    WeakPointer weak_pointer = entries_[i];
+    HeapObject* current_object = weak_pointer.object_;
     ASSERT(from_space->Includes(current_object->address()));
     if (from_space->IsAlive(current_object)) {
-      HeapObject* new_object = previous->object_ =
+      HeapObject* new_object = weak_pointer.object_ =
           from_space->NewLocation(current_object);
       if (to_space->IsInSingleChunk(new_object)) {
-        to_space->weak_pointers()->Append(previous);
+        to_space->weak_pointers()->Add(weak_pointer);
       } else {
         ASSERT(old_space->Includes(new_object->address()));
-        old_space->weak_pointers()->Append(previous);
+        old_space->weak_pointers()->Add(weak_pointer);
       }
     } else {
-      // Object died.  Invoke
-      previous->Invoke();
-      delete previous;
+      dead.PushBack(weak_pointer);
     }
   }
+  entries_.Clear();
+  index_.Clear();
+  Finalize(&dead);
 }
 
-void WeakPointer::Process(WeakPointerList* pointers, OldSpace* space) {
-  for (auto it = pointers->Begin(); it != pointers->End();) {
-    HeapObject* current_object = it->object_;
+void WeakPointerTable::Process(OldSpace* space) {
+  Vector<WeakPointer> survivors;
+  Vector<WeakPointer> dead;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    WeakPointer weak_pointer = entries_[i];
+    HeapObject* current_object = weak_pointer.object_;
     ASSERT(space->Includes(current_object->address()));
-    if (!space->IsAlive(current_object)) {
-      auto previous = *it;
-      it = pointers->Erase(it);
-      // Object died.  Invoke
-      previous->Invoke();
-      delete previous;
+    if (space->IsAlive(current_object)) {
+      weak_pointer.object_ = space->NewLocation(current_object);
+      survivors.PushBack(weak_pointer);
     } else {
-      it->object_ = space->NewLocation(current_object);
-      ++it;
+      dead.PushBack(weak_pointer);
     }
   }
+  entries_.Swap(survivors);
+  RebuildIndex();
+  Finalize(&dead);
 }
 
-void WeakPointer::ForceCallbacks(WeakPointerList* pointers) {
-  for (auto it = pointers->Begin(); it != pointers->End();) {
-    it->Invoke();
-    auto previous = *it;
-    it = pointers->Erase(it);
-    delete previous;
-  }
-}
-
-bool WeakPointer::Remove(WeakPointerList* pointers, HeapObject* object,
-                         ExternalWeakPointerCallback callback) {
-  for (auto it = pointers->Begin(); it != pointers->End();) {
-    if (it->object_ == object && ((it->arg_ == NULL && callback == NULL) ||
-                                  (it->callback_ == callback))) {
-      auto previous = *it;
-      it = pointers->Erase(it);
-      delete previous;
-      return true;
-    } else {
-      ++it;
-    }
-  }
-  return false;
+void WeakPointerTable::ForceCallbacks() {
+  Vector<WeakPointer> dead;
+  entries_.Swap(dead);
+  index_.Clear();
+  for (size_t i = 0; i < dead.size(); i++) dead[i].Invoke();
+  // Hand over what the callbacks queued, there may not be another GC.
+  if (!dead.IsEmpty()) FinalizerQueue::Dispatch();
 }
 
-void WeakPointer::Visit(WeakPointerList* pointers,
-                        PointerVisitor* visitor) {
-  for (auto weak_pointer : *pointers) {
-    visitor->Visit(reinterpret_cast<Object**>(&weak_pointer->object_));
+void WeakPointerTable::Visit(PointerVisitor* visitor) {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    visitor->Visit(reinterpret_cast<Object**>(&entries_[i].object_));
   }
+  // The visitor may have moved the objects.
+  RebuildIndex();
 }
 
 }  // namespace dartino
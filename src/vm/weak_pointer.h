@@ -5,46 +5,89 @@
 #ifndef SRC_VM_WEAK_POINTER_H_
 #define SRC_VM_WEAK_POINTER_H_
 
-#include "src/vm/double_list.h"
+#include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
+#include "src/vm/vector.h"
 
 namespace dartino {
 
 class HeapObject;
 class Space;
-class Heap;
 class OldSpace;
 class PointerVisitor;
-class WeakPointer;
 
 typedef void (*WeakPointerCallback)(HeapObject* object, void* arg);
 typedef void (*ExternalWeakPointerCallback)(void* arg);
-typedef DoubleList<WeakPointer> WeakPointerList;
 
-class WeakPointer : public WeakPointerList::Entry {
+class WeakPointer {
  public:
   WeakPointer(HeapObject* object, WeakPointerCallback callback, void* arg);
 
   WeakPointer(HeapObject* object, ExternalWeakPointerCallback callback,
               void* arg);
 
-  static void Process(WeakPointerList* pointers, OldSpace* space);
-  static void ProcessAndMoveSurvivors(WeakPointerList* pointers,
-                                      Space* from_space, Space* to_space,
-                                      Space* old_space);
-  static void ForceCallbacks(WeakPointerList* pointers);
-  static bool Remove(WeakPointerList* pointers, HeapObject* object,
-                     ExternalWeakPointerCallback callback = nullptr);
-  static void Visit(WeakPointerList* pointers, PointerVisitor* visitor);
+  HeapObject* object() const { return object_; }
 
  private:
+  friend class WeakPointerTable;
+
   HeapObject* object_;
   void* callback_;
   void* arg_;
+  // The index of the next weak pointer to the same object in the table, or
+  // -1.
+  int next_;
   bool external_;
 
   void Invoke();
 };
 
+// The weak pointers to the objects in one space. They are kept in an array,
+// so a GC walks them without chasing list nodes, and the young and old
+// tables are separate, so a scavenge only looks at the weak pointers to
+// new-space objects. An index from objects to their weak pointers makes
+// removal constant time.
+class WeakPointerTable {
+ public:
+  bool IsEmpty() const { return entries_.IsEmpty(); }
+  size_t size() const { return entries_.size(); }
+
+  void Add(const WeakPointer& weak_pointer);
+
+  // Removes a weak pointer to [object]. Without a callback, only weak
+  // pointers that have no argument or no callback match.
+  bool Remove(HeapObject* object,
+              ExternalWeakPointerCallback callback = nullptr);
+
+  // Finalizes the weak pointers to dead objects and updates the others to the
+  // new locations of their objects. The survivors of a scavenge move to the
+  // table of the space they were copied to. External callbacks are queued on
+  // the FinalizerQueue.
+  void Process(OldSpace* space);
+  void ProcessAndMoveSurvivors(Space* from_space, Space* to_space,
+                               Space* old_space);
+
+  // Invokes all callbacks, for when the space goes away.
+  void ForceCallbacks();
+
+  void Visit(PointerVisitor* visitor);
+
+ private:
+  // Objects are word aligned, so the low bits of their addresses are left
+  // out of the index keys.
+  static uword KeyOf(HeapObject* object) {
+    return reinterpret_cast<uword>(object) >> kPointerSizeLog2;
+  }
+
+  void Index(int index);
+  void RebuildIndex();
+  static void Finalize(Vector<WeakPointer>* dead);
+
+  Vector<WeakPointer> entries_;
+  // Maps the objects to the index of their first weak pointer in entries_.
+  HashMap<uword, int> index_;
+};
+
 }  // namespace dartino
 
 #endif  // SRC_VM_WEAK_POINTER_H_
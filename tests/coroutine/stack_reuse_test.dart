@@ -0,0 +1,56 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Tests that the stacks of done coroutines, of coroutines unwound by a throw
+// and the stacks left behind by stack growth can be reused by new
+// coroutines.
+
+import 'dart:dartino';
+
+import 'package:expect/expect.dart';
+
+main() {
+  for (int i = 0; i < 100; i++) {
+    // Keep a suspended coroutine alive while others come and go, so its
+    // stack must not be handed out again.
+    var suspended = new Coroutine(recurse);
+    Expect.equals(42, suspended(i));
+    testRecursion(i * 10);
+    testThrow(i);
+    Expect.equals(87, suspended(87));
+    Expect.equals(99, suspended(42));
+    Expect.isTrue(suspended.isDone);
+  }
+}
+
+void testRecursion(n) {
+  var co = new Coroutine(recurse);
+  Expect.equals(42, co(n));
+  Expect.equals(87, co(87));
+  Expect.equals(99, co(42));
+  Expect.isTrue(co.isDone);
+}
+
+void testThrow(n) {
+  var co = new Coroutine((x) => throwInTheDeep(x, n));
+  Expect.throws(() => co(n), (x) => identical(x, n));
+  Expect.isTrue(co.isDone);
+}
+
+int recurse(n) {
+  if (n == 0) {
+    Expect.equals(87, Coroutine.yield(42));
+    Expect.equals(42, Coroutine.yield(87));
+    return 99;
+  } else {
+    return recurse(n - 1);
+  }
+}
+
+throwInTheDeep(n, exception) {
+  if (n == 0) throw exception;
+  return (n % 4 == 0)
+      ? new Coroutine((x) => throwInTheDeep(n - 1, x))(exception)
+      : throwInTheDeep(n - 1, exception);
+}
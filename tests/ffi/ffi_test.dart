@@ -876,6 +876,8 @@ void testExternalFinalizer() {
   }
   Expect.equals(42, x[1023]);
 
+  // External finalizers run on a helper thread after the GC.
+  Foreign.waitForFinalizers();
   Expect.equals(1, check.icall$0());
 }
 
@@ -0,0 +1,84 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Calls functions often enough for -Xjit to compile them, and checks that the
+// compiled code computes what the interpreter does. The test runner runs it
+// with a low -Xjit-threshold.
+
+import 'package:expect/expect.dart';
+
+final int one = initializeOne();
+
+int initializeOne() => 1;
+
+int sum(int n) {
+  var s = 0;
+  while (n > 0) {
+    s = s + n * one;
+    n = n - 1;
+  }
+  return s;
+}
+
+int fib(int n) => n < 2 ? n : fib(n - 1) + fib(n - 2);
+
+double halves(int n) {
+  var d = 1.0;
+  for (var i = 0; i < n; i++) d = d * 0.5 + 0.25;
+  return d;
+}
+
+int square(int n) => n * n;
+
+int shifts(int n) => ((n << 3) >> 1) ^ ~n & 0xff | n;
+
+bool compare(a, b) => a < b && b > a && a <= b && b >= a && a != b;
+
+class Point {
+  final x;
+  final y;
+  Point(this.x, this.y);
+  Point operator +(Point other) => new Point(x + other.x, y + other.y);
+}
+
+Point addPoints(int n) {
+  var p = new Point(0, 0);
+  for (var i = 0; i < n; i++) p = p + new Point(i, 1);
+  return p;
+}
+
+int depth(int n) => n == 0 ? 0 : depth(n - 1) + 1;
+
+int thrower(int n) {
+  if (n == 0) throw n;
+  return thrower(n - 1);
+}
+
+int catcher(int n) {
+  try {
+    return thrower(n);
+  } catch (e) {
+    return e + 1;
+  }
+}
+
+main() {
+  for (var i = 0; i < 100; i++) {
+    Expect.equals(500500, sum(1000));
+    Expect.equals(6765, fib(20));
+    Expect.equals(0.5 + 1.0 / 2048, halves(10));
+    // Results that overflow smis become large integers.
+    Expect.equals(1 << 62, square(1 << 31));
+    Expect.equals(((i << 3) >> 1) ^ ~i & 0xff | i, shifts(i));
+    Expect.isTrue(compare(i, i + 1));
+    Expect.isTrue(compare(i + 0.5, i + 1.5));
+    Expect.isFalse(compare(double.NAN, 1.0));
+    var p = addPoints(10);
+    Expect.equals(45, p.x);
+    Expect.equals(10, p.y);
+    // Deep recursion grows the stack.
+    Expect.equals(10000, depth(10000));
+    Expect.equals(1, catcher(10));
+  }
+}
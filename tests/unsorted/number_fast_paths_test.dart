@@ -0,0 +1,61 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Tests the arithmetic and comparisons the interpreter does inline on
+// doubles and on smis that overflow into large integers.
+
+import 'package:expect/expect.dart';
+
+main() {
+  testDoubles();
+  testDoubleComparisons();
+  testSmiOverflow();
+  testManyAllocations();
+}
+
+testDoubles() {
+  var a = 1.5;
+  var b = 0.25;
+  Expect.equals(1.75, a + b);
+  Expect.equals(1.25, a - b);
+  Expect.equals(0.375, a * b);
+  Expect.isTrue((a * 1e308 * 10).isInfinite);
+}
+
+testDoubleComparisons() {
+  var nan = 0.0 / 0.0;
+  var one = 1.0;
+  Expect.isFalse(nan == nan);
+  Expect.isFalse(nan < one);
+  Expect.isFalse(nan <= one);
+  Expect.isFalse(nan > one);
+  Expect.isFalse(nan >= one);
+  Expect.isFalse(one < nan);
+  Expect.isTrue(0.0 == -0.0);
+  Expect.isTrue(one <= one);
+  Expect.isTrue(one >= one);
+  Expect.isFalse(one < one);
+  Expect.isTrue(-one < one);
+}
+
+testSmiOverflow() {
+  var s = 1 << 61;
+  Expect.equals(4611686018427387904, s + s);
+  Expect.equals(4611686018427387904, s * 2);
+  Expect.equals(-4611686018427387904, -s - s);
+  Expect.equals(s * -3, -s - s - s);
+  Expect.equals(s, (s + s) - s);
+}
+
+testManyAllocations() {
+  var sum = 0.0;
+  var big = 0;
+  var s = 1 << 61;
+  for (int i = 0; i < 100000; i++) {
+    sum = sum + 0.5;
+    big = (s + s) - s;
+  }
+  Expect.equals(50000.0, sum);
+  Expect.equals(s, big);
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Tests bytecode sequences the interpreter runs with the top of the stack
+// cached in a register, including the fallbacks that spill it.
+
+import 'package:expect/expect.dart';
+
+class Point {
+  final x;
+  final y;
+  Point(this.x, this.y);
+}
+
+int sumTo(int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum = sum + i;
+  }
+  return sum;
+}
+
+add(a, b) => a + b;
+
+less(a, b) => a < b;
+
+main() {
+  Expect.equals(4950, sumTo(100));
+
+  // Stores to locals further down the stack.
+  var a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7;
+  g = a + b;
+  a = g - c;
+  Expect.equals(3, g);
+  Expect.equals(0, a);
+  Expect.equals(4 + 5 + 6, d + e + f);
+
+  var p = new Point(3, 4);
+  Expect.equals(7, p.x + p.y);
+
+  // Operands that take the regular invoke paths.
+  Expect.equals("ab", add("a", "b"));
+  Expect.equals(1.5, add(1, 0.5));
+  Expect.equals(4611686018427387904, add(1 << 61, 1 << 61));
+  Expect.isTrue(less(1, 1.5));
+  Expect.isFalse(less(2.5, 1));
+
+  var list = [];
+  for (var i = 0; i < 3; i++) {
+    if (i == 1) continue;
+    list.add(i);
+  }
+  Expect.listEquals([0, 2], list);
+}
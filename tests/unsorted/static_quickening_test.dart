@@ -0,0 +1,34 @@
+// Copyright (c) 2016, the Dartino project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// Tests that lazily initialized statics are initialized once per process,
+// also after the interpreter has quickened the loads of them.
+
+import 'dart:dartino';
+
+import 'package:expect/expect.dart';
+
+int initializations = 0;
+
+final answer = initialize();
+
+initialize() {
+  initializations++;
+  return 42;
+}
+
+readAnswer() => answer;
+
+child() {
+  Expect.equals(42, readAnswer());
+  Expect.equals(1, initializations);
+}
+
+main() {
+  for (int i = 0; i < 10; i++) {
+    Expect.equals(42, readAnswer());
+  }
+  Expect.equals(1, initializations);
+  Process.spawnDetached(child);
+}
@@ -529,6 +529,22 @@ def StepsNormal(debug_log, system, modes, archs, asans, embedded_libs):
 
         RunWithCoreDumpArchiving(run, build_dir, build_conf)
 
+  # The JIT only targets x64. It gets a run of the snapshots of its own, on
+  # one configuration.
+  for configuration in configurations:
+    if configuration['build_conf'] == 'DebugX64':
+      build_conf = configuration['build_conf']
+      build_dir = configuration['build_dir']
+
+      def run():
+        StepTest(
+            configuration=configuration,
+            snapshot_run=True,
+            use_jit=True,
+            debug_log=debug_log)
+
+      RunWithCoreDumpArchiving(run, build_dir, build_conf)
+
 def StepsFreeRtos(debug_log):
   StepGyp()
 
@@ -764,6 +780,7 @@ def StepTest(
     configuration=None,
     snapshot_run=False,
     use_heap_blob=False,
+    use_jit=False,
     debug_log=None):
   name = configuration['build_conf']
   mode = configuration['mode']
@@ -776,6 +793,8 @@ def StepTest(
 
   if (use_heap_blob):
     suffix = '-heapblob'
+  elif (use_jit):
+    suffix = '-jit'
   elif (snapshot_run):
     suffix = '-snapshot'
   else:
@@ -805,6 +824,9 @@ def StepTest(
     if use_heap_blob:
       args.append('--use-heap-blob')
 
+    if use_jit:
+      args.append('--use-jit')
+
     if use_sdk:
       args.append('--use-sdk')
 
@@ -208,6 +208,14 @@ class DartinoVMRuntimeConfiguration extends DartVmRuntimeConfiguration {
                           : "${suite.buildDir}/dartino-vm";
     // NOTE: We assume that `dartino-vm` behaves the same as invoking
     // the DartVM in terms of exit codes.
+    if (configuration['use_jit']) {
+      // Compile functions after a few calls, so most tests run compiled code.
+      var argumentsJit = ["-Xjit", "-Xjit-threshold=10", "-Xabort-on-sigterm"]
+          ..addAll(arguments);
+      return <Command>[
+          commandBuilder.getVmCommand(
+              dartinoVM, argumentsJit, environmentOverrides)];
+    }
     return <Command>[
         commandBuilder.getVmCommand(dartinoVM, arguments, environmentOverrides),
         commandBuilder.getVmCommand(
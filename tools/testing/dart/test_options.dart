@@ -507,6 +507,14 @@ Note: currently only implemented for dart2js.''',
               [],
               false,
               type: 'bool'),
+          new _TestOptionSpecification(
+              'use_jit',
+              'Run tests with the JIT compiler of the Dartino VM instead of '
+              'the interpreter only.',
+              ['--use-jit'],
+              [],
+              false,
+              type: 'bool'),
           ];
   }
 
@@ -739,6 +747,13 @@ Note: currently only implemented for dart2js.''',
             "on LK.");
     }
 
+    if (config['use_jit'] &&
+        (config['arch'] != 'x64' || config['runtime'] != 'dartinovm')) {
+      isValid = false;
+      print("The JIT only runs in the --arch=x64 --runtime=dartinovm "
+            "configuration.");
+    }
+
     return isValid;
   }
 